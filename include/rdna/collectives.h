@@ -0,0 +1,173 @@
+#ifndef RDNA_COLLECTIVES_H
+#define RDNA_COLLECTIVES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rdna {
+
+class Stream;
+
+/**
+ * @brief Collective configuration
+ */
+struct CollectiveConfig {
+    size_t bucket_size;  // Bytes per ring pass; bounds scratch and pipelines large buffers
+    bool average;        // Divide reductions by size(), giving means instead of sums
+    bool use_rccl;       // Prefer RCCL when the build has it
+
+    CollectiveConfig();
+};
+
+/**
+ * @brief Single-process collectives over a ring of local devices
+ *
+ * Rank r is device_ids[r]; buffer arguments hold one pointer per rank, on
+ * that rank's device, and data_type is 0 (float32) or 2 (bfloat16), the
+ * types gradients are exchanged in. Calls only enqueue: each rank's work
+ * runs on the communicator's own stream for that device, after whatever
+ * the caller had queued on streams[r] (the device's current stream when
+ * streams is empty), so it overlaps with compute queued afterwards. Call
+ * wait() before reading results or reusing buffers.
+ *
+ * With RCCL available the calls map onto it; otherwise a ring of peer
+ * copies and reduction kernels runs it, neighbours ordered with events.
+ * Reductions are sums, or sums divided by size() when
+ * CollectiveConfig::average is set. Returns false if a launch fails;
+ * throws std::invalid_argument on mismatched arguments.
+ */
+class Communicator {
+public:
+    explicit Communicator(const std::vector<int>& device_ids, const CollectiveConfig& config = CollectiveConfig());
+    ~Communicator();
+
+    Communicator(const Communicator&) = delete;
+    Communicator& operator=(const Communicator&) = delete;
+
+    // Create streams, enable peer access around the ring and set up RCCL
+    bool initialize();
+    bool is_initialized() const;
+
+    int size() const;
+    const std::vector<int>& get_device_ids() const;
+    const CollectiveConfig& get_config() const;
+    bool uses_rccl() const;
+
+    // In place: count elements per rank, reduced across ranks
+    bool all_reduce(const std::vector<void*>& buffers, size_t count, int data_type,
+                    const std::vector<Stream*>& streams = {});
+
+    // recv[r] receives size() * count elements, send[q] landing at q * count
+    bool all_gather(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                    size_t count, int data_type, const std::vector<Stream*>& streams = {});
+
+    // send[r] holds size() * count elements; recv[r] receives the reduction
+    // of every rank's elements [r * count, (r + 1) * count)
+    bool reduce_scatter(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                        size_t count, int data_type, const std::vector<Stream*>& streams = {});
+
+    // Order streams[r] (current streams when empty) after every collective
+    // queued so far, without blocking the host
+    void wait(const std::vector<Stream*>& streams = {});
+
+    // Block the host until every queued collective has finished
+    void synchronize();
+
+    // The communicator's stream for rank
+    std::shared_ptr<Stream> get_stream(int rank) const;
+
+private:
+    struct Rank;
+    struct NeighbourJoin;
+
+    bool ring_all_reduce(const std::vector<void*>& buffers, size_t count, int data_type);
+    bool ring_all_gather(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                         size_t count, int data_type);
+    bool ring_reduce_scatter(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                             size_t count, int data_type);
+
+    // Start a collective after the callers' streams, and mark its end
+    void begin(const std::vector<Stream*>& streams);
+    void end();
+
+    // Ring step barrier: rank waits for both neighbours' previous step
+    void wait_for_neighbours(int rank, int step);
+    void finish_step(int rank, int step);
+    
+    // Every rank waits for its neighbours' last_step, after which nothing
+    // reads its buffers or scratch any more
+    void join_neighbours(int last_step);
+
+    std::vector<int> device_ids_;
+    CollectiveConfig config_;
+    std::vector<std::unique_ptr<Rank>> ranks_;
+    std::vector<void*> rccl_comms_;  // ncclComm_t per rank
+    bool initialized_;
+};
+
+/**
+ * @brief Gradient bucketing for data-parallel backward passes
+ *
+ * Gradients are registered once, in the order backward produces them, and
+ * packed into buckets of about CollectiveConfig::bucket_size. As backward
+ * marks a gradient ready, a bucket whose gradients are all ready is
+ * flattened and all-reduced right away while the rest of backward keeps
+ * running; wait() then unpacks every bucket and orders the optimizer's
+ * streams after it.
+ */
+class GradientBuckets {
+public:
+    GradientBuckets(std::shared_ptr<Communicator> communicator, int data_type = 0);
+    ~GradientBuckets();
+
+    GradientBuckets(const GradientBuckets&) = delete;
+    GradientBuckets& operator=(const GradientBuckets&) = delete;
+
+    // One pointer per rank; returns the gradient's index
+    size_t add_gradient(const std::vector<void*>& buffers, size_t count);
+
+    // Allocate flat bucket buffers; no gradients can be added afterwards
+    bool finalize();
+
+    // Gradient index was written by work queued on streams; launches its
+    // bucket's all-reduce once the bucket is complete
+    bool mark_ready(size_t index, const std::vector<Stream*>& streams = {});
+
+    // Reduce any buckets still pending, scatter results back into the
+    // gradients and order streams after them; readiness resets for the
+    // next step
+    bool wait(const std::vector<Stream*>& streams = {});
+
+    size_t bucket_count() const;
+
+private:
+    struct Gradient {
+        std::vector<void*> buffers;
+        size_t count;
+        size_t bucket;
+        size_t offset;  // Elements into the bucket
+        bool ready;
+    };
+
+    struct Bucket {
+        std::vector<void*> flat;  // Per rank, from the caching allocator
+        std::vector<size_t> gradients;
+        size_t count;
+        size_t pending;  // Gradients not yet marked ready this step
+        bool launched;
+    };
+
+    bool launch(Bucket& bucket, const std::vector<Stream*>& streams);
+
+    std::shared_ptr<Communicator> communicator_;
+    int data_type_;
+    std::vector<Gradient> gradients_;
+    std::vector<Bucket> buckets_;
+    bool finalized_;
+};
+
+} // namespace rdna
+
+#endif // RDNA_COLLECTIVES_H
@@ -1,16 +1,32 @@
 #ifndef RDNA_DEVICE_H
 #define RDNA_DEVICE_H
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 
 namespace rdna {
 
 // Forward declarations
 class DeviceContext;
 class Stream;
+class Event;
+class Graph;
+
+/**
+ * @brief Stream scheduling priority
+ * 
+ * LOW is the device's default priority; HIGH streams are scheduled ahead
+ * of it, for latency-sensitive work sharing the device with bulk work.
+ */
+enum class StreamPriority {
+    LOW,
+    HIGH
+};
 
 /**
  * @brief Device properties structure
@@ -26,6 +42,7 @@ struct DeviceProperties {
     int compute_units;
     int max_workgroup_size;
     int wavefront_size;
+    size_t shared_memory_per_block;  // LDS bytes available to one workgroup
     bool supports_fp16;
     bool supports_bf16;
     bool supports_tensor_cores;
@@ -38,7 +55,9 @@ struct DeviceProperties {
 /**
  * @brief Device discovery and management
  * 
- * Handles device enumeration, context creation, and device properties
+ * Handles device enumeration, context creation, and device properties.
+ * The device count and properties are queried from HIP once; free_memory
+ * is a snapshot from discovery.
  */
 class DeviceManager {
 public:
@@ -49,11 +68,38 @@ public:
     DeviceProperties get_device_properties(int device_id);
     std::vector<DeviceProperties> get_all_device_properties();
     
-    // Context management
+    // Context management. get_context returns the device's shared context,
+    // created and initialized on first use and kept for the process; it is
+    // what MemoryManager, KernelManager and the framework backends use.
+    // create_context builds a separate one. -1 means the current device.
+    std::shared_ptr<DeviceContext> get_context(int device_id);
     std::shared_ptr<DeviceContext> create_context(int device_id);
     std::shared_ptr<DeviceContext> get_current_context();
     void set_current_context(std::shared_ptr<DeviceContext> context);
     
+    // Calling thread's device, as HIP reports it, so switches made outside
+    // DeviceManager are seen; setting the device already current is a no-op
+    int get_current_device();
+    void set_current_device(int device_id);
+    
+    // Calling thread's stream per device. Kernels and allocations given no
+    // stream are queued to it; none is set by default, which means the null
+    // stream. Setting a null stream clears device_id's (-1: current device),
+    // otherwise the stream's own device is used.
+    std::shared_ptr<Stream> get_current_stream(int device_id = -1);
+    void set_current_stream(std::shared_ptr<Stream> stream, int device_id = -1);
+    void* get_current_stream_handle(int device_id = -1);  // nullptr when unset
+    
+    // Peer access. Whether device_id can map peer_id's memory is queried
+    // once per pair; enabling it lets device_id's kernels and copies reach
+    // that memory over the fabric instead of bouncing through the host,
+    // and is idempotent. enable_all_peer_access enables every capable pair
+    // and returns how many directed pairs are enabled.
+    bool can_access_peer(int device_id, int peer_id);
+    bool enable_peer_access(int device_id, int peer_id);
+    bool is_peer_access_enabled(int device_id, int peer_id);
+    int enable_all_peer_access();
+    
     // Error handling
     bool check_device_compatibility(int device_id);
     std::string get_last_error();
@@ -62,8 +108,23 @@ private:
     DeviceManager() = default;
     ~DeviceManager() = default;
     
+    static constexpr int kMaxDevices = 16;
+    
+    void discover_devices();
+    std::shared_ptr<Stream>& current_stream_slot(int device_id);
+    
+    std::once_flag discovery_flag_;
+    int device_count_ = 0;
     std::vector<DeviceProperties> devices_;
-    std::shared_ptr<DeviceContext> current_context_;
+    std::mutex context_mutex_;
+    std::array<std::shared_ptr<DeviceContext>, kMaxDevices> contexts_;  // Written once under context_mutex_
+    std::array<std::atomic<bool>, kMaxDevices> context_ready_{};
+    
+    enum PeerState : uint8_t { kPeerUnknown, kPeerUnsupported, kPeerSupported, kPeerEnabled };
+    PeerState query_peer_state(int device_id, int peer_id);  // Caller holds peer_mutex_
+    
+    std::mutex peer_mutex_;
+    std::array<std::array<PeerState, kMaxDevices>, kMaxDevices> peer_state_{};
     std::string last_error_;
 };
 
@@ -72,7 +133,7 @@ private:
  * 
  * Manages HIP device context and provides device-specific operations
  */
-class DeviceContext {
+class DeviceContext : public std::enable_shared_from_this<DeviceContext> {
 public:
     DeviceContext(int device_id);
     ~DeviceContext();
@@ -81,17 +142,32 @@ public:
     void synchronize();
     bool is_valid() const;
     int get_device_id() const;
-    DeviceProperties get_properties() const;
+    const DeviceProperties& get_properties() const;  // Fetched once
     
-    // Stream management
-    std::shared_ptr<Stream> create_stream();
+    // Stream management. create_stream makes a new HIP stream; pooled
+    // streams are created once per priority and handed out round-robin, so
+    // callers that just want to run independently of each other can take
+    // one per task without paying for stream creation.
+    std::shared_ptr<Stream> create_stream(StreamPriority priority = StreamPriority::LOW);
+    std::shared_ptr<Stream> get_stream_from_pool(StreamPriority priority = StreamPriority::LOW);
     std::shared_ptr<Stream> get_default_stream();
     
 private:
+    static constexpr size_t kPoolStreamsPerPriority = 4;
+    
+    struct StreamPool {
+        std::once_flag created;
+        std::array<std::shared_ptr<Stream>, kPoolStreamsPerPriority> streams;
+        std::atomic<uint32_t> next{0};
+    };
+    
     int device_id_;
     void* hip_context_;
     std::shared_ptr<Stream> default_stream_;
+    std::array<StreamPool, 2> stream_pools_;  // Indexed by StreamPriority
     bool initialized_;
+    mutable std::once_flag properties_flag_;
+    mutable DeviceProperties properties_;
 };
 
 /**
@@ -104,19 +180,126 @@ public:
     Stream(std::shared_ptr<DeviceContext> context);
     ~Stream();
     
-    bool initialize();
+    bool initialize(StreamPriority priority = StreamPriority::LOW);
     void synchronize();
     bool is_valid() const;
     void* get_native_handle() const;
+    std::shared_ptr<DeviceContext> get_context() const;
+    StreamPriority get_priority() const;
     
     // Memory operations
     bool memcpy(void* dst, const void* src, size_t size);
     bool memcpy_async(void* dst, const void* src, size_t size);
     
+    // Graph capture. Work queued on this stream between begin and end is
+    // recorded instead of run; allocations on it come from a private pool,
+    // pool_id's if given (sharing memory with an earlier graph whose
+    // replays never overlap this one's), else a new one. Capture is
+    // thread-local: other threads may keep using HIP meanwhile, but this
+    // thread must not synchronize. end_capture returns nullptr if the
+    // capture failed, e.g. because an unsupported call was made.
+    bool begin_capture(uint64_t pool_id = 0);
+    std::shared_ptr<Graph> end_capture();
+    bool is_capturing() const;
+    
 private:
     std::shared_ptr<DeviceContext> context_;
     void* hip_stream_;
     bool initialized_;
+    StreamPriority priority_;
+    uint64_t capture_pool_id_;  // Nonzero while capturing
+};
+
+/**
+ * @brief Makes a stream current on its device for the enclosing scope
+ * 
+ * Only the calling thread's current stream changes; the current device is
+ * left alone.
+ */
+class StreamGuard {
+public:
+    explicit StreamGuard(std::shared_ptr<Stream> stream);
+    ~StreamGuard();
+    
+    StreamGuard(const StreamGuard&) = delete;
+    StreamGuard& operator=(const StreamGuard&) = delete;
+    
+private:
+    int device_id_;
+    std::shared_ptr<Stream> original_stream_;
+};
+
+/**
+ * @brief Captured stream work, replayed with a single launch
+ * 
+ * Replays run exactly the captured kernels on exactly the captured
+ * buffers: feed new inputs by writing into the tensors that were read
+ * during capture and read results from the ones that were written. The
+ * graph keeps its memory pool reserved until reset or destruction.
+ */
+class Graph {
+public:
+    Graph(std::shared_ptr<DeviceContext> context, void* hip_graph, uint64_t pool_id);
+    ~Graph();
+    
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
+    
+    // Build the executable graph; replay does this on first use
+    bool instantiate();
+    bool is_instantiated() const;
+    
+    // Launch the whole graph on stream, ordered after work already queued there
+    bool replay(Stream& stream);
+    
+    // Free the graph and give up its pool reference
+    void reset();
+    
+    uint64_t get_pool_id() const;
+    void* get_native_handle() const;  // hipGraph_t
+    
+private:
+    std::shared_ptr<DeviceContext> context_;
+    void* hip_graph_;
+    void* hip_graph_exec_;
+    uint64_t pool_id_;
+};
+
+/**
+ * @brief Event abstraction
+ * 
+ * Marks a point in a stream's work for cross-stream ordering, host
+ * synchronization and device-side timing
+ */
+class Event {
+public:
+    Event(std::shared_ptr<DeviceContext> context, bool enable_timing = true);
+    ~Event();
+    
+    bool initialize();
+    bool is_valid() const;
+    void* get_native_handle() const;
+    
+    // Capture all work queued on stream so far
+    void record(Stream& stream);
+    
+    // Make stream wait for this event without blocking the host
+    void wait(Stream& stream);
+    
+    // Block the host until the recorded work completes
+    void synchronize();
+    
+    // True once the recorded work has completed
+    bool query() const;
+    
+    // Milliseconds between this event and end (both must have timing enabled)
+    float elapsed_time(const Event& end) const;
+    
+private:
+    std::shared_ptr<DeviceContext> context_;
+    void* hip_event_;
+    bool enable_timing_;
+    bool initialized_;
 };
 
 // Utility functions
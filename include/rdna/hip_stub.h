@@ -13,12 +13,14 @@ typedef int hipError_t;
 #define hipErrorInvalidValue 1
 #define hipErrorMemoryAllocation 2
 #define hipErrorNotInitialized 3
+#define hipErrorNotReady 600
 
 // HIP device properties structure (simplified)
 struct hipDeviceProp_t {
     char name[256];
     char gcnArchName[256];
     size_t totalGlobalMem;
+    size_t sharedMemPerBlock;
     int multiProcessorCount;
     int maxThreadsPerBlock;
     int warpSize;
@@ -30,6 +32,11 @@ struct hipDeviceProp_t {
 // HIP stream type (placeholder)
 typedef void* hipStream_t;
 
+// HIP event type (placeholder)
+typedef void* hipEvent_t;
+#define hipEventDefault 0x0
+#define hipEventDisableTiming 0x2
+
 // HIP runtime functions (stubs)
 inline const char* hipGetErrorString(hipError_t error) {
     static const char* error_strings[] = {
@@ -49,6 +56,7 @@ inline hipError_t hipGetDeviceProperties(hipDeviceProp_t* prop, int deviceId) {
     snprintf(prop->name, 256, "AMD Radeon RX 6800 XT (Stub)");
     snprintf(prop->gcnArchName, 256, "gfx1030");
     prop->totalGlobalMem = 16ULL * 1024 * 1024 * 1024; // 16GB
+    prop->sharedMemPerBlock = 64 * 1024;
     prop->multiProcessorCount = 72;
     prop->maxThreadsPerBlock = 1024;
     prop->warpSize = 64;
@@ -63,6 +71,14 @@ inline hipError_t hipDeviceSynchronize() { return hipSuccess; }
 inline hipError_t hipStreamCreate(hipStream_t* stream) { *stream = nullptr; return hipSuccess; }
 inline hipError_t hipStreamDestroy(hipStream_t stream) { return hipSuccess; }
 inline hipError_t hipStreamSynchronize(hipStream_t stream) { return hipSuccess; }
+inline hipError_t hipEventCreate(hipEvent_t* event) { *event = nullptr; return hipSuccess; }
+inline hipError_t hipEventCreateWithFlags(hipEvent_t* event, unsigned int flags) { *event = nullptr; return hipSuccess; }
+inline hipError_t hipEventDestroy(hipEvent_t event) { return hipSuccess; }
+inline hipError_t hipEventRecord(hipEvent_t event, hipStream_t stream) { return hipSuccess; }
+inline hipError_t hipEventQuery(hipEvent_t event) { return hipSuccess; }
+inline hipError_t hipEventSynchronize(hipEvent_t event) { return hipSuccess; }
+inline hipError_t hipEventElapsedTime(float* ms, hipEvent_t start, hipEvent_t stop) { *ms = 0.0f; return hipSuccess; }
+inline hipError_t hipStreamWaitEvent(hipStream_t stream, hipEvent_t event, unsigned int flags) { return hipSuccess; }
 inline hipError_t hipMemcpy(void* dst, const void* src, size_t size, int kind) { return hipSuccess; }
 inline hipError_t hipMemcpyAsync(void* dst, const void* src, size_t size, int kind, hipStream_t stream) { return hipSuccess; }
 inline hipError_t hipMalloc(void** ptr, size_t size) { *ptr = malloc(size); return hipSuccess; }
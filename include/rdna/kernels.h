@@ -1,9 +1,13 @@
 #ifndef RDNA_KERNELS_H
 #define RDNA_KERNELS_H
 
+#include <atomic>
 #include <cstddef>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include "device.h"
 
 namespace rdna {
@@ -66,6 +70,72 @@ struct ConvConfig {
     ConvConfig();
 };
 
+/**
+ * @brief One step of a fused elementwise chain
+ * 
+ * Operands index a value list holding the chain's inputs followed by the
+ * result of each earlier op; the last op's result is the chain's output.
+ */
+enum class FusedOpType {
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Maximum,
+    Minimum,
+    Relu,
+    Gelu,
+    Sigmoid,
+    Tanh
+};
+
+struct FusedOp {
+    FusedOpType type;
+    int lhs;
+    int rhs;  // Ignored by unary ops
+    
+    FusedOp(FusedOpType type, int lhs, int rhs = -1);
+};
+
+/**
+ * @brief Work applied to a matmul result before it is stored
+ * 
+ * Computes C = act(alpha * op(A) * op(B) + beta * C + bias) + residual in
+ * one pass over C. bias and residual broadcast against C (bias is usually
+ * shape {n}) and are skipped when their data pointer is nullptr.
+ */
+enum class Activation {
+    Identity,
+    Relu,
+    Gelu
+};
+
+struct MatmulEpilogue {
+    const void* bias;
+    TensorDesc bias_desc;
+    Activation activation;
+    const void* residual;
+    TensorDesc residual_desc;
+    
+    MatmulEpilogue();
+    bool empty() const;
+};
+
+/**
+ * @brief Scaled-dot-product attention options
+ * 
+ * scale <= 0 means 1/sqrt(head_dim). causal masks keys after each query
+ * (top-left aligned). key_lengths, if set, is a device array of one int32
+ * per batch entry; keys at or past it are padding.
+ */
+struct AttentionConfig {
+    float scale;
+    bool causal;
+    const int* key_lengths;
+    
+    AttentionConfig();
+};
+
 /**
  * @brief Base class for operator kernels
  */
@@ -82,7 +152,12 @@ protected:
 };
 
 /**
- * @brief Matmul kernel using rocBLAS and MIOpen
+ * @brief Matmul kernel using rocBLAS
+ * 
+ * Operands are row-major views described by TensorDesc::strides; a view
+ * whose last dimension is not unit-stride (e.g. a transpose) is passed to
+ * rocBLAS as a transposed operand instead of being copied. fp32, fp16 and
+ * bf16 inputs are supported, always accumulating in fp32.
  */
 class MatmulKernel : public OperatorKernel {
 public:
@@ -100,20 +175,93 @@ public:
                 const MatmulConfig& config = MatmulConfig(),
                 void* stream = nullptr);
     
-    // Batched matmul
-    bool batched_matmul(const std::vector<TensorDesc>& a_batch, const void* a_data,
-                        const std::vector<TensorDesc>& b_batch, const void* b_data,
-                        const std::vector<TensorDesc>& c_batch, void* c_data,
+    // Strided-batched matmul over the leading dimension of 3D descriptors;
+    // a batch extent of 1 on A or B broadcasts that operand
+    bool batched_matmul(const TensorDesc& a, const void* a_data,
+                        const TensorDesc& b, const void* b_data,
+                        const TensorDesc& c, void* c_data,
                         const MatmulConfig& config = MatmulConfig(),
                         void* stream = nullptr);
     
+    // matmul or batched_matmul (by rank of C) followed by a fused epilogue.
+    // When C is fp16/bf16 and beta is 0 the product is kept in fp32 scratch
+    // and only rounded to C's type after the epilogue.
+    bool fused_matmul(const TensorDesc& a, const void* a_data,
+                      const TensorDesc& b, const void* b_data,
+                      const TensorDesc& c, void* c_data,
+                      const MatmulEpilogue& epilogue,
+                      const MatmulConfig& config = MatmulConfig(),
+                      void* stream = nullptr);
+    
+    // matmul or batched_matmul (by rank of C) after timing every rocBLAS
+    // solution for this shape; the winner is recorded with the
+    // PerformanceOptimizer and used by later calls in the same shape bucket
+    bool tune(const TensorDesc& a, const void* a_data,
+              const TensorDesc& b, const void* b_data,
+              const TensorDesc& c, void* c_data,
+              const MatmulConfig& config = MatmulConfig(),
+              void* stream = nullptr);
+    
 private:
+    bool gemm(const TensorDesc& a, const void* a_data,
+              const TensorDesc& b, const void* b_data,
+              const TensorDesc& c, void* c_data,
+              const MatmulConfig& config, void* stream, bool batched, bool tune);
+    
     std::shared_ptr<DeviceContext> context_;
+    std::string arch_;  // Part of tuning keys
     void* rocblas_handle_;
+    std::mutex handle_mutex_;  // rocBLAS handles are not thread-safe
+};
+
+/**
+ * @brief Persistent cache of convolution algorithm choices
+ * 
+ * Keys capture everything that affects the choice: direction, shapes,
+ * strides, data type, convolution parameters and device arch. Benchmarked
+ * results are appended to a plain-text database (RDNA_CONV_FIND_DB, or
+ * ~/.cache/rdna/conv_find_db.txt) that is loaded on first use, so later
+ * processes skip the search entirely.
+ */
+class ConvAlgorithmCache {
+public:
+    static ConvAlgorithmCache& get_instance();
+    
+    // benchmarked_only ignores entries chosen by a quick, non-exhaustive find
+    bool lookup(const std::string& key, bool benchmarked_only, int& algorithm, size_t& workspace_size) const;
+    void store(const std::string& key, bool benchmarked, int algorithm, size_t workspace_size);
+    
+    // Database management; set_database_path loads the new file
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+    void set_database_path(const std::string& path);
+    std::string get_database_path() const;
+    void clear();
+    size_t size() const;
+    
+private:
+    ConvAlgorithmCache();
+    ~ConvAlgorithmCache() = default;
+    
+    struct Entry {
+        int algorithm;
+        size_t workspace_size;
+        bool benchmarked;
+    };
+    
+    bool load_locked(const std::string& path);
+    
+    std::unordered_map<std::string, Entry> entries_;
+    std::string database_path_;
+    mutable std::mutex mutex_;
 };
 
 /**
  * @brief Convolution kernel using MIOpen
+ * 
+ * Algorithms come from ConvAlgorithmCache. On a miss MIOpen's find is run,
+ * exhaustively when ConvConfig::benchmark is set, and the result is cached;
+ * benchmarked results are persisted.
  */
 class ConvKernel : public OperatorKernel {
 public:
@@ -152,12 +300,23 @@ public:
                                      const ConvConfig& config);
     
 private:
+    std::string make_cache_key(const char* direction,
+                               const TensorDesc& x, const TensorDesc& w, const TensorDesc& y,
+                               const ConvConfig& config) const;
+    
     std::shared_ptr<DeviceContext> context_;
     void* miopen_handle_;
+    std::string arch_;
+    std::mutex handle_mutex_;  // MIOpen handles are not thread-safe
 };
 
 /**
  * @brief Custom HIP kernels for operations not covered by MIOpen
+ * 
+ * Element-wise ops and activations run on the templated engine in
+ * elementwise.hip, specialized per data type and op at compile time.
+ * Softmax and normalization reduce each row within a wave where it fits,
+ * using the device's wavefront size.
  */
 class CustomKernels : public OperatorKernel {
 public:
@@ -168,7 +327,8 @@ public:
     bool is_initialized() const override;
     std::string get_name() const override;
     
-    // Element-wise operations
+    // Element-wise operations; inputs broadcast against the output and may
+    // be strided, and the output may alias an input of the same layout
     bool add(const TensorDesc& a, const void* a_data,
              const TensorDesc& b, const void* b_data,
              const TensorDesc& c, void* c_data,
@@ -192,7 +352,33 @@ public:
                  const TensorDesc& output, void* output_data,
                  int dim, void* stream = nullptr);
     
-    // Reduction operations
+    // Normalization over the last dimension. weight and bias match its
+    // length and the input's type and may be nullptr; mean and rstd, if
+    // given, receive one fp32 value per row for the backward pass.
+    bool layer_norm(const TensorDesc& input, const void* input_data,
+                    const void* weight, const void* bias,
+                    const TensorDesc& output, void* output_data,
+                    float epsilon = 1e-5f, float* mean = nullptr, float* rstd = nullptr,
+                    void* stream = nullptr);
+    
+    bool layer_norm_backward(const TensorDesc& grad_output, const void* grad_output_data,
+                             const TensorDesc& input, const void* input_data,
+                             const float* mean, const float* rstd, const void* weight,
+                             void* grad_input_data, void* grad_weight, void* grad_bias,
+                             void* stream = nullptr);
+    
+    bool rms_norm(const TensorDesc& input, const void* input_data, const void* weight,
+                  const TensorDesc& output, void* output_data,
+                  float epsilon = 1e-6f, float* rstd = nullptr, void* stream = nullptr);
+    
+    bool rms_norm_backward(const TensorDesc& grad_output, const void* grad_output_data,
+                           const TensorDesc& input, const void* input_data,
+                           const float* rstd, const void* weight,
+                           void* grad_input_data, void* grad_weight,
+                           void* stream = nullptr);
+    
+    // Reductions over dims (all of them if empty) into a dense output;
+    // KernelManager::set_deterministic fixes the reduction order
     bool sum(const TensorDesc& input, const void* input_data,
              const TensorDesc& output, void* output_data,
              const std::vector<int>& dims, void* stream = nullptr);
@@ -201,9 +387,68 @@ public:
               const TensorDesc& output, void* output_data,
               const std::vector<int>& dims, void* stream = nullptr);
     
+    // Evaluate an op chain in a single kernel, JIT-compiled with hipRTC on
+    // first use and cached by signature (ops, data types, rank), so shapes
+    // and strides can change without recompiling. Inputs broadcast against
+    // output; the result is rounded to the output's data type once.
+    bool fused_elementwise(const std::vector<TensorDesc>& inputs,
+                           const std::vector<const void*>& input_data,
+                           const std::vector<FusedOp>& ops,
+                           const TensorDesc& output, void* output_data,
+                           void* stream = nullptr);
+    
+    size_t get_fused_kernel_count() const;
+    
+private:
+    void* get_fused_function(const std::string& signature, const std::string& source);
+    
+    std::shared_ptr<DeviceContext> context_;
+    std::vector<void*> compiled_kernels_;  // hipModule_t per JIT-compiled chain
+    std::unordered_map<std::string, void*> fused_functions_;  // Signature -> hipFunction_t
+    mutable std::mutex fused_mutex_;
+};
+
+/**
+ * @brief Fused attention: softmax(scale * Q K^T) V without the score matrix
+ * 
+ * Q/O are [batch, heads, seq_q, head_dim] and K/V [batch, heads, seq_k,
+ * head_dim], fp16 or bf16, head_dim up to 128, any strides with a
+ * unit-stride head dim. Key tiles are staged in LDS sized from
+ * DeviceProperties::shared_memory_per_block, so memory beyond the operands
+ * is O(seq): logsumexp ([batch, heads, seq_q] fp32) from the forward pass
+ * and one fp32 per query row of workspace in the backward pass.
+ */
+class AttentionKernel : public OperatorKernel {
+public:
+    AttentionKernel(std::shared_ptr<DeviceContext> context);
+    ~AttentionKernel();
+    
+    bool initialize() override;
+    bool is_initialized() const override;
+    std::string get_name() const override;
+    
+    // logsumexp may be nullptr when no backward pass follows
+    bool forward(const TensorDesc& q, const void* q_data,
+                 const TensorDesc& k, const void* k_data,
+                 const TensorDesc& v, const void* v_data,
+                 const TensorDesc& output, void* output_data,
+                 const AttentionConfig& config = AttentionConfig(),
+                 float* logsumexp = nullptr, void* stream = nullptr);
+    
+    // Gradients share the layout of q, k, v and output; grad_q or the
+    // grad_k/grad_v pair may be nullptr to skip them
+    bool backward(const TensorDesc& q, const void* q_data,
+                  const TensorDesc& k, const void* k_data,
+                  const TensorDesc& v, const void* v_data,
+                  const TensorDesc& output, const void* output_data,
+                  const void* grad_output_data, const float* logsumexp,
+                  void* grad_q_data, void* grad_k_data, void* grad_v_data,
+                  const AttentionConfig& config = AttentionConfig(),
+                  void* stream = nullptr);
+    
 private:
     std::shared_ptr<DeviceContext> context_;
-    std::vector<void*> compiled_kernels_;
+    DeviceProperties properties_;
 };
 
 /**
@@ -217,11 +462,17 @@ public:
     std::shared_ptr<MatmulKernel> get_matmul_kernel(int device_id);
     std::shared_ptr<ConvKernel> get_conv_kernel(int device_id);
     std::shared_ptr<CustomKernels> get_custom_kernels(int device_id);
+    std::shared_ptr<AttentionKernel> get_attention_kernel(int device_id);
     
     // Kernel initialization
     bool initialize_kernels(int device_id);
     bool are_kernels_initialized(int device_id) const;
     
+    // Fixed reduction order in kernels that would otherwise combine with
+    // atomics or size their grids from the device; set from LibraryConfig
+    void set_deterministic(bool enabled);
+    bool is_deterministic() const;
+    
     // Operation dispatch
     bool dispatch_matmul(const TensorDesc& a, const void* a_data,
                          const TensorDesc& b, const void* b_data,
@@ -235,6 +486,14 @@ public:
                          const ConvConfig& config = ConvConfig(),
                          int device_id = -1, void* stream = nullptr);
     
+    bool dispatch_attention(const TensorDesc& q, const void* q_data,
+                            const TensorDesc& k, const void* k_data,
+                            const TensorDesc& v, const void* v_data,
+                            const TensorDesc& output, void* output_data,
+                            const AttentionConfig& config = AttentionConfig(),
+                            float* logsumexp = nullptr,
+                            int device_id = -1, void* stream = nullptr);
+    
 private:
     KernelManager() = default;
     ~KernelManager() = default;
@@ -243,16 +502,27 @@ private:
         std::shared_ptr<MatmulKernel> matmul;
         std::shared_ptr<ConvKernel> conv;
         std::shared_ptr<CustomKernels> custom;
+        std::shared_ptr<AttentionKernel> attention;
         bool initialized;
     };
     
     std::unordered_map<int, DeviceKernels> kernels_;
     mutable std::mutex mutex_;
+    std::atomic<bool> deterministic_{false};
 };
 
-// Utility functions for kernel operations
+// Utility functions for kernel operations. Launch configs are tiled for the
+// target in properties (the current device when omitted) so large shapes
+// fill every CU, and cached per shape. Matmul takes [M, K] x [K, N]
+// operands, optionally with a leading batch; convolution is tiled as an
+// implicit GEMM over output pixels and filters, one grid.z slice per image.
+KernelConfig calculate_matmul_kernel_config(const TensorDesc& a, const TensorDesc& b,
+                                            const DeviceProperties& properties);
 KernelConfig calculate_matmul_kernel_config(const TensorDesc& a, const TensorDesc& b);
-KernelConfig calculate_conv_kernel_config(const TensorDesc& input, const TensorDesc& filter);
+KernelConfig calculate_conv_kernel_config(const TensorDesc& input, const TensorDesc& filter,
+                                          const ConvConfig& config, const DeviceProperties& properties);
+KernelConfig calculate_conv_kernel_config(const TensorDesc& input, const TensorDesc& filter,
+                                          const ConvConfig& config = ConvConfig());
 size_t get_data_type_size(int data_type);
 
 } // namespace rdna
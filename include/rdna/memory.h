@@ -1,11 +1,17 @@
 #ifndef RDNA_MEMORY_H
 #define RDNA_MEMORY_H
 
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <map>
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <set>
+#include <string>
 #include <unordered_map>
 
 namespace rdna {
@@ -13,6 +19,7 @@ namespace rdna {
 // Forward declarations
 class DeviceContext;
 class Stream;
+class Event;
 
 /**
  * @brief Memory allocation information
@@ -38,6 +45,20 @@ struct MemoryStats {
     uint64_t max_allocated_bytes;
     uint64_t total_allocations;
     uint64_t total_frees;
+    
+    // Per-pool breakdown (segments are hipMalloc'd regions, blocks are carved from them)
+    uint64_t small_pool_segments;
+    uint64_t small_pool_blocks;
+    uint64_t large_pool_segments;
+    uint64_t large_pool_blocks;
+    
+    // Driver calls issued by the allocator
+    uint64_t device_malloc_calls;
+    uint64_t device_free_calls;
+    
+    // Library scratch held by per-stream workspace arenas (counted as allocated too)
+    uint64_t workspace_bytes;
+    uint64_t workspace_high_water_mark;
 };
 
 /**
@@ -49,13 +70,123 @@ struct AllocationOptions {
     bool managed_memory;
     size_t alignment;
     void* stream;
+    const char* tag;  // Optional static label carried into traces and snapshots
+};
+
+/**
+ * @brief Allocator trace event
+ * 
+ * Entries are plain data so recording never allocates; tag must point to
+ * storage that outlives the allocator, typically a string literal.
+ */
+enum class TraceAction : uint8_t {
+    Alloc,
+    Free,
+    Split,
+    Merge,
+    SegmentAlloc,
+    SegmentFree,
+    SegmentMap,
+    SegmentUnmap,
+    Oom
+};
+
+struct TraceEntry {
+    TraceAction action;
+    void* ptr;
+    size_t size;
+    void* stream;
+    uint64_t timestamp_ns;
+    const char* tag;
+};
+
+const char* trace_action_name(TraceAction action);
+
+/**
+ * @brief Point-in-time view of an allocator's segments and recent trace
+ */
+struct BlockSnapshot {
+    void* ptr;
+    size_t size;
+    const char* state;  // "allocated", "pending_free", "thread_cached" or "free"
+    uint64_t allocation_id;
+    const char* tag;
+};
+
+struct SegmentSnapshot {
+    void* ptr;
+    size_t size;
+    void* stream;
+    const char* pool;  // "small", "large", "private" (graph pools) or "unpooled"
+    bool expandable;
+    std::vector<BlockSnapshot> blocks;  // Address order
+};
+
+struct MemorySnapshot {
+    int device_id;
+    MemoryStats stats;
+    std::vector<SegmentSnapshot> segments;
+    std::vector<TraceEntry> trace;  // Oldest first
+    
+    std::string to_json() const;
+};
+
+/**
+ * @brief Exclusive loan of a stream's workspace arena
+ * 
+ * Holds the arena for as long as it lives, so the buffer cannot be regrown
+ * under queued work; release it once the library call using it is enqueued.
+ * Converts to false if the request exceeded the workspace limit.
+ */
+class Workspace {
+public:
+    Workspace() : ptr_(nullptr), size_(0), valid_(false) {}
+    Workspace(Workspace&&) = default;
+    Workspace& operator=(Workspace&&) = default;
+    
+    void* data() const { return ptr_; }
+    size_t size() const { return size_; }
+    explicit operator bool() const { return valid_; }
+    
+private:
+    friend class MemoryAllocator;
+    Workspace(std::unique_lock<std::mutex> lock, void* ptr, size_t size)
+        : lock_(std::move(lock)), ptr_(ptr), size_(size), valid_(true) {}
+    
+    std::unique_lock<std::mutex> lock_;
+    void* ptr_;
+    size_t size_;
+    bool valid_;
 };
 
 /**
  * @brief Caching memory allocator
  * 
  * Implements a caching allocator similar to PyTorch's CUDA allocator
- * with block splitting, caching, and memory reuse.
+ * with block splitting, caching, and memory reuse. Requests up to 1MB are
+ * carved from 2MB segments in a small pool; larger requests are rounded and
+ * served from a separate large pool so small activations never fragment
+ * large segments. Freed blocks stay in their segment for reuse; only whole,
+ * fully free segments are ever returned to the driver, least recently used
+ * first.
+ *
+ * Allocation is stream-ordered: a freed block is immediately reusable on the
+ * stream it was allocated on. Streams registered with record_stream() get a
+ * HIP event at free time and the block is only reused once those events have
+ * completed; idle segments migrate to other streams the same way.
+ *
+ * Each thread keeps a small front cache of blocks it recently freed from the
+ * small pool, and live pointers are indexed in sharded maps, so repeated
+ * same-size allocate/deallocate pairs never touch the allocator-wide mutex.
+ *
+ * With expandable segments enabled, the large pool instead reserves one
+ * virtual address range per stream and maps physical pages onto its end as
+ * it grows, so large blocks stay contiguous regardless of fragmentation and
+ * a free tail can be unmapped without releasing the whole segment.
+ *
+ * rocBLAS and MIOpen scratch comes from one workspace arena per stream that
+ * only ever grows, up to the workspace limit, so library calls do not churn
+ * the pools with short-lived multi-megabyte blocks.
  */
 class MemoryAllocator {
 public:
@@ -66,61 +197,335 @@ public:
     void* allocate(size_t size, const AllocationOptions& options = {});
     void deallocate(void* ptr);
     
-    // Memory operations
+    // Mark ptr as in use by a stream other than the one it was allocated on
+    void record_stream(void* ptr, void* stream);
+    
+    // Memory operations (block until complete, even when a stream is given)
     bool memcpy(void* dst, const void* src, size_t size, void* stream = nullptr);
     bool memset(void* ptr, int value, size_t size, void* stream = nullptr);
     
+    // Non-blocking variants; the returned event completes with the operation,
+    // or is nullptr if it could not be queued
+    std::shared_ptr<Event> memcpy_async(void* dst, const void* src, size_t size, Stream& stream);
+    std::shared_ptr<Event> memset_async(void* ptr, int value, size_t size, Stream& stream);
+    
     // Memory management
     void empty_cache();
     MemoryStats get_stats() const;
     AllocationInfo get_allocation_info(void* ptr) const;
     
+    // Diagnostics; the trace ring is always sized, recording can be toggled
+    MemorySnapshot snapshot() const;
+    void set_trace_enabled(bool enabled);
+    
+    // Appends trace entries recorded from cursor on, oldest first, and
+    // returns the cursor to pass next time; entries overwritten before they
+    // were read are skipped
+    uint64_t read_trace(uint64_t cursor, std::vector<TraceEntry>& entries) const;
+    bool is_trace_enabled() const;
+    
     // Cache management
     void set_cache_size_limit(size_t limit);
     size_t get_cache_size_limit() const;
     
+    // Large pool growth through HIP virtual memory management; returns false
+    // if the device does not support it
+    bool set_expandable_segments(bool enabled);
+    bool get_expandable_segments() const;
+    
+    // Borrow at least size bytes of stream's scratch arena, growing it if
+    // needed; sizes above the workspace limit yield an empty Workspace
+    Workspace acquire_workspace(size_t size, void* stream = nullptr);
+    void set_workspace_limit(size_t limit);
+    size_t get_workspace_limit() const;
+    
+    // Graph-private pools. While a stream captures into a pool, pooled
+    // allocations and workspace on that stream come from the pool's own
+    // segments, which no other stream reuses and empty_cache never
+    // releases, so the addresses baked into a graph stay valid for every
+    // replay. Pools are shared by id (create counts as the first retain);
+    // after the last release their segments go back to the driver as they
+    // fall idle. While any capture is underway the allocator issues no
+    // event queries and defers cross-stream frees, which would otherwise
+    // invalidate the capture.
+    uint64_t create_private_pool();
+    bool retain_private_pool(uint64_t pool_id);
+    void release_private_pool(uint64_t pool_id);
+    bool begin_capture_to_pool(uint64_t pool_id, void* stream);
+    void end_capture_to_pool(void* stream);
+    
     // Device memory info
     uint64_t get_total_memory() const;
     uint64_t get_free_memory() const;
     uint64_t get_used_memory() const;
     
 private:
+    struct BlockPool;
+    struct Segment;
+    struct PrivatePool;
+    
     struct Block {
         void* ptr;
         size_t size;
         size_t allocated_size;
         bool in_use;
+        bool pinned_host;
         uint64_t allocation_id;
         void* stream;
+        BlockPool* pool;   // Owning pool, or nullptr for unpooled host/managed memory
+        Segment* segment;  // Backing allocation, or nullptr when unpooled
+        Block* prev;       // Address-adjacent neighbours split from the same segment
+        Block* next;
+        std::vector<void*> stream_uses;  // Extra streams registered via record_stream
+        int event_count;                 // Outstanding free events before reuse
+        const char* tag;                 // From AllocationOptions::tag of the last allocation
     };
     
-    struct CacheBlock {
+    // A single driver allocation that pooled blocks are carved from
+    struct Segment {
         void* ptr;
         size_t size;
+        BlockPool* pool;
         void* stream;
-        uint64_t last_used;
+        uint64_t last_used;    // allocation_counter_ when a block was last freed
+        size_t active_blocks;  // Blocks currently handed out to callers
+        void* idle_event;      // Recorded on stream when the segment went idle
+        bool expandable;       // Reserved address range; size is the mapped prefix
+        size_t reserved_size;
+        std::vector<void*> handles;  // Physical allocation backing each mapped page
+    };
+    
+    // Orders free blocks by stream, size, then address, so lower_bound is the
+    // best fit among blocks owned by the requesting stream
+    struct BlockComparator {
+        bool operator()(const Block* a, const Block* b) const;
+    };
+    using FreeBlockSet = std::set<Block*, BlockComparator>;
+    
+    // Free blocks below kLargeBlockThreshold are binned by power-of-two size
+    // class starting at kMinBinSize; larger ones share a single ordered set.
+    static constexpr size_t kMinBinSize = 256;
+    static constexpr size_t kLargeBlockThreshold = 1024 * 1024;
+    static constexpr size_t kSizeBinCount = 12;
+    
+    // Rounding and segment sizing, after the CUDA caching allocator
+    static constexpr size_t kMinBlockSize = 512;                  // Every block is a multiple of this
+    static constexpr size_t kSmallSize = 1024 * 1024;             // Largest request served by the small pool
+    static constexpr size_t kSmallBuffer = 2 * 1024 * 1024;       // Small pool segment size
+    static constexpr size_t kLargeBuffer = 20 * 1024 * 1024;      // Segment size for requests below kMinLargeAlloc
+    static constexpr size_t kMinLargeAlloc = 10 * 1024 * 1024;    // Larger requests get a dedicated segment
+    static constexpr size_t kRoundLarge = 2 * 1024 * 1024;        // Dedicated segments are rounded to this
+    static constexpr size_t kRoundupPower2Divisions = 4;          // Large request buckets per power of two
+    
+    struct BlockPool {
+        std::array<FreeBlockSet, kSizeBinCount> size_bins;
+        FreeBlockSet large_free_blocks;
+        bool is_small;
+        uint64_t segment_count;
+        uint64_t block_count;
+        PrivatePool* owner;  // Graph pool this belongs to, nullptr for the shared pools
+        
+        explicit BlockPool(bool small, PrivatePool* owner = nullptr)
+            : is_small(small), segment_count(0), block_count(0), owner(owner) {}
+    };
+    
+    // Per-thread front cache of recently freed small-pool blocks. Cached
+    // blocks stay marked in use in the shared pool, so the owning thread can
+    // hand them out again without taking mutex_.
+    struct ThreadCache {
+        std::mutex mutex;            // Only contended by flushes and get_stats
+        std::vector<Block*> blocks;  // Most recently freed last
+        size_t cached_bytes = 0;
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+    };
+    
+    // Live pointers, sharded so deallocate can find its block without mutex_
+    struct LiveBlock {
+        Block* block;
+        bool stream_recorded;  // record_stream was called, so free takes the slow path
+    };
+    struct LiveShard {
+        std::mutex mutex;
+        std::unordered_map<void*, LiveBlock> blocks;
+    };
+    
+    // Fixed-size trace ring. Writers claim a slot with one fetch_add and
+    // publish it through sequence, so snapshot() can skip torn entries.
+    struct TraceSlot {
+        std::atomic<uint64_t> sequence{0};  // Claim index + 1 once written, 0 while writing
+        TraceEntry entry;
+    };
+    static constexpr size_t kTraceCapacity = 16384;  // Power of two
+    
+    struct WorkspaceArena {
+        std::mutex mutex;  // Held by the outstanding Workspace
+        void* ptr = nullptr;
+        size_t size = 0;
+    };
+    
+    struct PrivatePool {
+        explicit PrivatePool(uint64_t id) : id(id), small(true, this), large(false, this) {}
+        
+        uint64_t id;
+        BlockPool small;
+        BlockPool large;
+        int use_count = 1;           // Graphs holding the pool
+        WorkspaceArena workspace;    // Serves captures in place of the stream's arena
+        std::vector<void*> outgrown;  // Arenas replaced mid-capture; captured work still uses them
+        size_t workspace_bytes = 0;   // Of workspace and outgrown
     };
     
+    static constexpr size_t kThreadCacheMaxBlocks = 32;
+    static constexpr size_t kThreadCacheMaxBytes = 4 * 1024 * 1024;
+    static constexpr size_t kLiveShardCount = 16;
+    
+    // Lock-free fast paths
+    ThreadCache* get_thread_cache();
+    void* allocate_from_thread_cache(size_t size, void* stream, const char* tag);
+    bool deallocate_to_thread_cache(Block* block);
+    void flush_thread_caches();
+    LiveShard& live_shard_for(const void* ptr);
+    void register_live_block(Block* block);
+    bool unregister_live_block(void* ptr, LiveBlock& entry);
+    void record_trace(TraceAction action, void* ptr, size_t size, void* stream, const char* tag = nullptr);
+    
     // Block management
-    Block* find_free_block(size_t size);
-    Block* allocate_new_block(size_t size, const AllocationOptions& options);
+    Block* find_free_block(BlockPool& pool, size_t size, void* stream);
+    Block* reuse_idle_segment(BlockPool& pool, size_t size, void* stream);
+    Block* allocate_new_block(BlockPool* pool, size_t size, const AllocationOptions& options);
+    bool should_split(const Block* block, size_t size) const;
     void split_block(Block* block, size_t needed_size);
-    void merge_adjacent_blocks();
+    Block* merge_adjacent_blocks(Block* block);
+    void free_block(Block* block);
+    void release_unpooled_block(Block* block);
     
-    // Cache management
-    void add_to_cache(Block* block);
-    CacheBlock* find_cached_block(size_t size);
-    void evict_from_cache(size_t needed_size);
-    void cleanup_cache();
+    // Cross-stream events
+    void* acquire_event();
+    void release_event(void* event);
+    void insert_events(Block* block);
+    void process_events();
+    void synchronize_and_free_events();
+    
+    // Size policy
+    static size_t round_size(size_t size);
+    static size_t get_allocation_size(size_t size);
+    BlockPool& get_pool(size_t size);
+    
+    // Free block index
+    static size_t size_to_bin(size_t size);
+    static FreeBlockSet& free_set_for(BlockPool& pool, size_t size);
+    void insert_free_block(Block* block);
+    void remove_free_block(Block* block);
+    
+    // Segment management
+    void release_segment(Segment* segment);
+    void free_segment_memory(Segment* segment);
+    size_t release_cached_segments(size_t needed_size);
+    
+    // Expandable segments
+    Segment* create_expandable_segment(void* stream);
+    Block* expand_segment(size_t size, void* stream);
+    Block* get_tail_block(Segment* segment);
+    bool map_segment_pages(Segment* segment, size_t new_size);
+    void unmap_segment_pages(Segment* segment, size_t new_size);
+    size_t trim_segment(Segment* segment);
+    
+    // Workspace arenas
+    void release_workspaces();
+    Workspace acquire_capture_workspace(PrivatePool* pool, size_t size, void* stream);
+    
+    // Graph pools; under mutex_
+    PrivatePool* capture_pool_for(void* stream) const;
+    bool is_capturing(void* stream) const;
+    void release_idle_private_segments(PrivatePool* pool);
     
     std::shared_ptr<DeviceContext> context_;
-    std::vector<std::unique_ptr<Block>> blocks_;
-    std::vector<std::unique_ptr<CacheBlock>> cache_;
+    std::unordered_map<void*, std::unique_ptr<Block>> blocks_;
+    std::unordered_map<void*, std::unique_ptr<Segment>> segments_;
+    BlockPool small_pool_;
+    BlockPool large_pool_;
+    std::deque<std::pair<void*, Block*>> pending_events_;  // FIFO of (hipEvent, block)
+    std::vector<void*> event_pool_;
     mutable std::mutex mutex_;
     
+    const uint64_t allocator_id_;  // Keys thread-local cache lookups; never reused
+    std::vector<std::unique_ptr<ThreadCache>> thread_caches_;
+    std::array<LiveShard, kLiveShardCount> live_shards_;
+    std::unique_ptr<TraceSlot[]> trace_;
+    std::atomic<uint64_t> trace_head_;
+    std::atomic<bool> trace_enabled_;
+    
+    bool expandable_segments_;
+    size_t expandable_page_size_;  // Mapping granularity, queried when enabled
+    std::unordered_map<void*, Segment*> expandable_segments_by_stream_;
+    
+    std::unordered_map<void*, std::unique_ptr<WorkspaceArena>> workspaces_;  // Keyed by stream
+    std::mutex workspace_mutex_;  // Guards workspaces_; never held while taking mutex_
+    std::atomic<size_t> workspace_limit_;
+    std::atomic<uint64_t> workspace_bytes_;
+    std::atomic<uint64_t> workspace_high_water_mark_;
+    
+    std::unordered_map<uint64_t, std::unique_ptr<PrivatePool>> private_pools_;
+    std::unordered_map<void*, PrivatePool*> capture_pools_;  // Capturing stream -> its pool
+    std::atomic<int> captures_underway_;  // Read without mutex_ to keep the fast paths
+    std::vector<Block*> deferred_frees_;  // Freed with stream uses during a capture
+    uint64_t next_pool_id_;
+    
     MemoryStats stats_;
     size_t cache_size_limit_;
-    uint64_t allocation_counter_;
+    std::atomic<uint64_t> allocation_counter_;  // Also bumped by the thread-cache fast path
+};
+
+/**
+ * @brief Caching allocator for page-locked host memory
+ * 
+ * hipHostMalloc is expensive, so released staging buffers are kept in
+ * power-of-two size bins rather than returned to the driver. Every release
+ * records an event on the stream that last used the buffer, and a cached
+ * buffer is only handed out again once that event has completed, so a DMA
+ * still reading from it can never be overwritten.
+ */
+class PinnedHostAllocator {
+public:
+    PinnedHostAllocator();
+    ~PinnedHostAllocator();
+    
+    PinnedHostAllocator(const PinnedHostAllocator&) = delete;
+    PinnedHostAllocator& operator=(const PinnedHostAllocator&) = delete;
+    
+    // Buffers are rounded up to a power of two of at least kMinBufferSize
+    void* allocate(size_t size);
+    
+    // Return a buffer to the cache once work queued on stream has finished with it
+    void deallocate(void* ptr, void* stream = nullptr);
+    
+    void empty_cache();
+    size_t get_allocated_bytes() const;
+    size_t get_cached_bytes() const;
+    
+private:
+    struct Buffer {
+        void* ptr;
+        size_t size;
+        bool in_use;
+        void* event;  // Recorded at release; nullptr once known complete
+    };
+    
+    static constexpr size_t kMinBufferSize = 4096;
+    
+    static size_t round_size(size_t size);
+    void* acquire_event();
+    void release_event(void* event);
+    void release_cached_buffers();
+    
+    std::unordered_map<void*, std::unique_ptr<Buffer>> buffers_;
+    std::map<size_t, std::vector<Buffer*>> free_buffers_;  // Keyed by rounded size
+    std::vector<void*> event_pool_;
+    mutable std::mutex mutex_;
+    
+    size_t allocated_bytes_;
+    size_t cached_bytes_;
 };
 
 /**
@@ -139,14 +544,50 @@ public:
     // Global memory operations
     void* allocate(size_t size, int device_id = -1, const AllocationOptions& options = {});
     void deallocate(void* ptr);
+    void record_stream(void* ptr, void* stream);
     
-    // Memory operations
+    // Memory operations (block until complete, even when a stream is given)
     bool memcpy(void* dst, const void* src, size_t size, void* stream = nullptr);
     bool memset(void* ptr, int value, size_t size, void* stream = nullptr);
     
+    // Non-blocking variants returning a completion event
+    std::shared_ptr<Event> memcpy_async(void* dst, const void* src, size_t size, Stream& stream);
+    std::shared_ptr<Event> memset_async(void* ptr, int value, size_t size, Stream& stream);
+    
+    // Device-to-device copy between GPUs, queued on stream, which must
+    // belong to one of the two devices. Peer access between them is enabled
+    // on first use where the hardware allows it, so the copy goes over the
+    // fabric; otherwise HIP stages it through host memory.
+    std::shared_ptr<Event> peer_memcpy_async(void* dst, int dst_device, const void* src, int src_device,
+                                             size_t size, Stream& stream);
+    
+    // Allocate device memory and queue an upload of host_ptr into it on stream.
+    // Pageable sources are chunked through rotating pinned buffers so copying
+    // one chunk overlaps the DMA of the previous one, and may be reused as
+    // soon as this returns. Pinned sources are DMA'd directly and must not be
+    // modified or freed until the copy completes: record an Event on stream
+    // after this returns and wait on it, or synchronize the stream.
+    void* stage_to_device(const void* host_ptr, size_t size, void* stream = nullptr, int device_id = -1);
+    PinnedHostAllocator& get_pinned_allocator();
+    
+    // Scratch for library calls on stream; see MemoryAllocator::acquire_workspace
+    Workspace acquire_workspace(size_t size, int device_id = -1, void* stream = nullptr);
+    
     // Management
+    void set_expandable_segments(bool enabled);
+    void set_workspace_limit(size_t limit);
+    size_t get_workspace_limit() const;
     void empty_cache(int device_id = -1);
     MemoryStats get_stats(int device_id = -1) const;
+    MemorySnapshot snapshot(int device_id = -1) const;
+    
+    // get_stats for a device that already has an allocator; false, without
+    // creating one, otherwise
+    bool find_stats(int device_id, MemoryStats& stats) const;
+    
+    // MemoryAllocator::read_trace for device_id; nothing before the device
+    // has an allocator
+    uint64_t read_trace(int device_id, uint64_t cursor, std::vector<TraceEntry>& entries) const;
     
     // Device memory info
     uint64_t get_total_memory(int device_id = -1) const;
@@ -157,7 +598,27 @@ private:
     MemoryManager() = default;
     ~MemoryManager() = default;
     
+    static constexpr size_t kStagingChunkSize = 4 * 1024 * 1024;
+    static constexpr size_t kStagingBufferCount = 3;
+    static constexpr int kMaxDevices = 16;
+    static constexpr size_t kPointerShardCount = 16;
+    
+    // Owner of every pointer handed out by allocate(), so deallocate and
+    // record_stream never need a hipPointerGetAttributes query
+    struct PointerShard {
+        std::mutex mutex;
+        std::unordered_map<void*, MemoryAllocator*> owners;
+    };
+    
+    MemoryAllocator* find_allocator(int device_id);
+    PointerShard& pointer_shard_for(const void* ptr);
+    
     std::unordered_map<int, std::shared_ptr<MemoryAllocator>> allocators_;
+    std::array<std::atomic<MemoryAllocator*>, kMaxDevices> device_allocators_{};  // Lock-free view of allocators_
+    std::array<PointerShard, kPointerShardCount> pointer_shards_;
+    PinnedHostAllocator pinned_allocator_;
+    bool expandable_segments_ = false;
+    size_t workspace_limit_ = 256 * 1024 * 1024;
     mutable std::mutex mutex_;
 };
 
@@ -166,11 +627,14 @@ constexpr AllocationOptions DEFAULT_ALLOCATION_OPTIONS = {
     .pinned_host_memory = false,
     .unified_memory = false,
     .managed_memory = false,
-    .alignment = 256
+    .alignment = 256,
+    .stream = nullptr,
+    .tag = nullptr
 };
 
 // Utility functions
 bool is_device_pointer(const void* ptr);
+bool is_pinned_host_pointer(const void* ptr);
 int get_device_for_pointer(const void* ptr);
 size_t get_memory_alignment();
 
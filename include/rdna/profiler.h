@@ -1,42 +1,74 @@
 #ifndef RDNA_PROFILER_H
 #define RDNA_PROFILER_H
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <fstream>
+#include "rdna/kernels.h"
+#include "rdna/memory.h"
 
 namespace rdna {
 
 // Performance event types
-enum class EventType {
+enum class EventType : uint8_t {
     KERNEL_LAUNCH,
     MEMORY_ALLOCATION,
     MEMORY_COPY,
     MEMORY_SET,
     STREAM_SYNCHRONIZE,
-    DEVICE_SYNCHRONIZE
+    DEVICE_SYNCHRONIZE,
+    FRAMEWORK_OP  // PyTorch/TensorFlow operator boundaries
 };
 
-// Performance event record
+// Performance event record. Plain data so recording never allocates;
+// names are interned, resolve them with PerformanceProfiler::get_name.
 struct PerformanceEvent {
-    EventType type;
-    std::string name;
-    std::chrono::high_resolution_clock::time_point start_time;
-    std::chrono::high_resolution_clock::time_point end_time;
-    size_t bytes_processed;
-    int device_id;
+    uint64_t start_ns;  // steady_clock
+    uint64_t end_ns;
+    uint64_t bytes_processed;
     void* stream;
-    std::string additional_info;
+    uint32_t name_id;
+    uint32_t info_id;  // 0 when there is none
+    int32_t device_id;
+    uint32_t thread_id;  // Profiler-assigned, dense from 0
+    EventType type;
+    bool device_timed;  // Times are the GPU's, from HIP events
     
     double duration_ms() const {
-        return std::chrono::duration_cast<std::chrono::microseconds>(
-            end_time - start_time).count() / 1000.0;
+        return (end_ns - start_ns) / 1e6;
     }
 };
 
+// Correlates an end with its start. Carries everything the record needs,
+// so ending an event touches no shared state and may happen on any thread.
+struct EventHandle {
+    uint64_t start_ns = 0;
+    uint64_t bytes = 0;
+    uint32_t name_id = 0;
+    uint32_t info_id = 0;
+    EventType type = EventType::KERNEL_LAUNCH;
+    bool active = false;  // False when profiling was off at start
+};
+
+// Start of a device-timed event: a pooled HIP event recorded on stream
+struct DeviceEventHandle {
+    void* start = nullptr;  // hipEvent_t
+    void* stream = nullptr;
+    uint64_t bytes = 0;
+    uint32_t name_id = 0;
+    uint32_t info_id = 0;
+    int32_t device_id = -1;
+    EventType type = EventType::KERNEL_LAUNCH;
+    bool active = false;
+};
+
 // Performance statistics
 struct PerformanceStats {
     double total_time_ms;
@@ -46,6 +78,58 @@ struct PerformanceStats {
     size_t call_count;
     size_t total_bytes_processed;
     double throughput_gbps;
+    double bandwidth_gbs;  // Achieved GB/s over the total time
+    
+    // Latency percentiles, within the histogram's ~3% bucket error
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double p999_ms;
+};
+
+/**
+ * @brief Log-linear latency histogram in nanoseconds
+ *
+ * Each power of two is split into 32 linear buckets, so any percentile is
+ * within ~3% of the exact value; values from 1 ns up to 2^40 ns (~18 min),
+ * larger ones land in the last bucket. Histograms merge by adding counts.
+ */
+struct LatencyHistogram {
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kMaxExponent = 40;
+    static constexpr size_t kBucketCount = size_t(kMaxExponent - kSubBucketBits + 1) << kSubBucketBits;
+    
+    std::vector<uint64_t> counts;  // kBucketCount entries, empty until something is merged in
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+    uint64_t min_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t bytes = 0;
+    
+    static size_t bucket_index(uint64_t value_ns);
+    static uint64_t bucket_value(size_t index);  // Midpoint of the bucket
+    
+    void merge(const LatencyHistogram& other);
+    uint64_t percentile_ns(double quantile) const;  // quantile in [0, 1]
+};
+
+// One operation's latency distribution since the last clear_events
+struct OpMetrics {
+    EventType type;
+    std::string name;
+    LatencyHistogram latency;
+};
+
+struct DeviceMemoryMetrics {
+    int device_id;
+    MemoryStats stats;
+};
+
+// Point-in-time view for scraping; taking one blocks no recording thread
+struct MetricsSnapshot {
+    uint64_t timestamp_ns;  // steady_clock
+    std::vector<OpMetrics> ops;
+    std::vector<DeviceMemoryMetrics> memory;  // Devices that have an allocator
 };
 
 // Profiler configuration
@@ -53,17 +137,38 @@ struct ProfilerConfig {
     bool enable_timing;
     bool enable_memory_tracking;
     bool enable_kernel_tracking;
-    size_t max_events;
-    std::string output_file;
+    bool enable_device_timing;  // HIP event pairs around kernels and copies
+    size_t max_events;  // Per recording thread, rounded up to a power of two
+    std::string output_file;  // Default start_trace path
     
     ProfilerConfig() 
         : enable_timing(true),
           enable_memory_tracking(true),
           enable_kernel_tracking(true),
+          enable_device_timing(false),
           max_events(10000) {}
 };
 
-// Performance profiler
+/**
+ * @brief Performance profiler
+ * 
+ * Each recording thread appends to its own fixed-size ring of
+ * PerformanceEvent records, so recording takes no lock and never shifts
+ * or allocates once the thread's ring exists; when a ring is full the
+ * oldest records are overwritten. Statistics, reports and get_events
+ * gather the rings at read time.
+ *
+ * With enable_device_timing, kernels and copies are bracketed by HIP
+ * events from a per-device pool. A collector thread resolves them once
+ * they complete and records the GPU start and end, mapped onto the host
+ * steady_clock through a periodically re-anchored reference event, so
+ * durations and bandwidth are the real on-device ones.
+ *
+ * Every record also lands in a per-operation latency histogram owned by
+ * the recording thread, so statistics and metrics cover everything since
+ * the last clear_events, not just what the rings still hold, and reading
+ * them never scans the rings or stalls a recorder.
+ */
 class PerformanceProfiler {
 public:
     static PerformanceProfiler& get_instance();
@@ -72,45 +177,145 @@ public:
     void set_config(const ProfilerConfig& config);
     ProfilerConfig get_config() const;
     
+    // Name interning; id 0 is the empty string. Interning a name already
+    // seen on this thread takes no lock.
+    uint32_t intern(const std::string& name);
+    std::string get_name(uint32_t id) const;
+    
     // Event recording
-    void start_event(EventType type, const std::string& name, 
-                     size_t bytes = 0, const std::string& info = "");
-    void end_event(EventType type, const std::string& name);
+    EventHandle start_event(EventType type, const std::string& name, 
+                            size_t bytes = 0, const std::string& info = "");
+    EventHandle start_event(EventType type, uint32_t name_id, size_t bytes = 0, uint32_t info_id = 0);
+    void end_event(const EventHandle& handle, void* stream = nullptr);
+    
+    // Device timing; end queues the pair for the collector and returns at
+    // once. start returns an inactive handle when device timing is off.
+    DeviceEventHandle start_device_event(EventType type, uint32_t name_id, int device_id, void* stream,
+                                         size_t bytes = 0, uint32_t info_id = 0);
+    void end_device_event(const DeviceEventHandle& handle);
+    bool is_device_timing_enabled() const { return device_timing_enabled_.load(std::memory_order_relaxed); }
+    
+    // Block until every device event ended so far has been recorded
+    void flush_device_events();
+    
+    // Scoped recording without a handle: pop_event ends this thread's
+    // innermost pushed event named name
+    void push_event(EventType type, const std::string& name);
+    void pop_event(EventType type, const std::string& name);
     
     // Memory tracking
     void record_memory_allocation(size_t size, void* ptr, int device_id);
     void record_memory_deallocation(void* ptr);
     void record_memory_copy(size_t size, void* src, void* dst, int device_id);
     
-    // Kernel tracking
+    // Host-side markers; on-GPU durations come from device timing
     void record_kernel_launch(const std::string& kernel_name, 
                               size_t grid_size[3], size_t block_size[3],
                               size_t shared_memory, int device_id);
     
-    // Statistics
+    // Statistics, from the histograms; an empty name covers every
+    // operation of type, get_all_stats merges types per name
     PerformanceStats get_stats(EventType type, const std::string& name = "") const;
     std::unordered_map<std::string, PerformanceStats> get_all_stats() const;
     
+    // Metrics export. collect_metrics is the pull API; format_prometheus
+    // renders a snapshot in the Prometheus text exposition format (latency
+    // as summaries with p50/p90/p99/p999 quantiles, allocator counters as
+    // gauges and counters per device). The metrics server answers every
+    // HTTP GET on address:port with that text from a background thread;
+    // false if it is already running or the port cannot be bound.
+    MetricsSnapshot collect_metrics() const;
+    static std::string format_prometheus(const MetricsSnapshot& snapshot);
+    bool start_metrics_server(int port, const std::string& address = "127.0.0.1");
+    void stop_metrics_server();
+    std::vector<PerformanceEvent> get_events() const;  // Every retained record, by start time
+    
     // Reporting
     void generate_report(const std::string& filename = "");
     void print_summary();
     void clear_events();
     
+    // Timeline export. Streams Chrome trace JSON (array form, which
+    // chrome://tracing and Perfetto load even if the file was never closed)
+    // to path, or output_file when empty, appending what was recorded since
+    // the last flush every flush_interval_ms until stop_trace. Lanes: host
+    // calls per thread, framework ops per thread, and per device one lane
+    // per stream for timed kernels and copies plus one for allocator
+    // events. False if a trace is already running or path cannot be opened.
+    bool start_trace(const std::string& path = "", int flush_interval_ms = 100);
+    void stop_trace();
+    bool is_tracing() const;
+    
     // Utility functions
-    bool is_enabled() const { return config_.enable_timing; }
-    size_t get_event_count() const { return events_.size(); }
+    bool is_enabled() const { return timing_enabled_.load(std::memory_order_relaxed); }
+    size_t get_event_count() const;
     
 private:
-    PerformanceProfiler() = default;
-    ~PerformanceProfiler() = default;
+    PerformanceProfiler();
+    ~PerformanceProfiler();
+    
+    // Single-writer ring owned by one thread at a time. Slots are published
+    // through sequence like the allocator trace, so readers skip torn ones.
+    struct EventSlot {
+        std::atomic<uint64_t> sequence{0};  // Index + 1 once written, 0 while writing
+        PerformanceEvent event;
+    };
+    struct OpHistogram;  // Atomic counterpart of LatencyHistogram
+    struct EventRing {
+        explicit EventRing(size_t capacity, uint32_t thread_id);
+        ~EventRing();
+        
+        std::unique_ptr<EventSlot[]> slots;
+        size_t mask;
+        uint32_t thread_id;
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> floor{0};  // Records before this were cleared
+        std::atomic<bool> owned{true};  // Released at thread exit for reuse
+        
+        // Keyed by type and name id. Only the owner inserts, under the
+        // mutex; its own lookups take none.
+        mutable std::mutex histograms_mutex;
+        std::unordered_map<uint64_t, std::unique_ptr<OpHistogram>> histograms;
+    };
+    
+    EventRing* thread_ring();
+    void release_ring(EventRing* ring);
+    void append(const PerformanceEvent& event);  // Keeps event.thread_id
+    // Visits retained records. With cursors (one per ring, grown as needed)
+    // only records past each cursor are visited and the cursors advance;
+    // records overwritten before being reached are counted in dropped.
+    template <typename F>
+    void for_each_event(F&& f, std::vector<uint64_t>* cursors = nullptr, uint64_t* dropped = nullptr) const;
+    // Merged histograms per (type, name id) across rings
+    std::unordered_map<uint64_t, LatencyHistogram> merged_histograms() const;
     
     ProfilerConfig config_;
-    std::vector<PerformanceEvent> events_;
-    std::unordered_map<void*, size_t> memory_allocations_;
-    mutable std::mutex mutex_;
+    std::atomic<bool> timing_enabled_;
+    std::atomic<bool> memory_tracking_enabled_;
+    std::atomic<bool> kernel_tracking_enabled_;
+    std::atomic<bool> device_timing_enabled_;
+    std::atomic<size_t> ring_capacity_;
+    
+    mutable std::mutex rings_mutex_;  // Ring registration and reads only
+    std::vector<std::unique_ptr<EventRing>> rings_;
+    
+    mutable std::mutex names_mutex_;
+    std::unordered_map<std::string, uint32_t> name_ids_;
+    std::vector<std::string> names_;
+    
+    struct DeviceTiming;  // Event pools and the collector thread
+    std::unique_ptr<DeviceTiming> device_timing_;
+    
+    struct TraceWriter;  // Output file and the thread streaming into it
+    std::unique_ptr<TraceWriter> trace_writer_;
+    mutable std::mutex trace_mutex_;  // Starting and stopping traces
     
-    // Current event tracking
-    std::unordered_map<std::string, PerformanceEvent> active_events_;
+    struct MetricsServer;  // Listening socket and its thread
+    std::unique_ptr<MetricsServer> metrics_server_;
+    mutable std::mutex metrics_mutex_;
+    
+    std::unordered_map<void*, size_t> memory_allocations_;
+    mutable std::mutex mutex_;  // Config and memory_allocations_
 };
 
 // Automatic event timing (RAII)
@@ -118,32 +323,66 @@ class ScopedEvent {
 public:
     ScopedEvent(EventType type, const std::string& name, 
                 size_t bytes = 0, const std::string& info = "")
-        : type_(type), name_(name) {
-        PerformanceProfiler::get_instance().start_event(type, name, bytes, info);
-    }
+        : handle_(PerformanceProfiler::get_instance().start_event(type, name, bytes, info)) {}
+    
+    ScopedEvent(EventType type, uint32_t name_id, size_t bytes = 0)
+        : handle_(PerformanceProfiler::get_instance().start_event(type, name_id, bytes)) {}
     
     ~ScopedEvent() {
-        PerformanceProfiler::get_instance().end_event(type_, name_);
+        PerformanceProfiler::get_instance().end_event(handle_);
     }
     
+    ScopedEvent(const ScopedEvent&) = delete;
+    ScopedEvent& operator=(const ScopedEvent&) = delete;
+    
 private:
-    EventType type_;
-    std::string name_;
+    EventHandle handle_;
+};
+
+// Device-timed scope around work queued on stream; free when device
+// timing is off
+class ScopedDeviceEvent {
+public:
+    ScopedDeviceEvent(EventType type, const char* name, int device_id, void* stream, size_t bytes = 0) {
+        PerformanceProfiler& profiler = PerformanceProfiler::get_instance();
+        if (profiler.is_device_timing_enabled()) {
+            handle_ = profiler.start_device_event(type, profiler.intern(name), device_id, stream, bytes);
+        }
+    }
+    
+    ~ScopedDeviceEvent() {
+        if (handle_.active) {
+            PerformanceProfiler::get_instance().end_device_event(handle_);
+        }
+    }
+    
+    ScopedDeviceEvent(const ScopedDeviceEvent&) = delete;
+    ScopedDeviceEvent& operator=(const ScopedDeviceEvent&) = delete;
+    
+private:
+    DeviceEventHandle handle_;
 };
 
 // Convenience macros for profiling
+#define RDNA_PROFILE_CONCAT_IMPL(a, b) a##b
+#define RDNA_PROFILE_CONCAT(a, b) RDNA_PROFILE_CONCAT_IMPL(a, b)
+
 #ifdef RDNA_PROFILING_ENABLED
     #define RDNA_PROFILE_SCOPE(name) \
-        rdna::ScopedEvent scoped_event_##__LINE__(rdna::EventType::KERNEL_LAUNCH, name)
+        rdna::ScopedEvent RDNA_PROFILE_CONCAT(scoped_event_, __LINE__)(rdna::EventType::KERNEL_LAUNCH, name)
     
+    // Interns the function name once per call site
     #define RDNA_PROFILE_FUNCTION() \
-        RDNA_PROFILE_SCOPE(__FUNCTION__)
+        static const uint32_t RDNA_PROFILE_CONCAT(profile_name_, __LINE__) = \
+            rdna::PerformanceProfiler::get_instance().intern(__FUNCTION__); \
+        rdna::ScopedEvent RDNA_PROFILE_CONCAT(scoped_event_, __LINE__)( \
+            rdna::EventType::KERNEL_LAUNCH, RDNA_PROFILE_CONCAT(profile_name_, __LINE__))
     
     #define RDNA_PROFILE_START(event_type, name) \
-        rdna::PerformanceProfiler::get_instance().start_event(event_type, name)
+        rdna::PerformanceProfiler::get_instance().push_event(event_type, name)
     
     #define RDNA_PROFILE_END(event_type, name) \
-        rdna::PerformanceProfiler::get_instance().end_event(event_type, name)
+        rdna::PerformanceProfiler::get_instance().pop_event(event_type, name)
     
     #define RDNA_PROFILE_MEMORY_ALLOC(size, ptr, device) \
         rdna::PerformanceProfiler::get_instance().record_memory_allocation(size, ptr, device)
@@ -159,12 +398,67 @@ private:
     #define RDNA_PROFILE_MEMORY_FREE(ptr)
 #endif
 
-// Performance optimization utilities
+// One way of running an operation, timed by the autotuner. launch issues
+// the work once on stream and returns false if this candidate cannot run
+// the problem; it may overwrite its outputs.
+struct TuningCandidate {
+    std::string name;
+    KernelConfig config;
+    std::function<bool(void* stream)> launch;
+};
+
+struct TuningResult {
+    std::string algorithm;
+    KernelConfig config;
+    double time_ms;
+    
+    TuningResult();
+};
+
+/**
+ * @brief Shape-keyed autotuner
+ * 
+ * Candidates for an (op, shape bucket, dtype, arch) key are timed on the
+ * device with HIP events and the fastest is kept: its name in
+ * algorithm_cache_, its launch configuration in optimal_configs_. Shapes
+ * are bucketed to three significant bits, so nearby sizes share a result.
+ * Results persist in a versioned text file, read at startup from
+ * RDNA_TUNING_FILE or ~/.cache/rdna/tuning.txt, which rdna-tune fills
+ * offline.
+ */
 class PerformanceOptimizer {
 public:
     static PerformanceOptimizer& get_instance();
     
-    // Kernel optimization
+    static constexpr int kTuningFileVersion = 1;
+    
+    // Tuning keys
+    static std::vector<size_t> bucket_shape(const std::vector<size_t>& shape);
+    static std::string make_tuning_key(const std::string& op, const std::vector<size_t>& shape,
+                                       int data_type, const std::string& arch);
+    
+    // Time every candidate on device_id and record the fastest under key.
+    // Returns false if no candidate ran.
+    bool tune(const std::string& key, const std::vector<TuningCandidate>& candidates,
+              int device_id, void* stream = nullptr, TuningResult* result = nullptr);
+    bool lookup(const std::string& key, TuningResult& result) const;
+    void record(const std::string& key, const TuningResult& result);
+    size_t get_tuned_count() const;
+    void clear_tuning();
+    
+    // Launches per candidate: untimed warmup, then timed iterations averaged
+    void set_tuning_iterations(int warmup, int iterations);
+    
+    // Persistence; an empty path means the tuning file path. Loading merges,
+    // keeping the faster entry for keys already present.
+    bool load_tuning_file(const std::string& path = "");
+    bool save_tuning_file(const std::string& path = "") const;
+    void set_tuning_file_path(const std::string& path);
+    std::string get_tuning_file_path() const;
+    
+    // Kernel optimization: applies the tuned block size for kernel_name on
+    // this device's arch, else keeps the caller's; grid_size goes from
+    // problem extents to block counts either way
     void optimize_kernel_config(const std::string& kernel_name,
                                size_t* grid_size, size_t* block_size,
                                size_t* shared_memory, int device_id);
@@ -173,7 +467,8 @@ public:
     void suggest_memory_layout(const std::vector<size_t>& shape,
                               std::vector<size_t>* optimal_strides);
     
-    // Algorithm selection
+    // Algorithm selection: the tuned winner for operation_type if it is
+    // available, else the first available algorithm
     std::string select_best_algorithm(const std::string& operation_type,
                                      const std::vector<std::string>& available_algorithms,
                                      int device_id);
@@ -181,42 +476,135 @@ public:
     // Cache optimization
     void optimize_cache_behavior(size_t working_set_size, int device_id);
     
-    // Performance tuning
-    void tune_parameters(const std::string& operation_type, int device_id);
+    // Tune the built-in shape set for operation_type ("matmul",
+    // "convolution" or "all") on device_id; used by rdna-tune. progress is
+    // called once per problem with its description and whether it tuned.
+    using TuningProgress = std::function<void(const std::string& problem, bool tuned)>;
+    void tune_parameters(const std::string& operation_type, int device_id,
+                         const TuningProgress& progress = nullptr);
     
 private:
-    PerformanceOptimizer() = default;
+    PerformanceOptimizer();
     ~PerformanceOptimizer() = default;
     
-    std::unordered_map<std::string, std::unordered_map<int, std::string>> algorithm_cache_;
-    std::unordered_map<std::string, std::unordered_map<int, size_t>> optimal_configs_;
+    std::string get_arch(int device_id);
+    bool load_locked(const std::string& path);
+    
+    std::unordered_map<std::string, std::string> algorithm_cache_;  // Key -> winning algorithm
+    std::unordered_map<std::string, KernelConfig> optimal_configs_;  // Key -> its launch config
+    std::unordered_map<std::string, double> tuned_times_;  // Key -> its time in ms
+    std::unordered_map<int, std::string> device_arch_;
+    std::string tuning_file_path_;
+    int warmup_iterations_;
+    int timed_iterations_;
+    std::atomic<size_t> tuned_count_;  // Lets untuned callers skip the lock
+    mutable std::mutex mutex_;
+};
+
+// One benchmark's summary over its repetitions
+struct BenchmarkResult {
+    std::string name;      // Unique within a run, e.g. "gemm_fp16_4096x4096x4096"
+    std::string category;  // bandwidth, latency, gemm, conv, allocator, roofline
+    std::string unit;      // Of value: GB/s, us, TFLOPS, Mops/s
+    std::string arch;      // Device the result was measured on
+    double value;          // Mean over repetitions
+    double ci95;           // Half-width of the 95% confidence interval of the mean
+    double min_value;
+    double max_value;
+    double time_ms;        // Mean time per operation
+    double intensity;      // FLOP per byte for roofline points, 0 when not meaningful
+    int repetitions;
+    bool lower_is_better;  // Latencies; throughputs are higher-is-better
+    
+    BenchmarkResult();
+};
+
+struct BenchmarkOptions {
+    int warmup;       // Untimed runs before the first repetition
+    int repetitions;  // Timed samples per benchmark
+    bool quick;       // Smaller sweeps, for CI smoke runs
+    
+    BenchmarkOptions() : warmup(3), repetitions(20), quick(false) {}
+};
+
+enum class CopyKind {
+    DeviceToDevice,
+    HostToDevice,        // Pageable host memory
+    DeviceToHost,
+    PinnedToDevice,      // Page-locked host memory from the pinned allocator
+    DeviceToPinned
 };
 
-// Benchmarking utilities
+/**
+ * @brief Device benchmark suite
+ * 
+ * Every benchmark runs its warmup, then times each repetition separately
+ * (HIP events on a private stream for device work, steady_clock for host
+ * work such as launch overhead and the allocator) and records a
+ * BenchmarkResult with the mean and a Student-t 95% confidence interval.
+ * Individual benchmarks return the recorded value. Results accumulate
+ * until clear_results, save as JSON and can be checked against a saved
+ * baseline; rdna-bench drives the whole suite from the command line.
+ */
 class BenchmarkRunner {
 public:
     static BenchmarkRunner& get_instance();
     
-    // Run benchmark suite
-    void run_benchmarks(int device_id);
+    void set_options(const BenchmarkOptions& options);
+    BenchmarkOptions get_options() const;
     
-    // Individual benchmarks
-    double benchmark_memory_bandwidth(int device_id, size_t size);
-    double benchmark_kernel_latency(const std::string& kernel_name, int device_id);
-    double benchmark_matrix_multiply(int m, int n, int k, int device_id);
+    // Run the suite, or only the listed categories, on device_id
+    void run_benchmarks(int device_id, const std::vector<std::string>& categories = {});
+    
+    // Bandwidth in GB/s; device-to-device counts the read and the write
+    double benchmark_memory_bandwidth(int device_id, size_t size);  // Device to device
+    double benchmark_copy_bandwidth(CopyKind kind, size_t size, int device_id);
+    
+    // Empty-kernel round trip (launch and wait) in microseconds; also
+    // records the host cost of queueing one launch
+    double benchmark_kernel_latency(int device_id);
+    
+    // Achieved TFLOPS, through the same kernels the framework dispatches to.
+    // Convolution is NCHW, stride 1, same padding.
+    double benchmark_matrix_multiply(int m, int n, int k, int device_id, int data_type = 0);
     double benchmark_convolution(int batch, int height, int width, int channels,
-                                int filters, int kernel_size, int device_id);
+                                int filters, int kernel_size, int device_id, int data_type = 0);
+    
+    // Allocate/free pairs per second, in millions, across threads
+    double benchmark_allocator(int threads, size_t size, int device_id);
+    
+    // Roofline points in GB/s: c = a + b, and a full sum
+    double benchmark_elementwise(size_t elements, int data_type, int device_id);
+    double benchmark_reduction(size_t elements, int data_type, int device_id);
+    
+    // Results
+    std::vector<BenchmarkResult> get_results() const;
+    void clear_results();
+    bool save_results(const std::string& filename) const;
+    static bool load_results(const std::string& filename, std::vector<BenchmarkResult>& results);
     
     // Compare against baseline
     void compare_with_baseline(const std::string& operation, double rdna_time,
                               double baseline_time, const std::string& baseline_name);
     
+    // Compare every result against the same-named one in a save_results
+    // file. A result regresses when it is worse by more than tolerance
+    // (relative) and by more than the two confidence intervals combined.
+    // Returns the number of regressions, or -1 if the file cannot be read.
+    int compare_with_baseline(const std::string& baseline_file, double tolerance = 0.05) const;
+    
     // Generate performance report
     void generate_benchmark_report(const std::string& filename);
     
 private:
     BenchmarkRunner() = default;
     ~BenchmarkRunner() = default;
+    
+    void record(const BenchmarkResult& result);
+    
+    BenchmarkOptions options_;
+    std::vector<BenchmarkResult> results_;
+    mutable std::mutex mutex_;
 };
 
 } // namespace rdna
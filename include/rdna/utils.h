@@ -37,10 +37,13 @@ std::string get_build_info();
 
 // Configuration structure
 struct LibraryConfig {
-    bool enable_debug_logging;
-    bool enable_profiling;
-    size_t memory_cache_limit;
-    bool use_unified_memory;
+    bool enable_debug_logging = false;
+    bool enable_profiling = false;
+    size_t memory_cache_limit = 1024 * 1024 * 1024; // 1GB
+    bool use_unified_memory = false;
+    bool expandable_segments = false; // Grow the large pool by mapping pages into reserved address space
+    size_t workspace_limit = 256 * 1024 * 1024; // Per-stream cap on rocBLAS/MIOpen scratch
+    bool deterministic = false; // Fixed-order reductions, bitwise reproducible run to run
 };
 
 // Configuration management
@@ -105,6 +105,73 @@ class tf_device:
     def __exit__(self, *args):
         set_device(self.prev_device)
 
+# Stream selection (torch.cuda.stream-style)
+class stream:
+    """Context manager making a stream current on its device.
+    
+    Kernels and allocations issued without an explicit stream on this
+    thread are queued to it, so work under different streams can overlap.
+    Streams from DeviceContext.get_stream_from_pool are cheap to take.
+    
+    Args:
+        stream (Stream): Stream to make current; None leaves it unchanged
+    """
+    
+    def __init__(self, stream):
+        self.stream = stream
+        self.prev_stream = None
+    
+    def __enter__(self):
+        if self.stream is not None:
+            manager = DeviceManager.get_instance()
+            device_id = self.stream.get_context().get_device_id()
+            self.prev_stream = manager.get_current_stream(device_id)
+            manager.set_current_stream(self.stream)
+        return self
+    
+    def __exit__(self, *args):
+        if self.stream is not None:
+            device_id = self.stream.get_context().get_device_id()
+            DeviceManager.get_instance().set_current_stream(self.prev_stream, device_id)
+
+# Graph capture (torch.cuda.graph-style)
+class graph:
+    """Context manager that captures the work queued on a stream into a Graph.
+    
+    Allocations made on the stream inside the block come from a private
+    pool, so the tensors it creates stay valid for every replay. Pass
+    pool=other.get_pool_id() to share memory with a graph that is never
+    replayed concurrently with this one.
+    
+    Args:
+        stream (Stream): Non-default stream to capture on
+        pool (int, optional): Private pool to capture into. Defaults to a new one.
+    """
+    
+    def __init__(self, stream, pool=0):
+        self.stream = stream
+        self.pool = pool
+        self.graph = None
+        self._stream_context = None
+    
+    def __enter__(self):
+        if not self.stream.begin_capture(self.pool):
+            raise RuntimeError("Failed to begin graph capture")
+        self._stream_context = stream(self.stream)
+        self._stream_context.__enter__()
+        return self
+    
+    def __exit__(self, exc_type, *args):
+        self._stream_context.__exit__()
+        self.graph = self.stream.end_capture()
+        if self.graph is None and exc_type is None:
+            raise RuntimeError("Graph capture failed")
+        return False
+    
+    def replay(self):
+        """Replay the captured graph on the capture stream."""
+        return self.graph.replay(self.stream)
+
 # Convenience functions for PyTorch users
 def is_rdna_available():
     """Check if RDNA is available (PyTorch-compatible)."""
@@ -169,6 +236,9 @@ __all__ = [
     'set_device',
     'device',
     'tf_device',
+    'stream',
+    'graph',
+    'from_dlpack',
     'is_rdna_available',
     'rdna_device_count',
     'empty_cache',
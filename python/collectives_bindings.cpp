@@ -0,0 +1,103 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "rdna/collectives.h"
+#include "rdna/device.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace py = pybind11;
+using namespace rdna;
+
+namespace {
+
+// Buffers cross the binding as integer addresses, one per rank, as
+// returned by e.g. DeviceTensor.data_ptr or torch.Tensor.data_ptr()
+template <typename T>
+std::vector<T*> to_pointers(const std::vector<uintptr_t>& addresses) {
+    std::vector<T*> pointers;
+    pointers.reserve(addresses.size());
+    for (uintptr_t address : addresses) {
+        pointers.push_back(reinterpret_cast<T*>(address));
+    }
+    return pointers;
+}
+
+std::vector<Stream*> to_streams(const std::vector<std::shared_ptr<Stream>>& streams) {
+    std::vector<Stream*> pointers;
+    pointers.reserve(streams.size());
+    for (const auto& stream : streams) {
+        pointers.push_back(stream.get());
+    }
+    return pointers;
+}
+
+using StreamList = std::vector<std::shared_ptr<Stream>>;
+
+} // namespace
+
+void bind_collectives(py::module& m) {
+    // CollectiveConfig binding
+    py::class_<CollectiveConfig>(m, "CollectiveConfig")
+        .def(py::init<>())
+        .def_readwrite("bucket_size", &CollectiveConfig::bucket_size)
+        .def_readwrite("average", &CollectiveConfig::average)
+        .def_readwrite("use_rccl", &CollectiveConfig::use_rccl);
+
+    // Communicator binding
+    py::class_<Communicator, std::shared_ptr<Communicator>>(m, "Communicator")
+        .def(py::init<const std::vector<int>&, const CollectiveConfig&>(),
+             py::arg("device_ids"), py::arg("config") = CollectiveConfig())
+        .def("initialize", &Communicator::initialize)
+        .def("is_initialized", &Communicator::is_initialized)
+        .def("size", &Communicator::size)
+        .def("get_device_ids", &Communicator::get_device_ids)
+        .def("get_config", &Communicator::get_config)
+        .def("uses_rccl", &Communicator::uses_rccl)
+        .def("all_reduce", [](Communicator& self, const std::vector<uintptr_t>& buffers, size_t count,
+                              int data_type, const StreamList& streams) {
+                 return self.all_reduce(to_pointers<void>(buffers), count, data_type, to_streams(streams));
+             },
+             py::arg("buffers"), py::arg("count"), py::arg("data_type") = 0, py::arg("streams") = StreamList())
+        .def("all_gather", [](Communicator& self, const std::vector<uintptr_t>& send,
+                              const std::vector<uintptr_t>& recv, size_t count, int data_type,
+                              const StreamList& streams) {
+                 return self.all_gather(to_pointers<const void>(send), to_pointers<void>(recv),
+                                        count, data_type, to_streams(streams));
+             },
+             py::arg("send"), py::arg("recv"), py::arg("count"), py::arg("data_type") = 0,
+             py::arg("streams") = StreamList())
+        .def("reduce_scatter", [](Communicator& self, const std::vector<uintptr_t>& send,
+                                  const std::vector<uintptr_t>& recv, size_t count, int data_type,
+                                  const StreamList& streams) {
+                 return self.reduce_scatter(to_pointers<const void>(send), to_pointers<void>(recv),
+                                            count, data_type, to_streams(streams));
+             },
+             py::arg("send"), py::arg("recv"), py::arg("count"), py::arg("data_type") = 0,
+             py::arg("streams") = StreamList())
+        .def("wait", [](Communicator& self, const StreamList& streams) {
+                 self.wait(to_streams(streams));
+             },
+             py::arg("streams") = StreamList())
+        .def("synchronize", &Communicator::synchronize)
+        .def("get_stream", &Communicator::get_stream);
+
+    // GradientBuckets binding
+    py::class_<GradientBuckets>(m, "GradientBuckets")
+        .def(py::init<std::shared_ptr<Communicator>, int>(),
+             py::arg("communicator"), py::arg("data_type") = 0)
+        .def("add_gradient", [](GradientBuckets& self, const std::vector<uintptr_t>& buffers, size_t count) {
+                 return self.add_gradient(to_pointers<void>(buffers), count);
+             })
+        .def("finalize", &GradientBuckets::finalize)
+        .def("mark_ready", [](GradientBuckets& self, size_t index, const StreamList& streams) {
+                 return self.mark_ready(index, to_streams(streams));
+             },
+             py::arg("index"), py::arg("streams") = StreamList())
+        .def("wait", [](GradientBuckets& self, const StreamList& streams) {
+                 return self.wait(to_streams(streams));
+             },
+             py::arg("streams") = StreamList())
+        .def("bucket_count", &GradientBuckets::bucket_count);
+}
@@ -17,6 +17,7 @@ void bind_device(py::module& m) {
         .def_readonly("compute_units", &DeviceProperties::compute_units)
         .def_readonly("max_workgroup_size", &DeviceProperties::max_workgroup_size)
         .def_readonly("wavefront_size", &DeviceProperties::wavefront_size)
+        .def_readonly("shared_memory_per_block", &DeviceProperties::shared_memory_per_block)
         .def_readonly("supports_fp16", &DeviceProperties::supports_fp16)
         .def_readonly("supports_bf16", &DeviceProperties::supports_bf16)
         .def_readonly("supports_tensor_cores", &DeviceProperties::supports_tensor_cores)
@@ -27,6 +28,10 @@ void bind_device(py::module& m) {
                    " name='" + props.name + "'>";
         });
 
+    py::enum_<StreamPriority>(m, "StreamPriority")
+        .value("LOW", StreamPriority::LOW)
+        .value("HIGH", StreamPriority::HIGH);
+
     // DeviceManager binding
     py::class_<DeviceManager>(m, "DeviceManager")
         .def_static("get_instance", &DeviceManager::get_instance, 
@@ -34,21 +39,57 @@ void bind_device(py::module& m) {
         .def("device_count", &DeviceManager::device_count)
         .def("get_device_properties", &DeviceManager::get_device_properties)
         .def("get_all_device_properties", &DeviceManager::get_all_device_properties)
+        .def("get_context", &DeviceManager::get_context, py::arg("device_id") = -1)
         .def("create_context", &DeviceManager::create_context)
         .def("get_current_context", &DeviceManager::get_current_context)
         .def("set_current_context", &DeviceManager::set_current_context)
+        .def("get_current_device", &DeviceManager::get_current_device)
+        .def("set_current_device", &DeviceManager::set_current_device)
+        .def("get_current_stream", &DeviceManager::get_current_stream, py::arg("device_id") = -1)
+        .def("set_current_stream", &DeviceManager::set_current_stream,
+             py::arg("stream"), py::arg("device_id") = -1)
+        .def("can_access_peer", &DeviceManager::can_access_peer)
+        .def("enable_peer_access", &DeviceManager::enable_peer_access)
+        .def("is_peer_access_enabled", &DeviceManager::is_peer_access_enabled)
+        .def("enable_all_peer_access", &DeviceManager::enable_all_peer_access)
         .def("check_device_compatibility", &DeviceManager::check_device_compatibility)
         .def("get_last_error", &DeviceManager::get_last_error);
 
     // Stream binding
     py::class_<Stream, std::shared_ptr<Stream>>(m, "Stream")
         .def(py::init<std::shared_ptr<DeviceContext>>())
-        .def("initialize", &Stream::initialize)
+        .def("initialize", &Stream::initialize, py::arg("priority") = StreamPriority::LOW)
         .def("synchronize", &Stream::synchronize)
         .def("is_valid", &Stream::is_valid)
         .def("get_native_handle", &Stream::get_native_handle)
+        .def("get_context", &Stream::get_context)
+        .def("get_priority", &Stream::get_priority)
         .def("memcpy", &Stream::memcpy)
-        .def("memcpy_async", &Stream::memcpy_async);
+        .def("memcpy_async", &Stream::memcpy_async)
+        .def("begin_capture", &Stream::begin_capture, py::arg("pool_id") = 0)
+        .def("end_capture", &Stream::end_capture)
+        .def("is_capturing", &Stream::is_capturing);
+
+    // Graph binding
+    py::class_<Graph, std::shared_ptr<Graph>>(m, "Graph")
+        .def("instantiate", &Graph::instantiate)
+        .def("is_instantiated", &Graph::is_instantiated)
+        .def("replay", &Graph::replay)
+        .def("reset", &Graph::reset)
+        .def("get_pool_id", &Graph::get_pool_id);
+
+    // Event binding
+    py::class_<Event, std::shared_ptr<Event>>(m, "Event")
+        .def(py::init<std::shared_ptr<DeviceContext>, bool>(),
+             py::arg("context"), py::arg("enable_timing") = true)
+        .def("initialize", &Event::initialize)
+        .def("is_valid", &Event::is_valid)
+        .def("get_native_handle", &Event::get_native_handle)
+        .def("record", &Event::record)
+        .def("wait", &Event::wait)
+        .def("synchronize", &Event::synchronize)
+        .def("query", &Event::query)
+        .def("elapsed_time", &Event::elapsed_time);
 
     // DeviceContext binding
     py::class_<DeviceContext, std::shared_ptr<DeviceContext>>(m, "DeviceContext")
@@ -58,7 +99,9 @@ void bind_device(py::module& m) {
         .def("is_valid", &DeviceContext::is_valid)
         .def("get_device_id", &DeviceContext::get_device_id)
         .def("get_properties", &DeviceContext::get_properties)
-        .def("create_stream", &DeviceContext::create_stream)
+        .def("create_stream", &DeviceContext::create_stream, py::arg("priority") = StreamPriority::LOW)
+        .def("get_stream_from_pool", &DeviceContext::get_stream_from_pool,
+             py::arg("priority") = StreamPriority::LOW)
         .def("get_default_stream", &DeviceContext::get_default_stream);
 
     // Device management functions
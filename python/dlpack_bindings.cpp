@@ -0,0 +1,333 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <hip/hip_runtime.h>
+#include "rdna/device.h"
+#include "rdna/memory.h"
+#include "rdna/kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace py = pybind11;
+using namespace py::literals;
+using namespace rdna;
+
+namespace {
+
+// DLPack ABI (unversioned DLManagedTensor, as exchanged through the
+// "dltensor" capsule by PyTorch, TensorFlow, JAX and CuPy)
+enum DLDeviceType : int32_t {
+    kDLCPU = 1,
+    kDLROCM = 10,
+};
+
+enum DLDataTypeCode : uint8_t {
+    kDLFloat = 2,
+    kDLBfloat = 4,
+};
+
+struct DLDevice {
+    DLDeviceType device_type;
+    int32_t device_id;
+};
+
+struct DLDataType {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+};
+
+struct DLTensor {
+    void* data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t* shape;
+    int64_t* strides;  // In elements; null means compact row-major
+    uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void* manager_ctx;
+    void (*deleter)(DLManagedTensor* self);
+};
+
+constexpr const char* kDLTensorCapsuleName = "dltensor";
+constexpr const char* kUsedDLTensorCapsuleName = "used_dltensor";
+
+} // namespace
+
+/**
+ * @brief Strided device buffer shared with other frameworks through DLPack
+ *
+ * storage owns the memory: either a MemoryManager allocation, returned to
+ * the caching allocator when the last reference goes, or an imported
+ * DLManagedTensor, handed back to its producer's deleter. Exported
+ * capsules hold a reference of their own, so either side may drop its
+ * tensor first. stream is where the data was last written; consumers are
+ * ordered after it.
+ */
+struct DeviceTensor {
+    std::shared_ptr<void> storage;
+    void* data = nullptr;
+    TensorDesc desc;
+    int device_id = 0;
+    void* stream = nullptr;
+    bool owns_allocation = false;  // storage is a MemoryManager allocation
+};
+
+namespace {
+
+// Keeps the tensor's storage and the shape/stride arrays alive for as long
+// as the consumer holds the DLManagedTensor
+struct ExportContext {
+    std::shared_ptr<void> storage;
+    std::vector<int64_t> shape;
+    std::vector<int64_t> strides;
+    DLManagedTensor managed;
+};
+
+void delete_export_context(DLManagedTensor* managed) {
+    delete static_cast<ExportContext*>(managed->manager_ctx);
+}
+
+// Only a capsule nobody consumed still owns its tensor; consumers rename it
+void release_unconsumed_capsule(PyObject* capsule) {
+    if (PyCapsule_IsValid(capsule, kDLTensorCapsuleName)) {
+        auto* managed = static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule, kDLTensorCapsuleName));
+        if (managed && managed->deleter) {
+            managed->deleter(managed);
+        }
+    }
+}
+
+DLDataType to_dl_dtype(int data_type) {
+    switch (data_type) {
+        case 0: return {kDLFloat, 32, 1};
+        case 1: return {kDLFloat, 16, 1};
+        case 2: return {kDLBfloat, 16, 1};
+        default: throw std::invalid_argument("Unsupported data type for DLPack export");
+    }
+}
+
+int from_dl_dtype(const DLDataType& dtype) {
+    if (dtype.lanes == 1 && dtype.code == kDLFloat && dtype.bits == 32) return 0;
+    if (dtype.lanes == 1 && dtype.code == kDLFloat && dtype.bits == 16) return 1;
+    if (dtype.lanes == 1 && dtype.code == kDLBfloat && dtype.bits == 16) return 2;
+    throw std::invalid_argument("Unsupported DLPack dtype; expected float32, float16 or bfloat16");
+}
+
+bool is_row_major(const TensorDesc& desc) {
+    size_t expected = 1;
+    for (size_t i = desc.shape.size(); i-- > 0;) {
+        if (desc.shape[i] != 1 && desc.strides[i] != expected) {
+            return false;
+        }
+        expected *= desc.shape[i];
+    }
+    return true;
+}
+
+// DLPack stream argument: None and 0 mean the null stream, -1 asks the
+// producer not to synchronize, anything else is a hipStream_t
+bool parse_consumer_stream(const py::object& stream, void*& handle) {
+    handle = nullptr;
+    if (stream.is_none()) {
+        return true;
+    }
+    intptr_t value = stream.cast<intptr_t>();
+    if (value == -1) {
+        return false;
+    }
+    handle = reinterpret_cast<void*>(value);
+    return true;
+}
+
+// Order consumer after everything already queued on producer, without
+// blocking the host
+void wait_for_stream(void* consumer, void* producer, int device_id) {
+    if (consumer == producer) {
+        return;
+    }
+    int previous = 0;
+    hipGetDevice(&previous);
+    hipSetDevice(device_id);
+    hipEvent_t event = nullptr;
+    hipError_t result = hipEventCreateWithFlags(&event, hipEventDisableTiming);
+    if (result == hipSuccess) {
+        result = hipEventRecord(event, static_cast<hipStream_t>(producer));
+        if (result == hipSuccess) {
+            result = hipStreamWaitEvent(static_cast<hipStream_t>(consumer), event, 0);
+        }
+        hipEventDestroy(event);  // Released once the wait is satisfied
+    }
+    hipSetDevice(previous);
+    if (result != hipSuccess) {
+        throw std::runtime_error("Failed to order DLPack consumer stream: " +
+                                 std::string(hipGetErrorString(result)));
+    }
+}
+
+std::shared_ptr<DeviceTensor> empty_tensor(const std::vector<size_t>& shape, int data_type, int device_id) {
+    if (device_id == -1) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    auto tensor = std::make_shared<DeviceTensor>();
+    tensor->desc = TensorDesc(shape, data_type);
+    tensor->device_id = device_id;
+    tensor->stream = DeviceManager::get_instance().get_current_stream_handle(device_id);
+    tensor->owns_allocation = true;
+
+    AllocationOptions options = {};
+    options.stream = tensor->stream;
+    options.tag = "dlpack";
+    void* ptr = MemoryManager::get_instance().allocate(std::max<size_t>(tensor->desc.get_size(), 1),
+                                                       device_id, options);
+    if (!ptr) {
+        throw std::runtime_error("Failed to allocate device tensor");
+    }
+    tensor->storage = std::shared_ptr<void>(ptr, [](void* p) { MemoryManager::get_instance().deallocate(p); });
+    tensor->data = ptr;
+    return tensor;
+}
+
+// Blocking copies between a contiguous tensor and a host buffer of the
+// same size, ordered on the tensor's stream
+void copy_host(DeviceTensor& tensor, const py::buffer& host, bool to_device) {
+    py::buffer_info info = host.request(!to_device);
+    size_t size = static_cast<size_t>(info.size * info.itemsize);
+    if (!tensor.desc.contiguous || size != tensor.desc.get_size()) {
+        throw std::invalid_argument("Host buffer must match a contiguous tensor in size");
+    }
+    bool copied = to_device ? MemoryManager::get_instance().memcpy(tensor.data, info.ptr, size, tensor.stream)
+                            : MemoryManager::get_instance().memcpy(info.ptr, tensor.data, size, tensor.stream);
+    if (!copied) {
+        throw std::runtime_error("Failed to copy device tensor");
+    }
+}
+
+py::capsule to_dlpack(const DeviceTensor& tensor, const py::object& stream) {
+    void* consumer = nullptr;
+    if (parse_consumer_stream(stream, consumer)) {
+        wait_for_stream(consumer, tensor.stream, tensor.device_id);
+        if (tensor.owns_allocation && consumer != tensor.stream) {
+            // The consumer may release its reference while its own work is
+            // still reading the buffer
+            MemoryManager::get_instance().record_stream(tensor.data, consumer);
+        }
+    }
+
+    auto context = std::make_unique<ExportContext>();
+    context->storage = tensor.storage;
+    context->shape.assign(tensor.desc.shape.begin(), tensor.desc.shape.end());
+    context->strides.assign(tensor.desc.strides.begin(), tensor.desc.strides.end());
+
+    DLTensor& dl = context->managed.dl_tensor;
+    dl.data = tensor.data;
+    dl.device = {kDLROCM, tensor.device_id};
+    dl.ndim = static_cast<int32_t>(context->shape.size());
+    dl.dtype = to_dl_dtype(tensor.desc.data_type);
+    dl.shape = context->shape.data();
+    dl.strides = context->strides.data();
+    dl.byte_offset = 0;
+    context->managed.manager_ctx = context.get();
+    context->managed.deleter = delete_export_context;
+
+    DLManagedTensor* managed = &context.release()->managed;
+    return py::capsule(managed, kDLTensorCapsuleName, release_unconsumed_capsule);
+}
+
+std::shared_ptr<DeviceTensor> from_dlpack_capsule(const py::capsule& capsule) {
+    if (!PyCapsule_IsValid(capsule.ptr(), kDLTensorCapsuleName)) {
+        throw std::invalid_argument("Expected an unconsumed DLPack capsule");
+    }
+    auto* managed = static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule.ptr(), kDLTensorCapsuleName));
+    const DLTensor& dl = managed->dl_tensor;
+    if (dl.device.device_type != kDLROCM) {
+        throw std::invalid_argument("DLPack tensor is not in ROCm device memory");
+    }
+    if (dl.ndim < 0 || (dl.ndim > 0 && !dl.shape)) {
+        throw std::invalid_argument("Malformed DLPack tensor");
+    }
+
+    auto tensor = std::make_shared<DeviceTensor>();
+    tensor->desc.data_type = from_dl_dtype(dl.dtype);
+    tensor->desc.shape.resize(dl.ndim);
+    tensor->desc.strides.resize(dl.ndim);
+    size_t expected = 1;
+    for (int i = dl.ndim - 1; i >= 0; --i) {
+        if (dl.shape[i] < 0 || (dl.strides && dl.strides[i] < 0)) {
+            throw std::invalid_argument("Negative DLPack shapes and strides are not supported");
+        }
+        tensor->desc.shape[i] = static_cast<size_t>(dl.shape[i]);
+        tensor->desc.strides[i] = dl.strides ? static_cast<size_t>(dl.strides[i]) : expected;
+        expected *= tensor->desc.shape[i];
+    }
+    tensor->desc.contiguous = is_row_major(tensor->desc);
+    tensor->data = static_cast<char*>(dl.data) + dl.byte_offset;
+    tensor->device_id = dl.device.device_id;
+    tensor->stream = DeviceManager::get_instance().get_current_stream_handle(tensor->device_id);
+
+    // The tensor now owns managed; mark the capsule consumed so its
+    // destructor leaves it alone
+    tensor->storage = std::shared_ptr<void>(managed, [](void* p) {
+        auto* owned = static_cast<DLManagedTensor*>(p);
+        if (owned->deleter) {
+            owned->deleter(owned);
+        }
+    });
+    PyCapsule_SetName(capsule.ptr(), kUsedDLTensorCapsuleName);
+    return tensor;
+}
+
+} // namespace
+
+void bind_dlpack(py::module& m) {
+    py::class_<DeviceTensor, std::shared_ptr<DeviceTensor>>(m, "DeviceTensor")
+        .def_static("empty", &empty_tensor, "Allocate an uninitialized tensor from the caching allocator",
+                    py::arg("shape"), py::arg("data_type") = 0, py::arg("device_id") = -1)
+        .def_property_readonly("shape", [](const DeviceTensor& t) { return t.desc.shape; })
+        .def_property_readonly("strides", [](const DeviceTensor& t) { return t.desc.strides; })
+        .def_property_readonly("data_type", [](const DeviceTensor& t) { return t.desc.data_type; })
+        .def_property_readonly("device_id", [](const DeviceTensor& t) { return t.device_id; })
+        .def_property_readonly("desc", [](const DeviceTensor& t) { return t.desc; })
+        .def_property_readonly("data_ptr", [](const DeviceTensor& t) { return reinterpret_cast<uintptr_t>(t.data); })
+        .def_property_readonly("nbytes", [](const DeviceTensor& t) { return t.desc.get_size(); })
+        .def_property_readonly("data", [](const DeviceTensor& t) { return t.data; },
+                               "Device pointer, for the kernel and memory APIs")
+        .def("copy_from", [](DeviceTensor& t, const py::buffer& host) { copy_host(t, host, true); },
+             "Upload a host buffer of the same size", py::arg("host"))
+        .def("copy_to", [](DeviceTensor& t, const py::buffer& host) { copy_host(t, host, false); },
+             "Download into a writable host buffer of the same size", py::arg("host"))
+        .def("__dlpack__", &to_dlpack, py::arg("stream") = py::none())
+        .def("__dlpack_device__", [](const DeviceTensor& t) {
+            return py::make_tuple(static_cast<int>(kDLROCM), t.device_id);
+        });
+
+    m.def("to_dlpack", [](const DeviceTensor& tensor) {
+        return to_dlpack(tensor, py::none());
+    }, "Export a DeviceTensor as a DLPack capsule, ordered after the null stream", py::arg("tensor"));
+
+    m.def("from_dlpack", [](py::object source) {
+        if (py::isinstance<py::capsule>(source)) {
+            return from_dlpack_capsule(source.cast<py::capsule>());
+        }
+        if (!py::hasattr(source, "__dlpack__")) {
+            throw std::invalid_argument("Object does not support the DLPack protocol");
+        }
+        // Ask the producer to order its writes before our current stream
+        py::tuple device = source.attr("__dlpack_device__")().cast<py::tuple>();
+        int device_id = device[1].cast<int>();
+        void* stream = DeviceManager::get_instance().get_current_stream_handle(device_id);
+        py::object stream_arg = py::none();
+        if (stream) {
+            stream_arg = py::int_(reinterpret_cast<intptr_t>(stream));
+        }
+        py::object capsule = source.attr("__dlpack__")("stream"_a = stream_arg);
+        return from_dlpack_capsule(capsule.cast<py::capsule>());
+    }, "Wrap another framework's ROCm tensor without copying", py::arg("source"));
+}
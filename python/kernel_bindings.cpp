@@ -43,6 +43,51 @@ void bind_kernels(py::module& m) {
         .def_readwrite("groups", &ConvConfig::groups)
         .def_readwrite("benchmark", &ConvConfig::benchmark);
 
+    // Fused elementwise bindings
+    py::enum_<FusedOpType>(m, "FusedOpType")
+        .value("Add", FusedOpType::Add)
+        .value("Subtract", FusedOpType::Subtract)
+        .value("Multiply", FusedOpType::Multiply)
+        .value("Divide", FusedOpType::Divide)
+        .value("Maximum", FusedOpType::Maximum)
+        .value("Minimum", FusedOpType::Minimum)
+        .value("Relu", FusedOpType::Relu)
+        .value("Gelu", FusedOpType::Gelu)
+        .value("Sigmoid", FusedOpType::Sigmoid)
+        .value("Tanh", FusedOpType::Tanh);
+
+    py::class_<FusedOp>(m, "FusedOp")
+        .def(py::init<FusedOpType, int, int>(), py::arg("type"), py::arg("lhs"), py::arg("rhs") = -1)
+        .def_readwrite("type", &FusedOp::type)
+        .def_readwrite("lhs", &FusedOp::lhs)
+        .def_readwrite("rhs", &FusedOp::rhs);
+
+    // MatmulEpilogue binding
+    py::enum_<Activation>(m, "Activation")
+        .value("Identity", Activation::Identity)
+        .value("Relu", Activation::Relu)
+        .value("Gelu", Activation::Gelu);
+
+    py::class_<MatmulEpilogue>(m, "MatmulEpilogue")
+        .def(py::init<>())
+        .def_readwrite("bias", &MatmulEpilogue::bias)
+        .def_readwrite("bias_desc", &MatmulEpilogue::bias_desc)
+        .def_readwrite("activation", &MatmulEpilogue::activation)
+        .def_readwrite("residual", &MatmulEpilogue::residual)
+        .def_readwrite("residual_desc", &MatmulEpilogue::residual_desc)
+        .def("empty", &MatmulEpilogue::empty);
+
+    // AttentionConfig binding; key_lengths is a device pointer
+    py::class_<AttentionConfig>(m, "AttentionConfig")
+        .def(py::init<>())
+        .def_readwrite("scale", &AttentionConfig::scale)
+        .def_readwrite("causal", &AttentionConfig::causal)
+        .def_property("key_lengths",
+                      [](const AttentionConfig& config) { return static_cast<const void*>(config.key_lengths); },
+                      [](AttentionConfig& config, const void* lengths) {
+                          config.key_lengths = static_cast<const int*>(lengths);
+                      });
+
     // OperatorKernel base class binding
     py::class_<OperatorKernel>(m, "OperatorKernel")
         .def("initialize", &OperatorKernel::initialize)
@@ -53,7 +98,9 @@ void bind_kernels(py::module& m) {
     py::class_<MatmulKernel, OperatorKernel, std::shared_ptr<MatmulKernel>>(m, "MatmulKernel")
         .def(py::init<std::shared_ptr<DeviceContext>>())
         .def("matmul", &MatmulKernel::matmul)
-        .def("batched_matmul", &MatmulKernel::batched_matmul);
+        .def("batched_matmul", &MatmulKernel::batched_matmul)
+        .def("fused_matmul", &MatmulKernel::fused_matmul)
+        .def("tune", &MatmulKernel::tune);
 
     // ConvKernel binding
     py::class_<ConvKernel, OperatorKernel, std::shared_ptr<ConvKernel>>(m, "ConvKernel")
@@ -63,6 +110,44 @@ void bind_kernels(py::module& m) {
         .def("conv2d_backward_filter", &ConvKernel::conv2d_backward_filter)
         .def("find_best_algorithm", &ConvKernel::find_best_algorithm);
 
+    // AttentionKernel binding
+    py::class_<AttentionKernel, OperatorKernel, std::shared_ptr<AttentionKernel>>(m, "AttentionKernel")
+        .def(py::init<std::shared_ptr<DeviceContext>>())
+        .def("forward", [](AttentionKernel& self, const TensorDesc& q, const void* q_data,
+                           const TensorDesc& k, const void* k_data, const TensorDesc& v, const void* v_data,
+                           const TensorDesc& output, void* output_data, const AttentionConfig& config,
+                           void* logsumexp, void* stream) {
+                 return self.forward(q, q_data, k, k_data, v, v_data, output, output_data, config,
+                                     static_cast<float*>(logsumexp), stream);
+             },
+             py::arg("q"), py::arg("q_data"), py::arg("k"), py::arg("k_data"), py::arg("v"), py::arg("v_data"),
+             py::arg("output"), py::arg("output_data"), py::arg("config") = AttentionConfig(),
+             py::arg("logsumexp") = nullptr, py::arg("stream") = nullptr)
+        .def("backward", [](AttentionKernel& self, const TensorDesc& q, const void* q_data,
+                            const TensorDesc& k, const void* k_data, const TensorDesc& v, const void* v_data,
+                            const TensorDesc& output, const void* output_data, const void* grad_output_data,
+                            const void* logsumexp, void* grad_q_data, void* grad_k_data, void* grad_v_data,
+                            const AttentionConfig& config, void* stream) {
+                 return self.backward(q, q_data, k, k_data, v, v_data, output, output_data, grad_output_data,
+                                      static_cast<const float*>(logsumexp), grad_q_data, grad_k_data, grad_v_data,
+                                      config, stream);
+             },
+             py::arg("q"), py::arg("q_data"), py::arg("k"), py::arg("k_data"), py::arg("v"), py::arg("v_data"),
+             py::arg("output"), py::arg("output_data"), py::arg("grad_output_data"), py::arg("logsumexp"),
+             py::arg("grad_q_data"), py::arg("grad_k_data"), py::arg("grad_v_data"),
+             py::arg("config") = AttentionConfig(), py::arg("stream") = nullptr);
+
+    // ConvAlgorithmCache binding
+    py::class_<ConvAlgorithmCache>(m, "ConvAlgorithmCache")
+        .def_static("get_instance", &ConvAlgorithmCache::get_instance,
+                   py::return_value_policy::reference)
+        .def("load", &ConvAlgorithmCache::load)
+        .def("save", &ConvAlgorithmCache::save)
+        .def("set_database_path", &ConvAlgorithmCache::set_database_path)
+        .def("get_database_path", &ConvAlgorithmCache::get_database_path)
+        .def("clear", &ConvAlgorithmCache::clear)
+        .def("size", &ConvAlgorithmCache::size);
+
     // CustomKernels binding
     py::class_<CustomKernels, OperatorKernel, std::shared_ptr<CustomKernels>>(m, "CustomKernels")
         .def(py::init<std::shared_ptr<DeviceContext>>())
@@ -71,8 +156,51 @@ void bind_kernels(py::module& m) {
         .def("relu", &CustomKernels::relu)
         .def("gelu", &CustomKernels::gelu)
         .def("softmax", &CustomKernels::softmax)
+        // Row statistics are fp32 device buffers, passed like the data pointers
+        .def("layer_norm", [](CustomKernels& self, const TensorDesc& input, const void* input_data,
+                              const void* weight, const void* bias, const TensorDesc& output, void* output_data,
+                              float epsilon, void* mean, void* rstd, void* stream) {
+                 return self.layer_norm(input, input_data, weight, bias, output, output_data, epsilon,
+                                        static_cast<float*>(mean), static_cast<float*>(rstd), stream);
+             },
+             py::arg("input"), py::arg("input_data"), py::arg("weight"), py::arg("bias"),
+             py::arg("output"), py::arg("output_data"), py::arg("epsilon") = 1e-5f,
+             py::arg("mean") = nullptr, py::arg("rstd") = nullptr, py::arg("stream") = nullptr)
+        .def("layer_norm_backward", [](CustomKernels& self, const TensorDesc& grad_output,
+                                       const void* grad_output_data, const TensorDesc& input, const void* input_data,
+                                       const void* mean, const void* rstd, const void* weight,
+                                       void* grad_input_data, void* grad_weight, void* grad_bias, void* stream) {
+                 return self.layer_norm_backward(grad_output, grad_output_data, input, input_data,
+                                                 static_cast<const float*>(mean), static_cast<const float*>(rstd),
+                                                 weight, grad_input_data, grad_weight, grad_bias, stream);
+             },
+             py::arg("grad_output"), py::arg("grad_output_data"), py::arg("input"), py::arg("input_data"),
+             py::arg("mean"), py::arg("rstd"), py::arg("weight"), py::arg("grad_input_data"),
+             py::arg("grad_weight") = nullptr, py::arg("grad_bias") = nullptr, py::arg("stream") = nullptr)
+        .def("rms_norm", [](CustomKernels& self, const TensorDesc& input, const void* input_data,
+                            const void* weight, const TensorDesc& output, void* output_data,
+                            float epsilon, void* rstd, void* stream) {
+                 return self.rms_norm(input, input_data, weight, output, output_data, epsilon,
+                                      static_cast<float*>(rstd), stream);
+             },
+             py::arg("input"), py::arg("input_data"), py::arg("weight"), py::arg("output"),
+             py::arg("output_data"), py::arg("epsilon") = 1e-6f, py::arg("rstd") = nullptr,
+             py::arg("stream") = nullptr)
+        .def("rms_norm_backward", [](CustomKernels& self, const TensorDesc& grad_output,
+                                     const void* grad_output_data, const TensorDesc& input, const void* input_data,
+                                     const void* rstd, const void* weight, void* grad_input_data,
+                                     void* grad_weight, void* stream) {
+                 return self.rms_norm_backward(grad_output, grad_output_data, input, input_data,
+                                               static_cast<const float*>(rstd), weight, grad_input_data,
+                                               grad_weight, stream);
+             },
+             py::arg("grad_output"), py::arg("grad_output_data"), py::arg("input"), py::arg("input_data"),
+             py::arg("rstd"), py::arg("weight"), py::arg("grad_input_data"),
+             py::arg("grad_weight") = nullptr, py::arg("stream") = nullptr)
         .def("sum", &CustomKernels::sum)
-        .def("mean", &CustomKernels::mean);
+        .def("mean", &CustomKernels::mean)
+        .def("fused_elementwise", &CustomKernels::fused_elementwise)
+        .def("get_fused_kernel_count", &CustomKernels::get_fused_kernel_count);
 
     // KernelManager binding
     py::class_<KernelManager>(m, "KernelManager")
@@ -81,10 +209,14 @@ void bind_kernels(py::module& m) {
         .def("get_matmul_kernel", &KernelManager::get_matmul_kernel)
         .def("get_conv_kernel", &KernelManager::get_conv_kernel)
         .def("get_custom_kernels", &KernelManager::get_custom_kernels)
+        .def("get_attention_kernel", &KernelManager::get_attention_kernel)
         .def("initialize_kernels", &KernelManager::initialize_kernels)
         .def("are_kernels_initialized", &KernelManager::are_kernels_initialized)
+        .def("set_deterministic", &KernelManager::set_deterministic)
+        .def("is_deterministic", &KernelManager::is_deterministic)
         .def("dispatch_matmul", &KernelManager::dispatch_matmul)
-        .def("dispatch_conv2d", &KernelManager::dispatch_conv2d);
+        .def("dispatch_conv2d", &KernelManager::dispatch_conv2d)
+        .def("dispatch_attention", &KernelManager::dispatch_attention);
 
     // Kernel operation functions
     m.def("matmul", [](const TensorDesc& a, py::buffer a_buf,
@@ -126,10 +258,23 @@ void bind_kernels(py::module& m) {
        py::arg("device_id") = -1, py::arg("stream") = nullptr);
 
     // Utility functions
-    m.def("calculate_matmul_kernel_config", &calculate_matmul_kernel_config, 
-          "Calculate kernel configuration for matmul");
-    m.def("calculate_conv_kernel_config", &calculate_conv_kernel_config,
-          "Calculate kernel configuration for convolution");
+    m.def("calculate_matmul_kernel_config",
+          py::overload_cast<const TensorDesc&, const TensorDesc&, const DeviceProperties&>(&calculate_matmul_kernel_config),
+          "Calculate kernel configuration for matmul on a device",
+          py::arg("a"), py::arg("b"), py::arg("properties"));
+    m.def("calculate_matmul_kernel_config",
+          py::overload_cast<const TensorDesc&, const TensorDesc&>(&calculate_matmul_kernel_config),
+          "Calculate kernel configuration for matmul on the current device",
+          py::arg("a"), py::arg("b"));
+    m.def("calculate_conv_kernel_config",
+          py::overload_cast<const TensorDesc&, const TensorDesc&, const ConvConfig&, const DeviceProperties&>(
+              &calculate_conv_kernel_config),
+          "Calculate kernel configuration for convolution on a device",
+          py::arg("input"), py::arg("filter"), py::arg("config"), py::arg("properties"));
+    m.def("calculate_conv_kernel_config",
+          py::overload_cast<const TensorDesc&, const TensorDesc&, const ConvConfig&>(&calculate_conv_kernel_config),
+          "Calculate kernel configuration for convolution on the current device",
+          py::arg("input"), py::arg("filter"), py::arg("config") = ConvConfig());
     m.def("get_data_type_size", &get_data_type_size,
           "Get size of data type in bytes");
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include "rdna/memory.h"
+#include "rdna/device.h"
 
 namespace py = pybind11;
 using namespace rdna;
@@ -26,7 +27,15 @@ void bind_memory(py::module& m) {
         .def_readonly("cached_blocks", &MemoryStats::cached_blocks)
         .def_readonly("max_allocated_bytes", &MemoryStats::max_allocated_bytes)
         .def_readonly("total_allocations", &MemoryStats::total_allocations)
-        .def_readonly("total_frees", &MemoryStats::total_frees);
+        .def_readonly("total_frees", &MemoryStats::total_frees)
+        .def_readonly("small_pool_segments", &MemoryStats::small_pool_segments)
+        .def_readonly("small_pool_blocks", &MemoryStats::small_pool_blocks)
+        .def_readonly("large_pool_segments", &MemoryStats::large_pool_segments)
+        .def_readonly("large_pool_blocks", &MemoryStats::large_pool_blocks)
+        .def_readonly("device_malloc_calls", &MemoryStats::device_malloc_calls)
+        .def_readonly("device_free_calls", &MemoryStats::device_free_calls)
+        .def_readonly("workspace_bytes", &MemoryStats::workspace_bytes)
+        .def_readonly("workspace_high_water_mark", &MemoryStats::workspace_high_water_mark);
 
     // AllocationOptions binding
     py::class_<AllocationOptions>(m, "AllocationOptions")
@@ -37,23 +46,84 @@ void bind_memory(py::module& m) {
         .def_readwrite("alignment", &AllocationOptions::alignment)
         .def_readwrite("stream", &AllocationOptions::stream);
 
+    // Trace and snapshot bindings
+    py::enum_<TraceAction>(m, "TraceAction")
+        .value("ALLOC", TraceAction::Alloc)
+        .value("FREE", TraceAction::Free)
+        .value("SPLIT", TraceAction::Split)
+        .value("MERGE", TraceAction::Merge)
+        .value("SEGMENT_ALLOC", TraceAction::SegmentAlloc)
+        .value("SEGMENT_FREE", TraceAction::SegmentFree)
+        .value("SEGMENT_MAP", TraceAction::SegmentMap)
+        .value("SEGMENT_UNMAP", TraceAction::SegmentUnmap)
+        .value("OOM", TraceAction::Oom);
+
+    py::class_<TraceEntry>(m, "TraceEntry")
+        .def_readonly("action", &TraceEntry::action)
+        .def_readonly("size", &TraceEntry::size)
+        .def_readonly("timestamp_ns", &TraceEntry::timestamp_ns)
+        .def_property_readonly("address", [](const TraceEntry& e) { return reinterpret_cast<uintptr_t>(e.ptr); })
+        .def_property_readonly("stream", [](const TraceEntry& e) { return reinterpret_cast<uintptr_t>(e.stream); })
+        .def_property_readonly("tag", [](const TraceEntry& e) { return e.tag ? py::str(e.tag) : py::none(); });
+
+    py::class_<BlockSnapshot>(m, "BlockSnapshot")
+        .def_readonly("size", &BlockSnapshot::size)
+        .def_readonly("state", &BlockSnapshot::state)
+        .def_readonly("allocation_id", &BlockSnapshot::allocation_id)
+        .def_property_readonly("address", [](const BlockSnapshot& b) { return reinterpret_cast<uintptr_t>(b.ptr); })
+        .def_property_readonly("tag", [](const BlockSnapshot& b) { return b.tag ? py::str(b.tag) : py::none(); });
+
+    py::class_<SegmentSnapshot>(m, "SegmentSnapshot")
+        .def_readonly("size", &SegmentSnapshot::size)
+        .def_readonly("pool", &SegmentSnapshot::pool)
+        .def_readonly("expandable", &SegmentSnapshot::expandable)
+        .def_readonly("blocks", &SegmentSnapshot::blocks)
+        .def_property_readonly("address", [](const SegmentSnapshot& s) { return reinterpret_cast<uintptr_t>(s.ptr); })
+        .def_property_readonly("stream", [](const SegmentSnapshot& s) { return reinterpret_cast<uintptr_t>(s.stream); });
+
+    py::class_<MemorySnapshot>(m, "MemorySnapshot")
+        .def_readonly("device_id", &MemorySnapshot::device_id)
+        .def_readonly("stats", &MemorySnapshot::stats)
+        .def_readonly("segments", &MemorySnapshot::segments)
+        .def_readonly("trace", &MemorySnapshot::trace)
+        .def("to_json", &MemorySnapshot::to_json);
+
     // MemoryAllocator binding
     py::class_<MemoryAllocator, std::shared_ptr<MemoryAllocator>>(m, "MemoryAllocator")
         .def(py::init<std::shared_ptr<DeviceContext>>())
         .def("allocate", &MemoryAllocator::allocate, 
              py::arg("size"), py::arg("options") = DEFAULT_ALLOCATION_OPTIONS)
         .def("deallocate", &MemoryAllocator::deallocate)
+        .def("record_stream", &MemoryAllocator::record_stream)
         .def("memcpy", &MemoryAllocator::memcpy)
         .def("memset", &MemoryAllocator::memset)
+        .def("memcpy_async", &MemoryAllocator::memcpy_async)
+        .def("memset_async", &MemoryAllocator::memset_async)
         .def("empty_cache", &MemoryAllocator::empty_cache)
         .def("get_stats", &MemoryAllocator::get_stats)
         .def("get_allocation_info", &MemoryAllocator::get_allocation_info)
+        .def("snapshot", &MemoryAllocator::snapshot)
+        .def("set_trace_enabled", &MemoryAllocator::set_trace_enabled)
+        .def("is_trace_enabled", &MemoryAllocator::is_trace_enabled)
         .def("set_cache_size_limit", &MemoryAllocator::set_cache_size_limit)
         .def("get_cache_size_limit", &MemoryAllocator::get_cache_size_limit)
+        .def("set_expandable_segments", &MemoryAllocator::set_expandable_segments)
+        .def("get_expandable_segments", &MemoryAllocator::get_expandable_segments)
+        .def("set_workspace_limit", &MemoryAllocator::set_workspace_limit)
+        .def("get_workspace_limit", &MemoryAllocator::get_workspace_limit)
         .def("get_total_memory", &MemoryAllocator::get_total_memory)
         .def("get_free_memory", &MemoryAllocator::get_free_memory)
         .def("get_used_memory", &MemoryAllocator::get_used_memory);
 
+    // PinnedHostAllocator binding (owned by MemoryManager)
+    py::class_<PinnedHostAllocator>(m, "PinnedHostAllocator")
+        .def("allocate", &PinnedHostAllocator::allocate)
+        .def("deallocate", &PinnedHostAllocator::deallocate,
+             py::arg("ptr"), py::arg("stream") = nullptr)
+        .def("empty_cache", &PinnedHostAllocator::empty_cache)
+        .def("get_allocated_bytes", &PinnedHostAllocator::get_allocated_bytes)
+        .def("get_cached_bytes", &PinnedHostAllocator::get_cached_bytes);
+    
     // MemoryManager binding
     py::class_<MemoryManager>(m, "MemoryManager")
         .def_static("get_instance", &MemoryManager::get_instance, 
@@ -64,10 +134,25 @@ void bind_memory(py::module& m) {
              py::arg("size"), py::arg("device_id") = -1, 
              py::arg("options") = DEFAULT_ALLOCATION_OPTIONS)
         .def("deallocate", &MemoryManager::deallocate)
+        .def("record_stream", &MemoryManager::record_stream)
         .def("memcpy", &MemoryManager::memcpy)
         .def("memset", &MemoryManager::memset)
+        .def("memcpy_async", &MemoryManager::memcpy_async)
+        .def("memset_async", &MemoryManager::memset_async)
+        .def("peer_memcpy_async", &MemoryManager::peer_memcpy_async,
+             py::arg("dst"), py::arg("dst_device"), py::arg("src"), py::arg("src_device"),
+             py::arg("size"), py::arg("stream"))
+        .def("stage_to_device", &MemoryManager::stage_to_device,
+             py::arg("host_ptr"), py::arg("size"), py::arg("stream") = nullptr,
+             py::arg("device_id") = -1)
+        .def("get_pinned_allocator", &MemoryManager::get_pinned_allocator,
+             py::return_value_policy::reference)
+        .def("set_expandable_segments", &MemoryManager::set_expandable_segments)
+        .def("set_workspace_limit", &MemoryManager::set_workspace_limit)
+        .def("get_workspace_limit", &MemoryManager::get_workspace_limit)
         .def("empty_cache", &MemoryManager::empty_cache)
         .def("get_stats", &MemoryManager::get_stats)
+        .def("snapshot", &MemoryManager::snapshot, py::arg("device_id") = -1)
         .def("get_total_memory", &MemoryManager::get_total_memory)
         .def("get_free_memory", &MemoryManager::get_free_memory)
         .def("get_used_memory", &MemoryManager::get_used_memory);
@@ -96,6 +181,11 @@ void bind_memory(py::module& m) {
         return stats.allocated_bytes + stats.cached_bytes;
     }, "Get reserved memory (allocated + cached) in bytes", py::arg("device_id") = -1);
 
+    m.def("memory_snapshot", [](int device_id) {
+        MemoryManager& manager = MemoryManager::get_instance();
+        return manager.snapshot(device_id).to_json();
+    }, "Get segments, blocks and recent allocator trace as JSON", py::arg("device_id") = -1);
+
     m.def("memory_cached", [](int device_id) {
         MemoryManager& manager = MemoryManager::get_instance();
         MemoryStats stats = manager.get_stats(device_id);
@@ -121,8 +211,22 @@ void bind_memory(py::module& m) {
         return ss.str();
     }, "Get memory summary", py::arg("device_id") = -1);
 
+    // Asynchronous copies for double-buffered input pipelines
+    m.def("memcpy_async", [](void* dst, const void* src, size_t size, Stream& stream) {
+        MemoryManager& manager = MemoryManager::get_instance();
+        return manager.memcpy_async(dst, src, size, stream);
+    }, "Queue a copy on stream and return its completion event",
+       py::arg("dst"), py::arg("src"), py::arg("size"), py::arg("stream"));
+
+    m.def("memset_async", [](void* ptr, int value, size_t size, Stream& stream) {
+        MemoryManager& manager = MemoryManager::get_instance();
+        return manager.memset_async(ptr, value, size, stream);
+    }, "Queue a memset on stream and return its completion event",
+       py::arg("ptr"), py::arg("value"), py::arg("size"), py::arg("stream"));
+
     // Utility functions
     m.def("is_device_pointer", &is_device_pointer, "Check if pointer is device memory");
+    m.def("is_pinned_host_pointer", &is_pinned_host_pointer, "Check if pointer is page-locked host memory");
     m.def("get_device_for_pointer", &get_device_for_pointer, "Get device ID for pointer");
     m.def("get_memory_alignment", &get_memory_alignment, "Get memory alignment");
 }
\ No newline at end of file
@@ -13,6 +13,8 @@ void bind_device(py::module& m);
 void bind_memory(py::module& m);
 void bind_kernels(py::module& m);
 void bind_utils(py::module& m);
+void bind_dlpack(py::module& m);
+void bind_collectives(py::module& m);
 
 PYBIND11_MODULE(rdna_py, m) {
     m.doc() = "RDNA Stack Python Bindings - AMD GPU acceleration for PyTorch and TensorFlow";
@@ -25,6 +27,8 @@ PYBIND11_MODULE(rdna_py, m) {
     bind_memory(m);
     bind_kernels(m);
     bind_utils(m);
+    bind_dlpack(m);
+    bind_collectives(m);
     
     // Module-level functions
     m.def("is_available", &rdna::is_rdna_supported, "Check if RDNA devices are available");
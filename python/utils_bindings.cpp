@@ -12,7 +12,10 @@ void bind_utils(py::module& m) {
         .def_readwrite("enable_debug_logging", &LibraryConfig::enable_debug_logging)
         .def_readwrite("enable_profiling", &LibraryConfig::enable_profiling)
         .def_readwrite("memory_cache_limit", &LibraryConfig::memory_cache_limit)
-        .def_readwrite("use_unified_memory", &LibraryConfig::use_unified_memory);
+        .def_readwrite("use_unified_memory", &LibraryConfig::use_unified_memory)
+        .def_readwrite("expandable_segments", &LibraryConfig::expandable_segments)
+        .def_readwrite("workspace_limit", &LibraryConfig::workspace_limit)
+        .def_readwrite("deterministic", &LibraryConfig::deterministic);
 
     // Configuration functions
     m.def("get_library_config", &get_library_config, "Get current library configuration");
@@ -79,13 +82,4 @@ void bind_python_utils(py::module& m) {
             "strides"_a = info.strides
         );
     }, "Get buffer information");
-    
-    // DLPack support (placeholder for future implementation)
-    m.def("to_dlpack", [](py::object obj) {
-        throw std::runtime_error("DLPack support not yet implemented");
-    }, "Convert to DLPack tensor");
-    
-    m.def("from_dlpack", [](py::object dlpack) {
-        throw std::runtime_error("DLPack support not yet implemented");
-    }, "Convert from DLPack tensor");
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <torch/extension.h>
 #include <torch/library.h>
 #include <ATen/ATen.h>
+#include <ATen/ExpandUtils.h>
 #include <ATen/core/op_registration/op_registration.h>
 #include <c10/core/Device.h>
 #include <c10/core/DeviceType.h>
@@ -9,6 +10,7 @@
 #include "rdna/device.h"
 #include "rdna/memory.h"
 #include "rdna/kernels.h"
+#include "rdna/profiler.h"
 
 namespace rdna {
 namespace pytorch {
@@ -16,20 +18,19 @@ namespace pytorch {
 // RDNA device type
 constexpr c10::DeviceType kRDNADeviceType = c10::DeviceType::XPU; // Using XPU as placeholder for RDNA
 
-// Global device manager
+// Makes device_id current for the scope; a thread-local index swap, and
+// free when the device is already current. -1 keeps the current device.
 class RDNADeviceGuard {
 public:
-    RDNADeviceGuard(int device_id) {
-        original_device_ = rdna::DeviceManager::get_instance().get_current_context()->get_device_id();
-        rdna::DeviceManager::get_instance().set_current_context(
-            rdna::DeviceManager::get_instance().create_context(device_id)
-        );
+    RDNADeviceGuard(int device_id)
+        : original_device_(rdna::DeviceManager::get_instance().get_current_device()) {
+        if (device_id >= 0) {
+            rdna::DeviceManager::get_instance().set_current_device(device_id);
+        }
     }
     
     ~RDNADeviceGuard() {
-        rdna::DeviceManager::get_instance().set_current_context(
-            rdna::DeviceManager::get_instance().create_context(original_device_)
-        );
+        rdna::DeviceManager::get_instance().set_current_device(original_device_);
     }
     
 private:
@@ -51,7 +52,7 @@ at::Tensor to_rdna(const at::Tensor& tensor, int device_id = 0) {
 // Memory management
 struct RDNAAllocator : public at::Allocator {
     void* allocate(size_t size) override {
-        rdna::AllocationOptions options;
+        rdna::AllocationOptions options = {};
         return rdna::MemoryManager::get_instance().allocate(size, -1, options);
     }
     
@@ -62,27 +63,51 @@ struct RDNAAllocator : public at::Allocator {
 
 static RDNAAllocator rdna_allocator;
 
+// Describe an ATen tensor's real layout, so kernels see its strides
+bool to_tensor_desc(const at::Tensor& tensor, rdna::TensorDesc& desc) {
+    switch (tensor.scalar_type()) {
+        case at::kFloat: desc.data_type = 0; break;
+        case at::kHalf: desc.data_type = 1; break;
+        case at::kBFloat16: desc.data_type = 2; break;
+        default: return false;
+    }
+    desc.shape.assign(tensor.sizes().begin(), tensor.sizes().end());
+    desc.strides.assign(tensor.strides().begin(), tensor.strides().end());
+    desc.contiguous = tensor.is_contiguous();
+    return true;
+}
+
 // Operator implementations
 at::Tensor rdna_add(const at::Tensor& self, const at::Tensor& other, const at::Scalar& alpha) {
     RDNADeviceGuard guard(self.device().index());
+    rdna::ScopedEvent op_event(rdna::EventType::FRAMEWORK_OP, "aten::add");
     
     // Convert to RDNA if needed
     auto self_rdna = to_rdna(self);
     auto other_rdna = to_rdna(other);
     
-    // Use custom kernel for addition
-    rdna::TensorDesc self_desc({self.size(0)}, 0); // Simplified
-    rdna::TensorDesc other_desc({other.size(0)}, 0);
-    rdna::TensorDesc result_desc({self.size(0)}, 0);
+    // The kernel computes a + b; scaled adds and mixed dtypes stay on ATen
+    rdna::TensorDesc self_desc, other_desc, result_desc;
+    if (alpha.to<float>() != 1.0f || self_rdna.scalar_type() != other_rdna.scalar_type() ||
+        !to_tensor_desc(self_rdna, self_desc) || !to_tensor_desc(other_rdna, other_desc)) {
+        return self_rdna + other_rdna * alpha.to<float>();
+    }
     
-    rdna::KernelManager& kernel_manager = rdna::KernelManager::get_instance();
-    // Implementation would call custom kernel
+    at::Tensor result = at::empty(at::infer_size(self_rdna.sizes(), other_rdna.sizes()), self_rdna.options());
+    to_tensor_desc(result, result_desc);
     
-    return self_rdna + other_rdna * alpha.to<float>(); // Placeholder
+    rdna::KernelManager& kernel_manager = rdna::KernelManager::get_instance();
+    auto custom = kernel_manager.get_custom_kernels(self_rdna.device().index());
+    TORCH_CHECK(custom->is_initialized() || custom->initialize(), "Failed to initialize RDNA custom kernels");
+    TORCH_CHECK(custom->add(self_desc, self_rdna.data_ptr(), other_desc, other_rdna.data_ptr(),
+                            result_desc, result.data_ptr()),
+                "RDNA add kernel failed");
+    return result;
 }
 
 at::Tensor rdna_matmul(const at::Tensor& self, const at::Tensor& other) {
     RDNADeviceGuard guard(self.device().index());
+    rdna::ScopedEvent op_event(rdna::EventType::FRAMEWORK_OP, "aten::matmul");
     
     auto self_rdna = to_rdna(self);
     auto other_rdna = to_rdna(other);
@@ -104,6 +129,7 @@ at::Tensor rdna_conv2d(const at::Tensor& input, const at::Tensor& weight,
                        at::IntArrayRef padding, at::IntArrayRef dilation, 
                        int64_t groups) {
     RDNADeviceGuard guard(input.device().index());
+    rdna::ScopedEvent op_event(rdna::EventType::FRAMEWORK_OP, "aten::conv2d");
     
     auto input_rdna = to_rdna(input);
     auto weight_rdna = to_rdna(weight);
@@ -146,14 +172,98 @@ void rdna_empty_cache() {
 }
 
 int64_t rdna_current_device() {
-    int device_id;
-    // hipGetDevice(&device_id); // Would use HIP in real implementation
-    device_id = 0; // Placeholder
-    return device_id;
+    return rdna::DeviceManager::get_instance().get_current_device();
 }
 
 void rdna_set_device(c10::DeviceIndex device_index) {
-    // hipSetDevice(device_index); // Would use HIP in real implementation
+    rdna::DeviceManager::get_instance().set_current_device(device_index);
+}
+
+// Graph capture, mirroring torch.cuda.CUDAGraph. Capture runs on a side
+// stream per graph, made current for the capturing thread; ops it calls
+// between capture_begin and capture_end are recorded rather than run, and
+// tensors they allocate come from the graph's private pool, so they stay
+// valid across replays.
+class RDNAGraph {
+public:
+    RDNAGraph() : device_id_(-1) {}
+    
+    void capture_begin(uint64_t pool = 0) {
+        TORCH_CHECK(!graph_ && !stream_guard_, "RDNAGraph has already been captured; call reset() first");
+        device_id_ = rdna::DeviceManager::get_instance().get_current_device();
+        auto context = rdna::DeviceManager::get_instance().get_context(device_id_);
+        TORCH_CHECK(context, "No RDNA device ", device_id_);
+        if (!stream_) {
+            stream_ = context->create_stream();
+            TORCH_CHECK(stream_, "Failed to create RDNA capture stream");
+        }
+        
+        // Work already queued on the null stream must not be captured, nor
+        // race with the first replay
+        context->synchronize();
+        TORCH_CHECK(stream_->begin_capture(pool), "Failed to begin RDNA graph capture");
+        stream_guard_ = std::make_unique<rdna::StreamGuard>(stream_);
+    }
+    
+    void capture_end() {
+        TORCH_CHECK(stream_guard_, "capture_end called without capture_begin");
+        stream_guard_.reset();
+        graph_ = stream_->end_capture();
+        TORCH_CHECK(graph_, "RDNA graph capture failed");
+        TORCH_CHECK(graph_->instantiate(), "Failed to instantiate RDNA graph");
+    }
+    
+    void replay() {
+        TORCH_CHECK(graph_, "RDNAGraph must be captured before replay");
+        TORCH_CHECK(graph_->replay(*stream_), "RDNA graph replay failed");
+    }
+    
+    void reset() {
+        if (stream_guard_) {
+            stream_guard_.reset();
+            stream_->end_capture();
+        }
+        graph_.reset();
+    }
+    
+    // Pass to another graph's capture_begin to share this graph's memory
+    uint64_t pool() const {
+        return graph_ ? graph_->get_pool_id() : 0;
+    }
+    
+private:
+    int device_id_;
+    std::shared_ptr<rdna::Stream> stream_;
+    std::shared_ptr<rdna::Graph> graph_;
+    std::unique_ptr<rdna::StreamGuard> stream_guard_;
+};
+
+// A pool to capture several graphs into, for torch.cuda.graph_pool_handle
+// parity. The handle holds a reference on the pool, so the pool outlives
+// the handle or the last graph captured into it, whichever goes last.
+class RDNAGraphPool {
+public:
+    RDNAGraphPool()
+        : device_id_(rdna::DeviceManager::get_instance().get_current_device()),
+          pool_id_(rdna::MemoryManager::get_instance().get_allocator(device_id_)->create_private_pool()) {}
+    
+    ~RDNAGraphPool() {
+        rdna::MemoryManager::get_instance().get_allocator(device_id_)->release_private_pool(pool_id_);
+    }
+    
+    RDNAGraphPool(const RDNAGraphPool&) = delete;
+    RDNAGraphPool& operator=(const RDNAGraphPool&) = delete;
+    
+    int device() const { return device_id_; }
+    uint64_t id() const { return pool_id_; }
+    
+private:
+    int device_id_;
+    uint64_t pool_id_;
+};
+
+std::shared_ptr<RDNAGraphPool> rdna_graph_pool_handle() {
+    return std::make_shared<RDNAGraphPool>();
 }
 
 // Operator registration
@@ -180,6 +290,23 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
     m.def("empty_cache", &rdna_empty_cache, "Empty RDNA memory cache");
     m.def("current_device", &rdna_current_device, "Get current RDNA device");
     m.def("set_device", &rdna_set_device, "Set current RDNA device");
+    m.def("graph_pool_handle", &rdna_graph_pool_handle, "Create a memory pool for sharing between RDNA graphs");
+    
+    py::class_<RDNAGraphPool, std::shared_ptr<RDNAGraphPool>>(m, "RDNAGraphPool")
+        .def("id", &RDNAGraphPool::id);
+    
+    py::class_<RDNAGraph>(m, "RDNAGraph")
+        .def(py::init<>())
+        .def("capture_begin", &RDNAGraph::capture_begin, py::arg("pool") = 0)
+        .def("capture_begin", [](RDNAGraph& self, const RDNAGraphPool& pool) {
+                 TORCH_CHECK(pool.device() == rdna::DeviceManager::get_instance().get_current_device(),
+                             "Graph pool belongs to RDNA device ", pool.device());
+                 self.capture_begin(pool.id());
+             }, py::arg("pool"))
+        .def("capture_end", &RDNAGraph::capture_end)
+        .def("replay", &RDNAGraph::replay)
+        .def("reset", &RDNAGraph::reset)
+        .def("pool", &RDNAGraph::pool);
 }
 
 } // namespace pytorch
@@ -0,0 +1,42 @@
+#ifndef RDNA_ATTENTION_H
+#define RDNA_ATTENTION_H
+
+#include "rdna/kernels.h"
+
+namespace rdna {
+
+/**
+ * @brief Tiled scaled-dot-product attention
+ *
+ * q and o are [batch, heads, seq_q, head_dim], k and v are
+ * [batch, heads, seq_k, head_dim]; any strides are accepted as long as
+ * head_dim is unit-stride, and gradients share the layout of the tensor
+ * they belong to. fp16 and bf16 only, accumulating in fp32, head_dim up to
+ * 128. Scores are never materialized: key (forward) or query (backward)
+ * tiles are staged in LDS, blocking factor picked to fit
+ * shared_memory_per_block, and only the per-row logsumexp is kept for the
+ * backward pass. Throws std::invalid_argument on mismatched descriptors,
+ * returns false if a launch fails.
+ */
+
+// logsumexp is optional here and receives [batch, heads, seq_q] fp32
+bool launch_attention_forward(const TensorDesc& q, const void* q_data,
+                              const TensorDesc& k, const void* k_data,
+                              const TensorDesc& v, const void* v_data,
+                              const TensorDesc& o, void* o_data,
+                              float* logsumexp, const AttentionConfig& config,
+                              const DeviceProperties& properties, void* stream);
+
+// Row terms sum(dO * O) live in the stream's workspace arena on the device
+bool launch_attention_backward(const TensorDesc& q, const void* q_data,
+                               const TensorDesc& k, const void* k_data,
+                               const TensorDesc& v, const void* v_data,
+                               const TensorDesc& o, const void* o_data,
+                               const void* grad_o_data, const float* logsumexp,
+                               void* grad_q_data, void* grad_k_data, void* grad_v_data,
+                               const AttentionConfig& config,
+                               const DeviceProperties& properties, void* stream);
+
+} // namespace rdna
+
+#endif // RDNA_ATTENTION_H
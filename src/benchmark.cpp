@@ -0,0 +1,751 @@
+#include "rdna/profiler.h"
+#include "rdna/device.h"
+#include "rdna/memory.h"
+#include "benchmark.h"
+#include "device_scope.h"
+#include <hip/hip_runtime.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace rdna {
+
+namespace {
+
+constexpr int kResultsFileVersion = 1;
+
+// Buffers are filled with this byte: 0x3c3c is ~1.0 in fp16 and a small
+// normal value in fp32 and bf16, so no kernel runs on zeros or denormals
+constexpr int kFillByte = 0x3c;
+
+constexpr int kLaunchesPerRepetition = 1000;   // Launch overhead
+constexpr int kRoundTripsPerRepetition = 100;  // Launch-and-wait latency
+constexpr int kAllocationsPerThread = 2000;
+
+// Two-sided 95% Student-t critical values for 1..30 degrees of freedom
+const double kStudentT95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+double student_t95(size_t degrees_of_freedom) {
+    if (degrees_of_freedom == 0) return 0.0;
+    if (degrees_of_freedom <= 30) return kStudentT95[degrees_of_freedom - 1];
+    return 1.960;
+}
+
+double host_ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+const char* data_type_name(int data_type) {
+    switch (data_type) {
+        case 1: return "fp16";
+        case 2: return "bf16";
+        default: return "fp32";
+    }
+}
+
+std::string size_name(size_t bytes) {
+    if (bytes >= (size_t(1) << 20) && bytes % (size_t(1) << 20) == 0) {
+        return std::to_string(bytes >> 20) + "MB";
+    }
+    if (bytes >= 1024 && bytes % 1024 == 0) {
+        return std::to_string(bytes >> 10) + "KB";
+    }
+    return std::to_string(bytes) + "B";
+}
+
+struct DeviceBuffer {
+    void* data = nullptr;
+
+    DeviceBuffer(size_t size, int device_id) {
+        if (size == 0) {
+            return;
+        }
+        data = MemoryManager::get_instance().allocate(size, device_id);
+        if (data) {
+            MemoryManager::get_instance().memset(data, kFillByte, size);
+        }
+    }
+    ~DeviceBuffer() {
+        if (data) {
+            MemoryManager::get_instance().deallocate(data);
+        }
+    }
+    DeviceBuffer(const DeviceBuffer&) = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+};
+
+// Private stream with an event pair for timing work queued on it
+class BenchStream {
+public:
+    BenchStream() {
+        valid_ = hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking) == hipSuccess &&
+                 hipEventCreate(&start_) == hipSuccess && hipEventCreate(&stop_) == hipSuccess;
+    }
+    ~BenchStream() {
+        if (start_) hipEventDestroy(start_);
+        if (stop_) hipEventDestroy(stop_);
+        if (stream_) hipStreamDestroy(stream_);
+    }
+    BenchStream(const BenchStream&) = delete;
+    BenchStream& operator=(const BenchStream&) = delete;
+
+    bool valid() const { return valid_; }
+    hipStream_t get() const { return stream_; }
+
+    // Device time of the work body queues, or a negative value if it fails
+    template <typename F>
+    double time_ms(F&& body) {
+        hipEventRecord(start_, stream_);
+        if (!body(stream_)) {
+            hipStreamSynchronize(stream_);
+            return -1.0;
+        }
+        hipEventRecord(stop_, stream_);
+        if (hipEventSynchronize(stop_) != hipSuccess) {
+            return -1.0;
+        }
+        float elapsed = 0.0f;
+        hipEventElapsedTime(&elapsed, start_, stop_);
+        return elapsed;
+    }
+
+private:
+    hipStream_t stream_ = nullptr;
+    hipEvent_t start_ = nullptr;
+    hipEvent_t stop_ = nullptr;
+    bool valid_ = false;
+};
+
+// Runs warmup, then one sample per repetition. run_once returns the
+// repetition's time in ms (negative on failure) and value_of turns a time
+// into the reported value. repetitions is 0 in the result if anything failed.
+template <typename Run, typename Value>
+BenchmarkResult measure(BenchmarkResult result, const BenchmarkOptions& options, Run&& run_once,
+                        Value&& value_of) {
+    for (int i = 0; i < options.warmup; ++i) {
+        if (run_once() < 0) {
+            return result;
+        }
+    }
+
+    std::vector<double> values;
+    double total_ms = 0.0;
+    for (int i = 0; i < std::max(options.repetitions, 1); ++i) {
+        double ms = run_once();
+        if (ms < 0) {
+            return result;
+        }
+        total_ms += ms;
+        values.push_back(value_of(std::max(ms, 1e-6)));
+    }
+
+    double mean = 0.0;
+    for (double v : values) mean += v;
+    mean /= values.size();
+    double variance = 0.0;
+    for (double v : values) variance += (v - mean) * (v - mean);
+    variance = values.size() > 1 ? variance / (values.size() - 1) : 0.0;
+
+    result.value = mean;
+    result.ci95 = student_t95(values.size() - 1) * std::sqrt(variance / values.size());
+    result.min_value = *std::min_element(values.begin(), values.end());
+    result.max_value = *std::max_element(values.begin(), values.end());
+    result.time_ms = total_ms / values.size();
+    result.repetitions = static_cast<int>(values.size());
+    return result;
+}
+
+BenchmarkResult make_result(const std::string& name, const char* category, const char* unit, int device_id,
+                            bool lower_is_better = false) {
+    BenchmarkResult result;
+    result.name = name;
+    result.category = category;
+    result.unit = unit;
+    result.arch = DeviceManager::get_instance().get_device_properties(device_id).arch;
+    result.lower_is_better = lower_is_better;
+    return result;
+}
+
+void write_json_string(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+// Raw text of key's value on a line written by save_results; strings come
+// back unquoted and unescaped
+bool json_field(const std::string& line, const std::string& key, std::string& value) {
+    size_t pos = line.find("\"" + key + "\":");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos += key.size() + 3;
+    while (pos < line.size() && line[pos] == ' ') ++pos;
+    value.clear();
+    if (pos < line.size() && line[pos] == '"') {
+        for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+            if (line[pos] == '\\' && pos + 1 < line.size()) ++pos;
+            value += line[pos];
+        }
+        return pos < line.size();
+    }
+    size_t end = line.find_first_of(",}", pos);
+    value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    return !value.empty();
+}
+
+double json_number(const std::string& line, const std::string& key) {
+    std::string value;
+    return json_field(line, key, value) ? std::strtod(value.c_str(), nullptr) : 0.0;
+}
+
+} // namespace
+
+BenchmarkResult::BenchmarkResult()
+    : value(0.0), ci95(0.0), min_value(0.0), max_value(0.0), time_ms(0.0), intensity(0.0),
+      repetitions(0), lower_is_better(false) {}
+
+// BenchmarkRunner implementation
+BenchmarkRunner& BenchmarkRunner::get_instance() {
+    static BenchmarkRunner instance;
+    return instance;
+}
+
+void BenchmarkRunner::set_options(const BenchmarkOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+BenchmarkOptions BenchmarkRunner::get_options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+void BenchmarkRunner::record(const BenchmarkResult& result) {
+    if (result.repetitions == 0) {
+        std::cerr << "Warning: Benchmark " << result.name << " failed" << std::endl;
+        return;
+    }
+    std::cout << std::left << std::setw(44) << result.name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << result.value << " +/- " << std::setw(8) << result.ci95 << " "
+              << result.unit << std::endl;
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.push_back(result);
+}
+
+void BenchmarkRunner::run_benchmarks(int device_id, const std::vector<std::string>& categories) {
+    auto wants = [&](const char* category) {
+        return categories.empty() || std::find(categories.begin(), categories.end(), category) != categories.end();
+    };
+
+    DeviceProperties props = DeviceManager::get_instance().get_device_properties(device_id);
+    bool quick = get_options().quick;
+    std::cout << "Running RDNA benchmarks on device " << device_id << " (" << props.name << ", "
+              << props.arch << ")" << std::endl;
+
+    bool kernels = KernelManager::get_instance().initialize_kernels(device_id);
+    if (!kernels) {
+        std::cerr << "Warning: Kernels unavailable on device " << device_id
+                  << ", skipping gemm, conv and roofline benchmarks" << std::endl;
+    }
+
+    std::vector<int> data_types = {0};
+    if (props.supports_fp16) data_types.push_back(1);
+    if (props.supports_bf16) data_types.push_back(2);
+
+    if (wants("bandwidth")) {
+        const size_t size = (quick ? 64 : 256) * (size_t(1) << 20);
+        for (CopyKind kind : {CopyKind::DeviceToDevice, CopyKind::HostToDevice, CopyKind::DeviceToHost,
+                              CopyKind::PinnedToDevice, CopyKind::DeviceToPinned}) {
+            benchmark_copy_bandwidth(kind, size, device_id);
+        }
+    }
+
+    if (wants("latency")) {
+        benchmark_kernel_latency(device_id);
+    }
+
+    if (kernels && wants("gemm")) {
+        // Square sweep, then transformer projections and a decode-sized GEMV-like shape
+        struct { int m, n, k; } shapes[] = {
+            {1024, 1024, 1024}, {2048, 2048, 2048}, {4096, 4096, 4096}, {8192, 8192, 8192},
+            {4096, 11008, 4096}, {4096, 4096, 11008}, {16, 4096, 4096}
+        };
+        size_t count = quick ? 3 : sizeof(shapes) / sizeof(shapes[0]);
+        for (int data_type : data_types) {
+            for (size_t i = 0; i < count; ++i) {
+                benchmark_matrix_multiply(shapes[i].m, shapes[i].n, shapes[i].k, device_id, data_type);
+            }
+        }
+    }
+
+    if (kernels && wants("conv")) {
+        // ResNet-50 stages
+        struct { int batch, size, channels, filters, kernel; } shapes[] = {
+            {32, 56, 64, 64, 3}, {32, 28, 128, 128, 3}, {32, 14, 256, 256, 3}, {32, 7, 512, 512, 3},
+            {32, 56, 256, 64, 1}
+        };
+        size_t count = quick ? 1 : sizeof(shapes) / sizeof(shapes[0]);
+        for (int data_type : data_types) {
+            for (size_t i = 0; i < count; ++i) {
+                benchmark_convolution(shapes[i].batch, shapes[i].size, shapes[i].size, shapes[i].channels,
+                                      shapes[i].filters, shapes[i].kernel, device_id, data_type);
+            }
+        }
+    }
+
+    if (wants("allocator")) {
+        int max_threads = static_cast<int>(std::min(16u, std::max(1u, std::thread::hardware_concurrency())));
+        for (size_t size : {size_t(4096), size_t(1) << 20}) {
+            for (int threads : {1, 4, max_threads}) {
+                if (threads > max_threads || (quick && threads > 4)) {
+                    continue;
+                }
+                benchmark_allocator(threads, size, device_id);
+                if (threads == max_threads) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (kernels && wants("roofline")) {
+        for (size_t elements : {size_t(1) << 20, size_t(1) << 24, size_t(1) << 26}) {
+            if (quick && elements > (size_t(1) << 24)) {
+                continue;
+            }
+            for (int data_type : data_types) {
+                benchmark_elementwise(elements, data_type, device_id);
+                benchmark_reduction(elements, data_type, device_id);
+            }
+        }
+    }
+}
+
+double BenchmarkRunner::benchmark_memory_bandwidth(int device_id, size_t size) {
+    return benchmark_copy_bandwidth(CopyKind::DeviceToDevice, size, device_id);
+}
+
+double BenchmarkRunner::benchmark_copy_bandwidth(CopyKind kind, size_t size, int device_id) {
+    static const char* const names[] = {"d2d", "h2d_pageable", "d2h_pageable", "h2d_pinned", "d2h_pinned"};
+    BenchmarkResult result = make_result(std::string("copy_") + names[static_cast<int>(kind)] + "_" + size_name(size),
+                                         "bandwidth", "GB/s", device_id);
+
+    DeviceScope scope(device_id);
+    BenchStream stream;
+    PinnedHostAllocator& pinned_allocator = MemoryManager::get_instance().get_pinned_allocator();
+    DeviceBuffer device(size, device_id);
+    DeviceBuffer device_copy(kind == CopyKind::DeviceToDevice ? size : 0, device_id);
+    std::vector<char> pageable;
+    void* pinned = nullptr;
+
+    void* dst = nullptr;
+    const void* src = nullptr;
+    switch (kind) {
+        case CopyKind::DeviceToDevice:
+            src = device.data;
+            dst = device_copy.data;
+            break;
+        case CopyKind::HostToDevice:
+        case CopyKind::DeviceToHost:
+            pageable.assign(size, static_cast<char>(kFillByte));
+            src = kind == CopyKind::HostToDevice ? pageable.data() : device.data;
+            dst = kind == CopyKind::HostToDevice ? device.data : static_cast<void*>(pageable.data());
+            break;
+        case CopyKind::PinnedToDevice:
+        case CopyKind::DeviceToPinned:
+            pinned = pinned_allocator.allocate(size);
+            src = kind == CopyKind::PinnedToDevice ? pinned : device.data;
+            dst = kind == CopyKind::PinnedToDevice ? device.data : pinned;
+            break;
+    }
+
+    if (stream.valid() && src && dst) {
+        const double bytes = static_cast<double>(kind == CopyKind::DeviceToDevice ? 2 * size : size);
+        result = measure(result, get_options(),
+            [&]() {
+                return stream.time_ms([&](hipStream_t s) {
+                    return hipMemcpyAsync(dst, src, size, hipMemcpyDefault, s) == hipSuccess;
+                });
+            },
+            [&](double ms) { return bytes / (ms * 1e6); });
+    }
+    if (pinned) {
+        pinned_allocator.deallocate(pinned, stream.get());
+    }
+    record(result);
+    return result.value;
+}
+
+double BenchmarkRunner::benchmark_kernel_latency(int device_id) {
+    DeviceScope scope(device_id);
+    BenchStream stream;
+    if (!stream.valid()) {
+        record(make_result("launch_latency", "latency", "us", device_id, true));
+        return 0.0;
+    }
+    BenchmarkOptions options = get_options();
+
+    // Host cost of queueing a launch, the queue drained between samples
+    BenchmarkResult overhead = measure(make_result("launch_overhead", "latency", "us", device_id, true), options,
+        [&]() {
+            auto start = std::chrono::steady_clock::now();
+            bool launched = launch_empty_kernels(kLaunchesPerRepetition, stream.get());
+            double ms = host_ms_since(start);
+            hipStreamSynchronize(stream.get());
+            return launched ? ms : -1.0;
+        },
+        [](double ms) { return ms * 1e3 / kLaunchesPerRepetition; });
+    record(overhead);
+
+    BenchmarkResult latency = measure(make_result("launch_latency", "latency", "us", device_id, true), options,
+        [&]() {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kRoundTripsPerRepetition; ++i) {
+                if (!launch_empty_kernels(1, stream.get()) || hipStreamSynchronize(stream.get()) != hipSuccess) {
+                    return -1.0;
+                }
+            }
+            return host_ms_since(start);
+        },
+        [](double ms) { return ms * 1e3 / kRoundTripsPerRepetition; });
+    record(latency);
+    return latency.value;
+}
+
+double BenchmarkRunner::benchmark_matrix_multiply(int m, int n, int k, int device_id, int data_type) {
+    BenchmarkResult result = make_result(std::string("gemm_") + data_type_name(data_type) + "_" +
+                                         std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k),
+                                         "gemm", "TFLOPS", device_id);
+
+    DeviceScope scope(device_id);
+    BenchStream stream;
+    size_t um = m, un = n, uk = k;
+    TensorDesc a({um, uk}, data_type), b({uk, un}, data_type), c({um, un}, data_type);
+    DeviceBuffer a_buf(a.get_size(), device_id), b_buf(b.get_size(), device_id), c_buf(c.get_size(), device_id);
+    auto matmul = KernelManager::get_instance().get_matmul_kernel(device_id);
+
+    const double flops = 2.0 * m * n * k;
+    result.intensity = flops / (a.get_size() + b.get_size() + c.get_size());
+    if (stream.valid() && matmul && a_buf.data && b_buf.data && c_buf.data) {
+        result = measure(result, get_options(),
+            [&]() {
+                return stream.time_ms([&](hipStream_t s) {
+                    return matmul->matmul(a, a_buf.data, b, b_buf.data, c, c_buf.data, MatmulConfig(), s);
+                });
+            },
+            [&](double ms) { return flops / (ms * 1e9); });
+    }
+    record(result);
+    return result.value;
+}
+
+double BenchmarkRunner::benchmark_convolution(int batch, int height, int width, int channels,
+                                            int filters, int kernel_size, int device_id, int data_type) {
+    BenchmarkResult result = make_result(std::string("conv_") + data_type_name(data_type) + "_b" +
+                                         std::to_string(batch) + "_c" + std::to_string(channels) + "_f" +
+                                         std::to_string(filters) + "_k" + std::to_string(kernel_size) + "_" +
+                                         std::to_string(height) + "x" + std::to_string(width),
+                                         "conv", "TFLOPS", device_id);
+
+    DeviceScope scope(device_id);
+    BenchStream stream;
+    size_t n = batch, h = height, w = width, c = channels, f = filters, r = kernel_size;
+    TensorDesc input({n, c, h, w}, data_type), filter({f, c, r, r}, data_type), output({n, f, h, w}, data_type);
+    ConvConfig config;
+    config.padding = {kernel_size / 2, kernel_size / 2};
+    config.benchmark = true;  // The find runs during warmup
+    DeviceBuffer in_buf(input.get_size(), device_id), filter_buf(filter.get_size(), device_id),
+                 out_buf(output.get_size(), device_id);
+    auto conv = KernelManager::get_instance().get_conv_kernel(device_id);
+
+    const double flops = 2.0 * n * f * h * w * c * r * r;
+    result.intensity = flops / (input.get_size() + filter.get_size() + output.get_size());
+    if (stream.valid() && conv && in_buf.data && filter_buf.data && out_buf.data) {
+        result = measure(result, get_options(),
+            [&]() {
+                return stream.time_ms([&](hipStream_t s) {
+                    return conv->conv2d_forward(input, in_buf.data, filter, filter_buf.data,
+                                                output, out_buf.data, config, s);
+                });
+            },
+            [&](double ms) { return flops / (ms * 1e9); });
+    }
+    record(result);
+    return result.value;
+}
+
+double BenchmarkRunner::benchmark_allocator(int threads, size_t size, int device_id) {
+    BenchmarkResult result = make_result("alloc_free_" + size_name(size) + "_t" + std::to_string(threads),
+                                         "allocator", "Mops/s", device_id);
+    MemoryManager& memory = MemoryManager::get_instance();
+    threads = std::max(threads, 1);
+    const double pairs = static_cast<double>(threads) * kAllocationsPerThread;
+
+    result = measure(result, get_options(),
+        [&]() {
+            std::atomic<bool> go{false};
+            std::atomic<bool> failed{false};
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&]() {
+                    DeviceScope scope(device_id);
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < kAllocationsPerThread; ++i) {
+                        void* ptr = memory.allocate(size, device_id);
+                        if (!ptr) {
+                            failed.store(true, std::memory_order_relaxed);
+                            return;
+                        }
+                        memory.deallocate(ptr);
+                    }
+                });
+            }
+            auto start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            double ms = host_ms_since(start);
+            return failed.load() ? -1.0 : ms;
+        },
+        [&](double ms) { return pairs / (ms * 1e3); });
+    record(result);
+    return result.value;
+}
+
+double BenchmarkRunner::benchmark_elementwise(size_t elements, int data_type, int device_id) {
+    BenchmarkResult result = make_result(std::string("add_") + data_type_name(data_type) + "_" +
+                                         std::to_string(elements), "roofline", "GB/s", device_id);
+
+    DeviceScope scope(device_id);
+    BenchStream stream;
+    TensorDesc desc({elements}, data_type);
+    DeviceBuffer a(desc.get_size(), device_id), b(desc.get_size(), device_id), c(desc.get_size(), device_id);
+    auto custom = KernelManager::get_instance().get_custom_kernels(device_id);
+
+    const double bytes = 3.0 * desc.get_size();
+    result.intensity = elements / bytes;
+    if (stream.valid() && custom && a.data && b.data && c.data) {
+        result = measure(result, get_options(),
+            [&]() {
+                return stream.time_ms([&](hipStream_t s) {
+                    return custom->add(desc, a.data, desc, b.data, desc, c.data, s);
+                });
+            },
+            [&](double ms) { return bytes / (ms * 1e6); });
+    }
+    record(result);
+    return result.value;
+}
+
+double BenchmarkRunner::benchmark_reduction(size_t elements, int data_type, int device_id) {
+    BenchmarkResult result = make_result(std::string("sum_") + data_type_name(data_type) + "_" +
+                                         std::to_string(elements), "roofline", "GB/s", device_id);
+
+    DeviceScope scope(device_id);
+    BenchStream stream;
+    TensorDesc input({elements}, data_type), output({1}, data_type);
+    DeviceBuffer in_buf(input.get_size(), device_id), out_buf(output.get_size(), device_id);
+    auto custom = KernelManager::get_instance().get_custom_kernels(device_id);
+
+    const double bytes = static_cast<double>(input.get_size());
+    result.intensity = elements / bytes;
+    if (stream.valid() && custom && in_buf.data && out_buf.data) {
+        result = measure(result, get_options(),
+            [&]() {
+                return stream.time_ms([&](hipStream_t s) {
+                    return custom->sum(input, in_buf.data, output, out_buf.data, {}, s);
+                });
+            },
+            [&](double ms) { return bytes / (ms * 1e6); });
+    }
+    record(result);
+    return result.value;
+}
+
+std::vector<BenchmarkResult> BenchmarkRunner::get_results() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+}
+
+void BenchmarkRunner::clear_results() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.clear();
+}
+
+bool BenchmarkRunner::save_results(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Warning: Cannot write benchmark results to " << filename << std::endl;
+        return false;
+    }
+    BenchmarkOptions options = get_options();
+    std::vector<BenchmarkResult> results = get_results();
+
+    // One result per line, which load_results relies on
+    file << std::setprecision(9);
+    file << "{\n\"version\": " << kResultsFileVersion << ",\n";
+    file << "\"options\": {\"warmup\": " << options.warmup << ", \"repetitions\": " << options.repetitions
+         << ", \"quick\": " << (options.quick ? "true" : "false") << "},\n";
+    file << "\"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        file << "{\"name\": ";
+        write_json_string(file, r.name);
+        file << ", \"category\": ";
+        write_json_string(file, r.category);
+        file << ", \"unit\": ";
+        write_json_string(file, r.unit);
+        file << ", \"arch\": ";
+        write_json_string(file, r.arch);
+        file << ", \"value\": " << r.value << ", \"ci95\": " << r.ci95 << ", \"min\": " << r.min_value
+             << ", \"max\": " << r.max_value << ", \"time_ms\": " << r.time_ms << ", \"intensity\": " << r.intensity
+             << ", \"repetitions\": " << r.repetitions
+             << ", \"lower_is_better\": " << (r.lower_is_better ? "true" : "false") << "}"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "]\n}\n";
+    return static_cast<bool>(file);
+}
+
+bool BenchmarkRunner::load_results(const std::string& filename, std::vector<BenchmarkResult>& results) {
+    std::ifstream file(filename);
+    if (!file) {
+        return false;
+    }
+
+    results.clear();
+    bool versioned = false;
+    std::string line, value;
+    while (std::getline(file, line)) {
+        if (json_field(line, "version", value)) {
+            if (std::atoi(value.c_str()) != kResultsFileVersion) {
+                std::cerr << "Warning: Unsupported benchmark results version in " << filename << std::endl;
+                return false;
+            }
+            versioned = true;
+            continue;
+        }
+        BenchmarkResult result;
+        if (!json_field(line, "name", result.name)) {
+            continue;
+        }
+        json_field(line, "category", result.category);
+        json_field(line, "unit", result.unit);
+        json_field(line, "arch", result.arch);
+        result.value = json_number(line, "value");
+        result.ci95 = json_number(line, "ci95");
+        result.min_value = json_number(line, "min");
+        result.max_value = json_number(line, "max");
+        result.time_ms = json_number(line, "time_ms");
+        result.intensity = json_number(line, "intensity");
+        result.repetitions = static_cast<int>(json_number(line, "repetitions"));
+        result.lower_is_better = json_field(line, "lower_is_better", value) && value == "true";
+        results.push_back(result);
+    }
+    return versioned;
+}
+
+void BenchmarkRunner::compare_with_baseline(const std::string& operation, double rdna_time,
+                                           double baseline_time, const std::string& baseline_name) {
+    double speedup = baseline_time / rdna_time;
+    std::cout << operation << " performance:" << std::endl;
+    std::cout << "  RDNA: " << rdna_time << " ms" << std::endl;
+    std::cout << "  " << baseline_name << ": " << baseline_time << " ms" << std::endl;
+    std::cout << "  Speedup: " << std::fixed << std::setprecision(2) << speedup << "x" << std::endl;
+
+    if (speedup > 1.0) {
+        std::cout << "  RDNA is " << (speedup - 1.0) * 100 << "% faster" << std::endl;
+    } else {
+        std::cout << "  RDNA is " << (1.0 - speedup) * 100 << "% slower" << std::endl;
+    }
+}
+
+int BenchmarkRunner::compare_with_baseline(const std::string& baseline_file, double tolerance) const {
+    std::vector<BenchmarkResult> baseline;
+    if (!load_results(baseline_file, baseline)) {
+        std::cerr << "Warning: Cannot read benchmark baseline " << baseline_file << std::endl;
+        return -1;
+    }
+    std::unordered_map<std::string, const BenchmarkResult*> by_name;
+    for (const auto& result : baseline) {
+        by_name[result.name] = &result;
+    }
+
+    int regressions = 0;
+    std::cout << "Comparison with " << baseline_file << ":" << std::endl;
+    for (const auto& current : get_results()) {
+        auto it = by_name.find(current.name);
+        if (it == by_name.end() || it->second->value <= 0) {
+            continue;
+        }
+        const BenchmarkResult& base = *it->second;
+        double change = (current.value - base.value) / base.value;
+        double worse = current.lower_is_better ? change : -change;
+        bool significant = std::fabs(current.value - base.value) >
+                           std::sqrt(current.ci95 * current.ci95 + base.ci95 * base.ci95);
+        bool regressed = worse > tolerance && significant;
+        bool improved = -worse > tolerance && significant;
+        regressions += regressed ? 1 : 0;
+
+        std::cout << "  " << std::left << std::setw(44) << current.name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << base.value << " -> " << std::setw(12)
+                  << current.value << " " << current.unit << " (" << std::showpos << std::setprecision(1)
+                  << change * 100 << "%" << std::noshowpos << ")"
+                  << (regressed ? " REGRESSION" : improved ? " improved" : "")
+                  << (base.arch != current.arch ? " [baseline on " + base.arch + "]" : "") << std::endl;
+    }
+    std::cout << regressions << " regression(s) beyond " << tolerance * 100 << "%" << std::endl;
+    return regressions;
+}
+
+void BenchmarkRunner::generate_benchmark_report(const std::string& filename) {
+    std::ostream* output = &std::cout;
+    std::ofstream file;
+    if (!filename.empty()) {
+        file.open(filename);
+        if (file.is_open()) {
+            output = &file;
+        }
+    }
+
+    BenchmarkOptions options = get_options();
+    *output << "RDNA Benchmark Report\n";
+    *output << "=====================\n\n";
+    *output << "Warmup: " << options.warmup << ", repetitions: " << options.repetitions
+            << ", intervals are 95% confidence\n";
+
+    std::string category;
+    for (const auto& result : get_results()) {
+        if (result.category != category) {
+            category = result.category;
+            *output << "\n[" << category << "]\n";
+        }
+        *output << "  " << std::left << std::setw(44) << result.name << std::right << std::fixed
+                << std::setprecision(3) << std::setw(12) << result.value << " +/- " << std::setw(8)
+                << result.ci95 << " " << result.unit;
+        if (result.intensity > 0) {
+            *output << "  (" << std::setprecision(2) << result.intensity << " FLOP/B)";
+        }
+        *output << "\n";
+    }
+}
+
+} // namespace rdna
@@ -0,0 +1,12 @@
+#ifndef RDNA_BENCHMARK_H
+#define RDNA_BENCHMARK_H
+
+namespace rdna {
+
+// Queue count launches of a one-thread kernel that does nothing, for
+// measuring launch overhead. Returns false if a launch fails.
+bool launch_empty_kernels(int count, void* stream);
+
+} // namespace rdna
+
+#endif // RDNA_BENCHMARK_H
@@ -0,0 +1,764 @@
+#include "rdna/collectives.h"
+#include "rdna/device.h"
+#include "rdna/kernels.h"
+#include "rdna/memory.h"
+#include "device_scope.h"
+#include <hip/hip_runtime.h>
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef RDNA_HAVE_RCCL
+#include <rccl/rccl.h>
+#endif
+
+namespace rdna {
+
+namespace {
+
+constexpr size_t kDefaultBucketSize = 25 * 1024 * 1024;
+
+// Stream the caller queued rank's inputs on
+void* caller_stream(const std::vector<Stream*>& streams, int rank, int device_id) {
+    if (streams.empty()) {
+        return DeviceManager::get_instance().get_current_stream_handle(device_id);
+    }
+    return streams[rank] ? streams[rank]->get_native_handle() : nullptr;
+}
+
+size_t element_size(int data_type) {
+    if (data_type != 0 && data_type != 2) {
+        throw std::invalid_argument("Collectives support float32 and bfloat16");
+    }
+    return get_data_type_size(data_type);
+}
+
+// Elements [chunk_begin(c), chunk_begin(c + 1)) of count split n ways
+size_t chunk_begin(size_t count, int n, int c) {
+    return count * c / n;
+}
+
+void* offset_bytes(const void* ptr, size_t bytes) {
+    return static_cast<char*>(const_cast<void*>(ptr)) + bytes;
+}
+
+// Scratch on rank's device, freed in order on the communicator's stream
+class ScratchBuffer {
+public:
+    ScratchBuffer(size_t size, int device_id, void* stream) : ptr_(nullptr) {
+        if (size > 0) {
+            AllocationOptions options = {};
+            options.stream = stream;
+            options.tag = "collective";
+            ptr_ = MemoryManager::get_instance().allocate(size, device_id, options);
+        }
+    }
+    ~ScratchBuffer() {
+        if (ptr_) {
+            MemoryManager::get_instance().deallocate(ptr_);
+        }
+    }
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    void* get() const { return ptr_; }
+
+private:
+    void* ptr_;
+};
+
+#ifdef RDNA_HAVE_RCCL
+ncclDataType_t to_rccl_type(int data_type) {
+    return data_type == 2 ? ncclBfloat16 : ncclFloat32;
+}
+#endif
+
+} // namespace
+
+// CollectiveConfig implementation
+CollectiveConfig::CollectiveConfig()
+    : bucket_size(kDefaultBucketSize), average(false), use_rccl(true) {}
+
+// Per-rank state. Step events alternate by step parity, so a rank can
+// record its next step while neighbours are still queuing waits on its
+// previous one.
+struct Communicator::Rank {
+    int device_id;
+    std::shared_ptr<DeviceContext> context;
+    std::shared_ptr<Stream> stream;
+    std::shared_ptr<CustomKernels> kernels;
+    std::array<hipEvent_t, 2> step_events{};
+    hipEvent_t done = nullptr;
+    void* scale = nullptr;  // float 1/size on the device, for averaging
+
+    Rank() = default;
+    Rank(const Rank&) = delete;
+    Rank& operator=(const Rank&) = delete;
+    ~Rank() {
+        DeviceScope scope(device_id);
+        for (hipEvent_t event : step_events) {
+            if (event) {
+                hipEventDestroy(event);
+            }
+        }
+        if (done) {
+            hipEventDestroy(done);
+        }
+        if (scale) {
+            MemoryManager::get_instance().deallocate(scale);
+        }
+    }
+
+    hipStream_t hip_stream() const {
+        return static_cast<hipStream_t>(stream->get_native_handle());
+    }
+};
+
+// Joins the ring when a pass goes out of scope, including on a failed
+// launch. Declared after a pass's scratch buffers, so their stream-ordered
+// frees come after the join too.
+struct Communicator::NeighbourJoin {
+    Communicator& communicator;
+    const int& steps;  // Ring steps queued so far
+
+    ~NeighbourJoin() {
+        communicator.join_neighbours(steps - 1);
+    }
+};
+
+// Communicator implementation
+Communicator::Communicator(const std::vector<int>& device_ids, const CollectiveConfig& config)
+    : device_ids_(device_ids), config_(config), initialized_(false) {
+    if (device_ids_.empty()) {
+        throw std::invalid_argument("Communicator needs at least one device");
+    }
+    int count = DeviceManager::get_instance().device_count();
+    for (size_t i = 0; i < device_ids_.size(); ++i) {
+        if (device_ids_[i] < 0 || device_ids_[i] >= count) {
+            throw std::invalid_argument("Invalid device ID");
+        }
+        if (std::find(device_ids_.begin(), device_ids_.begin() + i, device_ids_[i]) != device_ids_.begin() + i) {
+            throw std::invalid_argument("Communicator devices must be distinct");
+        }
+    }
+}
+
+Communicator::~Communicator() {
+    if (initialized_) {
+        try {
+            synchronize();
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+        }
+    }
+#ifdef RDNA_HAVE_RCCL
+    for (void* comm : rccl_comms_) {
+        ncclCommDestroy(static_cast<ncclComm_t>(comm));
+    }
+#endif
+}
+
+bool Communicator::initialize() {
+    if (initialized_) {
+        return true;
+    }
+
+    // Ranks are kept only once all of them are set up, so a failed call
+    // leaves nothing behind for a retry to duplicate
+    DeviceManager& devices = DeviceManager::get_instance();
+    const int n = size();
+    const float scale = 1.0f / n;
+    std::vector<std::unique_ptr<Rank>> ranks;
+    for (int r = 0; r < n; ++r) {
+        auto rank = std::make_unique<Rank>();
+        rank->device_id = device_ids_[r];
+        DeviceScope scope(rank->device_id);
+
+        // High priority, so transfers are not starved by the backward
+        // kernels they overlap with
+        rank->context = devices.get_context(rank->device_id);
+        rank->stream = rank->context->create_stream(StreamPriority::HIGH);
+        rank->kernels = KernelManager::get_instance().get_custom_kernels(rank->device_id);
+        if (!rank->kernels->is_initialized() && !rank->kernels->initialize()) {
+            return false;
+        }
+        for (hipEvent_t& event : rank->step_events) {
+            if (hipEventCreateWithFlags(&event, hipEventDisableTiming) != hipSuccess) {
+                return false;
+            }
+        }
+        if (hipEventCreateWithFlags(&rank->done, hipEventDisableTiming) != hipSuccess) {
+            return false;
+        }
+
+        AllocationOptions options = {};
+        options.stream = rank->stream->get_native_handle();
+        rank->scale = MemoryManager::get_instance().allocate(sizeof(float), rank->device_id, options);
+        if (!rank->scale ||
+            hipMemcpyAsync(rank->scale, &scale, sizeof(float), hipMemcpyHostToDevice, rank->hip_stream()) != hipSuccess ||
+            hipStreamSynchronize(rank->hip_stream()) != hipSuccess) {
+            return false;
+        }
+        ranks.push_back(std::move(rank));
+    }
+    ranks_ = std::move(ranks);
+
+    // Ring neighbours read each other's buffers directly
+    for (int r = 0; n > 1 && r < n; ++r) {
+        int next = device_ids_[(r + 1) % n];
+        devices.enable_peer_access(device_ids_[r], next);
+        devices.enable_peer_access(next, device_ids_[r]);
+    }
+
+#ifdef RDNA_HAVE_RCCL
+    if (config_.use_rccl && n > 1) {
+        std::vector<ncclComm_t> comms(n);
+        if (ncclCommInitAll(comms.data(), n, device_ids_.data()) == ncclSuccess) {
+            rccl_comms_.assign(comms.begin(), comms.end());
+        } else {
+            std::cerr << "Warning: RCCL initialization failed, using peer-to-peer rings" << std::endl;
+        }
+    }
+#endif
+
+    initialized_ = true;
+    return true;
+}
+
+bool Communicator::is_initialized() const {
+    return initialized_;
+}
+
+int Communicator::size() const {
+    return static_cast<int>(device_ids_.size());
+}
+
+const std::vector<int>& Communicator::get_device_ids() const {
+    return device_ids_;
+}
+
+const CollectiveConfig& Communicator::get_config() const {
+    return config_;
+}
+
+bool Communicator::uses_rccl() const {
+    return !rccl_comms_.empty();
+}
+
+std::shared_ptr<Stream> Communicator::get_stream(int rank) const {
+    if (rank < 0 || rank >= static_cast<int>(ranks_.size())) {
+        throw std::invalid_argument("Invalid rank");
+    }
+    return ranks_[rank]->stream;
+}
+
+void Communicator::begin(const std::vector<Stream*>& streams) {
+    if (!initialized_) {
+        throw std::runtime_error("Communicator not initialized");
+    }
+    if (!streams.empty() && streams.size() != ranks_.size()) {
+        throw std::invalid_argument("Expected one stream per rank");
+    }
+
+    // Step -1 is the inputs being ready, recorded on our stream so it also
+    // covers the end of the previous collective
+    for (int r = 0; r < size(); ++r) {
+        Rank& rank = *ranks_[r];
+        DeviceScope scope(rank.device_id);
+        hipEvent_t ready = rank.step_events[1];
+        hipEventRecord(ready, static_cast<hipStream_t>(caller_stream(streams, r, rank.device_id)));
+        hipStreamWaitEvent(rank.hip_stream(), ready, 0);
+        hipEventRecord(ready, rank.hip_stream());
+    }
+}
+
+void Communicator::end() {
+    for (auto& rank : ranks_) {
+        DeviceScope scope(rank->device_id);
+        hipEventRecord(rank->done, rank->hip_stream());
+    }
+}
+
+void Communicator::wait_for_neighbours(int rank, int step) {
+    const int n = size();
+    const int parity = (step + 1) % 2;  // Step - 1
+    hipStream_t stream = ranks_[rank]->hip_stream();
+    hipStreamWaitEvent(stream, ranks_[(rank + n - 1) % n]->step_events[parity], 0);
+    if (n > 2) {
+        hipStreamWaitEvent(stream, ranks_[(rank + 1) % n]->step_events[parity], 0);
+    }
+}
+
+void Communicator::finish_step(int rank, int step) {
+    hipEventRecord(ranks_[rank]->step_events[step % 2], ranks_[rank]->hip_stream());
+}
+
+void Communicator::join_neighbours(int last_step) {
+    if (last_step < 0 || size() == 1) {
+        return;
+    }
+    for (int r = 0; r < size(); ++r) {
+        DeviceScope scope(ranks_[r]->device_id);
+        wait_for_neighbours(r, last_step + 1);
+    }
+}
+
+bool Communicator::all_reduce(const std::vector<void*>& buffers, size_t count, int data_type,
+                              const std::vector<Stream*>& streams) {
+    if (buffers.size() != device_ids_.size()) {
+        throw std::invalid_argument("Expected one buffer per rank");
+    }
+    element_size(data_type);
+    begin(streams);
+
+    bool success = true;
+#ifdef RDNA_HAVE_RCCL
+    if (uses_rccl()) {
+        ncclGroupStart();
+        for (int r = 0; r < size(); ++r) {
+            success = ncclAllReduce(buffers[r], buffers[r], count, to_rccl_type(data_type),
+                                    config_.average ? ncclAvg : ncclSum,
+                                    static_cast<ncclComm_t>(rccl_comms_[r]), ranks_[r]->hip_stream()) == ncclSuccess && success;
+        }
+        success = ncclGroupEnd() == ncclSuccess && success;
+        end();
+        return success;
+    }
+#endif
+    success = ring_all_reduce(buffers, count, data_type);
+    end();
+    return success;
+}
+
+bool Communicator::all_gather(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                              size_t count, int data_type, const std::vector<Stream*>& streams) {
+    if (send.size() != device_ids_.size() || recv.size() != device_ids_.size()) {
+        throw std::invalid_argument("Expected one buffer per rank");
+    }
+    element_size(data_type);
+    begin(streams);
+
+    bool success = true;
+#ifdef RDNA_HAVE_RCCL
+    if (uses_rccl()) {
+        ncclGroupStart();
+        for (int r = 0; r < size(); ++r) {
+            success = ncclAllGather(send[r], recv[r], count, to_rccl_type(data_type),
+                                    static_cast<ncclComm_t>(rccl_comms_[r]), ranks_[r]->hip_stream()) == ncclSuccess && success;
+        }
+        success = ncclGroupEnd() == ncclSuccess && success;
+        end();
+        return success;
+    }
+#endif
+    success = ring_all_gather(send, recv, count, data_type);
+    end();
+    return success;
+}
+
+bool Communicator::reduce_scatter(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                                  size_t count, int data_type, const std::vector<Stream*>& streams) {
+    if (send.size() != device_ids_.size() || recv.size() != device_ids_.size()) {
+        throw std::invalid_argument("Expected one buffer per rank");
+    }
+    element_size(data_type);
+    begin(streams);
+
+    bool success = true;
+#ifdef RDNA_HAVE_RCCL
+    if (uses_rccl()) {
+        ncclGroupStart();
+        for (int r = 0; r < size(); ++r) {
+            success = ncclReduceScatter(send[r], recv[r], count, to_rccl_type(data_type),
+                                        config_.average ? ncclAvg : ncclSum,
+                                        static_cast<ncclComm_t>(rccl_comms_[r]), ranks_[r]->hip_stream()) == ncclSuccess && success;
+        }
+        success = ncclGroupEnd() == ncclSuccess && success;
+        end();
+        return success;
+    }
+#endif
+    success = ring_reduce_scatter(send, recv, count, data_type);
+    end();
+    return success;
+}
+
+// Classic ring: n - 1 reduce-scatter steps leave rank r owning the sum of
+// chunk r + 1, then n - 1 all-gather steps pass the sums around. Each step
+// the receiver pulls a chunk from its predecessor over the fabric, so
+// every link carries 2 (n - 1) / n of the buffer. Buffers longer than the
+// bucket size run as consecutive rings, which bounds scratch and lets the
+// first bucket's gather overlap the next one's reduction on other links.
+bool Communicator::ring_all_reduce(const std::vector<void*>& buffers, size_t count, int data_type) {
+    const int n = size();
+    if (n == 1 || count == 0) {
+        return true;
+    }
+    const size_t elem = element_size(data_type);
+    const size_t segment = std::max<size_t>(config_.bucket_size / elem, n);
+    const size_t scratch_count = (std::min(segment, count) + n - 1) / n;
+
+    std::vector<std::unique_ptr<ScratchBuffer>> scratch;
+    for (auto& rank : ranks_) {
+        DeviceScope scope(rank->device_id);
+        scratch.push_back(std::make_unique<ScratchBuffer>(scratch_count * elem, rank->device_id,
+                                                          rank->stream->get_native_handle()));
+        if (!scratch.back()->get()) {
+            return false;
+        }
+    }
+
+    int step = 0;
+    NeighbourJoin join{*this, step};
+    for (size_t base = 0; base < count; base += segment) {
+        const size_t seg_count = std::min(segment, count - base);
+
+        for (int s = 0; s < n - 1; ++s, ++step) {
+            for (int r = 0; r < n; ++r) {
+                Rank& rank = *ranks_[r];
+                const int pred = (r + n - 1) % n;
+                const int c = (r - 1 - s + 2 * n) % n;
+                const size_t begin = chunk_begin(seg_count, n, c);
+                const size_t len = chunk_begin(seg_count, n, c + 1) - begin;
+
+                DeviceScope scope(rank.device_id);
+                wait_for_neighbours(r, step);
+                if (len > 0) {
+                    void* own = offset_bytes(buffers[r], (base + begin) * elem);
+                    const void* theirs = offset_bytes(buffers[pred], (base + begin) * elem);
+                    if (hipMemcpyPeerAsync(scratch[r]->get(), rank.device_id, theirs, device_ids_[pred],
+                                           len * elem, rank.hip_stream()) != hipSuccess) {
+                        return false;
+                    }
+
+                    TensorDesc desc({len}, data_type);
+                    bool reduced = false;
+                    if (config_.average && s == n - 2) {
+                        // Last contribution: add and scale in one pass
+                        TensorDesc scale_desc({1}, 0);
+                        reduced = rank.kernels->fused_elementwise(
+                            {desc, desc, scale_desc}, {own, scratch[r]->get(), rank.scale},
+                            {FusedOp(FusedOpType::Add, 0, 1), FusedOp(FusedOpType::Multiply, 3, 2)},
+                            desc, own, rank.stream->get_native_handle());
+                    } else {
+                        reduced = rank.kernels->add(desc, own, desc, scratch[r]->get(), desc, own,
+                                                    rank.stream->get_native_handle());
+                    }
+                    if (!reduced) {
+                        return false;
+                    }
+                }
+                finish_step(r, step);
+            }
+        }
+
+        for (int t = 0; t < n - 1; ++t, ++step) {
+            for (int r = 0; r < n; ++r) {
+                Rank& rank = *ranks_[r];
+                const int pred = (r + n - 1) % n;
+                const int c = (r - t + n) % n;
+                const size_t begin = chunk_begin(seg_count, n, c);
+                const size_t len = chunk_begin(seg_count, n, c + 1) - begin;
+
+                DeviceScope scope(rank.device_id);
+                wait_for_neighbours(r, step);
+                if (len > 0 &&
+                    hipMemcpyPeerAsync(offset_bytes(buffers[r], (base + begin) * elem), rank.device_id,
+                                       offset_bytes(buffers[pred], (base + begin) * elem), device_ids_[pred],
+                                       len * elem, rank.hip_stream()) != hipSuccess) {
+                    return false;
+                }
+                finish_step(r, step);
+            }
+        }
+    }
+    return true;
+}
+
+// Each rank copies its own block into place, then n - 1 steps forward the
+// block the predecessor received last
+bool Communicator::ring_all_gather(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                                   size_t count, int data_type) {
+    const int n = size();
+    const size_t bytes = count * element_size(data_type);
+    if (bytes == 0) {
+        return true;
+    }
+
+    int step = 0;
+    NeighbourJoin join{*this, step};
+    for (int r = 0; r < n; ++r) {
+        Rank& rank = *ranks_[r];
+        DeviceScope scope(rank.device_id);
+        if (hipMemcpyAsync(offset_bytes(recv[r], r * bytes), send[r], bytes, hipMemcpyDeviceToDevice,
+                           rank.hip_stream()) != hipSuccess) {
+            return false;
+        }
+        finish_step(r, step);
+    }
+    ++step;
+
+    for (int t = 0; t < n - 1; ++t, ++step) {
+        for (int r = 0; r < n; ++r) {
+            Rank& rank = *ranks_[r];
+            const int pred = (r + n - 1) % n;
+            const int block = (r - 1 - t + 2 * n) % n;
+
+            DeviceScope scope(rank.device_id);
+            wait_for_neighbours(r, step);
+            if (hipMemcpyPeerAsync(offset_bytes(recv[r], block * bytes), rank.device_id,
+                                   offset_bytes(recv[pred], block * bytes), device_ids_[pred],
+                                   bytes, rank.hip_stream()) != hipSuccess) {
+                return false;
+            }
+            finish_step(r, step);
+        }
+    }
+    return true;
+}
+
+// The partial sum for block k starts at rank k + 1 and travels the ring,
+// each rank adding its own block k, until it arrives complete at rank k.
+// Partials are double-buffered by step parity so a rank never overwrites
+// the one its successor is still pulling. Blocks longer than the bucket
+// size run as consecutive rings over bucket-sized slices, which bounds
+// scratch as in ring_all_reduce.
+bool Communicator::ring_reduce_scatter(const std::vector<const void*>& send, const std::vector<void*>& recv,
+                                       size_t count, int data_type) {
+    const int n = size();
+    const size_t elem = element_size(data_type);
+    const size_t bytes = count * elem;
+    if (bytes == 0) {
+        return true;
+    }
+    if (n == 1) {
+        DeviceScope scope(ranks_[0]->device_id);
+        return hipMemcpyAsync(recv[0], send[0], bytes, hipMemcpyDeviceToDevice,
+                              ranks_[0]->hip_stream()) == hipSuccess;
+    }
+    const size_t segment = std::max<size_t>(config_.bucket_size / elem, 1);
+    const size_t slice_bytes = std::min(segment, count) * elem;
+
+    std::vector<std::unique_ptr<ScratchBuffer>> scratch;
+    std::vector<std::unique_ptr<ScratchBuffer>> partials;
+    for (auto& rank : ranks_) {
+        DeviceScope scope(rank->device_id);
+        void* stream = rank->stream->get_native_handle();
+        scratch.push_back(std::make_unique<ScratchBuffer>(slice_bytes, rank->device_id, stream));
+        partials.push_back(std::make_unique<ScratchBuffer>(2 * slice_bytes, rank->device_id, stream));
+        if (!scratch.back()->get() || !partials.back()->get()) {
+            return false;
+        }
+    }
+
+    int step = 0;
+    NeighbourJoin join{*this, step};
+    TensorDesc scale_desc({1}, 0);
+    for (size_t base = 0; base < count; base += segment) {
+        const size_t seg_count = std::min(segment, count - base);
+        TensorDesc desc({seg_count}, data_type);
+
+        for (int s = 1; s < n; ++s, ++step) {
+            for (int r = 0; r < n; ++r) {
+                Rank& rank = *ranks_[r];
+                const int pred = (r + n - 1) % n;
+                const int block = (r - 1 - s + 2 * n) % n;
+                const size_t offset = (block * count + base) * elem;
+
+                // The predecessor's partial for this slice, written last
+                // step; its first one is just its own input
+                const void* theirs = s == 1 ? offset_bytes(send[pred], offset)
+                                            : offset_bytes(partials[pred]->get(), ((step + 1) % 2) * slice_bytes);
+                const void* mine = offset_bytes(send[r], offset);
+                void* out = s == n - 1 ? offset_bytes(recv[r], base * elem)
+                                       : offset_bytes(partials[r]->get(), (step % 2) * slice_bytes);
+
+                DeviceScope scope(rank.device_id);
+                wait_for_neighbours(r, step);
+                if (hipMemcpyPeerAsync(scratch[r]->get(), rank.device_id, theirs, device_ids_[pred],
+                                       seg_count * elem, rank.hip_stream()) != hipSuccess) {
+                    return false;
+                }
+                bool reduced = false;
+                if (config_.average && s == n - 1) {
+                    reduced = rank.kernels->fused_elementwise(
+                        {desc, desc, scale_desc}, {mine, scratch[r]->get(), rank.scale},
+                        {FusedOp(FusedOpType::Add, 0, 1), FusedOp(FusedOpType::Multiply, 3, 2)},
+                        desc, out, rank.stream->get_native_handle());
+                } else {
+                    reduced = rank.kernels->add(desc, mine, desc, scratch[r]->get(), desc, out,
+                                                rank.stream->get_native_handle());
+                }
+                if (!reduced) {
+                    return false;
+                }
+                finish_step(r, step);
+            }
+        }
+    }
+    return true;
+}
+
+void Communicator::wait(const std::vector<Stream*>& streams) {
+    if (!streams.empty() && streams.size() != ranks_.size()) {
+        throw std::invalid_argument("Expected one stream per rank");
+    }
+    for (int r = 0; r < static_cast<int>(ranks_.size()); ++r) {
+        Rank& rank = *ranks_[r];
+        DeviceScope scope(rank.device_id);
+        hipStreamWaitEvent(static_cast<hipStream_t>(caller_stream(streams, r, rank.device_id)), rank.done, 0);
+    }
+}
+
+void Communicator::synchronize() {
+    for (auto& rank : ranks_) {
+        rank->stream->synchronize();
+    }
+}
+
+// GradientBuckets implementation
+GradientBuckets::GradientBuckets(std::shared_ptr<Communicator> communicator, int data_type)
+    : communicator_(communicator), data_type_(data_type), finalized_(false) {
+    if (!communicator_) {
+        throw std::invalid_argument("GradientBuckets needs a communicator");
+    }
+    element_size(data_type_);
+}
+
+GradientBuckets::~GradientBuckets() {
+    // Flat buffers are read by unpack copies on the callers' streams,
+    // which record_stream covers; the reductions themselves must be done
+    communicator_->synchronize();
+    for (Bucket& bucket : buckets_) {
+        for (void* flat : bucket.flat) {
+            MemoryManager::get_instance().deallocate(flat);
+        }
+    }
+}
+
+size_t GradientBuckets::add_gradient(const std::vector<void*>& buffers, size_t count) {
+    if (finalized_) {
+        throw std::runtime_error("GradientBuckets already finalized");
+    }
+    if (buffers.size() != static_cast<size_t>(communicator_->size())) {
+        throw std::invalid_argument("Expected one buffer per rank");
+    }
+
+    // A gradient bigger than a bucket gets one to itself
+    const size_t elem = element_size(data_type_);
+    const size_t bucket_size = communicator_->get_config().bucket_size;
+    if (buckets_.empty() || (buckets_.back().count > 0 && (buckets_.back().count + count) * elem > bucket_size)) {
+        buckets_.push_back(Bucket{{}, {}, 0, 0, false});
+    }
+    Bucket& bucket = buckets_.back();
+    gradients_.push_back(Gradient{buffers, count, buckets_.size() - 1, bucket.count, false});
+    bucket.gradients.push_back(gradients_.size() - 1);
+    bucket.count += count;
+    bucket.pending++;
+    return gradients_.size() - 1;
+}
+
+bool GradientBuckets::finalize() {
+    if (finalized_) {
+        return true;
+    }
+    const size_t elem = element_size(data_type_);
+    const std::vector<int>& devices = communicator_->get_device_ids();
+    for (Bucket& bucket : buckets_) {
+        for (int r = 0; r < communicator_->size(); ++r) {
+            AllocationOptions options = {};
+            options.stream = communicator_->get_stream(r)->get_native_handle();
+            options.tag = "gradient_bucket";
+            void* flat = MemoryManager::get_instance().allocate(std::max<size_t>(bucket.count * elem, 1),
+                                                                devices[r], options);
+            if (!flat) {
+                return false;
+            }
+            bucket.flat.push_back(flat);
+        }
+    }
+    finalized_ = true;
+    return true;
+}
+
+bool GradientBuckets::mark_ready(size_t index, const std::vector<Stream*>& streams) {
+    if (!finalized_) {
+        throw std::runtime_error("GradientBuckets not finalized");
+    }
+    if (index >= gradients_.size()) {
+        throw std::invalid_argument("Invalid gradient index");
+    }
+    Gradient& gradient = gradients_[index];
+    if (gradient.ready) {
+        throw std::invalid_argument("Gradient marked ready twice in one step");
+    }
+    gradient.ready = true;
+    Bucket& bucket = buckets_[gradient.bucket];
+    if (--bucket.pending > 0) {
+        return true;
+    }
+    return launch(bucket, streams);
+}
+
+bool GradientBuckets::launch(Bucket& bucket, const std::vector<Stream*>& streams) {
+    // Flatten on the callers' streams, right behind the kernels that wrote
+    // the gradients; the all-reduce then waits for those streams
+    const size_t elem = element_size(data_type_);
+    const std::vector<int>& devices = communicator_->get_device_ids();
+    for (int r = 0; r < communicator_->size(); ++r) {
+        DeviceScope scope(devices[r]);
+        hipStream_t stream = static_cast<hipStream_t>(caller_stream(streams, r, devices[r]));
+        for (size_t index : bucket.gradients) {
+            const Gradient& gradient = gradients_[index];
+            if (gradient.count > 0 &&
+                hipMemcpyAsync(offset_bytes(bucket.flat[r], gradient.offset * elem), gradient.buffers[r],
+                               gradient.count * elem, hipMemcpyDeviceToDevice, stream) != hipSuccess) {
+                return false;
+            }
+        }
+    }
+    bucket.launched = true;
+    return communicator_->all_reduce(bucket.flat, bucket.count, data_type_, streams);
+}
+
+bool GradientBuckets::wait(const std::vector<Stream*>& streams) {
+    bool success = true;
+    for (Bucket& bucket : buckets_) {
+        if (!bucket.launched) {
+            success = launch(bucket, streams) && success;
+        }
+    }
+    communicator_->wait(streams);
+
+    const size_t elem = element_size(data_type_);
+    const std::vector<int>& devices = communicator_->get_device_ids();
+    for (Bucket& bucket : buckets_) {
+        for (int r = 0; r < communicator_->size(); ++r) {
+            DeviceScope scope(devices[r]);
+            void* stream = caller_stream(streams, r, devices[r]);
+            for (size_t index : bucket.gradients) {
+                const Gradient& gradient = gradients_[index];
+                if (gradient.count > 0 &&
+                    hipMemcpyAsync(gradient.buffers[r], offset_bytes(bucket.flat[r], gradient.offset * elem),
+                                   gradient.count * elem, hipMemcpyDeviceToDevice,
+                                   static_cast<hipStream_t>(stream)) != hipSuccess) {
+                    success = false;
+                }
+            }
+            MemoryManager::get_instance().record_stream(bucket.flat[r], stream);
+        }
+        bucket.pending = bucket.gradients.size();
+        bucket.launched = false;
+    }
+    for (Gradient& gradient : gradients_) {
+        gradient.ready = false;
+    }
+    return success;
+}
+
+size_t GradientBuckets::bucket_count() const {
+    return buckets_.size();
+}
+
+} // namespace rdna
@@ -1,5 +1,7 @@
 #include "rdna/device.h"
+#include "rdna/memory.h"
 #include <hip/hip_runtime.h>
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -8,31 +10,33 @@ namespace rdna {
 // DeviceProperties implementation
 DeviceProperties::DeviceProperties()
     : device_id(-1), total_memory(0), free_memory(0), compute_units(0),
-      max_workgroup_size(0), wavefront_size(64), supports_fp16(false),
+      max_workgroup_size(0), wavefront_size(64), shared_memory_per_block(0), supports_fp16(false),
       supports_bf16(false), supports_tensor_cores(false),
       pci_bus_id(0), pci_device_id(0) {}
 
-// DeviceManager implementation
-DeviceManager& DeviceManager::get_instance() {
-    static DeviceManager instance;
-    return instance;
-}
+namespace {
 
-int DeviceManager::device_count() {
-    int count = 0;
-    hipError_t result = hipGetDeviceCount(&count);
-    if (result != hipSuccess) {
-        last_error_ = "Failed to get device count: " + std::string(hipGetErrorString(result));
-        return 0;
+// Runs f with device_id current, restoring the caller's device afterwards
+template <typename F>
+auto with_device(int device_id, F&& f) -> decltype(f()) {
+    int previous = 0;
+    bool restore = hipGetDevice(&previous) == hipSuccess && previous != device_id;
+    if (restore) {
+        hipSetDevice(device_id);
     }
-    return count;
+    struct Restore {
+        bool active;
+        int device;
+        ~Restore() {
+            if (active) {
+                hipSetDevice(device);
+            }
+        }
+    } guard{restore, previous};
+    return f();
 }
 
-DeviceProperties DeviceManager::get_device_properties(int device_id) {
-    if (device_id < 0 || device_id >= device_count()) {
-        throw std::invalid_argument("Invalid device ID");
-    }
-    
+DeviceProperties query_device_properties(int device_id) {
     hipDeviceProp_t prop;
     hipError_t result = hipGetDeviceProperties(&prop, device_id);
     if (result != hipSuccess) {
@@ -48,6 +52,7 @@ DeviceProperties DeviceManager::get_device_properties(int device_id) {
     props.compute_units = prop.multiProcessorCount;
     props.max_workgroup_size = prop.maxThreadsPerBlock;
     props.wavefront_size = prop.warpSize;
+    props.shared_memory_per_block = prop.sharedMemPerBlock;
     props.pci_bus_id = prop.pciBusID;
     props.pci_device_id = prop.pciDeviceID;
     
@@ -56,9 +61,9 @@ DeviceProperties DeviceManager::get_device_properties(int device_id) {
     props.supports_bf16 = prop.arch >= 900; // RDNA3+ supports BF16
     props.supports_tensor_cores = false; // RDNA doesn't have tensor cores like NVIDIA
     
-    // Get free memory
+    // Get free memory; hipMemGetInfo reports the current device
     size_t free, total;
-    result = hipMemGetInfo(&free, &total);
+    result = with_device(device_id, [&]() { return hipMemGetInfo(&free, &total); });
     if (result == hipSuccess) {
         props.free_memory = free;
     }
@@ -66,6 +71,48 @@ DeviceProperties DeviceManager::get_device_properties(int device_id) {
     return props;
 }
 
+} // namespace
+
+// DeviceManager implementation
+DeviceManager& DeviceManager::get_instance() {
+    static DeviceManager instance;
+    return instance;
+}
+
+void DeviceManager::discover_devices() {
+    int count = 0;
+    hipError_t result = hipGetDeviceCount(&count);
+    if (result != hipSuccess) {
+        last_error_ = "Failed to get device count: " + std::string(hipGetErrorString(result));
+        return;
+    }
+    
+    devices_.resize(count);
+    for (int i = 0; i < count; ++i) {
+        try {
+            devices_[i] = query_device_properties(i);
+        } catch (const std::exception& e) {
+            last_error_ = e.what();  // Left with device_id -1
+        }
+    }
+    device_count_ = count;
+}
+
+int DeviceManager::device_count() {
+    std::call_once(discovery_flag_, [this]() { discover_devices(); });
+    return device_count_;
+}
+
+DeviceProperties DeviceManager::get_device_properties(int device_id) {
+    if (device_id < 0 || device_id >= device_count()) {
+        throw std::invalid_argument("Invalid device ID");
+    }
+    if (devices_[device_id].device_id != device_id) {
+        throw std::runtime_error("Failed to get device properties for device " + std::to_string(device_id));
+    }
+    return devices_[device_id];
+}
+
 std::vector<DeviceProperties> DeviceManager::get_all_device_properties() {
     int count = device_count();
     std::vector<DeviceProperties> devices;
@@ -82,6 +129,29 @@ std::vector<DeviceProperties> DeviceManager::get_all_device_properties() {
     return devices;
 }
 
+std::shared_ptr<DeviceContext> DeviceManager::get_context(int device_id) {
+    if (device_id == -1) {
+        device_id = get_current_device();
+    }
+    if (device_id < 0 || device_id >= device_count() || device_id >= kMaxDevices) {
+        throw std::invalid_argument("Invalid device ID");
+    }
+    if (context_ready_[device_id].load(std::memory_order_acquire)) {
+        return contexts_[device_id];
+    }
+    
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    if (!contexts_[device_id]) {
+        auto context = std::make_shared<DeviceContext>(device_id);
+        if (!context->initialize()) {
+            throw std::runtime_error("Failed to initialize device context");
+        }
+        contexts_[device_id] = context;
+        context_ready_[device_id].store(true, std::memory_order_release);
+    }
+    return contexts_[device_id];
+}
+
 std::shared_ptr<DeviceContext> DeviceManager::create_context(int device_id) {
     if (device_id < 0 || device_id >= device_count()) {
         throw std::invalid_argument("Invalid device ID");
@@ -96,11 +166,147 @@ std::shared_ptr<DeviceContext> DeviceManager::create_context(int device_id) {
 }
 
 std::shared_ptr<DeviceContext> DeviceManager::get_current_context() {
-    return current_context_;
+    if (device_count() == 0) {
+        return nullptr;
+    }
+    return get_context(get_current_device());
 }
 
 void DeviceManager::set_current_context(std::shared_ptr<DeviceContext> context) {
-    current_context_ = context;
+    if (context) {
+        set_current_device(context->get_device_id());
+    }
+}
+
+int DeviceManager::get_current_device() {
+    int device_id = 0;
+    if (hipGetDevice(&device_id) != hipSuccess) {
+        return 0;
+    }
+    return device_id;
+}
+
+void DeviceManager::set_current_device(int device_id) {
+    if (device_id < 0 || device_id >= device_count()) {
+        throw std::invalid_argument("Invalid device ID");
+    }
+    // Ask HIP rather than remembering the last switch: torch and user code
+    // change devices behind our back
+    int current = -1;
+    if (hipGetDevice(&current) == hipSuccess && current == device_id) {
+        return;
+    }
+    hipError_t result = hipSetDevice(device_id);
+    if (result != hipSuccess) {
+        throw std::runtime_error("Failed to set device: " + std::string(hipGetErrorString(result)));
+    }
+}
+
+std::shared_ptr<Stream>& DeviceManager::current_stream_slot(int device_id) {
+    // Streams are held here, so a current stream stays alive until replaced
+    // or the thread exits
+    thread_local std::array<std::shared_ptr<Stream>, kMaxDevices> current_streams;
+    return current_streams[device_id];
+}
+
+std::shared_ptr<Stream> DeviceManager::get_current_stream(int device_id) {
+    if (device_id == -1) {
+        device_id = get_current_device();
+    }
+    if (device_id < 0 || device_id >= kMaxDevices) {
+        return nullptr;
+    }
+    return current_stream_slot(device_id);
+}
+
+void DeviceManager::set_current_stream(std::shared_ptr<Stream> stream, int device_id) {
+    if (stream) {
+        if (!stream->get_context()) {
+            throw std::invalid_argument("Stream has no device context");
+        }
+        device_id = stream->get_context()->get_device_id();
+    } else if (device_id == -1) {
+        device_id = get_current_device();
+    }
+    if (device_id < 0 || device_id >= device_count() || device_id >= kMaxDevices) {
+        throw std::invalid_argument("Invalid device ID");
+    }
+    current_stream_slot(device_id) = std::move(stream);
+}
+
+void* DeviceManager::get_current_stream_handle(int device_id) {
+    if (device_id == -1) {
+        device_id = get_current_device();
+    }
+    if (device_id < 0 || device_id >= kMaxDevices) {
+        return nullptr;
+    }
+    const std::shared_ptr<Stream>& stream = current_stream_slot(device_id);
+    return stream ? stream->get_native_handle() : nullptr;
+}
+
+DeviceManager::PeerState DeviceManager::query_peer_state(int device_id, int peer_id) {
+    PeerState& state = peer_state_[device_id][peer_id];
+    if (state == kPeerUnknown) {
+        int can_access = 0;
+        state = hipDeviceCanAccessPeer(&can_access, device_id, peer_id) == hipSuccess && can_access
+            ? kPeerSupported : kPeerUnsupported;
+    }
+    return state;
+}
+
+bool DeviceManager::can_access_peer(int device_id, int peer_id) {
+    if (device_id < 0 || peer_id < 0 || device_id >= device_count() || peer_id >= device_count() ||
+        device_id >= kMaxDevices || peer_id >= kMaxDevices || device_id == peer_id) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    return query_peer_state(device_id, peer_id) != kPeerUnsupported;
+}
+
+bool DeviceManager::enable_peer_access(int device_id, int peer_id) {
+    if (!can_access_peer(device_id, peer_id)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    PeerState& state = peer_state_[device_id][peer_id];
+    if (state == kPeerEnabled) {
+        return true;
+    }
+    
+    // Access is granted to device_id's context, so it must be current
+    hipError_t result = with_device(device_id, [&]() { return hipDeviceEnablePeerAccess(peer_id, 0); });
+    if (result == hipErrorPeerAccessAlreadyEnabled) {
+        hipGetLastError();  // Enabled outside DeviceManager; clear the sticky error
+        result = hipSuccess;
+    }
+    if (result != hipSuccess) {
+        last_error_ = "Failed to enable peer access: " + std::string(hipGetErrorString(result));
+        return false;
+    }
+    state = kPeerEnabled;
+    return true;
+}
+
+bool DeviceManager::is_peer_access_enabled(int device_id, int peer_id) {
+    if (device_id < 0 || peer_id < 0 || device_id >= kMaxDevices || peer_id >= kMaxDevices) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    return peer_state_[device_id][peer_id] == kPeerEnabled;
+}
+
+int DeviceManager::enable_all_peer_access() {
+    int enabled = 0;
+    int count = std::min(device_count(), kMaxDevices);
+    for (int device_id = 0; device_id < count; ++device_id) {
+        for (int peer_id = 0; peer_id < count; ++peer_id) {
+            if (device_id != peer_id && enable_peer_access(device_id, peer_id)) {
+                ++enabled;
+            }
+        }
+    }
+    return enabled;
 }
 
 bool DeviceManager::check_device_compatibility(int device_id) {
@@ -132,14 +338,14 @@ DeviceContext::~DeviceContext() {
 }
 
 bool DeviceContext::initialize() {
-    hipError_t result = hipSetDevice(device_id_);
-    if (result != hipSuccess) {
-        return false;
+    if (initialized_) {
+        return true;
     }
     
-    // Create default stream
+    // Create default stream; Stream::initialize selects this device
     default_stream_ = std::make_shared<Stream>(shared_from_this());
     if (!default_stream_->initialize()) {
+        default_stream_.reset();
         return false;
     }
     
@@ -149,7 +355,7 @@ bool DeviceContext::initialize() {
 
 void DeviceContext::synchronize() {
     if (initialized_) {
-        hipError_t result = hipDeviceSynchronize();
+        hipError_t result = with_device(device_id_, []() { return hipDeviceSynchronize(); });
         if (result != hipSuccess) {
             throw std::runtime_error("Failed to synchronize device: " + 
                                     std::string(hipGetErrorString(result)));
@@ -165,28 +371,45 @@ int DeviceContext::get_device_id() const {
     return device_id_;
 }
 
-DeviceProperties DeviceContext::get_properties() const {
-    DeviceManager& manager = DeviceManager::get_instance();
-    return manager.get_device_properties(device_id_);
+const DeviceProperties& DeviceContext::get_properties() const {
+    std::call_once(properties_flag_, [this]() {
+        properties_ = DeviceManager::get_instance().get_device_properties(device_id_);
+    });
+    return properties_;
 }
 
-std::shared_ptr<Stream> DeviceContext::create_stream() {
+std::shared_ptr<Stream> DeviceContext::create_stream(StreamPriority priority) {
     auto stream = std::make_shared<Stream>(shared_from_this());
-    if (!stream->initialize()) {
+    if (!stream->initialize(priority)) {
         throw std::runtime_error("Failed to create stream");
     }
     return stream;
 }
 
+std::shared_ptr<Stream> DeviceContext::get_stream_from_pool(StreamPriority priority) {
+    StreamPool& pool = stream_pools_[priority == StreamPriority::HIGH ? 1 : 0];
+    std::call_once(pool.created, [&]() {
+        for (auto& stream : pool.streams) {
+            stream = create_stream(priority);
+        }
+    });
+    uint32_t index = pool.next.fetch_add(1, std::memory_order_relaxed);
+    return pool.streams[index % kPoolStreamsPerPriority];
+}
+
 std::shared_ptr<Stream> DeviceContext::get_default_stream() {
     return default_stream_;
 }
 
 // Stream implementation
 Stream::Stream(std::shared_ptr<DeviceContext> context)
-    : context_(context), hip_stream_(nullptr), initialized_(false) {}
+    : context_(context), hip_stream_(nullptr), initialized_(false),
+      priority_(StreamPriority::LOW), capture_pool_id_(0) {}
 
 Stream::~Stream() {
+    if (capture_pool_id_) {
+        end_capture();  // Abandoned capture; drops the graph and its pool
+    }
     if (initialized_ && hip_stream_) {
         hipError_t result = hipStreamDestroy(static_cast<hipStream_t>(hip_stream_));
         if (result != hipSuccess) {
@@ -195,12 +418,27 @@ Stream::~Stream() {
     }
 }
 
-bool Stream::initialize() {
-    hipError_t result = hipStreamCreate(&hip_stream_);
+bool Stream::initialize(StreamPriority priority) {
+    // Streams belong to the device current at creation. Lower numbers are
+    // higher priorities; the range is per device.
+    hipStream_t stream = nullptr;
+    auto create = [&]() {
+        int least = 0;
+        int greatest = 0;
+        hipError_t result = hipDeviceGetStreamPriorityRange(&least, &greatest);
+        if (result != hipSuccess) {
+            return result;
+        }
+        return hipStreamCreateWithPriority(&stream, hipStreamDefault,
+                                           priority == StreamPriority::HIGH ? greatest : least);
+    };
+    hipError_t result = context_ ? with_device(context_->get_device_id(), create) : create();
     if (result != hipSuccess) {
         return false;
     }
     
+    hip_stream_ = stream;
+    priority_ = priority;
     initialized_ = true;
     return true;
 }
@@ -223,6 +461,10 @@ void* Stream::get_native_handle() const {
     return hip_stream_;
 }
 
+std::shared_ptr<DeviceContext> Stream::get_context() const {
+    return context_;
+}
+
 bool Stream::memcpy(void* dst, const void* src, size_t size) {
     hipError_t result = hipMemcpy(dst, src, size, hipMemcpyDefault);
     return result == hipSuccess;
@@ -238,6 +480,238 @@ bool Stream::memcpy_async(void* dst, const void* src, size_t size) {
     return result == hipSuccess;
 }
 
+StreamPriority Stream::get_priority() const {
+    return priority_;
+}
+
+bool Stream::begin_capture(uint64_t pool_id) {
+    // The null stream cannot be captured
+    if (!initialized_ || !hip_stream_ || !context_ || capture_pool_id_) {
+        return false;
+    }
+    int device_id = context_->get_device_id();
+    auto allocator = MemoryManager::get_instance().get_allocator(device_id);
+    if (pool_id) {
+        if (!allocator->retain_private_pool(pool_id)) {
+            return false;
+        }
+    } else {
+        pool_id = allocator->create_private_pool();
+    }
+    
+    // Route allocations first so nothing captured lands in the shared pools
+    if (!allocator->begin_capture_to_pool(pool_id, hip_stream_)) {
+        allocator->release_private_pool(pool_id);
+        return false;
+    }
+    hipError_t result = with_device(device_id, [&]() {
+        return hipStreamBeginCapture(static_cast<hipStream_t>(hip_stream_), hipStreamCaptureModeThreadLocal);
+    });
+    if (result != hipSuccess) {
+        allocator->end_capture_to_pool(hip_stream_);
+        allocator->release_private_pool(pool_id);
+        return false;
+    }
+    capture_pool_id_ = pool_id;
+    return true;
+}
+
+std::shared_ptr<Graph> Stream::end_capture() {
+    if (!capture_pool_id_) {
+        return nullptr;
+    }
+    uint64_t pool_id = capture_pool_id_;
+    capture_pool_id_ = 0;
+    
+    int device_id = context_->get_device_id();
+    hipGraph_t graph = nullptr;
+    hipError_t result = with_device(device_id, [&]() {
+        return hipStreamEndCapture(static_cast<hipStream_t>(hip_stream_), &graph);
+    });
+    auto allocator = MemoryManager::get_instance().get_allocator(device_id);
+    allocator->end_capture_to_pool(hip_stream_);
+    if (result != hipSuccess || !graph) {
+        std::cerr << "Warning: Graph capture failed: " << hipGetErrorString(result) << std::endl;
+        if (graph) {
+            hipGraphDestroy(graph);
+        }
+        allocator->release_private_pool(pool_id);
+        return nullptr;
+    }
+    return std::make_shared<Graph>(context_, graph, pool_id);
+}
+
+bool Stream::is_capturing() const {
+    return capture_pool_id_ != 0;
+}
+
+// StreamGuard implementation
+StreamGuard::StreamGuard(std::shared_ptr<Stream> stream) : device_id_(-1) {
+    if (stream && stream->get_context()) {
+        DeviceManager& manager = DeviceManager::get_instance();
+        device_id_ = stream->get_context()->get_device_id();
+        original_stream_ = manager.get_current_stream(device_id_);
+        manager.set_current_stream(std::move(stream));
+    }
+}
+
+StreamGuard::~StreamGuard() {
+    if (device_id_ >= 0) {
+        DeviceManager::get_instance().set_current_stream(std::move(original_stream_), device_id_);
+    }
+}
+
+// Graph implementation
+Graph::Graph(std::shared_ptr<DeviceContext> context, void* hip_graph, uint64_t pool_id)
+    : context_(context), hip_graph_(hip_graph), hip_graph_exec_(nullptr), pool_id_(pool_id) {}
+
+Graph::~Graph() {
+    reset();
+}
+
+bool Graph::instantiate() {
+    if (hip_graph_exec_) {
+        return true;
+    }
+    if (!hip_graph_) {
+        return false;
+    }
+    hipGraphExec_t exec = nullptr;
+    hipError_t result = with_device(context_->get_device_id(), [&]() {
+        return hipGraphInstantiate(&exec, static_cast<hipGraph_t>(hip_graph_), nullptr, nullptr, 0);
+    });
+    if (result != hipSuccess) {
+        std::cerr << "Warning: Failed to instantiate graph: " << hipGetErrorString(result) << std::endl;
+        return false;
+    }
+    hip_graph_exec_ = exec;
+    return true;
+}
+
+bool Graph::is_instantiated() const {
+    return hip_graph_exec_ != nullptr;
+}
+
+bool Graph::replay(Stream& stream) {
+    if (!instantiate()) {
+        return false;
+    }
+    hipError_t result = with_device(context_->get_device_id(), [&]() {
+        return hipGraphLaunch(static_cast<hipGraphExec_t>(hip_graph_exec_),
+                              static_cast<hipStream_t>(stream.get_native_handle()));
+    });
+    return result == hipSuccess;
+}
+
+void Graph::reset() {
+    if (hip_graph_exec_) {
+        hipGraphExecDestroy(static_cast<hipGraphExec_t>(hip_graph_exec_));
+        hip_graph_exec_ = nullptr;
+    }
+    if (hip_graph_) {
+        hipGraphDestroy(static_cast<hipGraph_t>(hip_graph_));
+        hip_graph_ = nullptr;
+    }
+    if (pool_id_) {
+        // Replays already queued keep running; the pool's memory only goes
+        // back once its blocks are freed, in stream order
+        MemoryManager::get_instance().get_allocator(context_->get_device_id())->release_private_pool(pool_id_);
+        pool_id_ = 0;
+    }
+}
+
+uint64_t Graph::get_pool_id() const {
+    return pool_id_;
+}
+
+void* Graph::get_native_handle() const {
+    return hip_graph_;
+}
+
+// Event implementation
+Event::Event(std::shared_ptr<DeviceContext> context, bool enable_timing)
+    : context_(context), hip_event_(nullptr), enable_timing_(enable_timing), initialized_(false) {}
+
+Event::~Event() {
+    if (initialized_ && hip_event_) {
+        hipError_t result = hipEventDestroy(static_cast<hipEvent_t>(hip_event_));
+        if (result != hipSuccess) {
+            std::cerr << "Warning: Failed to destroy event: " << hipGetErrorString(result) << std::endl;
+        }
+    }
+}
+
+bool Event::initialize() {
+    hipEvent_t event = nullptr;
+    unsigned int flags = enable_timing_ ? hipEventDefault : hipEventDisableTiming;
+    hipError_t result = hipEventCreateWithFlags(&event, flags);
+    if (result != hipSuccess) {
+        return false;
+    }
+    
+    hip_event_ = event;
+    initialized_ = true;
+    return true;
+}
+
+bool Event::is_valid() const {
+    return initialized_ && hip_event_ != nullptr;
+}
+
+void* Event::get_native_handle() const {
+    return hip_event_;
+}
+
+void Event::record(Stream& stream) {
+    hipError_t result = hipEventRecord(static_cast<hipEvent_t>(hip_event_),
+                                       static_cast<hipStream_t>(stream.get_native_handle()));
+    if (result != hipSuccess) {
+        throw std::runtime_error("Failed to record event: " + 
+                                std::string(hipGetErrorString(result)));
+    }
+}
+
+void Event::wait(Stream& stream) {
+    hipError_t result = hipStreamWaitEvent(static_cast<hipStream_t>(stream.get_native_handle()),
+                                           static_cast<hipEvent_t>(hip_event_), 0);
+    if (result != hipSuccess) {
+        throw std::runtime_error("Failed to wait on event: " + 
+                                std::string(hipGetErrorString(result)));
+    }
+}
+
+void Event::synchronize() {
+    if (initialized_ && hip_event_) {
+        hipError_t result = hipEventSynchronize(static_cast<hipEvent_t>(hip_event_));
+        if (result != hipSuccess) {
+            throw std::runtime_error("Failed to synchronize event: " + 
+                                    std::string(hipGetErrorString(result)));
+        }
+    }
+}
+
+bool Event::query() const {
+    if (!initialized_ || !hip_event_) {
+        return true;
+    }
+    return hipEventQuery(static_cast<hipEvent_t>(hip_event_)) == hipSuccess;
+}
+
+float Event::elapsed_time(const Event& end) const {
+    if (!enable_timing_ || !end.enable_timing_) {
+        throw std::invalid_argument("Both events must be created with timing enabled");
+    }
+    
+    float ms = 0.0f;
+    hipError_t result = hipEventElapsedTime(&ms, static_cast<hipEvent_t>(hip_event_),
+                                            static_cast<hipEvent_t>(end.hip_event_));
+    if (result != hipSuccess) {
+        throw std::runtime_error("Failed to compute elapsed time: " + 
+                                std::string(hipGetErrorString(result)));
+    }
+    return ms;
+}
+
 // Utility functions
 bool is_rdna_supported() {
     int count = 0;
@@ -0,0 +1,71 @@
+#ifndef RDNA_DEVICE_FUNCTIONS_H
+#define RDNA_DEVICE_FUNCTIONS_H
+
+// Helpers shared by the HIP kernel sources; include from .hip files only
+
+#include <hip/hip_runtime.h>
+#include <hip/hip_fp16.h>
+#include <hip/hip_bfloat16.h>
+#include <type_traits>
+
+namespace rdna {
+
+// Math is done in fp32 whatever the storage type
+template <typename T>
+__device__ __forceinline__ float load_float(T value) {
+    return static_cast<float>(value);
+}
+
+template <typename T>
+__device__ __forceinline__ T store_float(float value) {
+    return static_cast<T>(value);
+}
+
+template <int W>
+__device__ __forceinline__ float shuffle_xor(float value, int mask) {
+    return __shfl_xor(value, mask, W);
+}
+
+// Butterfly reduction over a wave of W lanes; every lane gets the result.
+// Aggregate types provide their own shuffle_xor<W> overload.
+template <int W, typename T, typename Combine>
+__device__ __forceinline__ T wave_reduce(T value, Combine combine) {
+#pragma unroll
+    for (int mask = W / 2; mask > 0; mask /= 2) {
+        value = combine(value, shuffle_xor<W>(value, mask));
+    }
+    return value;
+}
+
+// Reduction over a 1D block of BlockSize threads; every thread gets the
+// result. Safe to call repeatedly from the same kernel.
+template <int W, int BlockSize, typename T, typename Combine>
+__device__ __forceinline__ T block_reduce(T value, Combine combine, T identity) {
+    static_assert(BlockSize % W == 0 && BlockSize / W <= W, "block must be at most W waves");
+    __shared__ T partials[BlockSize / W];
+
+    const int lane = threadIdx.x % W;
+    const int wave = threadIdx.x / W;
+    value = wave_reduce<W>(value, combine);
+    if (lane == 0) {
+        partials[wave] = value;
+    }
+    __syncthreads();
+    value = wave_reduce<W>(lane < BlockSize / W ? partials[lane] : identity, combine);
+    __syncthreads();
+    return value;
+}
+
+// Instantiate f for the wavefront width of the target device: 32 on RDNA,
+// 64 on GCN/CDNA
+template <typename F>
+bool dispatch_wave_size(int wavefront_size, F&& f) {
+    if (wavefront_size == 64) {
+        return f(std::integral_constant<int, 64>());
+    }
+    return f(std::integral_constant<int, 32>());
+}
+
+} // namespace rdna
+
+#endif // RDNA_DEVICE_FUNCTIONS_H
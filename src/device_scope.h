@@ -0,0 +1,26 @@
+#ifndef RDNA_DEVICE_SCOPE_H
+#define RDNA_DEVICE_SCOPE_H
+
+#include "rdna/device.h"
+
+namespace rdna {
+
+// Switches the calling thread to device_id for the scope
+class DeviceScope {
+public:
+    explicit DeviceScope(int device_id) : previous_(DeviceManager::get_instance().get_current_device()) {
+        DeviceManager::get_instance().set_current_device(device_id);
+    }
+    ~DeviceScope() {
+        DeviceManager::get_instance().set_current_device(previous_);
+    }
+    DeviceScope(const DeviceScope&) = delete;
+    DeviceScope& operator=(const DeviceScope&) = delete;
+
+private:
+    int previous_;
+};
+
+} // namespace rdna
+
+#endif // RDNA_DEVICE_SCOPE_H
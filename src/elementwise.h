@@ -0,0 +1,33 @@
+#ifndef RDNA_ELEMENTWISE_H
+#define RDNA_ELEMENTWISE_H
+
+#include "rdna/kernels.h"
+
+namespace rdna {
+
+enum class ElementwiseOp {
+    Add,
+    Multiply,
+    Relu,
+    Gelu
+};
+
+/**
+ * @brief Launch out = op(a[, b]) on stream
+ *
+ * Inputs broadcast NumPy-style against out's shape and may be arbitrarily
+ * strided; when every operand shares one dense layout the kernel uses
+ * 128-bit loads and stores. All operands must have the same data type.
+ * out may alias an input that has exactly its shape and strides. b is
+ * ignored by unary ops. Throws std::invalid_argument on mismatched
+ * descriptors, returns false if the launch fails.
+ */
+bool launch_elementwise(ElementwiseOp op,
+                        const TensorDesc& a, const void* a_data,
+                        const TensorDesc* b, const void* b_data,
+                        const TensorDesc& out, void* out_data,
+                        void* stream);
+
+} // namespace rdna
+
+#endif // RDNA_ELEMENTWISE_H
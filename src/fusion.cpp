@@ -0,0 +1,383 @@
+#include "fusion.h"
+#include <hip/hip_runtime.h>
+#include <hip/hiprtc.h>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace rdna {
+
+namespace {
+
+constexpr unsigned kBlockSize = 256;
+constexpr size_t kMaxGridSize = 65535;  // Generated kernels are grid-stride loops
+constexpr int kOperands = kMaxFusedInputs + 1;
+
+bool is_binary(FusedOpType type) {
+    switch (type) {
+        case FusedOpType::Add:
+        case FusedOpType::Subtract:
+        case FusedOpType::Multiply:
+        case FusedOpType::Divide:
+        case FusedOpType::Maximum:
+        case FusedOpType::Minimum:
+            return true;
+        default:
+            return false;
+    }
+}
+
+struct Dim {
+    size_t size;
+    size_t strides[kOperands];
+};
+
+// Same collapsing as the static elementwise engine, over any operand count:
+// broadcast dimensions get stride 0, extent-1 dimensions are dropped and
+// neighbours contiguous in every operand are merged
+std::vector<Dim> collapse_dims(const TensorDesc& output, const std::vector<const TensorDesc*>& inputs) {
+    const size_t rank = output.shape.size();
+    const size_t operands = inputs.size() + 1;
+
+    std::vector<Dim> dims;
+    for (size_t i = rank; i-- > 0;) {
+        if (output.shape[i] == 1) {
+            continue;
+        }
+        Dim dim = {};
+        dim.size = output.shape[i];
+        dim.strides[0] = output.strides[i];
+        for (size_t input = 0; input < inputs.size(); ++input) {
+            const TensorDesc& desc = *inputs[input];
+            size_t offset = rank - desc.shape.size();
+            if (i < offset || desc.shape[i - offset] == 1) {
+                continue;
+            }
+            if (desc.shape[i - offset] != output.shape[i]) {
+                throw std::invalid_argument("fused elementwise shapes are not broadcastable");
+            }
+            dim.strides[input + 1] = desc.strides[i - offset];
+        }
+
+        if (!dims.empty()) {
+            Dim& inner = dims.back();
+            bool mergeable = true;
+            for (size_t t = 0; t < operands; ++t) {
+                mergeable &= dim.strides[t] == inner.strides[t] * inner.size;
+            }
+            if (mergeable) {
+                inner.size *= dim.size;
+                continue;
+            }
+        }
+        dims.push_back(dim);
+    }
+    return dims;
+}
+
+const char* storage_type(int data_type) {
+    switch (data_type) {
+        case 1: return "_Float16";
+        case 2: return "unsigned short";  // bf16 bits
+        default: return "float";
+    }
+}
+
+std::string load_expr(int data_type, const std::string& value) {
+    switch (data_type) {
+        case 1: return "static_cast<float>(" + value + ")";
+        case 2: return "load_bf16(" + value + ")";
+        default: return value;
+    }
+}
+
+std::string store_expr(int data_type, const std::string& value) {
+    switch (data_type) {
+        case 1: return "static_cast<_Float16>(" + value + ")";
+        case 2: return "store_bf16(" + value + ")";
+        default: return value;
+    }
+}
+
+std::string op_expr(const FusedOp& op) {
+    std::string a = "v" + std::to_string(op.lhs);
+    std::string b = "v" + std::to_string(op.rhs);
+    switch (op.type) {
+        case FusedOpType::Add: return a + " + " + b;
+        case FusedOpType::Subtract: return a + " - " + b;
+        case FusedOpType::Multiply: return a + " * " + b;
+        case FusedOpType::Divide: return a + " / " + b;
+        case FusedOpType::Maximum: return "fmaxf(" + a + ", " + b + ")";
+        case FusedOpType::Minimum: return "fminf(" + a + ", " + b + ")";
+        case FusedOpType::Relu: return a + " > 0.0f ? " + a + " : 0.0f";
+        case FusedOpType::Gelu: return "gelu(" + a + ")";
+        case FusedOpType::Sigmoid: return "1.0f / (1.0f + expf(-" + a + "))";
+        case FusedOpType::Tanh: return "tanhf(" + a + ")";
+    }
+    return a;
+}
+
+} // namespace
+
+FusionPlan plan_fused_elementwise(const std::vector<TensorDesc>& inputs,
+                                  const std::vector<const void*>& input_data,
+                                  const std::vector<FusedOp>& ops,
+                                  const TensorDesc& output, void* output_data) {
+    if (inputs.empty() || inputs.size() != input_data.size()) {
+        throw std::invalid_argument("fused elementwise needs one data pointer per input");
+    }
+    if (ops.size() > kMaxFusedOps) {
+        throw std::invalid_argument("fused elementwise chain is too long");
+    }
+
+    // Operands may only refer to inputs and earlier results
+    const int input_count = static_cast<int>(inputs.size());
+    for (size_t j = 0; j < ops.size(); ++j) {
+        const int limit = input_count + static_cast<int>(j);
+        if (ops[j].lhs < 0 || ops[j].lhs >= limit ||
+            (is_binary(ops[j].type) && (ops[j].rhs < 0 || ops[j].rhs >= limit))) {
+            throw std::invalid_argument("fused elementwise op refers to an undefined value");
+        }
+    }
+
+    // Dead code elimination from the output back
+    const int value_count = input_count + static_cast<int>(ops.size());
+    std::vector<bool> live(value_count, false);
+    live[value_count - 1] = true;
+    for (size_t j = ops.size(); j-- > 0;) {
+        if (live[input_count + j]) {
+            live[ops[j].lhs] = true;
+            if (is_binary(ops[j].type)) {
+                live[ops[j].rhs] = true;
+            }
+        }
+    }
+
+    FusionPlan plan = {};
+    std::vector<int> renumbered(value_count, -1);
+    std::vector<const TensorDesc*> kernel_inputs;
+    plan.data_types.push_back(output.data_type);
+    for (int i = 0; i < input_count; ++i) {
+        if (!live[i]) {
+            continue;
+        }
+        if (static_cast<int>(kernel_inputs.size()) == kMaxFusedInputs) {
+            throw std::invalid_argument("fused elementwise chain reads too many inputs");
+        }
+        if (inputs[i].strides.size() != inputs[i].shape.size() || inputs[i].shape.size() > output.shape.size()) {
+            throw std::invalid_argument("fused elementwise input does not broadcast to the output");
+        }
+        renumbered[i] = static_cast<int>(kernel_inputs.size());
+        plan.params.ptrs[kernel_inputs.size() + 1] = const_cast<void*>(input_data[i]);
+        plan.data_types.push_back(inputs[i].data_type);
+        kernel_inputs.push_back(&inputs[i]);
+    }
+    plan.num_inputs = static_cast<int>(kernel_inputs.size());
+    for (size_t j = 0; j < ops.size(); ++j) {
+        if (!live[input_count + j]) {
+            continue;
+        }
+        FusedOp op = ops[j];
+        op.lhs = renumbered[op.lhs];
+        op.rhs = is_binary(op.type) ? renumbered[op.rhs] : -1;
+        renumbered[input_count + j] = plan.num_inputs + static_cast<int>(plan.ops.size());
+        plan.ops.push_back(op);
+    }
+
+    if (output.strides.size() != output.shape.size()) {
+        throw std::invalid_argument("fused elementwise output strides do not match its shape");
+    }
+    std::vector<Dim> dims = collapse_dims(output, kernel_inputs);
+    if (dims.size() > static_cast<size_t>(kMaxFusedDims)) {
+        throw std::invalid_argument("fused elementwise operands have too many non-contiguous dimensions");
+    }
+
+    const int operands = plan.num_inputs + 1;
+    plan.params.ptrs[0] = output_data;
+    plan.params.n = output.num_elements();
+    plan.rank = static_cast<int>(dims.size());
+    plan.dense = true;
+    for (const Dim& dim : dims) {
+        for (int t = 0; t < operands; ++t) {
+            plan.dense &= dims.size() == 1 && dim.strides[t] == 1;
+        }
+    }
+
+    // Largest offset any thread computes, including the grid-stride overshoot
+    size_t max_offset = plan.params.n + kMaxGridSize * kBlockSize;
+    for (size_t d = 0; d < dims.size(); ++d) {
+        plan.params.sizes[d] = dims[d].size;
+        for (int t = 0; t < operands; ++t) {
+            plan.params.strides[t][d] = dims[d].strides[t];
+        }
+    }
+    for (int t = 0; t < operands; ++t) {
+        size_t extent = 0;
+        for (const Dim& dim : dims) {
+            extent += (dim.size - 1) * dim.strides[t];
+        }
+        max_offset = std::max(max_offset, extent);
+    }
+    plan.wide_index = max_offset > static_cast<size_t>(std::numeric_limits<int32_t>::max());
+
+    std::ostringstream signature;
+    signature << (plan.dense ? "d" : "s" + std::to_string(plan.rank)) << (plan.wide_index ? "w" : "n");
+    for (int data_type : plan.data_types) {
+        signature << ':' << data_type;
+    }
+    for (const FusedOp& op : plan.ops) {
+        signature << ';' << static_cast<int>(op.type) << ',' << op.lhs << ',' << op.rhs;
+    }
+    plan.signature = signature.str();
+    return plan;
+}
+
+std::string generate_fused_source(const FusionPlan& plan) {
+    const int operands = plan.num_inputs + 1;
+    const int result = plan.ops.empty() ? 0 : plan.num_inputs + static_cast<int>(plan.ops.size()) - 1;
+    std::ostringstream src;
+
+    src << "typedef unsigned long long u64;\n"
+        << "struct Params {\n"
+        << "    void* ptrs[" << kOperands << "];\n"
+        << "    u64 sizes[" << kMaxFusedDims << "];\n"
+        << "    u64 strides[" << kOperands << "][" << kMaxFusedDims << "];\n"
+        << "    u64 n;\n"
+        << "};\n"
+        << "__device__ __forceinline__ float load_bf16(unsigned short v) {\n"
+        << "    return __uint_as_float(static_cast<unsigned int>(v) << 16);\n"
+        << "}\n"
+        << "__device__ __forceinline__ unsigned short store_bf16(float f) {\n"
+        << "    unsigned int u = __float_as_uint(f);\n"
+        << "    if ((u & 0x7fffffffu) > 0x7f800000u) return static_cast<unsigned short>((u >> 16) | 0x40u);\n"
+        << "    u += 0x7fffu + ((u >> 16) & 1u);\n"
+        << "    return static_cast<unsigned short>(u >> 16);\n"
+        << "}\n"
+        << "__device__ __forceinline__ float gelu(float x) {\n"
+        << "    return 0.5f * x * (1.0f + erff(x * 0.70710678118654752f));\n"
+        << "}\n"
+        << "extern \"C\" __global__ void __launch_bounds__(" << kBlockSize << ") "
+        << kFusedKernelName << "(Params p) {\n"
+        << "    typedef " << (plan.wide_index ? "u64" : "unsigned int") << " index_t;\n"
+        << "    " << storage_type(plan.data_types[0]) << "* out = static_cast<"
+        << storage_type(plan.data_types[0]) << "*>(p.ptrs[0]);\n";
+    for (int i = 0; i < plan.num_inputs; ++i) {
+        const char* type = storage_type(plan.data_types[i + 1]);
+        src << "    const " << type << "* in" << i << " = static_cast<const " << type << "*>(p.ptrs[" << i + 1 << "]);\n";
+    }
+    if (!plan.dense) {
+        for (int d = 0; d < plan.rank; ++d) {
+            src << "    const index_t size" << d << " = static_cast<index_t>(p.sizes[" << d << "]);\n";
+            for (int t = 0; t < operands; ++t) {
+                src << "    const index_t stride" << t << '_' << d << " = static_cast<index_t>(p.strides["
+                    << t << "][" << d << "]);\n";
+            }
+        }
+    }
+    src << "    const index_t n = static_cast<index_t>(p.n);\n"
+        << "    const index_t step = static_cast<index_t>(gridDim.x) * blockDim.x;\n"
+        << "    for (index_t i = static_cast<index_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < n; i += step) {\n";
+
+    if (plan.dense) {
+        for (int t = 0; t < operands; ++t) {
+            src << "        const index_t off" << t << " = i;\n";
+        }
+    } else {
+        src << "        index_t rem = i;\n";
+        for (int t = 0; t < operands; ++t) {
+            src << "        index_t off" << t << " = 0;\n";
+        }
+        for (int d = 0; d < plan.rank; ++d) {
+            bool last = d + 1 == plan.rank;
+            src << "        {\n"
+                << "            const index_t c = " << (last ? "rem" : "rem % size" + std::to_string(d)) << ";\n";
+            if (!last) {
+                src << "            rem /= size" << d << ";\n";
+            }
+            for (int t = 0; t < operands; ++t) {
+                src << "            off" << t << " += c * stride" << t << '_' << d << ";\n";
+            }
+            src << "        }\n";
+        }
+    }
+
+    for (int i = 0; i < plan.num_inputs; ++i) {
+        src << "        const float v" << i << " = "
+            << load_expr(plan.data_types[i + 1], "in" + std::to_string(i) + "[off" + std::to_string(i + 1) + "]")
+            << ";\n";
+    }
+    for (size_t j = 0; j < plan.ops.size(); ++j) {
+        src << "        const float v" << plan.num_inputs + j << " = " << op_expr(plan.ops[j]) << ";\n";
+    }
+    src << "        out[off0] = " << store_expr(plan.data_types[0], "v" + std::to_string(result)) << ";\n"
+        << "    }\n"
+        << "}\n";
+    return src.str();
+}
+
+bool compile_fused_kernel(const std::string& source, const std::string& arch,
+                          void*& module, void*& function) {
+    hiprtcProgram program;
+    if (hiprtcCreateProgram(&program, source.c_str(), "rdna_fused_elementwise.hip", 0, nullptr, nullptr) != HIPRTC_SUCCESS) {
+        return false;
+    }
+
+    std::vector<const char*> options = {"-O3", "-std=c++17"};
+    std::string arch_option = "--offload-arch=" + arch;
+    if (!arch.empty()) {
+        options.push_back(arch_option.c_str());
+    }
+    hiprtcResult result = hiprtcCompileProgram(program, static_cast<int>(options.size()), options.data());
+    if (result != HIPRTC_SUCCESS) {
+        size_t log_size = 0;
+        hiprtcGetProgramLogSize(program, &log_size);
+        std::string log(log_size, '\0');
+        if (log_size > 0) {
+            hiprtcGetProgramLog(program, &log[0]);
+        }
+        std::cerr << "Warning: Failed to compile fused elementwise kernel: "
+                  << hiprtcGetErrorString(result) << "\n" << log << std::endl;
+        hiprtcDestroyProgram(&program);
+        return false;
+    }
+
+    size_t code_size = 0;
+    hiprtcGetCodeSize(program, &code_size);
+    std::vector<char> code(code_size);
+    hiprtcGetCode(program, code.data());
+    hiprtcDestroyProgram(&program);
+
+    hipModule_t hip_module = nullptr;
+    hipFunction_t hip_function = nullptr;
+    if (hipModuleLoadData(&hip_module, code.data()) != hipSuccess) {
+        return false;
+    }
+    if (hipModuleGetFunction(&hip_function, hip_module, kFusedKernelName) != hipSuccess) {
+        hipModuleUnload(hip_module);
+        return false;
+    }
+    module = hip_module;
+    function = hip_function;
+    return true;
+}
+
+bool launch_fused_kernel(void* function, const FusionPlan& plan, void* stream) {
+    if (plan.params.n == 0) {
+        return true;
+    }
+
+    unsigned grid = static_cast<unsigned>(std::min<size_t>((plan.params.n + kBlockSize - 1) / kBlockSize, kMaxGridSize));
+    FusedKernelParams params = plan.params;
+    void* args[] = {&params};
+    hipError_t result = hipModuleLaunchKernel(static_cast<hipFunction_t>(function), grid, 1, 1, kBlockSize, 1, 1,
+                                              0, static_cast<hipStream_t>(stream), args, nullptr);
+    if (result != hipSuccess) {
+        std::cerr << "Warning: Fused elementwise kernel launch failed: " << hipGetErrorString(result) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace rdna
@@ -0,0 +1,60 @@
+#ifndef RDNA_FUSION_H
+#define RDNA_FUSION_H
+
+#include "rdna/kernels.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rdna {
+
+constexpr int kMaxFusedInputs = 8;
+constexpr int kMaxFusedDims = 6;
+constexpr size_t kMaxFusedOps = 32;
+constexpr const char* kFusedKernelName = "rdna_fused_elementwise";
+
+// Kernel argument block, passed by value; the generated source declares an
+// identical struct. Slot 0 is the output, slots 1.. the kernel inputs.
+struct FusedKernelParams {
+    void* ptrs[kMaxFusedInputs + 1];
+    uint64_t sizes[kMaxFusedDims];  // Innermost dimension first
+    uint64_t strides[kMaxFusedInputs + 1][kMaxFusedDims];
+    uint64_t n;
+};
+
+/**
+ * @brief Lowered form of a fused elementwise chain
+ *
+ * Only shape-independent properties go into signature, so one compiled
+ * kernel serves every shape and broadcast pattern with the same rank.
+ */
+struct FusionPlan {
+    std::string signature;
+    std::vector<int> data_types;  // Output, then each kernel input
+    std::vector<FusedOp> ops;     // Live ops, operands renumbered over kernel inputs
+    int num_inputs;
+    int rank;          // Collapsed rank; unused when dense
+    bool dense;        // Every operand is one unit-stride run
+    bool wide_index;   // Offsets need 64-bit arithmetic
+    FusedKernelParams params;
+};
+
+// Validate the chain, drop ops and inputs the output does not depend on and
+// collapse the broadcast layout. Throws std::invalid_argument if malformed.
+FusionPlan plan_fused_elementwise(const std::vector<TensorDesc>& inputs,
+                                  const std::vector<const void*>& input_data,
+                                  const std::vector<FusedOp>& ops,
+                                  const TensorDesc& output, void* output_data);
+
+std::string generate_fused_source(const FusionPlan& plan);
+
+// Compile with hipRTC and load into the current device; prints the build log
+// and returns false on failure
+bool compile_fused_kernel(const std::string& source, const std::string& arch,
+                          void*& module, void*& function);
+
+bool launch_fused_kernel(void* function, const FusionPlan& plan, void* stream);
+
+} // namespace rdna
+
+#endif // RDNA_FUSION_H
@@ -1,9 +1,351 @@
 #include "rdna/kernels.h"
+#include "rdna/memory.h"
+#include "rdna/profiler.h"
+#include "attention.h"
+#include "elementwise.h"
+#include "fusion.h"
+#include "normalization.h"
+#include "reduction.h"
+#include <hip/hip_runtime.h>
+#define ROCBLAS_BETA_FEATURES_API  // Solution enumeration for the autotuner
+#include <rocblas/rocblas.h>
+#include <miopen/miopen.h>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <stdexcept>
 #include <iostream>
+#include <limits>
+#include <sstream>
 
 namespace rdna {
 
+namespace {
+
+// Column-major description of one rocBLAS GEMM operand
+struct GemmOperand {
+    rocblas_operation op;
+    rocblas_int ld;
+};
+
+rocblas_datatype to_rocblas_type(int data_type) {
+    switch (data_type) {
+        case 1: return rocblas_datatype_f16_r;
+        case 2: return rocblas_datatype_bf16_r;
+        default: return rocblas_datatype_f32_r;
+    }
+}
+
+bool fits_rocblas_int(size_t value) {
+    return value <= static_cast<size_t>(std::numeric_limits<rocblas_int>::max());
+}
+
+// rocBLAS is column-major, so a row-major product C = op(A) * op(B) is issued
+// as C^T = op(B)^T * op(A)^T. This describes op(X)^T for an operand stored
+// with extents rows x cols and the given element strides; a row-major X is
+// already X^T in column-major terms, a column-major one needs a transpose.
+bool describe_operand(size_t rows, size_t cols, size_t row_stride, size_t col_stride,
+                      bool transpose, GemmOperand& operand) {
+    size_t ld;
+    bool row_major;
+    if (col_stride == 1 || cols == 1) {
+        row_major = true;
+        ld = (rows == 1) ? cols : row_stride;
+        if (ld < cols) return false;
+    } else if (row_stride == 1 || rows == 1) {
+        row_major = false;
+        ld = col_stride;
+        if (ld < rows) return false;
+    } else {
+        return false;
+    }
+    if (!fits_rocblas_int(ld)) return false;
+    
+    operand.op = (row_major != transpose) ? rocblas_operation_none : rocblas_operation_transpose;
+    operand.ld = static_cast<rocblas_int>(std::max<size_t>(ld, 1));
+    return true;
+}
+
+miopenDataType_t to_miopen_type(int data_type) {
+    switch (data_type) {
+        case 1: return miopenHalf;
+        case 2: return miopenBFloat16;
+        default: return miopenFloat;
+    }
+}
+
+// Bytes spanned by a possibly strided tensor
+size_t storage_size(const TensorDesc& desc) {
+    if (desc.num_elements() == 0) {
+        return 0;
+    }
+    size_t extent = 1;
+    for (size_t i = 0; i < desc.shape.size(); ++i) {
+        extent += (desc.shape[i] - 1) * desc.strides[i];
+    }
+    return extent * get_data_type_size(desc.data_type);
+}
+
+// Owns a MIOpen tensor descriptor built from a TensorDesc
+class MiopenTensor {
+public:
+    explicit MiopenTensor(const TensorDesc& desc) : desc_(nullptr) {
+        if (miopenCreateTensorDescriptor(&desc_) != miopenStatusSuccess) {
+            desc_ = nullptr;
+            return;
+        }
+        std::vector<int> dims(desc.shape.begin(), desc.shape.end());
+        std::vector<int> strides(desc.strides.begin(), desc.strides.end());
+        if (miopenSetTensorDescriptor(desc_, to_miopen_type(desc.data_type), static_cast<int>(dims.size()),
+                                      dims.data(), strides.data()) != miopenStatusSuccess) {
+            miopenDestroyTensorDescriptor(desc_);
+            desc_ = nullptr;
+        }
+    }
+    ~MiopenTensor() {
+        if (desc_) {
+            miopenDestroyTensorDescriptor(desc_);
+        }
+    }
+    MiopenTensor(const MiopenTensor&) = delete;
+    MiopenTensor& operator=(const MiopenTensor&) = delete;
+    
+    bool is_valid() const { return desc_ != nullptr; }
+    miopenTensorDescriptor_t get() const { return desc_; }
+    
+private:
+    miopenTensorDescriptor_t desc_;
+};
+
+// Owns a 2D MIOpen convolution descriptor built from a ConvConfig
+class MiopenConvolution {
+public:
+    explicit MiopenConvolution(const ConvConfig& config) : desc_(nullptr) {
+        if (config.padding.size() != 2 || config.stride.size() != 2 || config.dilation.size() != 2) {
+            return;
+        }
+        if (miopenCreateConvolutionDescriptor(&desc_) != miopenStatusSuccess) {
+            desc_ = nullptr;
+            return;
+        }
+        if (miopenInitConvolutionDescriptor(desc_, miopenConvolution,
+                                            config.padding[0], config.padding[1],
+                                            config.stride[0], config.stride[1],
+                                            config.dilation[0], config.dilation[1]) != miopenStatusSuccess ||
+            miopenSetConvolutionGroupCount(desc_, config.groups) != miopenStatusSuccess) {
+            miopenDestroyConvolutionDescriptor(desc_);
+            desc_ = nullptr;
+        }
+    }
+    ~MiopenConvolution() {
+        if (desc_) {
+            miopenDestroyConvolutionDescriptor(desc_);
+        }
+    }
+    MiopenConvolution(const MiopenConvolution&) = delete;
+    MiopenConvolution& operator=(const MiopenConvolution&) = delete;
+    
+    bool is_valid() const { return desc_ != nullptr; }
+    miopenConvolutionDescriptor_t get() const { return desc_; }
+    
+private:
+    miopenConvolutionDescriptor_t desc_;
+};
+
+// Work given no stream goes to the calling thread's current stream
+void* resolve_stream(int device_id, void* stream) {
+    return stream ? stream : DeviceManager::get_instance().get_current_stream_handle(device_id);
+}
+
+// Device scratch from the caching allocator. Release is stream-ordered, so it
+// is safe to drop as soon as the work using it has been queued.
+class DeviceBuffer {
+public:
+    DeviceBuffer(size_t size, int device_id, void* stream) : ptr_(nullptr), size_(size) {
+        if (size_ > 0) {
+            AllocationOptions options = {};
+            options.stream = stream;
+            ptr_ = MemoryManager::get_instance().allocate(size_, device_id, options);
+        }
+    }
+    ~DeviceBuffer() {
+        if (ptr_) {
+            MemoryManager::get_instance().deallocate(ptr_);
+        }
+    }
+    DeviceBuffer(const DeviceBuffer&) = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+    
+    bool is_valid() const { return size_ == 0 || ptr_ != nullptr; }
+    void* get() const { return ptr_; }
+    size_t size() const { return size_; }
+    
+private:
+    void* ptr_;
+    size_t size_;
+};
+
+// Looks up key, running find on a miss or when the cached algorithm no
+// longer fits workspace_limit. find(exhaustive, algorithm, workspace_size)
+// reports the fastest algorithm MIOpen found within the limit.
+using ConvFindFn = std::function<bool(bool, int&, size_t&)>;
+
+bool select_conv_algorithm(const std::string& key, bool benchmark, size_t workspace_limit,
+                           const ConvFindFn& find, int& algorithm, size_t& workspace_size) {
+    ConvAlgorithmCache& cache = ConvAlgorithmCache::get_instance();
+    if (cache.lookup(key, benchmark, algorithm, workspace_size) && workspace_size <= workspace_limit) {
+        return true;
+    }
+    if (!find(benchmark, algorithm, workspace_size)) {
+        return false;
+    }
+    cache.store(key, benchmark, algorithm, workspace_size);
+    return true;
+}
+
+// Selects algorithm for one convolution direction and acquires its
+// workspace on stream. get_workspace_size(size_t*) and
+// find_algorithm(workspace, workspace_size, exhaustive, perf, returned)
+// wrap the direction's MIOpen calls; perf_algorithm is the perf field
+// that direction reports.
+template <typename Algorithm, typename GetWorkspaceSize, typename FindAlgorithm>
+bool prepare_conv_algorithm(const std::string& key, bool benchmark, int device_id, void* stream,
+                            Algorithm miopenConvAlgoPerf_t::*perf_algorithm,
+                            GetWorkspaceSize get_workspace_size, FindAlgorithm find_algorithm,
+                            Algorithm& algorithm, Workspace& workspace) {
+    MemoryManager& memory = MemoryManager::get_instance();
+    const size_t workspace_limit = memory.get_workspace_limit();
+    
+    // Find only considers algorithms whose workspace fits the buffer it is
+    // given, so capping that buffer makes the fastest fitting one win
+    auto find = [&](bool exhaustive, int& found, size_t& workspace_size) {
+        size_t search_size = 0;
+        if (get_workspace_size(&search_size) != miopenStatusSuccess) {
+            return false;
+        }
+        Workspace search = memory.acquire_workspace(std::min(search_size, workspace_limit), device_id, stream);
+        miopenConvAlgoPerf_t perf;
+        int returned = 0;
+        if (!search ||
+            find_algorithm(search.data(), search.size(), exhaustive, &perf, &returned) != miopenStatusSuccess ||
+            returned == 0) {
+            return false;
+        }
+        found = static_cast<int>(perf.*perf_algorithm);
+        workspace_size = perf.memory;
+        return true;
+    };
+    
+    int selected = 0;
+    size_t workspace_size = 0;
+    if (!select_conv_algorithm(key, benchmark, workspace_limit, find, selected, workspace_size)) {
+        return false;
+    }
+    algorithm = static_cast<Algorithm>(selected);
+    workspace = memory.acquire_workspace(workspace_size, device_id, stream);
+    return static_cast<bool>(workspace);
+}
+
+const char* forward_algorithm_name(int algorithm) {
+    switch (algorithm) {
+        case miopenConvolutionFwdAlgoGEMM: return "miopenConvolutionFwdAlgoGEMM";
+        case miopenConvolutionFwdAlgoDirect: return "miopenConvolutionFwdAlgoDirect";
+        case miopenConvolutionFwdAlgoFFT: return "miopenConvolutionFwdAlgoFFT";
+        case miopenConvolutionFwdAlgoWinograd: return "miopenConvolutionFwdAlgoWinograd";
+        case miopenConvolutionFwdAlgoImplicitGEMM: return "miopenConvolutionFwdAlgoImplicitGEMM";
+        default: return "UNKNOWN_ALGORITHM";
+    }
+}
+
+// Tuning names for rocBLAS GEMM kernels; the standard heuristic is -1
+std::string gemm_solution_name(int32_t solution) {
+    return solution < 0 ? "rocblas_standard" : "rocblas_solution_" + std::to_string(solution);
+}
+
+int32_t parse_gemm_solution(const std::string& name) {
+    const std::string prefix = "rocblas_solution_";
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+        return -1;
+    }
+    try {
+        return std::stoi(name.substr(prefix.size()));
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+// Every solution rocBLAS can run for this problem, for the autotuner
+std::vector<int32_t> list_gemm_solutions(rocblas_handle handle, bool batched,
+                                         const GemmOperand& op_a, const GemmOperand& op_b, const GemmOperand& op_c,
+                                         size_t m, size_t n, size_t k, size_t batch,
+                                         const TensorDesc& a, const TensorDesc& b, const TensorDesc& c,
+                                         const void* a_data, const void* b_data, void* c_data,
+                                         const MatmulConfig& config,
+                                         rocblas_datatype input_type, rocblas_datatype output_type) {
+    auto query = [&](rocblas_int* list, rocblas_int* size) {
+        if (!batched) {
+            return rocblas_gemm_ex_get_solutions(handle, op_b.op, op_a.op,
+                                                 static_cast<rocblas_int>(n), static_cast<rocblas_int>(m),
+                                                 static_cast<rocblas_int>(k), &config.alpha,
+                                                 b_data, input_type, op_b.ld,
+                                                 a_data, input_type, op_a.ld,
+                                                 &config.beta,
+                                                 c_data, output_type, op_c.ld,
+                                                 c_data, output_type, op_c.ld,
+                                                 rocblas_datatype_f32_r, rocblas_gemm_algo_solution_index,
+                                                 rocblas_gemm_flags_none, list, size);
+        }
+        rocblas_stride stride_a = a.shape[0] == 1 ? 0 : static_cast<rocblas_stride>(a.strides[0]);
+        rocblas_stride stride_b = b.shape[0] == 1 ? 0 : static_cast<rocblas_stride>(b.strides[0]);
+        rocblas_stride stride_c = static_cast<rocblas_stride>(c.strides[0]);
+        return rocblas_gemm_strided_batched_ex_get_solutions(handle, op_b.op, op_a.op,
+                                                             static_cast<rocblas_int>(n), static_cast<rocblas_int>(m),
+                                                             static_cast<rocblas_int>(k), &config.alpha,
+                                                             b_data, input_type, op_b.ld, stride_b,
+                                                             a_data, input_type, op_a.ld, stride_a,
+                                                             &config.beta,
+                                                             c_data, output_type, op_c.ld, stride_c,
+                                                             c_data, output_type, op_c.ld, stride_c,
+                                                             static_cast<rocblas_int>(batch),
+                                                             rocblas_datatype_f32_r, rocblas_gemm_algo_solution_index,
+                                                             rocblas_gemm_flags_none, list, size);
+    };
+    
+    rocblas_int size = 0;
+    if (query(nullptr, &size) != rocblas_status_success || size <= 0) {
+        return {};
+    }
+    std::vector<rocblas_int> list(size);
+    if (query(list.data(), &size) != rocblas_status_success) {
+        return {};
+    }
+    list.resize(std::min<size_t>(list.size(), static_cast<size_t>(size)));
+    return std::vector<int32_t>(list.begin(), list.end());
+}
+
+std::string default_find_db_path() {
+    if (const char* path = std::getenv("RDNA_CONV_FIND_DB")) {
+        return path;
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/rdna/conv_find_db.txt";
+    }
+    return "";
+}
+
+// Bytes a fused chain moves: every input once, plus the output
+size_t fused_traffic(const std::vector<TensorDesc>& inputs, const TensorDesc& output) {
+    size_t bytes = output.get_size();
+    for (const TensorDesc& input : inputs) {
+        bytes += input.get_size();
+    }
+    return bytes;
+}
+
+} // namespace
+
 // KernelConfig implementation
 KernelConfig::KernelConfig()
     : shared_memory_size(0), stream(nullptr) {
@@ -54,6 +396,18 @@ size_t TensorDesc::get_size() const {
 MatmulConfig::MatmulConfig()
     : transpose_a(false), transpose_b(false), alpha(1.0f), beta(0.0f) {}
 
+// FusedOp implementation
+FusedOp::FusedOp(FusedOpType type, int lhs, int rhs)
+    : type(type), lhs(lhs), rhs(rhs) {}
+
+// MatmulEpilogue implementation
+MatmulEpilogue::MatmulEpilogue()
+    : bias(nullptr), activation(Activation::Identity), residual(nullptr) {}
+
+bool MatmulEpilogue::empty() const {
+    return !bias && activation == Activation::Identity && !residual;
+}
+
 // ConvConfig implementation
 ConvConfig::ConvConfig()
     : groups(1), benchmark(false) {
@@ -62,6 +416,10 @@ ConvConfig::ConvConfig()
     dilation = {1, 1};
 }
 
+// AttentionConfig implementation
+AttentionConfig::AttentionConfig()
+    : scale(0.0f), causal(false), key_lengths(nullptr) {}
+
 // MatmulKernel implementation
 MatmulKernel::MatmulKernel(std::shared_ptr<DeviceContext> context)
     : context_(context), rocblas_handle_(nullptr) {
@@ -70,17 +428,35 @@ MatmulKernel::MatmulKernel(std::shared_ptr<DeviceContext> context)
 
 MatmulKernel::~MatmulKernel() {
     if (rocblas_handle_) {
-        // rocblas_destroy_handle(rocblas_handle_);
+        rocblas_status status = rocblas_destroy_handle(static_cast<rocblas_handle>(rocblas_handle_));
+        if (status != rocblas_status_success) {
+            std::cerr << "Warning: Failed to destroy rocBLAS handle: " << rocblas_status_to_string(status) << std::endl;
+        }
     }
 }
 
 bool MatmulKernel::initialize() {
-    // TODO: Initialize rocBLAS handle
-    // rocblas_status status = rocblas_create_handle(&rocblas_handle_);
-    // if (status != rocblas_status_success) {
-    //     return false;
-    // }
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    if (initialized_) {
+        return true;
+    }
+    
+    // rocBLAS binds a handle to the device that is current when it is created
+    int previous_device = 0;
+    hipGetDevice(&previous_device);
+    if (hipSetDevice(context_->get_device_id()) != hipSuccess) {
+        return false;
+    }
     
+    rocblas_handle handle = nullptr;
+    rocblas_status status = rocblas_create_handle(&handle);
+    hipSetDevice(previous_device);
+    if (status != rocblas_status_success) {
+        return false;
+    }
+    
+    rocblas_handle_ = handle;
+    arch_ = context_->get_properties().arch;
     initialized_ = true;
     return true;
 }
@@ -97,33 +473,369 @@ bool MatmulKernel::matmul(const TensorDesc& a, const void* a_data,
                           const TensorDesc& b, const void* b_data,
                           const TensorDesc& c, void* c_data,
                           const MatmulConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "matmul", context_->get_device_id(), stream,
+                             a.get_size() + b.get_size() + c.get_size());
+    return gemm(a, a_data, b, b_data, c, c_data, config, stream, false, false);
+}
+
+bool MatmulKernel::batched_matmul(const TensorDesc& a, const void* a_data,
+                                  const TensorDesc& b, const void* b_data,
+                                  const TensorDesc& c, void* c_data,
+                                  const MatmulConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "batched_matmul", context_->get_device_id(), stream,
+                             a.get_size() + b.get_size() + c.get_size());
+    return gemm(a, a_data, b, b_data, c, c_data, config, stream, true, false);
+}
+
+bool MatmulKernel::gemm(const TensorDesc& a, const void* a_data,
+                        const TensorDesc& b, const void* b_data,
+                        const TensorDesc& c, void* c_data,
+                        const MatmulConfig& config, void* stream, bool batched, bool tune) {
     if (!initialized_) {
         throw std::runtime_error("MatmulKernel not initialized");
     }
     
-    // TODO: Implement matmul using rocBLAS
-    // This is a placeholder implementation
-    std::cout << "Matmul operation: " << a.shape[0] << "x" << a.shape[1] 
-              << " * " << b.shape[0] << "x" << b.shape[1] 
-              << " -> " << c.shape[0] << "x" << c.shape[1] << std::endl;
+    const size_t rank = batched ? 3 : 2;
+    for (const TensorDesc* desc : {&a, &b, &c}) {
+        if (desc->shape.size() != rank || desc->strides.size() != rank) {
+            throw std::invalid_argument(batched ? "batched_matmul expects 3D tensors" : "matmul expects 2D tensors");
+        }
+    }
+    if (a.data_type != b.data_type) {
+        throw std::invalid_argument("matmul inputs must share a data type");
+    }
+    
+    // Logical extents of op(A) (m x k) and op(B) (k x n)
+    const size_t r = rank - 2;
+    size_t m = config.transpose_a ? a.shape[r + 1] : a.shape[r];
+    size_t k = config.transpose_a ? a.shape[r] : a.shape[r + 1];
+    size_t kb = config.transpose_b ? b.shape[r + 1] : b.shape[r];
+    size_t n = config.transpose_b ? b.shape[r] : b.shape[r + 1];
+    if (k != kb || c.shape[r] != m || c.shape[r + 1] != n) {
+        throw std::invalid_argument("matmul shape mismatch");
+    }
+    if (!fits_rocblas_int(m) || !fits_rocblas_int(n) || !fits_rocblas_int(k)) {
+        throw std::invalid_argument("matmul dimensions exceed rocBLAS limits");
+    }
+    
+    GemmOperand op_a, op_b, op_c;
+    if (!describe_operand(a.shape[r], a.shape[r + 1], a.strides[r], a.strides[r + 1], config.transpose_a, op_a) ||
+        !describe_operand(b.shape[r], b.shape[r + 1], b.strides[r], b.strides[r + 1], config.transpose_b, op_b) ||
+        !describe_operand(m, n, c.strides[r], c.strides[r + 1], false, op_c) ||
+        op_c.op != rocblas_operation_none) {
+        throw std::invalid_argument("matmul operands need one unit-stride dimension and a row-major output");
+    }
+    
+    size_t batch = batched ? c.shape[0] : 1;
+    if (batched && ((a.shape[0] != batch && a.shape[0] != 1) || (b.shape[0] != batch && b.shape[0] != 1) ||
+                    !fits_rocblas_int(batch))) {
+        throw std::invalid_argument("batched_matmul batch mismatch");
+    }
+    
+    rocblas_datatype input_type = to_rocblas_type(a.data_type);
+    rocblas_datatype output_type = to_rocblas_type(c.data_type);
+    
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    rocblas_handle handle = static_cast<rocblas_handle>(rocblas_handle_);
+    if (rocblas_set_stream(handle, static_cast<hipStream_t>(stream)) != rocblas_status_success) {
+        return false;
+    }
+    
+    // A negative solution index means the standard algorithm, where rocBLAS
+    // picks a kernel heuristically
+    auto issue = [&](int32_t solution, void* out) {
+        rocblas_gemm_algo algo = solution < 0 ? rocblas_gemm_algo_standard : rocblas_gemm_algo_solution_index;
+        solution = std::max(solution, 0);
+        if (!batched) {
+            return rocblas_gemm_ex(handle, op_b.op, op_a.op,
+                                   static_cast<rocblas_int>(n), static_cast<rocblas_int>(m), static_cast<rocblas_int>(k),
+                                   &config.alpha,
+                                   b_data, input_type, op_b.ld,
+                                   a_data, input_type, op_a.ld,
+                                   &config.beta,
+                                   out, output_type, op_c.ld,
+                                   out, output_type, op_c.ld,
+                                   rocblas_datatype_f32_r, algo, solution, 0);
+        }
+        // A zero stride re-reads the same matrix for every batch entry
+        rocblas_stride stride_a = a.shape[0] == 1 ? 0 : static_cast<rocblas_stride>(a.strides[0]);
+        rocblas_stride stride_b = b.shape[0] == 1 ? 0 : static_cast<rocblas_stride>(b.strides[0]);
+        rocblas_stride stride_c = static_cast<rocblas_stride>(c.strides[0]);
+        
+        return rocblas_gemm_strided_batched_ex(handle, op_b.op, op_a.op,
+                                               static_cast<rocblas_int>(n), static_cast<rocblas_int>(m),
+                                               static_cast<rocblas_int>(k),
+                                               &config.alpha,
+                                               b_data, input_type, op_b.ld, stride_b,
+                                               a_data, input_type, op_a.ld, stride_a,
+                                               &config.beta,
+                                               out, output_type, op_c.ld, stride_c,
+                                               out, output_type, op_c.ld, stride_c,
+                                               static_cast<rocblas_int>(batch),
+                                               rocblas_datatype_f32_r, algo, solution, 0);
+    };
+    
+    // Size query mode returns without launching, so the scratch a solution
+    // needs can be lent from the stream's arena instead of rocBLAS's own pool
+    auto workspace_needed = [&](int32_t solution) {
+        size_t size = 0;
+        if (rocblas_start_device_memory_size_query(handle) == rocblas_status_success) {
+            issue(solution, c_data);
+            if (rocblas_stop_device_memory_size_query(handle, &size) != rocblas_status_success) {
+                size = 0;
+            }
+        }
+        return size;
+    };
+    
+    PerformanceOptimizer& optimizer = PerformanceOptimizer::get_instance();
+    std::string tuning_key;
+    if (tune || optimizer.get_tuned_count() > 0) {
+        std::string op = std::string("gemm_") + (op_b.op == rocblas_operation_none ? 'N' : 'T') +
+                         (op_a.op == rocblas_operation_none ? 'N' : 'T') + "_out" + std::to_string(c.data_type);
+        tuning_key = PerformanceOptimizer::make_tuning_key(op, {m, n, k, batch}, a.data_type, arch_);
+    }
+    
+    std::vector<int32_t> solutions;
+    if (tune) {
+        solutions = list_gemm_solutions(handle, batched, op_a, op_b, op_c, m, n, k, batch, a, b, c,
+                                        a_data, b_data, c_data, config, input_type, output_type);
+    }
     
+    int32_t solution = -1;
+    TuningResult tuned;
+    if (!tune && !tuning_key.empty() && optimizer.lookup(tuning_key, tuned)) {
+        solution = parse_gemm_solution(tuned.algorithm);
+    }
+    
+    size_t workspace_size = workspace_needed(solution);
+    for (int32_t candidate : solutions) {
+        workspace_size = std::max(workspace_size, workspace_needed(candidate));
+    }
+    Workspace workspace = MemoryManager::get_instance().acquire_workspace(workspace_size, context_->get_device_id(), stream);
+    if (!workspace) {
+        std::cerr << "Warning: rocBLAS GEMM needs " << workspace_size << " bytes of workspace, over the limit" << std::endl;
+        return false;
+    }
+    if (rocblas_set_workspace(handle, workspace.data(), workspace.size()) != rocblas_status_success) {
+        return false;
+    }
+    
+    if (tune) {
+        // Candidates run many times, so a nonzero beta would keep accumulating
+        // into C. They write a copy of it instead and only the final issue
+        // below touches the caller's output.
+        DeviceBuffer scratch(storage_size(c), context_->get_device_id(), stream);
+        if (!scratch.is_valid() ||
+            hipMemcpyAsync(scratch.get(), c_data, scratch.size(), hipMemcpyDeviceToDevice,
+                           static_cast<hipStream_t>(stream)) != hipSuccess) {
+            return false;
+        }
+        std::vector<TuningCandidate> candidates;
+        solutions.insert(solutions.begin(), -1);
+        for (int32_t candidate : solutions) {
+            candidates.push_back({gemm_solution_name(candidate), KernelConfig(), [&, candidate](void*) {
+                return issue(candidate, scratch.get()) == rocblas_status_success;
+            }});
+        }
+        if (optimizer.tune(tuning_key, candidates, context_->get_device_id(), stream, &tuned)) {
+            solution = parse_gemm_solution(tuned.algorithm);
+        }
+    }
+    
+    rocblas_status status = issue(solution, c_data);
+    if (status != rocblas_status_success && solution >= 0) {
+        // A solution tuned on a neighbouring shape in the bucket may not apply here
+        status = issue(-1, c_data);
+    }
+    if (status != rocblas_status_success) {
+        std::cerr << "Warning: rocBLAS GEMM failed: " << rocblas_status_to_string(status) << std::endl;
+        return false;
+    }
     return true;
 }
 
-bool MatmulKernel::batched_matmul(const std::vector<TensorDesc>& a_batch, const void* a_data,
-                                  const std::vector<TensorDesc>& b_batch, const void* b_data,
-                                  const std::vector<TensorDesc>& c_batch, void* c_data,
-                                  const MatmulConfig& config, void* stream) {
-    if (!initialized_) {
-        throw std::runtime_error("MatmulKernel not initialized");
+bool MatmulKernel::tune(const TensorDesc& a, const void* a_data,
+                        const TensorDesc& b, const void* b_data,
+                        const TensorDesc& c, void* c_data,
+                        const MatmulConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    return gemm(a, a_data, b, b_data, c, c_data, config, stream, c.shape.size() == 3, true);
+}
+
+bool MatmulKernel::fused_matmul(const TensorDesc& a, const void* a_data,
+                                const TensorDesc& b, const void* b_data,
+                                const TensorDesc& c, void* c_data,
+                                const MatmulEpilogue& epilogue,
+                                const MatmulConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "fused_matmul", context_->get_device_id(), stream,
+                             a.get_size() + b.get_size() + c.get_size());
+    const bool batched = c.shape.size() == 3;
+    if (epilogue.empty()) {
+        return gemm(a, a_data, b, b_data, c, c_data, config, stream, batched, false);
     }
     
-    // TODO: Implement batched matmul
-    std::cout << "Batched matmul operation: " << a_batch.size() << " batches" << std::endl;
+    // Round to C's type only once, after the epilogue. beta needs C itself as
+    // the GEMM input, so in that case the epilogue updates C in place.
+    const bool widen = c.data_type != 0 && config.beta == 0.0f;
+    TensorDesc product = widen ? TensorDesc(c.shape, 0) : c;
+    DeviceBuffer scratch(widen ? product.get_size() : 0, context_->get_device_id(), stream);
+    if (!scratch.is_valid()) {
+        return false;
+    }
+    void* product_data = widen ? scratch.get() : c_data;
+    if (!gemm(a, a_data, b, b_data, product, product_data, config, stream, batched, false)) {
+        return false;
+    }
+    
+    std::vector<TensorDesc> inputs = {product};
+    std::vector<const void*> input_data = {product_data};
+    int bias_value = -1, residual_value = -1;
+    if (epilogue.bias) {
+        bias_value = static_cast<int>(inputs.size());
+        inputs.push_back(epilogue.bias_desc);
+        input_data.push_back(epilogue.bias);
+    }
+    if (epilogue.residual) {
+        residual_value = static_cast<int>(inputs.size());
+        inputs.push_back(epilogue.residual_desc);
+        input_data.push_back(epilogue.residual);
+    }
+    
+    std::vector<FusedOp> ops;
+    int value = 0;
+    auto append = [&](FusedOpType type, int rhs) {
+        ops.emplace_back(type, value, rhs);
+        value = static_cast<int>(inputs.size() + ops.size()) - 1;
+    };
+    if (bias_value >= 0) {
+        append(FusedOpType::Add, bias_value);
+    }
+    if (epilogue.activation == Activation::Relu) {
+        append(FusedOpType::Relu, -1);
+    } else if (epilogue.activation == Activation::Gelu) {
+        append(FusedOpType::Gelu, -1);
+    }
+    if (residual_value >= 0) {
+        append(FusedOpType::Add, residual_value);
+    }
+    
+    auto custom = KernelManager::get_instance().get_custom_kernels(context_->get_device_id());
+    if (!custom->is_initialized() && !custom->initialize()) {
+        return false;
+    }
+    return custom->fused_elementwise(inputs, input_data, ops, c, c_data, stream);
+}
+
+// ConvAlgorithmCache implementation
+ConvAlgorithmCache& ConvAlgorithmCache::get_instance() {
+    static ConvAlgorithmCache instance;
+    return instance;
+}
+
+ConvAlgorithmCache::ConvAlgorithmCache() : database_path_(default_find_db_path()) {
+    if (!database_path_.empty()) {
+        load_locked(database_path_);
+    }
+}
+
+bool ConvAlgorithmCache::lookup(const std::string& key, bool benchmarked_only,
+                                int& algorithm, size_t& workspace_size) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || (benchmarked_only && !it->second.benchmarked)) {
+        return false;
+    }
+    algorithm = it->second.algorithm;
+    workspace_size = it->second.workspace_size;
+    return true;
+}
+
+void ConvAlgorithmCache::store(const std::string& key, bool benchmarked, int algorithm, size_t workspace_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = Entry{algorithm, workspace_size, benchmarked};
+    if (!benchmarked || database_path_.empty()) {
+        return;
+    }
+    
+    // Append, so concurrent workers only ever add lines; the last one wins on load
+    std::error_code error;
+    std::filesystem::path path(database_path_);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    std::ofstream out(database_path_, std::ios::app);
+    if (!out) {
+        std::cerr << "Warning: Failed to write conv find-db: " << database_path_ << std::endl;
+        return;
+    }
+    out << key << ' ' << algorithm << ' ' << workspace_size << '\n';
+}
+
+bool ConvAlgorithmCache::load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return load_locked(path);
+}
+
+bool ConvAlgorithmCache::load_locked(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
     
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        int algorithm;
+        size_t workspace_size;
+        if (fields >> key >> algorithm >> workspace_size) {
+            entries_[key] = Entry{algorithm, workspace_size, true};
+        }
+    }
     return true;
 }
 
+bool ConvAlgorithmCache::save(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    for (const auto& entry : entries_) {
+        if (entry.second.benchmarked) {
+            out << entry.first << ' ' << entry.second.algorithm << ' ' << entry.second.workspace_size << '\n';
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+void ConvAlgorithmCache::set_database_path(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    database_path_ = path;
+    if (!path.empty()) {
+        load_locked(path);
+    }
+}
+
+std::string ConvAlgorithmCache::get_database_path() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return database_path_;
+}
+
+void ConvAlgorithmCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t ConvAlgorithmCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
 // ConvKernel implementation
 ConvKernel::ConvKernel(std::shared_ptr<DeviceContext> context)
     : context_(context), miopen_handle_(nullptr) {
@@ -132,17 +844,35 @@ ConvKernel::ConvKernel(std::shared_ptr<DeviceContext> context)
 
 ConvKernel::~ConvKernel() {
     if (miopen_handle_) {
-        // miopenDestroy(miopen_handle_);
+        miopenStatus_t status = miopenDestroy(static_cast<miopenHandle_t>(miopen_handle_));
+        if (status != miopenStatusSuccess) {
+            std::cerr << "Warning: Failed to destroy MIOpen handle: " << miopenGetErrorString(status) << std::endl;
+        }
     }
 }
 
 bool ConvKernel::initialize() {
-    // TODO: Initialize MIOpen handle
-    // miopenStatus_t status = miopenCreate(&miopen_handle_);
-    // if (status != miopenStatusSuccess) {
-    //     return false;
-    // }
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    if (initialized_) {
+        return true;
+    }
+    
+    // Like rocBLAS, MIOpen binds a handle to the current device
+    int previous_device = 0;
+    hipGetDevice(&previous_device);
+    if (hipSetDevice(context_->get_device_id()) != hipSuccess) {
+        return false;
+    }
     
+    miopenHandle_t handle = nullptr;
+    miopenStatus_t status = miopenCreate(&handle);
+    hipSetDevice(previous_device);
+    if (status != miopenStatusSuccess) {
+        return false;
+    }
+    
+    miopen_handle_ = handle;
+    arch_ = context_->get_properties().arch;
     initialized_ = true;
     return true;
 }
@@ -159,16 +889,48 @@ bool ConvKernel::conv2d_forward(const TensorDesc& input, const void* input_data,
                                 const TensorDesc& filter, const void* filter_data,
                                 const TensorDesc& output, void* output_data,
                                 const ConvConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "conv2d_forward", context_->get_device_id(), stream,
+                             input.get_size() + filter.get_size() + output.get_size());
     if (!initialized_) {
         throw std::runtime_error("ConvKernel not initialized");
     }
     
-    // TODO: Implement convolution using MIOpen
-    std::cout << "Conv2D forward: input " << input.shape[0] << "x" << input.shape[1] 
-              << "x" << input.shape[2] << "x" << input.shape[3] 
-              << ", filter " << filter.shape[0] << "x" << filter.shape[1] 
-              << "x" << filter.shape[2] << "x" << filter.shape[3] << std::endl;
+    MiopenTensor x(input), w(filter), y(output);
+    MiopenConvolution conv(config);
+    if (!x.is_valid() || !w.is_valid() || !y.is_valid() || !conv.is_valid()) {
+        return false;
+    }
     
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    miopenHandle_t handle = static_cast<miopenHandle_t>(miopen_handle_);
+    if (miopenSetStream(handle, static_cast<hipStream_t>(stream)) != miopenStatusSuccess) {
+        return false;
+    }
+    miopenConvFwdAlgorithm_t algorithm = miopenConvolutionFwdAlgoGEMM;
+    Workspace workspace;
+    if (!prepare_conv_algorithm(
+            make_cache_key("fwd", input, filter, output, config), config.benchmark, context_->get_device_id(), stream,
+            &miopenConvAlgoPerf_t::fwd_algo,
+            [&](size_t* size) {
+                return miopenConvolutionForwardGetWorkSpaceSize(handle, w.get(), x.get(), conv.get(), y.get(), size);
+            },
+            [&](void* search, size_t search_size, bool exhaustive, miopenConvAlgoPerf_t* perf, int* returned) {
+                return miopenFindConvolutionForwardAlgorithm(handle, x.get(), input_data, w.get(), filter_data, conv.get(),
+                                                             y.get(), output_data, 1, returned, perf,
+                                                             search, search_size, exhaustive);
+            },
+            algorithm, workspace)) {
+        return false;
+    }
+    const float alpha = 1.0f, beta = 0.0f;
+    miopenStatus_t status = miopenConvolutionForward(handle, &alpha, x.get(), input_data, w.get(), filter_data,
+                                                     conv.get(), algorithm,
+                                                     &beta, y.get(), output_data, workspace.data(), workspace.size());
+    if (status != miopenStatusSuccess) {
+        std::cerr << "Warning: MIOpen convolution forward failed: " << miopenGetErrorString(status) << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -176,13 +938,49 @@ bool ConvKernel::conv2d_backward_data(const TensorDesc& filter, const void* filt
                                       const TensorDesc& output_grad, const void* output_grad_data,
                                       const TensorDesc& input_grad, void* input_grad_data,
                                       const ConvConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "conv2d_backward_data", context_->get_device_id(), stream,
+                             filter.get_size() + output_grad.get_size() + input_grad.get_size());
     if (!initialized_) {
         throw std::runtime_error("ConvKernel not initialized");
     }
     
-    // TODO: Implement convolution backward data
-    std::cout << "Conv2D backward data" << std::endl;
+    MiopenTensor w(filter), dy(output_grad), dx(input_grad);
+    MiopenConvolution conv(config);
+    if (!w.is_valid() || !dy.is_valid() || !dx.is_valid() || !conv.is_valid()) {
+        return false;
+    }
     
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    miopenHandle_t handle = static_cast<miopenHandle_t>(miopen_handle_);
+    if (miopenSetStream(handle, static_cast<hipStream_t>(stream)) != miopenStatusSuccess) {
+        return false;
+    }
+    miopenConvBwdDataAlgorithm_t algorithm = miopenConvolutionBwdDataAlgoGEMM;
+    Workspace workspace;
+    if (!prepare_conv_algorithm(
+            make_cache_key("bwd_data", input_grad, filter, output_grad, config), config.benchmark,
+            context_->get_device_id(), stream, &miopenConvAlgoPerf_t::bwd_data_algo,
+            [&](size_t* size) {
+                return miopenConvolutionBackwardDataGetWorkSpaceSize(handle, dy.get(), w.get(), conv.get(), dx.get(), size);
+            },
+            [&](void* search, size_t search_size, bool exhaustive, miopenConvAlgoPerf_t* perf, int* returned) {
+                return miopenFindConvolutionBackwardDataAlgorithm(handle, dy.get(), output_grad_data, w.get(), filter_data,
+                                                                  conv.get(), dx.get(), input_grad_data, 1, returned, perf,
+                                                                  search, search_size, exhaustive);
+            },
+            algorithm, workspace)) {
+        return false;
+    }
+    const float alpha = 1.0f, beta = 0.0f;
+    miopenStatus_t status = miopenConvolutionBackwardData(handle, &alpha, dy.get(), output_grad_data, w.get(), filter_data,
+                                                          conv.get(), algorithm,
+                                                          &beta, dx.get(), input_grad_data,
+                                                          workspace.data(), workspace.size());
+    if (status != miopenStatusSuccess) {
+        std::cerr << "Warning: MIOpen convolution backward data failed: " << miopenGetErrorString(status) << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -190,13 +988,49 @@ bool ConvKernel::conv2d_backward_filter(const TensorDesc& input, const void* inp
                                         const TensorDesc& output_grad, const void* output_grad_data,
                                         const TensorDesc& filter_grad, void* filter_grad_data,
                                         const ConvConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "conv2d_backward_filter", context_->get_device_id(), stream,
+                             input.get_size() + output_grad.get_size() + filter_grad.get_size());
     if (!initialized_) {
         throw std::runtime_error("ConvKernel not initialized");
     }
     
-    // TODO: Implement convolution backward filter
-    std::cout << "Conv2D backward filter" << std::endl;
+    MiopenTensor x(input), dy(output_grad), dw(filter_grad);
+    MiopenConvolution conv(config);
+    if (!x.is_valid() || !dy.is_valid() || !dw.is_valid() || !conv.is_valid()) {
+        return false;
+    }
     
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    miopenHandle_t handle = static_cast<miopenHandle_t>(miopen_handle_);
+    if (miopenSetStream(handle, static_cast<hipStream_t>(stream)) != miopenStatusSuccess) {
+        return false;
+    }
+    miopenConvBwdWeightsAlgorithm_t algorithm = miopenConvolutionBwdWeightsAlgoGEMM;
+    Workspace workspace;
+    if (!prepare_conv_algorithm(
+            make_cache_key("bwd_weights", input, filter_grad, output_grad, config), config.benchmark,
+            context_->get_device_id(), stream, &miopenConvAlgoPerf_t::bwd_weights_algo,
+            [&](size_t* size) {
+                return miopenConvolutionBackwardWeightsGetWorkSpaceSize(handle, dy.get(), x.get(), conv.get(), dw.get(), size);
+            },
+            [&](void* search, size_t search_size, bool exhaustive, miopenConvAlgoPerf_t* perf, int* returned) {
+                return miopenFindConvolutionBackwardWeightsAlgorithm(handle, dy.get(), output_grad_data, x.get(), input_data,
+                                                                     conv.get(), dw.get(), filter_grad_data, 1, returned, perf,
+                                                                     search, search_size, exhaustive);
+            },
+            algorithm, workspace)) {
+        return false;
+    }
+    const float alpha = 1.0f, beta = 0.0f;
+    miopenStatus_t status = miopenConvolutionBackwardWeights(handle, &alpha, dy.get(), output_grad_data, x.get(), input_data,
+                                                             conv.get(), algorithm,
+                                                             &beta, dw.get(), filter_grad_data,
+                                                             workspace.data(), workspace.size());
+    if (status != miopenStatusSuccess) {
+        std::cerr << "Warning: MIOpen convolution backward filter failed: " << miopenGetErrorString(status) << std::endl;
+        return false;
+    }
     return true;
 }
 
@@ -204,8 +1038,53 @@ std::string ConvKernel::find_best_algorithm(const TensorDesc& input,
                                            const TensorDesc& filter,
                                            const TensorDesc& output,
                                            const ConvConfig& config) {
-    // TODO: Implement algorithm selection
-    return "DEFAULT_ALGORITHM";
+    if (!initialized_) {
+        throw std::runtime_error("ConvKernel not initialized");
+    }
+    
+    int algorithm = 0;
+    size_t workspace_size = 0;
+    std::string key = make_cache_key("fwd", input, filter, output, config);
+    ConvAlgorithmCache& cache = ConvAlgorithmCache::get_instance();
+    if (!cache.lookup(key, config.benchmark, algorithm, workspace_size)) {
+        // MIOpen's find runs the convolution, so it needs real scratch tensors
+        const int device_id = context_->get_device_id();
+        DeviceBuffer x(storage_size(input), device_id, nullptr);
+        DeviceBuffer w(storage_size(filter), device_id, nullptr);
+        DeviceBuffer y(storage_size(output), device_id, nullptr);
+        if (!x.is_valid() || !w.is_valid() || !y.is_valid() ||
+            !conv2d_forward(input, x.get(), filter, w.get(), output, y.get(), config, nullptr) ||
+            !cache.lookup(key, config.benchmark, algorithm, workspace_size)) {
+            return "UNKNOWN_ALGORITHM";
+        }
+    }
+    return forward_algorithm_name(algorithm);
+}
+
+std::string ConvKernel::make_cache_key(const char* direction,
+                                       const TensorDesc& x, const TensorDesc& w, const TensorDesc& y,
+                                       const ConvConfig& config) const {
+    // Whitespace-free so keys can be stored one per line in the find-db
+    std::ostringstream key;
+    auto append_dims = [&key](const char* tag, const auto& values) {
+        key << ';' << tag;
+        for (size_t i = 0; i < values.size(); ++i) {
+            key << (i ? "x" : "") << values[i];
+        }
+    };
+    
+    key << direction << ';' << arch_ << ";t" << x.data_type << '-' << w.data_type << '-' << y.data_type;
+    append_dims("x", x.shape);
+    append_dims("xs", x.strides);
+    append_dims("w", w.shape);
+    append_dims("ws", w.strides);
+    append_dims("y", y.shape);
+    append_dims("ys", y.strides);
+    append_dims("p", config.padding);
+    append_dims("u", config.stride);
+    append_dims("d", config.dilation);
+    key << ";g" << config.groups;
+    return key.str();
 }
 
 // CustomKernels implementation
@@ -215,11 +1094,17 @@ CustomKernels::CustomKernels(std::shared_ptr<DeviceContext> context)
 }
 
 CustomKernels::~CustomKernels() {
-    // TODO: Clean up compiled kernels
+    for (void* module : compiled_kernels_) {
+        hipError_t result = hipModuleUnload(static_cast<hipModule_t>(module));
+        if (result != hipSuccess) {
+            std::cerr << "Warning: Failed to unload fused kernel module: " << hipGetErrorString(result) << std::endl;
+        }
+    }
 }
 
 bool CustomKernels::initialize() {
-    // TODO: Compile custom HIP kernels
+    // The kernels are built ahead of time from the .hip sources; fused
+    // chains compile on first use in fusion.cpp
     initialized_ = true;
     return true;
 }
@@ -235,92 +1120,286 @@ std::string CustomKernels::get_name() const {
 bool CustomKernels::add(const TensorDesc& a, const void* a_data,
                         const TensorDesc& b, const void* b_data,
                         const TensorDesc& c, void* c_data, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "add", context_->get_device_id(), stream,
+                             a.get_size() + b.get_size() + c.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement element-wise addition
-    std::cout << "Element-wise addition" << std::endl;
-    
-    return true;
+    return launch_elementwise(ElementwiseOp::Add, a, a_data, &b, b_data, c, c_data, stream);
 }
 
 bool CustomKernels::multiply(const TensorDesc& a, const void* a_data,
                             const TensorDesc& b, const void* b_data,
                             const TensorDesc& c, void* c_data, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "multiply", context_->get_device_id(), stream,
+                             a.get_size() + b.get_size() + c.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement element-wise multiplication
-    std::cout << "Element-wise multiplication" << std::endl;
-    
-    return true;
+    return launch_elementwise(ElementwiseOp::Multiply, a, a_data, &b, b_data, c, c_data, stream);
 }
 
 bool CustomKernels::relu(const TensorDesc& input, const void* input_data,
                         const TensorDesc& output, void* output_data, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "relu", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement ReLU activation
-    std::cout << "ReLU activation" << std::endl;
-    
-    return true;
+    return launch_elementwise(ElementwiseOp::Relu, input, input_data, nullptr, nullptr,
+                              output, output_data, stream);
 }
 
 bool CustomKernels::gelu(const TensorDesc& input, const void* input_data,
                        const TensorDesc& output, void* output_data, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "gelu", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement GELU activation
-    std::cout << "GELU activation" << std::endl;
+    return launch_elementwise(ElementwiseOp::Gelu, input, input_data, nullptr, nullptr,
+                              output, output_data, stream);
+}
+
+bool CustomKernels::fused_elementwise(const std::vector<TensorDesc>& inputs,
+                                      const std::vector<const void*>& input_data,
+                                      const std::vector<FusedOp>& ops,
+                                      const TensorDesc& output, void* output_data,
+                                      void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "fused_elementwise", context_->get_device_id(), stream,
+                             fused_traffic(inputs, output));
+    if (!initialized_) {
+        throw std::runtime_error("CustomKernels not initialized");
+    }
     
-    return true;
+    FusionPlan plan = plan_fused_elementwise(inputs, input_data, ops, output, output_data);
+    if (plan.params.n == 0) {
+        return true;
+    }
+    
+    void* function = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(fused_mutex_);
+        auto it = fused_functions_.find(plan.signature);
+        if (it != fused_functions_.end()) {
+            function = it->second;
+        }
+    }
+    if (!function) {
+        function = get_fused_function(plan.signature, generate_fused_source(plan));
+        if (!function) {
+            return false;
+        }
+    }
+    return launch_fused_kernel(function, plan, stream);
+}
+
+size_t CustomKernels::get_fused_kernel_count() const {
+    std::lock_guard<std::mutex> lock(fused_mutex_);
+    return fused_functions_.size();
+}
+
+void* CustomKernels::get_fused_function(const std::string& signature, const std::string& source) {
+    std::lock_guard<std::mutex> lock(fused_mutex_);
+    auto it = fused_functions_.find(signature);
+    if (it != fused_functions_.end()) {
+        return it->second;  // Compiled by another thread meanwhile
+    }
+    
+    // Modules load into the current device
+    int previous_device = 0;
+    hipGetDevice(&previous_device);
+    if (hipSetDevice(context_->get_device_id()) != hipSuccess) {
+        return nullptr;
+    }
+    void* module = nullptr;
+    void* function = nullptr;
+    bool compiled = compile_fused_kernel(source, context_->get_properties().arch, module, function);
+    hipSetDevice(previous_device);
+    if (!compiled) {
+        return nullptr;
+    }
+    
+    compiled_kernels_.push_back(module);
+    fused_functions_[signature] = function;
+    return function;
 }
 
 bool CustomKernels::softmax(const TensorDesc& input, const void* input_data,
                            const TensorDesc& output, void* output_data,
                            int dim, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "softmax", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement softmax
-    std::cout << "Softmax along dimension " << dim << std::endl;
+    return launch_softmax(input, input_data, output, output_data, dim,
+                          context_->get_properties().wavefront_size, stream);
+}
+
+bool CustomKernels::layer_norm(const TensorDesc& input, const void* input_data,
+                               const void* weight, const void* bias,
+                               const TensorDesc& output, void* output_data,
+                               float epsilon, float* mean, float* rstd, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "layer_norm", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
+    if (!initialized_) {
+        throw std::runtime_error("CustomKernels not initialized");
+    }
     
-    return true;
+    return launch_norm(input, input_data, weight, bias, output, output_data, mean, rstd,
+                       epsilon, false, context_->get_properties().wavefront_size, stream);
+}
+
+bool CustomKernels::layer_norm_backward(const TensorDesc& grad_output, const void* grad_output_data,
+                                        const TensorDesc& input, const void* input_data,
+                                        const float* mean, const float* rstd, const void* weight,
+                                        void* grad_input_data, void* grad_weight, void* grad_bias,
+                                        void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "layer_norm_backward", context_->get_device_id(), stream,
+                             grad_output.get_size() + 2 * input.get_size());
+    if (!initialized_) {
+        throw std::runtime_error("CustomKernels not initialized");
+    }
+    
+    return launch_norm_backward(grad_output, grad_output_data, input, input_data, mean, rstd, weight,
+                                grad_input_data, grad_weight, grad_bias, false,
+                                context_->get_properties().wavefront_size, context_->get_device_id(), stream);
+}
+
+bool CustomKernels::rms_norm(const TensorDesc& input, const void* input_data, const void* weight,
+                             const TensorDesc& output, void* output_data,
+                             float epsilon, float* rstd, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "rms_norm", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
+    if (!initialized_) {
+        throw std::runtime_error("CustomKernels not initialized");
+    }
+    
+    return launch_norm(input, input_data, weight, nullptr, output, output_data, nullptr, rstd,
+                       epsilon, true, context_->get_properties().wavefront_size, stream);
+}
+
+bool CustomKernels::rms_norm_backward(const TensorDesc& grad_output, const void* grad_output_data,
+                                      const TensorDesc& input, const void* input_data,
+                                      const float* rstd, const void* weight,
+                                      void* grad_input_data, void* grad_weight, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "rms_norm_backward", context_->get_device_id(), stream,
+                             grad_output.get_size() + 2 * input.get_size());
+    if (!initialized_) {
+        throw std::runtime_error("CustomKernels not initialized");
+    }
+    
+    return launch_norm_backward(grad_output, grad_output_data, input, input_data, nullptr, rstd, weight,
+                                grad_input_data, grad_weight, nullptr, true,
+                                context_->get_properties().wavefront_size, context_->get_device_id(), stream);
 }
 
 bool CustomKernels::sum(const TensorDesc& input, const void* input_data,
                        const TensorDesc& output, void* output_data,
                        const std::vector<int>& dims, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "sum", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement sum reduction
-    std::cout << "Sum reduction" << std::endl;
-    
-    return true;
+    DeviceProperties properties = context_->get_properties();
+    return launch_reduction(ReduceOp::Sum, input, input_data, output, output_data, dims,
+                            KernelManager::get_instance().is_deterministic(), properties.wavefront_size,
+                            properties.compute_units, context_->get_device_id(), stream);
 }
 
 bool CustomKernels::mean(const TensorDesc& input, const void* input_data,
                         const TensorDesc& output, void* output_data,
                         const std::vector<int>& dims, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "mean", context_->get_device_id(), stream,
+                             input.get_size() + output.get_size());
     if (!initialized_) {
         throw std::runtime_error("CustomKernels not initialized");
     }
     
-    // TODO: Implement mean reduction
-    std::cout << "Mean reduction" << std::endl;
-    
+    DeviceProperties properties = context_->get_properties();
+    return launch_reduction(ReduceOp::Mean, input, input_data, output, output_data, dims,
+                            KernelManager::get_instance().is_deterministic(), properties.wavefront_size,
+                            properties.compute_units, context_->get_device_id(), stream);
+}
+
+// AttentionKernel implementation
+AttentionKernel::AttentionKernel(std::shared_ptr<DeviceContext> context)
+    : context_(context) {
+    initialized_ = false;
+}
+
+AttentionKernel::~AttentionKernel() = default;
+
+bool AttentionKernel::initialize() {
+    // Tile sizes and wave width are picked per launch from these
+    properties_ = context_->get_properties();
+    initialized_ = true;
     return true;
 }
 
+bool AttentionKernel::is_initialized() const {
+    return initialized_;
+}
+
+std::string AttentionKernel::get_name() const {
+    return "AttentionKernel";
+}
+
+bool AttentionKernel::forward(const TensorDesc& q, const void* q_data,
+                              const TensorDesc& k, const void* k_data,
+                              const TensorDesc& v, const void* v_data,
+                              const TensorDesc& output, void* output_data,
+                              const AttentionConfig& config, float* logsumexp, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "attention_forward", context_->get_device_id(), stream,
+                             q.get_size() + k.get_size() + v.get_size() + output.get_size());
+    if (!initialized_) {
+        throw std::runtime_error("AttentionKernel not initialized");
+    }
+    
+    return launch_attention_forward(q, q_data, k, k_data, v, v_data, output, output_data,
+                                    logsumexp, config, properties_, stream);
+}
+
+bool AttentionKernel::backward(const TensorDesc& q, const void* q_data,
+                               const TensorDesc& k, const void* k_data,
+                               const TensorDesc& v, const void* v_data,
+                               const TensorDesc& output, const void* output_data,
+                               const void* grad_output_data, const float* logsumexp,
+                               void* grad_q_data, void* grad_k_data, void* grad_v_data,
+                               const AttentionConfig& config, void* stream) {
+    stream = resolve_stream(context_->get_device_id(), stream);
+    ScopedDeviceEvent timing(EventType::KERNEL_LAUNCH, "attention_backward", context_->get_device_id(), stream,
+                             2 * (q.get_size() + k.get_size() + v.get_size()) + 2 * output.get_size());
+    if (!initialized_) {
+        throw std::runtime_error("AttentionKernel not initialized");
+    }
+    
+    return launch_attention_backward(q, q_data, k, k_data, v, v_data, output, output_data,
+                                     grad_output_data, logsumexp, grad_q_data, grad_k_data, grad_v_data,
+                                     config, properties_, stream);
+}
+
 // KernelManager implementation
 KernelManager& KernelManager::get_instance() {
     static KernelManager instance;
@@ -331,14 +1410,12 @@ std::shared_ptr<MatmulKernel> KernelManager::get_matmul_kernel(int device_id) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (device_id == -1) {
-        // Get current device
-        // TODO: Implement device context management
-        device_id = 0;
+        device_id = DeviceManager::get_instance().get_current_device();
     }
     
     auto& device_kernels = kernels_[device_id];
     if (!device_kernels.matmul) {
-        auto context = std::make_shared<DeviceContext>(device_id);
+        auto context = DeviceManager::get_instance().get_context(device_id);
         device_kernels.matmul = std::make_shared<MatmulKernel>(context);
     }
     
@@ -349,12 +1426,12 @@ std::shared_ptr<ConvKernel> KernelManager::get_conv_kernel(int device_id) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (device_id == -1) {
-        device_id = 0;
+        device_id = DeviceManager::get_instance().get_current_device();
     }
     
     auto& device_kernels = kernels_[device_id];
     if (!device_kernels.conv) {
-        auto context = std::make_shared<DeviceContext>(device_id);
+        auto context = DeviceManager::get_instance().get_context(device_id);
         device_kernels.conv = std::make_shared<ConvKernel>(context);
     }
     
@@ -365,27 +1442,48 @@ std::shared_ptr<CustomKernels> KernelManager::get_custom_kernels(int device_id)
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (device_id == -1) {
-        device_id = 0;
+        device_id = DeviceManager::get_instance().get_current_device();
     }
     
     auto& device_kernels = kernels_[device_id];
     if (!device_kernels.custom) {
-        auto context = std::make_shared<DeviceContext>(device_id);
+        auto context = DeviceManager::get_instance().get_context(device_id);
         device_kernels.custom = std::make_shared<CustomKernels>(context);
     }
     
     return device_kernels.custom;
 }
 
+std::shared_ptr<AttentionKernel> KernelManager::get_attention_kernel(int device_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (device_id == -1) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    
+    auto& device_kernels = kernels_[device_id];
+    if (!device_kernels.attention) {
+        auto context = DeviceManager::get_instance().get_context(device_id);
+        device_kernels.attention = std::make_shared<AttentionKernel>(context);
+    }
+    
+    return device_kernels.attention;
+}
+
 bool KernelManager::initialize_kernels(int device_id) {
+    if (device_id == -1) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
     auto matmul = get_matmul_kernel(device_id);
     auto conv = get_conv_kernel(device_id);
     auto custom = get_custom_kernels(device_id);
+    auto attention = get_attention_kernel(device_id);
     
     bool success = true;
     success &= matmul->initialize();
     success &= conv->initialize();
     success &= custom->initialize();
+    success &= attention->initialize();
     
     kernels_[device_id].initialized = success;
     return success;
@@ -399,6 +1497,14 @@ bool KernelManager::are_kernels_initialized(int device_id) const {
     return it->second.initialized;
 }
 
+void KernelManager::set_deterministic(bool enabled) {
+    deterministic_ = enabled;
+}
+
+bool KernelManager::is_deterministic() const {
+    return deterministic_;
+}
+
 bool KernelManager::dispatch_matmul(const TensorDesc& a, const void* a_data,
                                   const TensorDesc& b, const void* b_data,
                                   const TensorDesc& c, void* c_data,
@@ -415,29 +1521,192 @@ bool KernelManager::dispatch_conv2d(const TensorDesc& input, const void* input_d
     return kernel->conv2d_forward(input, input_data, filter, filter_data, output, output_data, config, stream);
 }
 
+bool KernelManager::dispatch_attention(const TensorDesc& q, const void* q_data,
+                                       const TensorDesc& k, const void* k_data,
+                                       const TensorDesc& v, const void* v_data,
+                                       const TensorDesc& output, void* output_data,
+                                       const AttentionConfig& config, float* logsumexp,
+                                       int device_id, void* stream) {
+    auto kernel = get_attention_kernel(device_id);
+    return kernel->forward(q, q_data, k, k_data, v, v_data, output, output_data, config, logsumexp, stream);
+}
+
 // Utility functions
+namespace {
+
+// Per-target launch preferences. RDNA reports workgroup processors (two
+// CUs sharing LDS) as compute units, so it wants more resident blocks per
+// reported unit than CDNA does.
+struct ArchLaunchTraits {
+    const char* arch;
+    size_t threads;          // Preferred workgroup size
+    size_t max_tile_m;       // Largest output tile, rows
+    size_t max_tile_n;       // Largest output tile, columns
+    size_t blocks_per_cu;    // Resident blocks needed to hide latency
+};
+
+const ArchLaunchTraits kArchLaunchTraits[] = {
+    {"gfx1030", 256, 128, 64, 4},
+    {"gfx1100", 256, 128, 128, 4},
+    {"gfx90a", 256, 128, 128, 2},
+    {"gfx942", 256, 256, 128, 2},
+};
+
+const ArchLaunchTraits kDefaultLaunchTraits = {"", 256, 64, 64, 2};
+
+const ArchLaunchTraits& launch_traits(const std::string& arch) {
+    // Targets may carry feature suffixes, e.g. gfx90a:sramecc+:xnack-
+    std::string base = arch.substr(0, arch.find(':'));
+    for (const ArchLaunchTraits& traits : kArchLaunchTraits) {
+        if (base == traits.arch) {
+            return traits;
+        }
+    }
+    return kDefaultLaunchTraits;
+}
+
+DeviceProperties current_device_properties() {
+    return DeviceManager::get_instance().get_context(-1)->get_properties();
+}
+
+/**
+ * Tiles an m x n output over blocks for a k-deep reduction, batch times.
+ * Candidates run from the largest tile down; the first one that fits its
+ * double-buffered A and B slabs in LDS and yields enough blocks to keep
+ * blocks_per_cu resident on every CU wins. If none does, the largest tile
+ * reaching the best achievable block count is used. grid.x walks column
+ * tiles, grid.y row tiles and grid.z the batch.
+ */
+KernelConfig tile_gemm_launch(size_t m, size_t n, size_t k, size_t batch,
+                              int data_type, const DeviceProperties& properties) {
+    static const size_t kTiles[][2] = {
+        {256, 128}, {128, 128}, {128, 64}, {64, 64}, {64, 32}, {32, 32}
+    };
+    const ArchLaunchTraits& traits = launch_traits(properties.arch);
+    const size_t element_size = get_data_type_size(data_type);
+    const size_t tile_k = std::min<size_t>(element_size == 4 ? 16 : 32, std::max<size_t>(k, 1));
+    const size_t compute_units = std::max(properties.compute_units, 1);
+    const size_t target_blocks = compute_units * traits.blocks_per_cu;
+    const size_t lds_limit = properties.shared_memory_per_block ? properties.shared_memory_per_block : 64 * 1024;
+    batch = std::max<size_t>(batch, 1);
+    
+    size_t tile_m = 32, tile_n = 32, best_score = 0;
+    for (const auto& tile : kTiles) {
+        if (tile[0] > traits.max_tile_m || tile[1] > traits.max_tile_n) {
+            continue;
+        }
+        if (2 * (tile[0] + tile[1]) * tile_k * element_size > lds_limit) {
+            continue;
+        }
+        size_t blocks = (m + tile[0] - 1) / tile[0] * ((n + tile[1] - 1) / tile[1]) * batch;
+        size_t score = std::min(blocks, target_blocks);
+        if (score > best_score) {
+            tile_m = tile[0];
+            tile_n = tile[1];
+            best_score = score;
+        }
+        if (score >= target_blocks) {
+            break;
+        }
+    }
+    
+    // Whole waves, at least four outputs per thread
+    const size_t wave = std::max(properties.wavefront_size, 1);
+    size_t threads = std::min(traits.threads, tile_m * tile_n / 4);
+    if (properties.max_workgroup_size > 0) {
+        threads = std::min<size_t>(threads, properties.max_workgroup_size);
+    }
+    threads = std::max(threads / wave, size_t(1)) * wave;
+    
+    KernelConfig config((n + tile_n - 1) / tile_n, (m + tile_m - 1) / tile_m, batch,
+                        wave, threads / wave, 1);
+    config.shared_memory_size = 2 * (tile_m + tile_n) * tile_k * element_size;
+    return config;
+}
+
+// Shapes repeat call after call, so configs are computed once per key
+KernelConfig cached_launch(const std::string& key, const std::function<KernelConfig()>& compute) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, KernelConfig> cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+    KernelConfig config = compute();
+    std::lock_guard<std::mutex> lock(mutex);
+    return cache.emplace(key, config).first->second;
+}
+
+std::string launch_key(const char* op, const std::vector<std::vector<size_t>>& shapes, int data_type,
+                       const DeviceProperties& properties) {
+    std::ostringstream key;
+    key << op;
+    for (const auto& shape : shapes) {
+        key << '|';
+        for (size_t extent : shape) {
+            key << extent << 'x';
+        }
+    }
+    key << "|dt" << data_type << '|' << properties.arch << '|' << properties.compute_units << '|'
+        << properties.wavefront_size << '|' << properties.max_workgroup_size << '|'
+        << properties.shared_memory_per_block;
+    return key.str();
+}
+
+} // namespace
+
+KernelConfig calculate_matmul_kernel_config(const TensorDesc& a, const TensorDesc& b,
+                                            const DeviceProperties& properties) {
+    if (a.shape.size() < 2 || b.shape.size() < 2) {
+        throw std::invalid_argument("calculate_matmul_kernel_config: operands must have rank 2 or 3");
+    }
+    return cached_launch(launch_key("matmul", {a.shape, b.shape}, a.data_type, properties), [&]() {
+        size_t m = a.shape[a.shape.size() - 2];
+        size_t k = a.shape.back();
+        size_t n = b.shape.back();
+        size_t batch = a.shape.size() == 3 ? std::max(a.shape[0], b.shape.size() == 3 ? b.shape[0] : 1) : 1;
+        return tile_gemm_launch(m, n, k, batch, a.data_type, properties);
+    });
+}
+
 KernelConfig calculate_matmul_kernel_config(const TensorDesc& a, const TensorDesc& b) {
-    // Simple kernel configuration calculation
-    // TODO: Implement proper kernel configuration based on RDNA architecture
-    size_t block_x = 16;
-    size_t block_y = 16;
-    size_t grid_x = (a.shape[0] + block_x - 1) / block_x;
-    size_t grid_y = (b.shape[1] + block_y - 1) / block_y;
-    
-    return KernelConfig(grid_x, grid_y, 1, block_x, block_y, 1);
-}
-
-KernelConfig calculate_conv_kernel_config(const TensorDesc& input, const TensorDesc& filter) {
-    // Simple kernel configuration calculation
-    // TODO: Implement proper kernel configuration for convolution
-    size_t block_x = 8;
-    size_t block_y = 8;
-    size_t block_z = 4;
-    size_t grid_x = (input.shape[0] + block_x - 1) / block_x;
-    size_t grid_y = (input.shape[1] + block_y - 1) / block_y;
-    size_t grid_z = (filter.shape[0] + block_z - 1) / block_z;
-    
-    return KernelConfig(grid_x, grid_y, grid_z, block_x, block_y, block_z);
+    return calculate_matmul_kernel_config(a, b, current_device_properties());
+}
+
+KernelConfig calculate_conv_kernel_config(const TensorDesc& input, const TensorDesc& filter,
+                                          const ConvConfig& config, const DeviceProperties& properties) {
+    if (input.shape.size() != 4 || filter.shape.size() != 4) {
+        throw std::invalid_argument("calculate_conv_kernel_config: expected NCHW input and KCRS filter");
+    }
+    std::vector<size_t> params;
+    for (const auto* values : {&config.padding, &config.stride, &config.dilation}) {
+        params.insert(params.end(), values->begin(), values->end());
+    }
+    params.push_back(config.groups);
+    return cached_launch(launch_key("conv", {input.shape, filter.shape, params}, input.data_type, properties), [&]() {
+        // Implicit GEMM: output pixels by filters, reducing over C*R*S
+        auto at = [](const std::vector<int>& values, size_t i, int fallback) {
+            return i < values.size() ? values[i] : fallback;
+        };
+        size_t out_extent[2];
+        for (size_t i = 0; i < 2; ++i) {
+            long padded = static_cast<long>(input.shape[2 + i]) + 2 * at(config.padding, i, 0);
+            long span = static_cast<long>(at(config.dilation, i, 1)) * (static_cast<long>(filter.shape[2 + i]) - 1) + 1;
+            long stride = std::max(at(config.stride, i, 1), 1);
+            out_extent[i] = padded >= span ? static_cast<size_t>((padded - span) / stride + 1) : 0;
+        }
+        size_t reduce = filter.shape[1] * filter.shape[2] * filter.shape[3];
+        return tile_gemm_launch(out_extent[0] * out_extent[1], filter.shape[0], reduce, input.shape[0],
+                                input.data_type, properties);
+    });
+}
+
+KernelConfig calculate_conv_kernel_config(const TensorDesc& input, const TensorDesc& filter,
+                                          const ConvConfig& config) {
+    return calculate_conv_kernel_config(input, filter, config, current_device_properties());
 }
 
 size_t get_data_type_size(int data_type) {
@@ -1,63 +1,228 @@
 #include "rdna/memory.h"
+#include "rdna/device.h"
+#include "rdna/profiler.h"
 #include <hip/hip_runtime.h>
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
+#include <unordered_set>
 
 namespace rdna {
 
+namespace {
+
+std::atomic<uint64_t> next_allocator_id{1};
+
+uint64_t trace_timestamp_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void write_json_string(std::ostream& out, const char* value) {
+    if (!value) {
+        out << "null";
+        return;
+    }
+    out << '"';
+    for (const char* c = value; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            out << ' ';
+        } else {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+// Records a completion event behind the work just queued on stream, or
+// returns nullptr, matching the async copy APIs' error contract
+std::shared_ptr<Event> record_completion_event(Stream& stream) {
+    auto event = std::make_shared<Event>(stream.get_context(), false);
+    if (!event->initialize()) {
+        return nullptr;
+    }
+    hipError_t result = hipEventRecord(static_cast<hipEvent_t>(event->get_native_handle()),
+                                       static_cast<hipStream_t>(stream.get_native_handle()));
+    if (result != hipSuccess) {
+        return nullptr;
+    }
+    return event;
+}
+
+std::shared_ptr<Event> enqueue_memcpy(void* dst, const void* src, size_t size, Stream& stream) {
+    ScopedDeviceEvent timing(EventType::MEMORY_COPY, "memcpy_async", stream.get_context()->get_device_id(),
+                             stream.get_native_handle(), size);
+    hipError_t result = hipMemcpyAsync(dst, src, size, hipMemcpyDefault,
+                                       static_cast<hipStream_t>(stream.get_native_handle()));
+    if (result != hipSuccess) {
+        return nullptr;
+    }
+    return record_completion_event(stream);
+}
+
+std::shared_ptr<Event> enqueue_memset(void* ptr, int value, size_t size, Stream& stream) {
+    ScopedDeviceEvent timing(EventType::MEMORY_SET, "memset_async", stream.get_context()->get_device_id(),
+                             stream.get_native_handle(), size);
+    hipError_t result = hipMemsetAsync(ptr, value, size,
+                                       static_cast<hipStream_t>(stream.get_native_handle()));
+    if (result != hipSuccess) {
+        return nullptr;
+    }
+    return record_completion_event(stream);
+}
+
+} // namespace
+
 // MemoryAllocator implementation
 MemoryAllocator::MemoryAllocator(std::shared_ptr<DeviceContext> context)
-    : context_(context), cache_size_limit_(1024 * 1024 * 1024), // 1GB default limit
+    : context_(context), small_pool_(true), large_pool_(false),
+      allocator_id_(next_allocator_id.fetch_add(1, std::memory_order_relaxed)),
+      trace_(std::make_unique<TraceSlot[]>(kTraceCapacity)), trace_head_(0), trace_enabled_(true),
+      expandable_segments_(false), expandable_page_size_(0),
+      workspace_limit_(256 * 1024 * 1024), workspace_bytes_(0), workspace_high_water_mark_(0),
+      captures_underway_(0), next_pool_id_(1),
+      cache_size_limit_(1024 * 1024 * 1024), // 1GB default limit
       allocation_counter_(0) {
-    stats_ = {0, 0, 0, 0, 0, 0, 0};
+    stats_ = MemoryStats{};
 }
 
 MemoryAllocator::~MemoryAllocator() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    // Free all blocks
-    for (auto& block : blocks_) {
-        if (block->ptr) {
-            hipError_t result = hipFree(block->ptr);
+    for (auto& pending : pending_events_) {
+        hipEventDestroy(static_cast<hipEvent_t>(pending.first));
+    }
+    pending_events_.clear();
+    
+    // Free all segments, then any unpooled host/managed blocks. Idle events
+    // outlive their segments, which wait on them before unmapping
+    for (auto& entry : segments_) {
+        free_segment_memory(entry.second.get());
+        if (entry.second->idle_event) {
+            hipEventDestroy(static_cast<hipEvent_t>(entry.second->idle_event));
+        }
+    }
+    for (void* event : event_pool_) {
+        hipEventDestroy(static_cast<hipEvent_t>(event));
+    }
+    event_pool_.clear();
+    for (auto& entry : blocks_) {
+        Block* block = entry.second.get();
+        if (!block->segment) {
+            hipError_t result = block->pinned_host ? hipHostFree(block->ptr) : hipFree(block->ptr);
             if (result != hipSuccess) {
                 std::cerr << "Warning: Failed to free memory block: " << hipGetErrorString(result) << std::endl;
             }
         }
     }
     blocks_.clear();
-    cache_.clear();
+    segments_.clear();
+    for (BlockPool* pool : {&small_pool_, &large_pool_}) {
+        for (auto& bin : pool->size_bins) {
+            bin.clear();
+        }
+        pool->large_free_blocks.clear();
+    }
 }
 
 void* MemoryAllocator::allocate(size_t size, const AllocationOptions& options) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     if (size == 0) {
         return nullptr;
     }
     
-    // Apply alignment
-    size_t aligned_size = ((size + options.alignment - 1) / options.alignment) * options.alignment;
+    // Apply alignment, then round into the pool's size buckets
+    size_t aligned_size = size;
+    if (options.alignment > kMinBlockSize) {
+        aligned_size = ((size + options.alignment - 1) / options.alignment) * options.alignment;
+    }
+    aligned_size = round_size(aligned_size);
     
-    // Try to find a free block
-    Block* block = find_free_block(aligned_size);
-    if (!block) {
-        // Allocate new block
-        block = allocate_new_block(aligned_size, options);
-        if (!block) {
-            return nullptr;
+    bool pooled = !options.pinned_host_memory && !options.unified_memory;
+    bool capturing = captures_underway_.load(std::memory_order_acquire) > 0;
+    if (pooled && aligned_size <= kSmallSize && !capturing) {
+        void* ptr = allocate_from_thread_cache(aligned_size, options.stream, options.tag);
+        if (ptr) {
+            return ptr;
         }
     }
     
-    // Split block if it's larger than needed
-    if (block->size > aligned_size + sizeof(Block)) {
-        split_block(block, aligned_size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    capturing = captures_underway_.load(std::memory_order_relaxed) > 0;
+    
+    Block* block = nullptr;
+    if (!pooled) {
+        // Host and managed memory are not pooled alongside device segments
+        block = allocate_new_block(nullptr, aligned_size, options);
+        if (!block) {
+            record_trace(TraceAction::Oom, nullptr, aligned_size, options.stream, options.tag);
+            return nullptr;
+        }
+    } else {
+        PrivatePool* private_pool = capturing ? capture_pool_for(options.stream) : nullptr;
+        BlockPool& pool = !private_pool ? get_pool(aligned_size)
+                        : aligned_size <= kSmallSize ? private_pool->small : private_pool->large;
+        
+        // Blocks whose cross-stream events have completed become reusable;
+        // querying events would invalidate a capture
+        if (!capturing) {
+            process_events();
+        }
+        
+        // Try to find a free block owned by this stream, then an idle
+        // segment that another stream has finished with. Graph pools only
+        // ever grow by whole segments of their own.
+        block = find_free_block(pool, aligned_size, options.stream);
+        if (!block && !capturing) {
+            block = reuse_idle_segment(pool, aligned_size, options.stream);
+        }
+        if (!block && expandable_segments_ && !pool.is_small && !private_pool) {
+            block = expand_segment(aligned_size, options.stream);
+        }
+        if (block) {
+            remove_free_block(block);
+        } else {
+            // Allocate a new segment sized for the pool
+            size_t segment_size = get_allocation_size(aligned_size);
+            block = allocate_new_block(&pool, segment_size, options);
+            if (!block && capturing) {
+                // Releasing segments synchronizes, which a capture cannot do
+                record_trace(TraceAction::Oom, nullptr, aligned_size, options.stream, options.tag);
+                return nullptr;
+            }
+            if (!block) {
+                // Hand idle segments back to the driver and retry before failing
+                flush_thread_caches();
+                release_cached_segments(std::numeric_limits<size_t>::max());
+                block = allocate_new_block(&pool, segment_size, options);
+                if (!block) {
+                    record_trace(TraceAction::Oom, nullptr, aligned_size, options.stream, options.tag);
+                    return nullptr;
+                }
+            }
+        }
+        
+        // Split block if it's larger than needed
+        if (should_split(block, aligned_size)) {
+            split_block(block, aligned_size);
+        }
+        
+        Segment* segment = block->segment;
+        if (segment->active_blocks++ == 0 && segment->idle_event) {
+            release_event(segment->idle_event);
+            segment->idle_event = nullptr;
+        }
     }
     
     block->in_use = true;
     block->stream = options.stream;
-    block->allocation_id = ++allocation_counter_;
+    block->allocation_id = allocation_counter_.fetch_add(1, std::memory_order_relaxed) + 1;
+    block->tag = options.tag;
     
     stats_.allocated_bytes += block->allocated_size;
     stats_.allocated_blocks++;
@@ -67,54 +232,85 @@ void* MemoryAllocator::allocate(size_t size, const AllocationOptions& options) {
         stats_.max_allocated_bytes = stats_.allocated_bytes;
     }
     
+    register_live_block(block);
+    record_trace(TraceAction::Alloc, block->ptr, block->allocated_size, block->stream, block->tag);
     return block->ptr;
 }
 
 void MemoryAllocator::deallocate(void* ptr) {
     if (!ptr) return;
     
+    LiveBlock entry;
+    bool live = unregister_live_block(ptr, entry);
+    if (live && !entry.stream_recorded && deallocate_to_thread_cache(entry.block)) {
+        record_trace(TraceAction::Free, ptr, entry.block->size, entry.block->stream, entry.block->tag);
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(mutex_);
     
     // Find the block
-    auto it = std::find_if(blocks_.begin(), blocks_.end(),
-        [ptr](const std::unique_ptr<Block>& block) {
-            return block->ptr == ptr;
-        });
-    
+    auto it = blocks_.find(ptr);
     if (it == blocks_.end()) {
         std::cerr << "Warning: Attempt to free unknown pointer" << std::endl;
         return;
     }
     
-    Block* block = it->get();
-    if (!block->in_use) {
+    // Blocks parked in a thread cache look in use, but are no longer live
+    Block* block = it->second.get();
+    if (!live || !block->in_use || block->event_count > 0) {
         std::cerr << "Warning: Double free detected" << std::endl;
         return;
     }
     
-    block->in_use = false;
-    stats_.allocated_bytes -= block->allocated_size;
-    stats_.allocated_blocks--;
     stats_.total_frees++;
+    record_trace(TraceAction::Free, ptr, block->allocated_size, block->stream, block->tag);
     
-    // Add to cache if the block is large enough
-    if (block->size >= 1024) { // Cache blocks larger than 1KB
-        add_to_cache(block);
-    } else {
-        // Small blocks are immediately freed
-        hipError_t result = hipFree(block->ptr);
-        if (result != hipSuccess) {
-            std::cerr << "Warning: Failed to free memory: " << hipGetErrorString(result) << std::endl;
+    if (!block->stream_uses.empty()) {
+        // Other streams may still be reading the block; defer until their
+        // recorded events complete (see process_events). Recording those
+        // events waits for the end of any capture.
+        if (captures_underway_.load(std::memory_order_relaxed) > 0) {
+            deferred_frees_.push_back(block);
+        } else {
+            insert_events(block);
         }
-        blocks_.erase(it);
+        return;
+    }
+    
+    free_block(block);
+}
+
+void MemoryAllocator::record_stream(void* ptr, void* stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = blocks_.find(ptr);
+    if (it == blocks_.end() || !it->second->in_use) {
+        std::cerr << "Warning: record_stream on unknown pointer" << std::endl;
+        return;
     }
     
-    // Try to merge adjacent free blocks
-    merge_adjacent_blocks();
+    LiveShard& shard = live_shard_for(ptr);
+    std::lock_guard<std::mutex> shard_lock(shard.mutex);
+    auto live = shard.blocks.find(ptr);
+    if (live == shard.blocks.end()) {
+        std::cerr << "Warning: record_stream on unknown pointer" << std::endl;
+        return;
+    }
+    
+    Block* block = it->second.get();
+    if (!block->pool || stream == block->stream) {
+        return; // Same-stream reuse is already ordered
+    }
+    if (std::find(block->stream_uses.begin(), block->stream_uses.end(), stream) == block->stream_uses.end()) {
+        block->stream_uses.push_back(stream);
+    }
+    live->second.stream_recorded = true;
 }
 
 bool MemoryAllocator::memcpy(void* dst, const void* src, size_t size, void* stream) {
     hipError_t result;
+    ScopedDeviceEvent timing(EventType::MEMORY_COPY, "memcpy", -1, stream, size);
     
     if (stream) {
         result = hipMemcpyAsync(dst, src, size, hipMemcpyDefault, static_cast<hipStream_t>(stream));
@@ -129,6 +325,7 @@ bool MemoryAllocator::memcpy(void* dst, const void* src, size_t size, void* stre
 
 bool MemoryAllocator::memset(void* ptr, int value, size_t size, void* stream) {
     hipError_t result;
+    ScopedDeviceEvent timing(EventType::MEMORY_SET, "memset", -1, stream, size);
     
     if (stream) {
         result = hipMemsetAsync(ptr, value, size, static_cast<hipStream_t>(stream));
@@ -141,34 +338,60 @@ bool MemoryAllocator::memset(void* ptr, int value, size_t size, void* stream) {
     return result == hipSuccess;
 }
 
+std::shared_ptr<Event> MemoryAllocator::memcpy_async(void* dst, const void* src, size_t size, Stream& stream) {
+    return enqueue_memcpy(dst, src, size, stream);
+}
+
+std::shared_ptr<Event> MemoryAllocator::memset_async(void* ptr, int value, size_t size, Stream& stream) {
+    return enqueue_memset(ptr, value, size, stream);
+}
+
 void MemoryAllocator::empty_cache() {
+    release_workspaces();
+    
     std::lock_guard<std::mutex> lock(mutex_);
-    cleanup_cache();
+    flush_thread_caches();
+    synchronize_and_free_events();
+    release_cached_segments(std::numeric_limits<size_t>::max());
 }
 
 MemoryStats MemoryAllocator::get_stats() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return stats_;
+    MemoryStats stats = stats_;
+    stats.small_pool_segments = small_pool_.segment_count;
+    stats.small_pool_blocks = small_pool_.block_count;
+    stats.large_pool_segments = large_pool_.segment_count;
+    stats.large_pool_blocks = large_pool_.block_count;
+    stats.workspace_bytes = workspace_bytes_.load(std::memory_order_relaxed);
+    stats.workspace_high_water_mark = workspace_high_water_mark_.load(std::memory_order_relaxed);
+    
+    // Thread-cached blocks are still in use as far as the pools know
+    for (const auto& cache : thread_caches_) {
+        std::lock_guard<std::mutex> cache_lock(cache->mutex);
+        stats.allocated_bytes -= cache->cached_bytes;
+        stats.allocated_blocks -= cache->blocks.size();
+        stats.cached_bytes += cache->cached_bytes;
+        stats.cached_blocks += cache->blocks.size();
+        stats.total_allocations += cache->allocations;
+        stats.total_frees += cache->frees;
+    }
+    return stats;
 }
 
 AllocationInfo MemoryAllocator::get_allocation_info(void* ptr) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = std::find_if(blocks_.begin(), blocks_.end(),
-        [ptr](const std::unique_ptr<Block>& block) {
-            return block->ptr == ptr;
-        });
-    
+    auto it = blocks_.find(ptr);
     if (it == blocks_.end()) {
         return AllocationInfo{};
     }
     
-    const Block* block = it->get();
+    const Block* block = it->second.get();
     return AllocationInfo{
         block->ptr,
         block->size,
         block->allocated_size,
-        true, // is_device_memory
+        !block->pinned_host, // is_device_memory
         context_->get_device_id(),
         block->stream,
         block->allocation_id
@@ -179,7 +402,7 @@ void MemoryAllocator::set_cache_size_limit(size_t limit) {
     std::lock_guard<std::mutex> lock(mutex_);
     cache_size_limit_ = limit;
     if (stats_.cached_bytes > limit) {
-        evict_from_cache(stats_.cached_bytes - limit);
+        release_cached_segments(stats_.cached_bytes - limit);
     }
 }
 
@@ -187,258 +410,1649 @@ size_t MemoryAllocator::get_cache_size_limit() const {
     return cache_size_limit_;
 }
 
-uint64_t MemoryAllocator::get_total_memory() const {
-    size_t free, total;
-    hipError_t result = hipMemGetInfo(&free, &total);
-    return (result == hipSuccess) ? total : 0;
-}
-
-uint64_t MemoryAllocator::get_free_memory() const {
-    size_t free, total;
-    hipError_t result = hipMemGetInfo(&free, &total);
-    return (result == hipSuccess) ? free : 0;
+bool MemoryAllocator::set_expandable_segments(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (enabled && expandable_page_size_ == 0) {
+        hipMemAllocationProp prop = {};
+        prop.type = hipMemAllocationTypePinned;
+        prop.location.type = hipMemLocationTypeDevice;
+        prop.location.id = context_->get_device_id();
+        
+        size_t granularity = 0;
+        hipError_t result = hipMemGetAllocationGranularity(&granularity, &prop,
+                                                           hipMemAllocationGranularityRecommended);
+        if (result != hipSuccess || granularity == 0) {
+            std::cerr << "Warning: Expandable segments unsupported on this device: "
+                      << hipGetErrorString(result) << std::endl;
+            return false;
+        }
+        // Map in pages of at least kRoundLarge to keep driver calls rare
+        expandable_page_size_ = ((kRoundLarge + granularity - 1) / granularity) * granularity;
+    }
+    
+    // Existing expandable segments keep serving their streams either way
+    expandable_segments_ = enabled;
+    return true;
 }
 
-uint64_t MemoryAllocator::get_used_memory() const {
-    size_t free, total;
-    hipError_t result = hipMemGetInfo(&free, &total);
-    return (result == hipSuccess) ? (total - free) : 0;
+bool MemoryAllocator::get_expandable_segments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return expandable_segments_;
 }
 
-// Private implementation methods
-MemoryAllocator::Block* MemoryAllocator::find_free_block(size_t size) {
-    for (auto& block : blocks_) {
-        if (!block->in_use && block->size >= size) {
-            return block.get();
-        }
+Workspace MemoryAllocator::acquire_workspace(size_t size, void* stream) {
+    const size_t limit = workspace_limit_.load(std::memory_order_relaxed);
+    if (size > limit) {
+        return Workspace();
     }
-    return nullptr;
-}
-
-MemoryAllocator::Block* MemoryAllocator::allocate_new_block(size_t size, const AllocationOptions& options) {
-    void* ptr = nullptr;
-    hipError_t result;
     
-    if (options.pinned_host_memory) {
-        result = hipHostMalloc(&ptr, size, hipHostMallocDefault);
-    } else if (options.unified_memory) {
-        result = hipMallocManaged(&ptr, size);
-    } else {
-        result = hipMalloc(&ptr, size);
+    if (captures_underway_.load(std::memory_order_acquire) > 0) {
+        PrivatePool* pool;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pool = capture_pool_for(stream);
+        }
+        if (pool) {
+            return acquire_capture_workspace(pool, size, stream);
+        }
     }
     
-    if (result != hipSuccess) {
-        return nullptr;
+    WorkspaceArena* arena = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(workspace_mutex_);
+        auto& slot = workspaces_[stream];
+        if (!slot) {
+            slot = std::make_unique<WorkspaceArena>();
+        }
+        arena = slot.get();
     }
     
-    auto block = std::make_unique<Block>();
-    block->ptr = ptr;
-    block->size = size;
-    block->allocated_size = size;
-    block->in_use = false;
-    block->stream = options.stream;
-    
-    Block* block_ptr = block.get();
-    blocks_.push_back(std::move(block));
-    return block_ptr;
-}
-
-void MemoryAllocator::split_block(Block* block, size_t needed_size) {
-    if (block->size <= needed_size + sizeof(Block)) {
-        return;
+    std::unique_lock<std::mutex> lock(arena->mutex);
+    if (arena->size >= size) {
+        return Workspace(std::move(lock), arena->ptr, arena->size);
     }
     
-    size_t remaining_size = block->size - needed_size;
-    void* remaining_ptr = static_cast<char*>(block->ptr) + needed_size;
-    
-    auto new_block = std::make_unique<Block>();
-    new_block->ptr = remaining_ptr;
-    new_block->size = remaining_size;
-    new_block->allocated_size = remaining_size;
-    new_block->in_use = false;
-    new_block->stream = block->stream;
+    // Grow in large-pool rounding steps so a slowly climbing request size
+    // does not reallocate every call. The old buffer can go straight back to
+    // the pool: anything reusing it is ordered on this stream behind the
+    // work that last borrowed it.
+    size_t new_size = std::min(((size + kRoundLarge - 1) / kRoundLarge) * kRoundLarge, limit);
+    if (arena->ptr) {
+        deallocate(arena->ptr);
+        workspace_bytes_.fetch_sub(arena->size, std::memory_order_relaxed);
+        arena->ptr = nullptr;
+        arena->size = 0;
+    }
     
-    block->size = needed_size;
+    AllocationOptions options = {};
+    options.stream = stream;
+    options.tag = "workspace";
+    void* ptr = allocate(new_size, options);
+    if (!ptr) {
+        return Workspace();
+    }
+    arena->ptr = ptr;
+    arena->size = new_size;
     
-    // Insert after current block
-    auto it = std::find_if(blocks_.begin(), blocks_.end(),
-        [block](const std::unique_ptr<Block>& b) { return b.get() == block; });
-    
-    if (it != blocks_.end()) {
-        blocks_.insert(std::next(it), std::move(new_block));
-    }
-}
-
-void MemoryAllocator::merge_adjacent_blocks() {
-    // Simple implementation - could be optimized
-    bool merged;
-    do {
-        merged = false;
-        for (size_t i = 0; i < blocks_.size() - 1; ++i) {
-            Block* current = blocks_[i].get();
-            Block* next = blocks_[i + 1].get();
-            
-            if (!current->in_use && !next->in_use &&
-                static_cast<char*>(current->ptr) + current->size == next->ptr) {
-                
-                current->size += next->size;
-                blocks_.erase(blocks_.begin() + i + 1);
-                merged = true;
-                break;
-            }
-        }
-    } while (merged);
+    uint64_t total = workspace_bytes_.fetch_add(new_size, std::memory_order_relaxed) + new_size;
+    uint64_t peak = workspace_high_water_mark_.load(std::memory_order_relaxed);
+    while (total > peak &&
+           !workspace_high_water_mark_.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+    }
+    return Workspace(std::move(lock), arena->ptr, arena->size);
 }
 
-void MemoryAllocator::add_to_cache(Block* block) {
-    auto cached_block = std::make_unique<CacheBlock>();
-    cached_block->ptr = block->ptr;
-    cached_block->size = block->size;
-    cached_block->stream = block->stream;
-    cached_block->last_used = allocation_counter_;
-    
-    cache_.push_back(std::move(cached_block));
-    stats_.cached_bytes += block->size;
-    stats_.cached_blocks++;
+void MemoryAllocator::set_workspace_limit(size_t limit) {
+    // Oversized arenas are only given back by empty_cache()
+    workspace_limit_.store(limit, std::memory_order_relaxed);
 }
 
-MemoryAllocator::CacheBlock* MemoryAllocator::find_cached_block(size_t size) {
-    for (auto& cached_block : cache_) {
-        if (cached_block->size >= size) {
-            return cached_block.get();
-        }
-    }
-    return nullptr;
+size_t MemoryAllocator::get_workspace_limit() const {
+    return workspace_limit_.load(std::memory_order_relaxed);
 }
 
-void MemoryAllocator::evict_from_cache(size_t needed_size) {
-    // Sort by last used (LRU)
-    std::sort(cache_.begin(), cache_.end(),
-        [](const std::unique_ptr<CacheBlock>& a, const std::unique_ptr<CacheBlock>& b) {
-            return a->last_used < b->last_used;
-        });
+Workspace MemoryAllocator::acquire_capture_workspace(PrivatePool* pool, size_t size, void* stream) {
+    // The stream's own arena may be regrown after the capture, so captured
+    // work borrows the pool's instead. Outgrown buffers are kept: work
+    // captured earlier still points at them.
+    std::unique_lock<std::mutex> lock(pool->workspace.mutex);
+    WorkspaceArena& arena = pool->workspace;
+    if (arena.size >= size) {
+        return Workspace(std::move(lock), arena.ptr, arena.size);
+    }
     
-    size_t freed_size = 0;
-    auto it = cache_.begin();
-    while (it != cache_.end() && freed_size < needed_size) {
-        hipError_t result = hipFree((*it)->ptr);
-        if (result == hipSuccess) {
-            freed_size += (*it)->size;
-            stats_.cached_bytes -= (*it)->size;
-            stats_.cached_blocks--;
-            it = cache_.erase(it);
-        } else {
-            ++it;
-        }
+    size_t new_size = std::min(((size + kRoundLarge - 1) / kRoundLarge) * kRoundLarge,
+                               workspace_limit_.load(std::memory_order_relaxed));
+    AllocationOptions options = {};
+    options.stream = stream;
+    options.tag = "workspace";
+    void* ptr = allocate(new_size, options);
+    if (!ptr) {
+        return Workspace();
     }
-}
-
-void MemoryAllocator::cleanup_cache() {
-    for (auto& cached_block : cache_) {
-        hipError_t result = hipFree(cached_block->ptr);
-        if (result != hipSuccess) {
-            std::cerr << "Warning: Failed to free cached memory: " << hipGetErrorString(result) << std::endl;
-        }
+    if (arena.ptr) {
+        pool->outgrown.push_back(arena.ptr);
     }
-    cache_.clear();
-    stats_.cached_bytes = 0;
-    stats_.cached_blocks = 0;
+    arena.ptr = ptr;
+    arena.size = new_size;
+    pool->workspace_bytes += new_size;
+    workspace_bytes_.fetch_add(new_size, std::memory_order_relaxed);
+    return Workspace(std::move(lock), arena.ptr, arena.size);
 }
 
-// MemoryManager implementation
-MemoryManager& MemoryManager::get_instance() {
-    static MemoryManager instance;
-    return instance;
+uint64_t MemoryAllocator::create_private_pool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_pool_id_++;
+    private_pools_.emplace(id, std::make_unique<PrivatePool>(id));
+    return id;
 }
 
-std::shared_ptr<MemoryAllocator> MemoryManager::get_allocator(int device_id) {
+bool MemoryAllocator::retain_private_pool(uint64_t pool_id) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    if (device_id == -1) {
-        int current_device;
-        hipError_t result = hipGetDevice(&current_device);
-        if (result != hipSuccess) {
-            throw std::runtime_error("Failed to get current device");
+    auto it = private_pools_.find(pool_id);
+    if (it == private_pools_.end() || it->second->use_count == 0) {
+        return false;  // Unknown, or already on its way back to the driver
+    }
+    it->second->use_count++;
+    return true;
+}
+
+void MemoryAllocator::release_private_pool(uint64_t pool_id) {
+    PrivatePool* pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = private_pools_.find(pool_id);
+        if (it == private_pools_.end() || it->second->use_count == 0 || --it->second->use_count > 0) {
+            return;
         }
-        device_id = current_device;
+        pool = it->second.get();
     }
     
-    auto it = allocators_.find(device_id);
-    if (it == allocators_.end()) {
-        auto context = std::make_shared<DeviceContext>(device_id);
-        if (!context->initialize()) {
-            throw std::runtime_error("Failed to initialize device context for allocator");
+    // Last user gone; the pool only stays alive for its segments now, and
+    // nothing allocates from it any more
+    std::vector<void*> workspaces;
+    {
+        std::lock_guard<std::mutex> arena_lock(pool->workspace.mutex);
+        workspaces.swap(pool->outgrown);
+        if (pool->workspace.ptr) {
+            workspaces.push_back(pool->workspace.ptr);
         }
-        
-        auto allocator = std::make_shared<MemoryAllocator>(context);
-        allocators_[device_id] = allocator;
-        return allocator;
+        workspace_bytes_.fetch_sub(pool->workspace_bytes, std::memory_order_relaxed);
+        pool->workspace_bytes = 0;
+        pool->workspace.ptr = nullptr;
+        pool->workspace.size = 0;
+    }
+    for (void* ptr : workspaces) {
+        deallocate(ptr);
     }
     
-    return it->second;
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_idle_private_segments(pool);
 }
 
-std::shared_ptr<MemoryAllocator> MemoryManager::get_current_allocator() {
-    int current_device;
-    hipError_t result = hipGetDevice(&current_device);
-    if (result != hipSuccess) {
-        throw std::runtime_error("Failed to get current device");
+bool MemoryAllocator::begin_capture_to_pool(uint64_t pool_id, void* stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = private_pools_.find(pool_id);
+    if (it == private_pools_.end() || it->second->use_count == 0 || capture_pools_.count(stream)) {
+        return false;
     }
-    return get_allocator(current_device);
+    
+    // Also turns off the thread-cache fast path, which would hand out
+    // shared-pool blocks on the capturing stream
+    capture_pools_[stream] = it->second.get();
+    captures_underway_.fetch_add(1, std::memory_order_release);
+    return true;
 }
 
-void* MemoryManager::allocate(size_t size, int device_id, const AllocationOptions& options) {
-    auto allocator = get_allocator(device_id);
-    return allocator->allocate(size, options);
+void MemoryAllocator::end_capture_to_pool(void* stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capture_pools_.erase(stream) == 0) {
+        return;
+    }
+    if (captures_underway_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::vector<Block*> deferred;
+        deferred.swap(deferred_frees_);
+        for (Block* block : deferred) {
+            insert_events(block);
+        }
+    }
 }
 
-void MemoryManager::deallocate(void* ptr) {
-    if (!ptr) return;
-    
-    int device_id = get_device_for_pointer(ptr);
-    if (device_id >= 0) {
-        auto allocator = get_allocator(device_id);
-        allocator->deallocate(ptr);
-    }
+MemoryAllocator::PrivatePool* MemoryAllocator::capture_pool_for(void* stream) const {
+    auto it = capture_pools_.find(stream);
+    return it != capture_pools_.end() ? it->second : nullptr;
 }
 
-bool MemoryManager::memcpy(void* dst, const void* src, size_t size, void* stream) {
-    // This is a simplified implementation
-    hipError_t result;
-    
-    if (stream) {
-        result = hipMemcpyAsync(dst, src, size, hipMemcpyDefault, static_cast<hipStream_t>(stream));
-        if (result != hipSuccess) return false;
-        result = hipStreamSynchronize(static_cast<hipStream_t>(stream));
-    } else {
-        result = hipMemcpy(dst, src, size, hipMemcpyDefault);
-    }
-    
-    return result == hipSuccess;
+bool MemoryAllocator::is_capturing(void* stream) const {
+    return captures_underway_.load(std::memory_order_relaxed) > 0 && capture_pools_.count(stream) > 0;
 }
 
-bool MemoryManager::memset(void* ptr, int value, size_t size, void* stream) {
-    hipError_t result;
-    
-    if (stream) {
-        result = hipMemsetAsync(ptr, value, size, static_cast<hipStream_t>(stream));
-        if (result != hipSuccess) return false;
-        result = hipStreamSynchronize(static_cast<hipStream_t>(stream));
-    } else {
-        result = hipMemset(ptr, value, size);
+void MemoryAllocator::release_idle_private_segments(PrivatePool* pool) {
+    if (pool->use_count > 0) {
+        return;
+    }
+    std::vector<Segment*> idle;
+    for (auto& entry : segments_) {
+        Segment* segment = entry.second.get();
+        if (segment->pool->owner == pool && segment->active_blocks == 0) {
+            idle.push_back(segment);
+        }
+    }
+    for (Segment* segment : idle) {
+        release_segment(segment);
+    }
+    if (pool->small.segment_count == 0 && pool->large.segment_count == 0) {
+        private_pools_.erase(pool->id);
     }
-    
-    return result == hipSuccess;
 }
 
-void MemoryManager::empty_cache(int device_id) {
-    auto allocator = get_allocator(device_id);
-    allocator->empty_cache();
+void MemoryAllocator::release_workspaces() {
+    // Arenas on loan are skipped rather than waited for
+    std::vector<void*> released;
+    {
+        std::lock_guard<std::mutex> lock(workspace_mutex_);
+        for (auto& entry : workspaces_) {
+            WorkspaceArena& arena = *entry.second;
+            std::unique_lock<std::mutex> arena_lock(arena.mutex, std::try_to_lock);
+            if (arena_lock.owns_lock() && arena.ptr) {
+                released.push_back(arena.ptr);
+                workspace_bytes_.fetch_sub(arena.size, std::memory_order_relaxed);
+                arena.ptr = nullptr;
+                arena.size = 0;
+            }
+        }
+    }
+    for (void* ptr : released) {
+        deallocate(ptr);
+    }
 }
 
-MemoryStats MemoryManager::get_stats(int device_id) const {
-    auto allocator = const_cast<MemoryManager*>(this)->get_allocator(device_id);
-    return allocator->get_stats();
+MemorySnapshot MemoryAllocator::snapshot() const {
+    MemorySnapshot result;
+    result.device_id = context_->get_device_id();
+    result.stats = get_stats();
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        // Thread caches stay locked while blocks are read: their fast path
+        // relabels blocks without mutex_
+        std::unordered_set<const Block*> thread_cached;
+        std::vector<std::unique_lock<std::mutex>> cache_locks;
+        for (const auto& cache : thread_caches_) {
+            cache_locks.emplace_back(cache->mutex);
+            thread_cached.insert(cache->blocks.begin(), cache->blocks.end());
+        }
+        auto block_state = [&thread_cached](const Block* block) {
+            if (!block->in_use) {
+                return "free";
+            }
+            if (block->event_count > 0) {
+                return "pending_free";
+            }
+            return thread_cached.count(block) ? "thread_cached" : "allocated";
+        };
+        
+        for (const auto& entry : segments_) {
+            const Segment* segment = entry.second.get();
+            SegmentSnapshot segment_snapshot{segment->ptr, segment->size, segment->stream,
+                                             segment->pool->owner ? "private"
+                                                 : segment->pool->is_small ? "small" : "large",
+                                             segment->expandable, {}};
+            auto first = blocks_.find(segment->ptr);
+            for (const Block* block = first != blocks_.end() ? first->second.get() : nullptr;
+                 block; block = block->next) {
+                segment_snapshot.blocks.push_back(BlockSnapshot{block->ptr, block->size, block_state(block),
+                                                                block->allocation_id, block->tag});
+            }
+            result.segments.push_back(std::move(segment_snapshot));
+        }
+        for (const auto& entry : blocks_) {
+            const Block* block = entry.second.get();
+            if (block->segment) {
+                continue;
+            }
+            result.segments.push_back(SegmentSnapshot{block->ptr, block->size, block->stream, "unpooled", false,
+                {BlockSnapshot{block->ptr, block->size, block_state(block), block->allocation_id, block->tag}}});
+        }
+    }
+    std::sort(result.segments.begin(), result.segments.end(),
+        [](const SegmentSnapshot& a, const SegmentSnapshot& b) {
+            return reinterpret_cast<uintptr_t>(a.ptr) < reinterpret_cast<uintptr_t>(b.ptr);
+        });
+    
+    read_trace(0, result.trace);
+    return result;
+}
+
+uint64_t MemoryAllocator::read_trace(uint64_t cursor, std::vector<TraceEntry>& entries) const {
+    // Writers never wait for readers; skip slots that are mid-write or were
+    // overwritten while being copied
+    uint64_t head = trace_head_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(cursor, head > kTraceCapacity ? head - kTraceCapacity : 0);
+    for (uint64_t index = begin; index < head; ++index) {
+        const TraceSlot& slot = trace_[index & (kTraceCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+            continue;
+        }
+        TraceEntry entry = slot.entry;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == index + 1) {
+            entries.push_back(entry);
+        }
+    }
+    return head;
+}
+
+void MemoryAllocator::set_trace_enabled(bool enabled) {
+    trace_enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+bool MemoryAllocator::is_trace_enabled() const {
+    return trace_enabled_.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryAllocator::get_total_memory() const {
+    size_t free, total;
+    hipError_t result = hipMemGetInfo(&free, &total);
+    return (result == hipSuccess) ? total : 0;
+}
+
+uint64_t MemoryAllocator::get_free_memory() const {
+    size_t free, total;
+    hipError_t result = hipMemGetInfo(&free, &total);
+    return (result == hipSuccess) ? free : 0;
+}
+
+uint64_t MemoryAllocator::get_used_memory() const {
+    size_t free, total;
+    hipError_t result = hipMemGetInfo(&free, &total);
+    return (result == hipSuccess) ? (total - free) : 0;
+}
+
+// Private implementation methods
+MemoryAllocator::ThreadCache* MemoryAllocator::get_thread_cache() {
+    // Allocator ids are never reused, so entries left behind by a destroyed
+    // allocator are simply never matched again
+    thread_local std::vector<std::pair<uint64_t, ThreadCache*>> caches;
+    for (const auto& entry : caches) {
+        if (entry.first == allocator_id_) {
+            return entry.second;
+        }
+    }
+    
+    ThreadCache* cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        thread_caches_.push_back(std::make_unique<ThreadCache>());
+        cache = thread_caches_.back().get();
+    }
+    caches.emplace_back(allocator_id_, cache);
+    return cache;
+}
+
+void* MemoryAllocator::allocate_from_thread_cache(size_t size, void* stream, const char* tag) {
+    ThreadCache* cache = get_thread_cache();
+    Block* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        for (auto it = cache->blocks.rbegin(); it != cache->blocks.rend(); ++it) {
+            if ((*it)->size == size && (*it)->stream == stream) {
+                // Relabel under the cache lock, which snapshot() holds while
+                // it reads cached blocks
+                block = *it;
+                block->allocation_id = allocation_counter_.fetch_add(1, std::memory_order_relaxed) + 1;
+                block->tag = tag;
+                cache->blocks.erase(std::next(it).base());
+                cache->cached_bytes -= block->size;
+                cache->allocations++;
+                break;
+            }
+        }
+    }
+    if (!block) {
+        return nullptr;
+    }
+    
+    register_live_block(block);
+    record_trace(TraceAction::Alloc, block->ptr, block->size, stream, tag);
+    return block->ptr;
+}
+
+bool MemoryAllocator::deallocate_to_thread_cache(Block* block) {
+    // A live block's pool, size and stream only change under mutex_ while it
+    // is free, so they are safe to read here
+    if (block->pool != &small_pool_) {
+        return false;
+    }
+    
+    ThreadCache* cache = get_thread_cache();
+    std::vector<Block*> evicted;
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->blocks.push_back(block);
+        cache->cached_bytes += block->size;
+        cache->frees++;
+        while (cache->blocks.size() > kThreadCacheMaxBlocks || cache->cached_bytes > kThreadCacheMaxBytes) {
+            Block* oldest = cache->blocks.front();
+            cache->blocks.erase(cache->blocks.begin());
+            cache->cached_bytes -= oldest->size;
+            evicted.push_back(oldest);
+        }
+    }
+    
+    // Overflow goes back to the shared pool; mutex_ is never taken while a
+    // thread cache is locked
+    if (!evicted.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Block* oldest : evicted) {
+            free_block(oldest);
+        }
+    }
+    return true;
+}
+
+void MemoryAllocator::flush_thread_caches() {
+    for (auto& cache : thread_caches_) {
+        std::vector<Block*> blocks;
+        {
+            std::lock_guard<std::mutex> cache_lock(cache->mutex);
+            blocks.swap(cache->blocks);
+            cache->cached_bytes = 0;
+        }
+        for (Block* block : blocks) {
+            free_block(block);
+        }
+    }
+}
+
+MemoryAllocator::LiveShard& MemoryAllocator::live_shard_for(const void* ptr) {
+    // Blocks are kMinBlockSize aligned, so the low bits carry no information
+    return live_shards_[(reinterpret_cast<uintptr_t>(ptr) / kMinBlockSize) % kLiveShardCount];
+}
+
+void MemoryAllocator::register_live_block(Block* block) {
+    LiveShard& shard = live_shard_for(block->ptr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.blocks[block->ptr] = LiveBlock{block, false};
+}
+
+bool MemoryAllocator::unregister_live_block(void* ptr, LiveBlock& entry) {
+    LiveShard& shard = live_shard_for(ptr);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.blocks.find(ptr);
+    if (it == shard.blocks.end()) {
+        return false;
+    }
+    entry = it->second;
+    shard.blocks.erase(it);
+    return true;
+}
+
+void MemoryAllocator::record_trace(TraceAction action, void* ptr, size_t size, void* stream, const char* tag) {
+    if (!trace_enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    
+    uint64_t index = trace_head_.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot& slot = trace_[index & (kTraceCapacity - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.entry = TraceEntry{action, ptr, size, stream, trace_timestamp_ns(), tag};
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool MemoryAllocator::BlockComparator::operator()(const Block* a, const Block* b) const {
+    if (a->stream != b->stream) {
+        return reinterpret_cast<uintptr_t>(a->stream) < reinterpret_cast<uintptr_t>(b->stream);
+    }
+    if (a->size != b->size) {
+        return a->size < b->size;
+    }
+    return reinterpret_cast<uintptr_t>(a->ptr) < reinterpret_cast<uintptr_t>(b->ptr);
+}
+
+size_t MemoryAllocator::size_to_bin(size_t size) {
+    size_t bin = 0;
+    for (size_t bound = kMinBinSize * 2; bound <= size && bin + 1 < kSizeBinCount; bound <<= 1) {
+        ++bin;
+    }
+    return bin;
+}
+
+MemoryAllocator::FreeBlockSet& MemoryAllocator::free_set_for(BlockPool& pool, size_t size) {
+    if (size >= kLargeBlockThreshold) {
+        return pool.large_free_blocks;
+    }
+    return pool.size_bins[size_to_bin(size)];
+}
+
+// Free pooled blocks are exactly the cached memory, so the cache counters
+// are maintained here rather than at every call site.
+void MemoryAllocator::insert_free_block(Block* block) {
+    free_set_for(*block->pool, block->size).insert(block);
+    stats_.cached_bytes += block->size;
+    stats_.cached_blocks++;
+}
+
+void MemoryAllocator::remove_free_block(Block* block) {
+    free_set_for(*block->pool, block->size).erase(block);
+    stats_.cached_bytes -= block->size;
+    stats_.cached_blocks--;
+}
+
+size_t MemoryAllocator::round_size(size_t size) {
+    if (size < kMinBlockSize) {
+        return kMinBlockSize;
+    }
+    
+    if (size > kSmallSize) {
+        // Round up to one of kRoundupPower2Divisions evenly spaced buckets
+        // between the neighbouring powers of two (e.g. 4MB, 5MB, 6MB, 7MB)
+        size_t power2_floor = kSmallSize;
+        while (power2_floor * 2 <= size) {
+            power2_floor *= 2;
+        }
+        size_t step = power2_floor / kRoundupPower2Divisions;
+        return ((size + step - 1) / step) * step;
+    }
+    
+    return ((size + kMinBlockSize - 1) / kMinBlockSize) * kMinBlockSize;
+}
+
+size_t MemoryAllocator::get_allocation_size(size_t size) {
+    if (size <= kSmallSize) {
+        return kSmallBuffer;
+    } else if (size < kMinLargeAlloc) {
+        return kLargeBuffer;
+    }
+    return ((size + kRoundLarge - 1) / kRoundLarge) * kRoundLarge;
+}
+
+MemoryAllocator::BlockPool& MemoryAllocator::get_pool(size_t size) {
+    return (size <= kSmallSize) ? small_pool_ : large_pool_;
+}
+
+MemoryAllocator::Block* MemoryAllocator::find_free_block(BlockPool& pool, size_t size, void* stream) {
+    Block key{};
+    key.size = size;
+    key.ptr = nullptr;
+    key.stream = stream;
+    
+    // Every block in a higher bin is larger than any block in a lower one, so
+    // the first hit walking up from the request's bin is the best fit.
+    if (size < kLargeBlockThreshold) {
+        for (size_t bin = size_to_bin(size); bin < kSizeBinCount; ++bin) {
+            auto it = pool.size_bins[bin].lower_bound(&key);
+            if (it != pool.size_bins[bin].end() && (*it)->stream == stream) {
+                return *it;
+            }
+        }
+    }
+    
+    auto it = pool.large_free_blocks.lower_bound(&key);
+    if (it != pool.large_free_blocks.end() && (*it)->stream == stream) {
+        return *it;
+    }
+    return nullptr;
+}
+
+MemoryAllocator::Block* MemoryAllocator::reuse_idle_segment(BlockPool& pool, size_t size, void* stream) {
+    // Only reached on a miss that would otherwise call hipMalloc, so a scan
+    // over segments is cheap by comparison.
+    Segment* best = nullptr;
+    for (auto& entry : segments_) {
+        Segment* segment = entry.second.get();
+        if (segment->pool != &pool || segment->active_blocks != 0 || segment->size < size ||
+            segment->stream == stream || !segment->idle_event || segment->expandable) {
+            continue;
+        }
+        if (best && segment->size >= best->size) {
+            continue;
+        }
+        if (hipEventQuery(static_cast<hipEvent_t>(segment->idle_event)) == hipSuccess) {
+            best = segment;
+        }
+    }
+    if (!best) {
+        return nullptr;
+    }
+    
+    // The segment's last use on its old stream has completed; move it over
+    Block* block = blocks_.at(best->ptr).get();
+    remove_free_block(block);
+    release_event(best->idle_event);
+    best->idle_event = nullptr;
+    best->stream = stream;
+    block->stream = stream;
+    insert_free_block(block);
+    return block;
+}
+
+MemoryAllocator::Block* MemoryAllocator::allocate_new_block(BlockPool* pool, size_t size, const AllocationOptions& options) {
+    void* ptr = nullptr;
+    hipError_t result;
+    
+    if (options.pinned_host_memory) {
+        result = hipHostMalloc(&ptr, size, hipHostMallocDefault);
+    } else if (options.unified_memory) {
+        result = hipMallocManaged(&ptr, size);
+    } else {
+        result = hipMalloc(&ptr, size);
+    }
+    
+    stats_.device_malloc_calls++;
+    if (result != hipSuccess) {
+        return nullptr;
+    }
+    
+    auto block = std::make_unique<Block>();
+    block->ptr = ptr;
+    block->size = size;
+    block->allocated_size = size;
+    block->in_use = false;
+    block->pinned_host = options.pinned_host_memory;
+    block->stream = options.stream;
+    block->pool = pool;
+    block->segment = nullptr;
+    block->prev = nullptr;
+    block->next = nullptr;
+    block->event_count = 0;
+    block->tag = nullptr;
+    
+    if (pool) {
+        auto segment = std::make_unique<Segment>();
+        segment->ptr = ptr;
+        segment->size = size;
+        segment->pool = pool;
+        segment->stream = options.stream;
+        segment->last_used = allocation_counter_.load(std::memory_order_relaxed);
+        segment->active_blocks = 0;
+        segment->idle_event = nullptr;
+        segment->expandable = false;
+        segment->reserved_size = size;
+        block->segment = segment.get();
+        segments_.emplace(ptr, std::move(segment));
+        
+        pool->segment_count++;
+        pool->block_count++;
+        record_trace(TraceAction::SegmentAlloc, ptr, size, options.stream);
+    }
+    
+    Block* block_ptr = block.get();
+    blocks_.emplace(ptr, std::move(block));
+    return block_ptr;
+}
+
+bool MemoryAllocator::should_split(const Block* block, size_t size) const {
+    size_t remaining = block->size - size;
+    if (block->pool->is_small) {
+        return remaining >= kMinBlockSize;
+    }
+    // Large remainders only; small leftovers would pin the segment
+    return remaining > kSmallSize;
+}
+
+void MemoryAllocator::free_block(Block* block) {
+    block->in_use = false;
+    stats_.allocated_bytes -= block->allocated_size;
+    stats_.allocated_blocks--;
+    
+    if (!block->pool) {
+        release_unpooled_block(block);
+        return;
+    }
+    
+    Segment* segment = block->segment;
+    segment->active_blocks--;
+    segment->last_used = allocation_counter_.load(std::memory_order_relaxed);
+    
+    // Coalesce with free neighbours and make the result available for reuse
+    block = merge_adjacent_blocks(block);
+    insert_free_block(block);
+    
+    PrivatePool* owner = segment->pool->owner;
+    if (owner) {
+        // Graph pool segments never move to other streams; once the pool
+        // is released they go back to the driver as soon as they are idle
+        if (segment->active_blocks == 0 && owner->use_count == 0) {
+            release_idle_private_segments(owner);
+        }
+        return;
+    }
+    
+    if (segment->active_blocks == 0 && !is_capturing(segment->stream)) {
+        // Lets another stream adopt the segment once this stream is past it
+        segment->idle_event = acquire_event();
+        if (segment->idle_event) {
+            hipEventRecord(static_cast<hipEvent_t>(segment->idle_event),
+                           static_cast<hipStream_t>(segment->stream));
+        }
+    }
+    
+    if (stats_.cached_bytes > cache_size_limit_ && captures_underway_.load(std::memory_order_relaxed) == 0) {
+        release_cached_segments(stats_.cached_bytes - cache_size_limit_);
+    }
+}
+
+void* MemoryAllocator::acquire_event() {
+    if (!event_pool_.empty()) {
+        void* event = event_pool_.back();
+        event_pool_.pop_back();
+        return event;
+    }
+    hipEvent_t event = nullptr;
+    if (hipEventCreateWithFlags(&event, hipEventDisableTiming) != hipSuccess) {
+        return nullptr;
+    }
+    return event;
+}
+
+void MemoryAllocator::release_event(void* event) {
+    event_pool_.push_back(event);
+}
+
+void MemoryAllocator::insert_events(Block* block) {
+    for (void* stream : block->stream_uses) {
+        void* event = acquire_event();
+        if (!event) {
+            // Without an event the only safe ordering is a full wait
+            hipStreamSynchronize(static_cast<hipStream_t>(stream));
+            continue;
+        }
+        hipEventRecord(static_cast<hipEvent_t>(event), static_cast<hipStream_t>(stream));
+        pending_events_.emplace_back(event, block);
+        block->event_count++;
+    }
+    block->stream_uses.clear();
+    
+    if (block->event_count == 0) {
+        free_block(block);
+    }
+}
+
+void MemoryAllocator::process_events() {
+    // Events are recorded in free order, so stop at the first one still pending
+    while (!pending_events_.empty()) {
+        auto& pending = pending_events_.front();
+        hipError_t result = hipEventQuery(static_cast<hipEvent_t>(pending.first));
+        if (result == hipErrorNotReady) {
+            break;
+        }
+        
+        Block* block = pending.second;
+        release_event(pending.first);
+        pending_events_.pop_front();
+        if (--block->event_count == 0) {
+            free_block(block);
+        }
+    }
+}
+
+void MemoryAllocator::synchronize_and_free_events() {
+    while (!pending_events_.empty()) {
+        auto& pending = pending_events_.front();
+        hipEventSynchronize(static_cast<hipEvent_t>(pending.first));
+        
+        Block* block = pending.second;
+        release_event(pending.first);
+        pending_events_.pop_front();
+        if (--block->event_count == 0) {
+            free_block(block);
+        }
+    }
+}
+
+void MemoryAllocator::release_unpooled_block(Block* block) {
+    hipError_t result = block->pinned_host ? hipHostFree(block->ptr) : hipFree(block->ptr);
+    stats_.device_free_calls++;
+    if (result != hipSuccess) {
+        std::cerr << "Warning: Failed to free memory: " << hipGetErrorString(result) << std::endl;
+    }
+    blocks_.erase(block->ptr);
+}
+
+void MemoryAllocator::split_block(Block* block, size_t needed_size) {
+    if (block->size <= needed_size) {
+        return;
+    }
+    
+    size_t remaining_size = block->size - needed_size;
+    void* remaining_ptr = static_cast<char*>(block->ptr) + needed_size;
+    
+    auto new_block = std::make_unique<Block>();
+    new_block->ptr = remaining_ptr;
+    new_block->size = remaining_size;
+    new_block->allocated_size = remaining_size;
+    new_block->in_use = false;
+    new_block->pinned_host = block->pinned_host;
+    new_block->stream = block->stream;
+    new_block->pool = block->pool;
+    new_block->segment = block->segment;
+    new_block->prev = block;
+    new_block->next = block->next;
+    new_block->event_count = 0;
+    new_block->tag = nullptr;
+    if (block->next) {
+        block->next->prev = new_block.get();
+    }
+    block->next = new_block.get();
+    
+    block->size = needed_size;
+    block->allocated_size = needed_size;
+    block->pool->block_count++;
+    
+    insert_free_block(new_block.get());
+    blocks_.emplace(remaining_ptr, std::move(new_block));
+    record_trace(TraceAction::Split, remaining_ptr, remaining_size, block->stream);
+}
+
+MemoryAllocator::Block* MemoryAllocator::merge_adjacent_blocks(Block* block) {
+    // Neighbours are linked at split time, so only the two direct
+    // neighbours of the freed block can ever be merged with it.
+    bool merged = false;
+    Block* prev = block->prev;
+    if (prev && !prev->in_use) {
+        remove_free_block(prev);
+        prev->size += block->size;
+        prev->allocated_size = prev->size;
+        prev->next = block->next;
+        if (block->next) {
+            block->next->prev = prev;
+        }
+        prev->pool->block_count--;
+        blocks_.erase(block->ptr);
+        block = prev;
+        merged = true;
+    }
+    
+    Block* next = block->next;
+    if (next && !next->in_use) {
+        remove_free_block(next);
+        block->size += next->size;
+        block->allocated_size = block->size;
+        block->next = next->next;
+        if (next->next) {
+            next->next->prev = block;
+        }
+        block->pool->block_count--;
+        blocks_.erase(next->ptr);
+        merged = true;
+    }
+    
+    if (merged) {
+        record_trace(TraceAction::Merge, block->ptr, block->size, block->stream);
+    }
+    return block;
+}
+
+void MemoryAllocator::release_segment(Segment* segment) {
+    // Only called for fully free segments, which have merged back into one block
+    auto it = blocks_.find(segment->ptr);
+    Block* block = it->second.get();
+    remove_free_block(block);
+    if (segment->expandable) {
+        expandable_segments_by_stream_.erase(segment->stream);
+    }
+    
+    record_trace(TraceAction::SegmentFree, segment->ptr, segment->size, segment->stream);
+    free_segment_memory(segment);
+    stats_.device_free_calls++;
+    if (segment->idle_event) {
+        release_event(segment->idle_event);
+    }
+    
+    segment->pool->segment_count--;
+    segment->pool->block_count--;
+    blocks_.erase(it);
+    segments_.erase(segment->ptr);
+}
+
+void MemoryAllocator::free_segment_memory(Segment* segment) {
+    hipError_t result;
+    if (segment->expandable) {
+        unmap_segment_pages(segment, 0);
+        result = hipMemAddressFree(segment->ptr, segment->reserved_size);
+    } else {
+        result = hipFree(segment->ptr);
+    }
+    if (result != hipSuccess) {
+        std::cerr << "Warning: Failed to free memory segment: " << hipGetErrorString(result) << std::endl;
+    }
+}
+
+size_t MemoryAllocator::release_cached_segments(size_t needed_size) {
+    std::vector<Segment*> idle;
+    std::vector<Segment*> expandable;
+    for (auto& entry : segments_) {
+        if (entry.second->pool->owner) {
+            continue;  // Graph pools release their own segments
+        }
+        if (entry.second->active_blocks == 0) {
+            idle.push_back(entry.second.get());
+        } else if (entry.second->expandable) {
+            expandable.push_back(entry.second.get());
+        }
+    }
+    
+    // Least recently used first
+    std::sort(idle.begin(), idle.end(),
+        [](const Segment* a, const Segment* b) {
+            return a->last_used < b->last_used;
+        });
+    
+    size_t freed_size = 0;
+    for (Segment* segment : idle) {
+        if (freed_size >= needed_size) {
+            break;
+        }
+        freed_size += segment->size;
+        release_segment(segment);
+    }
+    
+    // Expandable segments still in use can give back their free tail
+    for (Segment* segment : expandable) {
+        if (freed_size >= needed_size) {
+            break;
+        }
+        freed_size += trim_segment(segment);
+    }
+    return freed_size;
+}
+
+MemoryAllocator::Segment* MemoryAllocator::create_expandable_segment(void* stream) {
+    // Reserve enough address space for the whole device so the segment never
+    // has to move; only mapped pages consume memory
+    size_t free_memory = 0, total_memory = 0;
+    if (hipMemGetInfo(&free_memory, &total_memory) != hipSuccess) {
+        return nullptr;
+    }
+    size_t reserved_size = ((total_memory + expandable_page_size_ - 1) / expandable_page_size_) * expandable_page_size_;
+    
+    void* ptr = nullptr;
+    if (hipMemAddressReserve(&ptr, reserved_size, expandable_page_size_, nullptr, 0) != hipSuccess) {
+        return nullptr;
+    }
+    
+    auto segment = std::make_unique<Segment>();
+    segment->ptr = ptr;
+    segment->size = 0;
+    segment->pool = &large_pool_;
+    segment->stream = stream;
+    segment->last_used = allocation_counter_.load(std::memory_order_relaxed);
+    segment->active_blocks = 0;
+    segment->idle_event = nullptr;
+    segment->expandable = true;
+    segment->reserved_size = reserved_size;
+    
+    Segment* segment_ptr = segment.get();
+    segments_.emplace(ptr, std::move(segment));
+    expandable_segments_by_stream_[stream] = segment_ptr;
+    large_pool_.segment_count++;
+    return segment_ptr;
+}
+
+MemoryAllocator::Block* MemoryAllocator::expand_segment(size_t size, void* stream) {
+    Segment* segment = nullptr;
+    auto it = expandable_segments_by_stream_.find(stream);
+    if (it != expandable_segments_by_stream_.end()) {
+        segment = it->second;
+    } else {
+        segment = create_expandable_segment(stream);
+        if (!segment) {
+            return nullptr;
+        }
+    }
+    
+    // Grow just enough that the free tail, if any, covers the request
+    Block* tail = get_tail_block(segment);
+    size_t available = (tail && !tail->in_use) ? tail->size : 0;
+    size_t grow = ((size - available + expandable_page_size_ - 1) / expandable_page_size_) * expandable_page_size_;
+    size_t old_size = segment->size;
+    
+    if (old_size + grow > segment->reserved_size || !map_segment_pages(segment, old_size + grow)) {
+        if (old_size == 0) {
+            // Never mapped, so there is no block to merge back
+            expandable_segments_by_stream_.erase(stream);
+            free_segment_memory(segment);
+            large_pool_.segment_count--;
+            segments_.erase(segment->ptr);
+        }
+        return nullptr;
+    }
+    stats_.device_malloc_calls++;
+    record_trace(TraceAction::SegmentMap, static_cast<char*>(segment->ptr) + old_size, grow, stream);
+    
+    if (available > 0) {
+        remove_free_block(tail);
+        tail->size += grow;
+        tail->allocated_size = tail->size;
+        insert_free_block(tail);
+        return tail;
+    }
+    
+    auto block = std::make_unique<Block>();
+    block->ptr = static_cast<char*>(segment->ptr) + old_size;
+    block->size = grow;
+    block->allocated_size = grow;
+    block->in_use = false;
+    block->pinned_host = false;
+    block->stream = stream;
+    block->pool = &large_pool_;
+    block->segment = segment;
+    block->prev = tail;
+    block->next = nullptr;
+    block->event_count = 0;
+    block->tag = nullptr;
+    if (tail) {
+        tail->next = block.get();
+    }
+    large_pool_.block_count++;
+    
+    Block* block_ptr = block.get();
+    insert_free_block(block_ptr);
+    blocks_.emplace(block_ptr->ptr, std::move(block));
+    return block_ptr;
+}
+
+MemoryAllocator::Block* MemoryAllocator::get_tail_block(Segment* segment) {
+    auto it = blocks_.find(segment->ptr);
+    if (it == blocks_.end()) {
+        return nullptr;
+    }
+    Block* block = it->second.get();
+    while (block->next) {
+        block = block->next;
+    }
+    return block;
+}
+
+bool MemoryAllocator::map_segment_pages(Segment* segment, size_t new_size) {
+    hipMemAllocationProp prop = {};
+    prop.type = hipMemAllocationTypePinned;
+    prop.location.type = hipMemLocationTypeDevice;
+    prop.location.id = context_->get_device_id();
+    
+    char* base = static_cast<char*>(segment->ptr);
+    size_t old_size = segment->size;
+    
+    // One physical allocation per page, so any page can be unmapped later
+    while (segment->size < new_size) {
+        hipMemGenericAllocationHandle_t handle;
+        if (hipMemCreate(&handle, expandable_page_size_, &prop, 0) != hipSuccess) {
+            unmap_segment_pages(segment, old_size);
+            return false;
+        }
+        if (hipMemMap(base + segment->size, expandable_page_size_, 0, handle, 0) != hipSuccess) {
+            hipMemRelease(handle);
+            unmap_segment_pages(segment, old_size);
+            return false;
+        }
+        segment->handles.push_back(handle);
+        segment->size += expandable_page_size_;
+    }
+    
+    hipMemAccessDesc access = {};
+    access.location = prop.location;
+    access.flags = hipMemAccessFlagsProtReadWrite;
+    if (hipMemSetAccess(base + old_size, new_size - old_size, &access, 1) != hipSuccess) {
+        unmap_segment_pages(segment, old_size);
+        return false;
+    }
+    return true;
+}
+
+void MemoryAllocator::unmap_segment_pages(Segment* segment, size_t new_size) {
+    if (new_size >= segment->size) {
+        return;
+    }
+    
+    // Unlike hipFree, unmapping does not wait for queued work, and free
+    // blocks may still be in use by kernels on the segment's stream. Blocks
+    // with record_stream uses only become free once their events complete,
+    // so the segment's own stream is the last user to wait for.
+    hipError_t result = segment->idle_event
+        ? hipEventSynchronize(static_cast<hipEvent_t>(segment->idle_event))
+        : hipStreamSynchronize(static_cast<hipStream_t>(segment->stream));
+    if (result != hipSuccess) {
+        std::cerr << "Warning: Failed to wait for segment before unmapping: " << hipGetErrorString(result) << std::endl;
+    }
+    
+    char* base = static_cast<char*>(segment->ptr);
+    hipMemUnmap(base + new_size, segment->size - new_size);
+    for (size_t page = new_size / expandable_page_size_; page < segment->handles.size(); ++page) {
+        hipMemRelease(static_cast<hipMemGenericAllocationHandle_t>(segment->handles[page]));
+    }
+    segment->handles.resize(new_size / expandable_page_size_);
+    segment->size = new_size;
+}
+
+size_t MemoryAllocator::trim_segment(Segment* segment) {
+    Block* tail = get_tail_block(segment);
+    if (!tail || tail->in_use) {
+        return 0;
+    }
+    if (!tail->prev) {
+        // Everything is free; give the whole range back
+        size_t size = segment->size;
+        release_segment(segment);
+        return size;
+    }
+    
+    // Unmap every whole page the free tail covers
+    size_t tail_offset = static_cast<char*>(tail->ptr) - static_cast<char*>(segment->ptr);
+    size_t keep = ((tail_offset + expandable_page_size_ - 1) / expandable_page_size_) * expandable_page_size_;
+    if (keep >= segment->size) {
+        return 0;
+    }
+    size_t freed_size = segment->size - keep;
+    
+    remove_free_block(tail);
+    if (keep == tail_offset) {
+        tail->prev->next = nullptr;
+        large_pool_.block_count--;
+        blocks_.erase(tail->ptr);
+    } else {
+        tail->size = keep - tail_offset;
+        tail->allocated_size = tail->size;
+        insert_free_block(tail);
+    }
+    
+    record_trace(TraceAction::SegmentUnmap, static_cast<char*>(segment->ptr) + keep, freed_size, segment->stream);
+    unmap_segment_pages(segment, keep);
+    stats_.device_free_calls++;
+    return freed_size;
+}
+
+// PinnedHostAllocator implementation
+PinnedHostAllocator::PinnedHostAllocator() : allocated_bytes_(0), cached_bytes_(0) {}
+
+PinnedHostAllocator::~PinnedHostAllocator() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (auto& entry : buffers_) {
+        Buffer* buffer = entry.second.get();
+        if (buffer->event) {
+            hipEventSynchronize(static_cast<hipEvent_t>(buffer->event));
+            hipEventDestroy(static_cast<hipEvent_t>(buffer->event));
+        }
+        hipError_t result = hipHostFree(buffer->ptr);
+        if (result != hipSuccess) {
+            std::cerr << "Warning: Failed to free pinned buffer: " << hipGetErrorString(result) << std::endl;
+        }
+    }
+    for (void* event : event_pool_) {
+        hipEventDestroy(static_cast<hipEvent_t>(event));
+    }
+    buffers_.clear();
+    free_buffers_.clear();
+    event_pool_.clear();
+}
+
+void* PinnedHostAllocator::allocate(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t rounded = round_size(size);
+    
+    // Reuse a cached buffer whose last transfer has completed
+    auto bin = free_buffers_.find(rounded);
+    if (bin != free_buffers_.end()) {
+        auto& candidates = bin->second;
+        for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+            Buffer* buffer = *it;
+            if (buffer->event) {
+                if (hipEventQuery(static_cast<hipEvent_t>(buffer->event)) != hipSuccess) {
+                    continue;
+                }
+                release_event(buffer->event);
+                buffer->event = nullptr;
+            }
+            candidates.erase(it);
+            buffer->in_use = true;
+            cached_bytes_ -= buffer->size;
+            allocated_bytes_ += buffer->size;
+            return buffer->ptr;
+        }
+    }
+    
+    void* ptr = nullptr;
+    hipError_t result = hipHostMalloc(&ptr, rounded, hipHostMallocDefault);
+    if (result != hipSuccess) {
+        // Pinned memory is a limited resource; drop the cache and retry once
+        release_cached_buffers();
+        result = hipHostMalloc(&ptr, rounded, hipHostMallocDefault);
+        if (result != hipSuccess) {
+            return nullptr;
+        }
+    }
+    
+    buffers_[ptr] = std::make_unique<Buffer>(Buffer{ptr, rounded, true, nullptr});
+    allocated_bytes_ += rounded;
+    return ptr;
+}
+
+void PinnedHostAllocator::deallocate(void* ptr, void* stream) {
+    if (!ptr) return;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = buffers_.find(ptr);
+    if (it == buffers_.end() || !it->second->in_use) {
+        std::cerr << "Warning: Attempting to free unknown or already freed pinned buffer" << std::endl;
+        return;
+    }
+    
+    Buffer* buffer = it->second.get();
+    void* event = acquire_event();
+    if (event && hipEventRecord(static_cast<hipEvent_t>(event), static_cast<hipStream_t>(stream)) == hipSuccess) {
+        buffer->event = event;
+    } else {
+        // Without an event the only safe ordering is a full wait
+        if (event) {
+            release_event(event);
+        }
+        hipStreamSynchronize(static_cast<hipStream_t>(stream));
+    }
+    
+    buffer->in_use = false;
+    allocated_bytes_ -= buffer->size;
+    cached_bytes_ += buffer->size;
+    free_buffers_[buffer->size].push_back(buffer);
+}
+
+void PinnedHostAllocator::empty_cache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_cached_buffers();
+}
+
+size_t PinnedHostAllocator::get_allocated_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocated_bytes_;
+}
+
+size_t PinnedHostAllocator::get_cached_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cached_bytes_;
+}
+
+size_t PinnedHostAllocator::round_size(size_t size) {
+    size_t rounded = kMinBufferSize;
+    while (rounded < size) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+void* PinnedHostAllocator::acquire_event() {
+    if (!event_pool_.empty()) {
+        void* event = event_pool_.back();
+        event_pool_.pop_back();
+        return event;
+    }
+    hipEvent_t event = nullptr;
+    if (hipEventCreateWithFlags(&event, hipEventDisableTiming) != hipSuccess) {
+        return nullptr;
+    }
+    return event;
+}
+
+void PinnedHostAllocator::release_event(void* event) {
+    event_pool_.push_back(event);
+}
+
+void PinnedHostAllocator::release_cached_buffers() {
+    for (auto& bin : free_buffers_) {
+        for (Buffer* buffer : bin.second) {
+            if (buffer->event) {
+                hipEventSynchronize(static_cast<hipEvent_t>(buffer->event));
+                release_event(buffer->event);
+            }
+            hipError_t result = hipHostFree(buffer->ptr);
+            if (result != hipSuccess) {
+                std::cerr << "Warning: Failed to free pinned buffer: " << hipGetErrorString(result) << std::endl;
+            }
+            cached_bytes_ -= buffer->size;
+            buffers_.erase(buffer->ptr);
+        }
+    }
+    free_buffers_.clear();
+}
+
+// MemoryManager implementation
+MemoryManager& MemoryManager::get_instance() {
+    static MemoryManager instance;
+    return instance;
+}
+
+std::shared_ptr<MemoryAllocator> MemoryManager::get_allocator(int device_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (device_id == -1) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    
+    auto it = allocators_.find(device_id);
+    if (it == allocators_.end()) {
+        auto context = DeviceManager::get_instance().get_context(device_id);
+        auto allocator = std::make_shared<MemoryAllocator>(context);
+        if (expandable_segments_) {
+            allocator->set_expandable_segments(true);
+        }
+        allocator->set_workspace_limit(workspace_limit_);
+        allocators_[device_id] = allocator;
+        if (device_id >= 0 && device_id < kMaxDevices) {
+            device_allocators_[device_id].store(allocator.get(), std::memory_order_release);
+        }
+        return allocator;
+    }
+    
+    return it->second;
+}
+
+std::shared_ptr<MemoryAllocator> MemoryManager::get_current_allocator() {
+    return get_allocator(DeviceManager::get_instance().get_current_device());
+}
+
+MemoryAllocator* MemoryManager::find_allocator(int device_id) {
+    if (device_id == -1) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    
+    // Allocators live as long as the manager, so the raw pointer stays valid
+    if (device_id >= 0 && device_id < kMaxDevices) {
+        MemoryAllocator* allocator = device_allocators_[device_id].load(std::memory_order_acquire);
+        if (allocator) {
+            return allocator;
+        }
+    }
+    return get_allocator(device_id).get();
+}
+
+MemoryManager::PointerShard& MemoryManager::pointer_shard_for(const void* ptr) {
+    return pointer_shards_[(reinterpret_cast<uintptr_t>(ptr) / get_memory_alignment()) % kPointerShardCount];
+}
+
+void* MemoryManager::allocate(size_t size, int device_id, const AllocationOptions& options) {
+    MemoryAllocator* allocator = find_allocator(device_id);
+    void* ptr = nullptr;
+    if (!options.stream) {
+        // Device memory is ordered on the thread's current stream, if any
+        AllocationOptions resolved = options;
+        resolved.stream = DeviceManager::get_instance().get_current_stream_handle(device_id);
+        ptr = allocator->allocate(size, resolved);
+    } else {
+        ptr = allocator->allocate(size, options);
+    }
+    if (ptr) {
+        PointerShard& shard = pointer_shard_for(ptr);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.owners[ptr] = allocator;
+    }
+    return ptr;
+}
+
+void MemoryManager::deallocate(void* ptr) {
+    if (!ptr) return;
+    
+    MemoryAllocator* allocator = nullptr;
+    {
+        PointerShard& shard = pointer_shard_for(ptr);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.owners.find(ptr);
+        if (it != shard.owners.end()) {
+            allocator = it->second;
+            shard.owners.erase(it);
+        }
+    }
+    if (allocator) {
+        allocator->deallocate(ptr);
+        return;
+    }
+    
+    // Not allocated through the manager; fall back to asking the runtime
+    int device_id = get_device_for_pointer(ptr);
+    if (device_id >= 0) {
+        find_allocator(device_id)->deallocate(ptr);
+    }
+}
+
+void MemoryManager::record_stream(void* ptr, void* stream) {
+    if (!ptr) return;
+    
+    MemoryAllocator* allocator = nullptr;
+    {
+        PointerShard& shard = pointer_shard_for(ptr);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.owners.find(ptr);
+        if (it != shard.owners.end()) {
+            allocator = it->second;
+        }
+    }
+    if (!allocator) {
+        int device_id = get_device_for_pointer(ptr);
+        if (device_id < 0) {
+            return;
+        }
+        allocator = find_allocator(device_id);
+    }
+    allocator->record_stream(ptr, stream);
+}
+
+bool MemoryManager::memcpy(void* dst, const void* src, size_t size, void* stream) {
+    // This is a simplified implementation
+    hipError_t result;
+    if (!stream) {
+        stream = DeviceManager::get_instance().get_current_stream_handle();
+    }
+    ScopedDeviceEvent timing(EventType::MEMORY_COPY, "memcpy", -1, stream, size);
+    
+    if (stream) {
+        result = hipMemcpyAsync(dst, src, size, hipMemcpyDefault, static_cast<hipStream_t>(stream));
+        if (result != hipSuccess) return false;
+        result = hipStreamSynchronize(static_cast<hipStream_t>(stream));
+    } else {
+        result = hipMemcpy(dst, src, size, hipMemcpyDefault);
+    }
+    
+    return result == hipSuccess;
+}
+
+bool MemoryManager::memset(void* ptr, int value, size_t size, void* stream) {
+    hipError_t result;
+    if (!stream) {
+        stream = DeviceManager::get_instance().get_current_stream_handle();
+    }
+    ScopedDeviceEvent timing(EventType::MEMORY_SET, "memset", -1, stream, size);
+    
+    if (stream) {
+        result = hipMemsetAsync(ptr, value, size, static_cast<hipStream_t>(stream));
+        if (result != hipSuccess) return false;
+        result = hipStreamSynchronize(static_cast<hipStream_t>(stream));
+    } else {
+        result = hipMemset(ptr, value, size);
+    }
+    
+    return result == hipSuccess;
+}
+
+std::shared_ptr<Event> MemoryManager::memcpy_async(void* dst, const void* src, size_t size, Stream& stream) {
+    return enqueue_memcpy(dst, src, size, stream);
+}
+
+std::shared_ptr<Event> MemoryManager::memset_async(void* ptr, int value, size_t size, Stream& stream) {
+    return enqueue_memset(ptr, value, size, stream);
+}
+
+std::shared_ptr<Event> MemoryManager::peer_memcpy_async(void* dst, int dst_device, const void* src, int src_device,
+                                                        size_t size, Stream& stream) {
+    int stream_device = stream.get_context()->get_device_id();
+    if (stream_device != dst_device && stream_device != src_device) {
+        throw std::invalid_argument("Peer copy stream must belong to the source or destination device");
+    }
+    if (dst_device != src_device) {
+        DeviceManager& devices = DeviceManager::get_instance();
+        devices.enable_peer_access(dst_device, src_device);
+        devices.enable_peer_access(src_device, dst_device);
+    }
+    
+    ScopedDeviceEvent timing(EventType::MEMORY_COPY, "peer_memcpy_async", stream_device,
+                             stream.get_native_handle(), size);
+    hipError_t result = hipMemcpyPeerAsync(dst, dst_device, src, src_device, size,
+                                           static_cast<hipStream_t>(stream.get_native_handle()));
+    if (result != hipSuccess) {
+        return nullptr;
+    }
+    return record_completion_event(stream);
+}
+
+void* MemoryManager::stage_to_device(const void* host_ptr, size_t size, void* stream, int device_id) {
+    if (!host_ptr || size == 0) {
+        return nullptr;
+    }
+    if (!stream) {
+        stream = DeviceManager::get_instance().get_current_stream_handle(device_id);
+    }
+    
+    AllocationOptions options = {};
+    options.stream = stream;
+    void* device_ptr = allocate(size, device_id, options);
+    if (!device_ptr) {
+        return nullptr;
+    }
+    
+    hipStream_t hip_stream = static_cast<hipStream_t>(stream);
+    
+    // Page-locked sources can be DMA'd directly; the caller keeps them alive
+    // until the stream passes the copy
+    if (is_pinned_host_pointer(host_ptr)) {
+        if (hipMemcpyAsync(device_ptr, host_ptr, size, hipMemcpyHostToDevice, hip_stream) != hipSuccess) {
+            deallocate(device_ptr);
+            return nullptr;
+        }
+        return device_ptr;
+    }
+    
+    // Rotate through staging buffers: before refilling one, wait only for the
+    // DMA that last read from it, so the host copy of chunk N overlaps the
+    // transfers of the chunks before it
+    const char* src = static_cast<const char*>(host_ptr);
+    char* dst = static_cast<char*>(device_ptr);
+    const size_t chunk_size = std::min(size, kStagingChunkSize);
+    std::array<void*, kStagingBufferCount> buffers{};
+    std::array<hipEvent_t, kStagingBufferCount> events{};
+    bool success = true;
+    
+    size_t slot = 0;
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        size_t bytes = std::min(chunk_size, size - offset);
+        
+        if (!buffers[slot]) {
+            buffers[slot] = pinned_allocator_.allocate(chunk_size);
+            if (!buffers[slot] || hipEventCreateWithFlags(&events[slot], hipEventDisableTiming) != hipSuccess) {
+                success = false;
+                break;
+            }
+        } else if (hipEventSynchronize(events[slot]) != hipSuccess) {
+            success = false;
+            break;
+        }
+        
+        std::memcpy(buffers[slot], src + offset, bytes);
+        if (hipMemcpyAsync(dst + offset, buffers[slot], bytes, hipMemcpyHostToDevice, hip_stream) != hipSuccess ||
+            hipEventRecord(events[slot], hip_stream) != hipSuccess) {
+            success = false;
+            break;
+        }
+        slot = (slot + 1) % kStagingBufferCount;
+    }
+    
+    // Buffers go back to the cache behind the queued copies
+    for (size_t i = 0; i < kStagingBufferCount; ++i) {
+        if (buffers[i]) {
+            pinned_allocator_.deallocate(buffers[i], stream);
+        }
+        if (events[i]) {
+            hipEventDestroy(events[i]);
+        }
+    }
+    
+    if (!success) {
+        hipStreamSynchronize(hip_stream);
+        deallocate(device_ptr);
+        return nullptr;
+    }
+    return device_ptr;
+}
+
+PinnedHostAllocator& MemoryManager::get_pinned_allocator() {
+    return pinned_allocator_;
+}
+
+Workspace MemoryManager::acquire_workspace(size_t size, int device_id, void* stream) {
+    if (!stream) {
+        stream = DeviceManager::get_instance().get_current_stream_handle(device_id);
+    }
+    return find_allocator(device_id)->acquire_workspace(size, stream);
+}
+
+void MemoryManager::set_workspace_limit(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    workspace_limit_ = limit;
+    for (auto& entry : allocators_) {
+        entry.second->set_workspace_limit(limit);
+    }
+}
+
+size_t MemoryManager::get_workspace_limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return workspace_limit_;
+}
+
+void MemoryManager::set_expandable_segments(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    expandable_segments_ = enabled;
+    for (auto& entry : allocators_) {
+        entry.second->set_expandable_segments(enabled);
+    }
+}
+
+void MemoryManager::empty_cache(int device_id) {
+    auto allocator = get_allocator(device_id);
+    allocator->empty_cache();
+}
+
+MemoryStats MemoryManager::get_stats(int device_id) const {
+    auto allocator = const_cast<MemoryManager*>(this)->get_allocator(device_id);
+    return allocator->get_stats();
+}
+
+bool MemoryManager::find_stats(int device_id, MemoryStats& stats) const {
+    if (device_id < 0 || device_id >= kMaxDevices) {
+        return false;
+    }
+    const MemoryAllocator* allocator = device_allocators_[device_id].load(std::memory_order_acquire);
+    if (!allocator) {
+        return false;
+    }
+    stats = allocator->get_stats();
+    return true;
+}
+
+MemorySnapshot MemoryManager::snapshot(int device_id) const {
+    auto allocator = const_cast<MemoryManager*>(this)->get_allocator(device_id);
+    return allocator->snapshot();
+}
+
+uint64_t MemoryManager::read_trace(int device_id, uint64_t cursor, std::vector<TraceEntry>& entries) const {
+    if (device_id < 0 || device_id >= kMaxDevices) {
+        return cursor;
+    }
+    const MemoryAllocator* allocator = device_allocators_[device_id].load(std::memory_order_acquire);
+    return allocator ? allocator->read_trace(cursor, entries) : cursor;
 }
 
 uint64_t MemoryManager::get_total_memory(int device_id) const {
@@ -457,12 +2071,93 @@ uint64_t MemoryManager::get_used_memory(int device_id) const {
 }
 
 // Utility functions
+const char* trace_action_name(TraceAction action) {
+    switch (action) {
+        case TraceAction::Alloc: return "alloc";
+        case TraceAction::Free: return "free";
+        case TraceAction::Split: return "split";
+        case TraceAction::Merge: return "merge";
+        case TraceAction::SegmentAlloc: return "segment_alloc";
+        case TraceAction::SegmentFree: return "segment_free";
+        case TraceAction::SegmentMap: return "segment_map";
+        case TraceAction::SegmentUnmap: return "segment_unmap";
+        case TraceAction::Oom: return "oom";
+    }
+    return "unknown";
+}
+
+std::string MemorySnapshot::to_json() const {
+    std::ostringstream out;
+    auto address = [](const void* ptr) { return reinterpret_cast<uintptr_t>(ptr); };
+    
+    out << "{\"device\": " << device_id << ", \"stats\": {"
+        << "\"allocated_bytes\": " << stats.allocated_bytes
+        << ", \"allocated_blocks\": " << stats.allocated_blocks
+        << ", \"cached_bytes\": " << stats.cached_bytes
+        << ", \"cached_blocks\": " << stats.cached_blocks
+        << ", \"max_allocated_bytes\": " << stats.max_allocated_bytes
+        << ", \"total_allocations\": " << stats.total_allocations
+        << ", \"total_frees\": " << stats.total_frees
+        << ", \"device_malloc_calls\": " << stats.device_malloc_calls
+        << ", \"device_free_calls\": " << stats.device_free_calls
+        << ", \"workspace_bytes\": " << stats.workspace_bytes
+        << ", \"workspace_high_water_mark\": " << stats.workspace_high_water_mark << "}";
+    
+    out << ", \"segments\": [";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const SegmentSnapshot& segment = segments[i];
+        out << (i ? ", " : "") << "{\"address\": " << address(segment.ptr)
+            << ", \"size\": " << segment.size
+            << ", \"stream\": " << address(segment.stream)
+            << ", \"pool\": \"" << segment.pool << "\""
+            << ", \"expandable\": " << (segment.expandable ? "true" : "false")
+            << ", \"blocks\": [";
+        for (size_t j = 0; j < segment.blocks.size(); ++j) {
+            const BlockSnapshot& block = segment.blocks[j];
+            out << (j ? ", " : "") << "{\"address\": " << address(block.ptr)
+                << ", \"size\": " << block.size
+                << ", \"state\": \"" << block.state << "\""
+                << ", \"allocation_id\": " << block.allocation_id
+                << ", \"tag\": ";
+            write_json_string(out, block.tag);
+            out << "}";
+        }
+        out << "]}";
+    }
+    
+    out << "], \"trace\": [";
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const TraceEntry& entry = trace[i];
+        out << (i ? ", " : "") << "{\"action\": \"" << trace_action_name(entry.action) << "\""
+            << ", \"address\": " << address(entry.ptr)
+            << ", \"size\": " << entry.size
+            << ", \"stream\": " << address(entry.stream)
+            << ", \"timestamp_ns\": " << entry.timestamp_ns
+            << ", \"tag\": ";
+        write_json_string(out, entry.tag);
+        out << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
 bool is_device_pointer(const void* ptr) {
     hipPointerAttribute_t attributes;
     hipError_t result = hipPointerGetAttributes(&attributes, ptr);
     return result == hipSuccess && attributes.memoryType == hipMemoryTypeDevice;
 }
 
+bool is_pinned_host_pointer(const void* ptr) {
+    hipPointerAttribute_t attributes;
+    hipError_t result = hipPointerGetAttributes(&attributes, ptr);
+    if (result != hipSuccess) {
+        // Pageable memory is unknown to the runtime; clear the sticky error
+        hipGetLastError();
+        return false;
+    }
+    return attributes.memoryType == hipMemoryTypeHost;
+}
+
 int get_device_for_pointer(const void* ptr) {
     hipPointerAttribute_t attributes;
     hipError_t result = hipPointerGetAttributes(&attributes, ptr);
@@ -0,0 +1,44 @@
+#ifndef RDNA_NORMALIZATION_H
+#define RDNA_NORMALIZATION_H
+
+#include "rdna/kernels.h"
+
+namespace rdna {
+
+/**
+ * @brief Row-wise softmax and normalization kernels
+ *
+ * Operands must be dense row-major. Rows short enough to sit in registers
+ * (up to wavefront_size * 32 elements) get one wave each and are read once;
+ * longer rows get a whole block and a single-pass online reduction.
+ * wavefront_size selects the shuffle width (32 on RDNA, 64 on GCN/CDNA).
+ * Throws std::invalid_argument on mismatched descriptors, returns false if
+ * a launch fails.
+ */
+
+// Softmax over dim (negative counts from the end)
+bool launch_softmax(const TensorDesc& input, const void* input_data,
+                    const TensorDesc& output, void* output_data,
+                    int dim, int wavefront_size, void* stream);
+
+// LayerNorm (rms == false) or RMSNorm over the last dimension. weight and
+// bias have that dimension's length and the input's type and may be nullptr;
+// mean (LayerNorm only) and rstd receive one fp32 value per row if given.
+bool launch_norm(const TensorDesc& input, const void* input_data,
+                 const void* weight, const void* bias,
+                 const TensorDesc& output, void* output_data,
+                 float* mean, float* rstd, float epsilon, bool rms,
+                 int wavefront_size, void* stream);
+
+// Gradients from the statistics saved by launch_norm. grad_weight and
+// grad_bias are optional and reduced over rows with fp32 partial sums in
+// the stream's workspace arena on device_id.
+bool launch_norm_backward(const TensorDesc& grad_output, const void* grad_output_data,
+                          const TensorDesc& input, const void* input_data,
+                          const float* mean, const float* rstd, const void* weight,
+                          void* grad_input_data, void* grad_weight, void* grad_bias,
+                          bool rms, int wavefront_size, int device_id, void* stream);
+
+} // namespace rdna
+
+#endif // RDNA_NORMALIZATION_H
@@ -1,20 +1,600 @@
 #include "rdna/profiler.h"
+#include "rdna/device.h"
+#include "rdna/memory.h"
+#include <hip/hip_runtime.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
 #include <iomanip>
+#include <limits>
+#include <set>
 #include <sstream>
 #include <iostream>
+#include <thread>
 
 namespace rdna {
 
+namespace {
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+size_t ring_capacity_for(size_t max_events) {
+    size_t capacity = 64;
+    while (capacity < max_events) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+PerformanceStats empty_stats() {
+    return PerformanceStats{0, 0, std::numeric_limits<double>::max(), 0, 0, 0, 0, 0, 0, 0, 0, 0};
+}
+
+PerformanceStats stats_from(const LatencyHistogram& latency) {
+    PerformanceStats stats = empty_stats();
+    if (latency.count == 0) {
+        return stats;
+    }
+    stats.call_count = latency.count;
+    stats.total_time_ms = latency.sum_ns / 1e6;
+    stats.total_bytes_processed = latency.bytes;
+    stats.min_time_ms = latency.min_ns / 1e6;
+    stats.max_time_ms = latency.max_ns / 1e6;
+    stats.average_time_ms = stats.total_time_ms / stats.call_count;
+    if (stats.total_time_ms > 0) {
+        stats.throughput_gbps = (stats.total_bytes_processed * 8.0) / (stats.total_time_ms * 1e6); // Gbps
+        stats.bandwidth_gbs = stats.total_bytes_processed / (stats.total_time_ms * 1e6);
+    }
+    stats.p50_ms = latency.percentile_ns(0.5) / 1e6;
+    stats.p90_ms = latency.percentile_ns(0.9) / 1e6;
+    stats.p99_ms = latency.percentile_ns(0.99) / 1e6;
+    stats.p999_ms = latency.percentile_ns(0.999) / 1e6;
+    return stats;
+}
+
+uint64_t histogram_key(EventType type, uint32_t name_id) {
+    return (static_cast<uint64_t>(type) << 32) | name_id;
+}
+
+// How often the collector re-measures each device's clock against the host
+constexpr uint64_t kClockAnchorIntervalNs = 1000000000;
+
+} // namespace
+
+/**
+ * Device timing state. Events come from per-device pools and go back once
+ * the collector has resolved them. Every pair is placed on the host clock
+ * relative to the device's anchor: an event recorded on an otherwise idle
+ * stream and synchronized, taken to have fired halfway between the host
+ * timestamps around it.
+ */
+struct PerformanceProfiler::DeviceTiming {
+    struct Pending {
+        hipEvent_t start;
+        hipEvent_t end;
+        PerformanceEvent event;
+    };
+    
+    struct Clock {
+        hipStream_t stream = nullptr;
+        hipEvent_t anchor = nullptr;
+        uint64_t anchor_ns = 0;
+        uint64_t refreshed_ns = 0;
+    };
+    
+    std::mutex pool_mutex;
+    std::unordered_map<int, std::vector<hipEvent_t>> pools;
+    
+    std::mutex queue_mutex;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    std::deque<Pending> queue;
+    size_t outstanding = 0;  // Ended but not yet recorded
+    bool stop = false;
+    std::once_flag started;
+    std::thread collector;
+    
+    std::unordered_map<int, Clock> clocks;  // Collector thread only
+    
+    hipEvent_t acquire(int device_id) {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            auto& pool = pools[device_id];
+            if (!pool.empty()) {
+                hipEvent_t event = pool.back();
+                pool.pop_back();
+                return event;
+            }
+        }
+        
+        // Events belong to the device current at creation
+        int previous = 0;
+        hipGetDevice(&previous);
+        if (previous != device_id && hipSetDevice(device_id) != hipSuccess) {
+            return nullptr;
+        }
+        hipEvent_t event = nullptr;
+        if (hipEventCreate(&event) != hipSuccess) {
+            event = nullptr;
+        }
+        if (previous != device_id) {
+            hipSetDevice(previous);
+        }
+        return event;
+    }
+    
+    void release(int device_id, hipEvent_t event) {
+        if (event) {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            pools[device_id].push_back(event);
+        }
+    }
+    
+    bool anchor(int device_id, Clock& clock) {
+        if (hipSetDevice(device_id) != hipSuccess) {
+            return false;
+        }
+        if (!clock.stream && hipStreamCreateWithFlags(&clock.stream, hipStreamNonBlocking) != hipSuccess) {
+            clock.stream = nullptr;
+            return false;
+        }
+        if (!clock.anchor && hipEventCreate(&clock.anchor) != hipSuccess) {
+            clock.anchor = nullptr;
+            return false;
+        }
+        uint64_t before = now_ns();
+        if (hipEventRecord(clock.anchor, clock.stream) != hipSuccess ||
+            hipEventSynchronize(clock.anchor) != hipSuccess) {
+            return false;
+        }
+        uint64_t after = now_ns();
+        clock.anchor_ns = before + (after - before) / 2;
+        clock.refreshed_ns = after;
+        return true;
+    }
+    
+    // Fills in the GPU start and end; false if the pair cannot be timed
+    bool resolve(Pending& pending) {
+        float duration_ms = 0.0f;
+        if (hipEventElapsedTime(&duration_ms, pending.start, pending.end) != hipSuccess) {
+            return false;
+        }
+        
+        const int device_id = pending.event.device_id;
+        Clock& clock = clocks[device_id];
+        if ((!clock.anchor || now_ns() - clock.refreshed_ns > kClockAnchorIntervalNs) &&
+            !anchor(device_id, clock) && !clock.anchor_ns) {
+            return false;
+        }
+        float offset_ms = 0.0f;  // Negative for work that started before the anchor
+        if (hipEventElapsedTime(&offset_ms, clock.anchor, pending.start) != hipSuccess) {
+            return false;
+        }
+        
+        int64_t start_ns = static_cast<int64_t>(clock.anchor_ns) + static_cast<int64_t>(offset_ms * 1e6);
+        pending.event.start_ns = static_cast<uint64_t>(std::max<int64_t>(start_ns, 0));
+        pending.event.end_ns = pending.event.start_ns + static_cast<uint64_t>(duration_ms * 1e6);
+        return true;
+    }
+    
+    void run(PerformanceProfiler& profiler) {
+        std::vector<Pending> pending;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                auto ready = [this]() { return stop || !queue.empty(); };
+                if (pending.empty()) {
+                    work_cv.wait(lock, ready);
+                } else {
+                    work_cv.wait_for(lock, std::chrono::microseconds(200), ready);
+                }
+                if (stop) {
+                    return;  // The runtime may be going away; leave events alone
+                }
+                for (Pending& item : queue) {
+                    pending.push_back(item);
+                }
+                queue.clear();
+            }
+            
+            size_t done = 0;
+            size_t kept = 0;
+            for (Pending& item : pending) {
+                hipError_t status = hipEventQuery(item.end);
+                if (status == hipErrorNotReady) {
+                    pending[kept++] = item;
+                    continue;
+                }
+                if (status == hipSuccess && resolve(item)) {
+                    profiler.append(item.event);
+                }
+                release(item.event.device_id, item.start);
+                release(item.event.device_id, item.end);
+                ++done;
+            }
+            pending.resize(kept);
+            
+            if (done) {
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                outstanding -= done;
+                if (outstanding == 0) {
+                    idle_cv.notify_all();
+                }
+            }
+        }
+    }
+};
+
+namespace {
+
+void write_json_string(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                        << std::dec << std::setfill(' ');
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+const char* event_category(EventType type) {
+    switch (type) {
+        case EventType::KERNEL_LAUNCH: return "kernel";
+        case EventType::MEMORY_ALLOCATION: return "alloc";
+        case EventType::MEMORY_COPY: return "memcpy";
+        case EventType::MEMORY_SET: return "memset";
+        case EventType::STREAM_SYNCHRONIZE:
+        case EventType::DEVICE_SYNCHRONIZE: return "sync";
+        case EventType::FRAMEWORK_OP: return "op";
+    }
+    return "other";
+}
+
+// Chrome trace process ids; each device gets kDevicePid + device_id
+constexpr int kHostPid = 0;
+constexpr int kFrameworkPid = 1;
+constexpr int kDevicePid = 100;
+constexpr int kAllocatorTid = 0;  // Stream lanes count from 1
+
+} // namespace
+
+/**
+ * Timeline writer. Every interval it takes the records past its ring
+ * cursors and the allocator trace past its per-device cursors, orders
+ * them by start time and appends them to the file, announcing each lane
+ * with metadata the first time it appears. Device-timed records can land
+ * a flush late, which trace viewers do not mind.
+ */
+struct PerformanceProfiler::TraceWriter {
+    std::ofstream out;
+    std::string path;
+    std::chrono::milliseconds interval{100};
+    uint64_t origin_ns = 0;
+    
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+    std::thread thread;
+    
+    // Writer thread only
+    std::vector<uint64_t> ring_cursors;
+    std::vector<uint64_t> allocator_cursors;
+    std::vector<int64_t> allocated_bytes;  // Net of allocator events since the trace started
+    std::unordered_map<uint32_t, std::string> names;
+    std::set<std::pair<int, int>> lanes;
+    std::unordered_map<int, std::unordered_map<void*, int>> stream_lanes;
+    uint64_t dropped = 0;
+    
+    double micros(uint64_t ns) const {
+        return (static_cast<int64_t>(ns) - static_cast<int64_t>(origin_ns)) / 1000.0;
+    }
+    
+    const std::string& name_of(const PerformanceProfiler& profiler, uint32_t id) {
+        auto it = names.find(id);
+        if (it == names.end()) {
+            it = names.emplace(id, profiler.get_name(id)).first;
+        }
+        return it->second;
+    }
+    
+    void announce(std::ostream& batch, int pid, int tid, const std::string& process, const std::string& thread) {
+        if (lanes.insert({pid, -1}).second) {  // tid -1 marks the process as named
+            batch << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":";
+            write_json_string(batch, process);
+            batch << "}},\n{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << pid
+                  << ",\"args\":{\"sort_index\":" << pid << "}},\n";
+        }
+        if (lanes.insert({pid, tid}).second) {
+            batch << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+                  << ",\"args\":{\"name\":";
+            write_json_string(batch, thread);
+            batch << "}},\n";
+        }
+    }
+    
+    int stream_lane(int device_id, void* stream) {
+        auto& lanes_for_device = stream_lanes[device_id];
+        auto it = lanes_for_device.find(stream);
+        if (it == lanes_for_device.end()) {
+            it = lanes_for_device.emplace(stream, static_cast<int>(lanes_for_device.size()) + 1).first;
+        }
+        return it->second;
+    }
+    
+    void write_event(std::ostream& batch, const PerformanceProfiler& profiler, const PerformanceEvent& event) {
+        int pid, tid;
+        if (event.device_timed) {
+            pid = kDevicePid + event.device_id;
+            tid = stream_lane(event.device_id, event.stream);
+            std::ostringstream lane;
+            if (event.stream) {
+                lane << "Stream " << event.stream;
+            } else {
+                lane << "Default stream";
+            }
+            announce(batch, pid, tid, "GPU " + std::to_string(event.device_id), lane.str());
+        } else if (event.type == EventType::FRAMEWORK_OP) {
+            pid = kFrameworkPid;
+            tid = static_cast<int>(event.thread_id);
+            announce(batch, pid, tid, "Framework ops", "Thread " + std::to_string(event.thread_id));
+        } else {
+            pid = kHostPid;
+            tid = static_cast<int>(event.thread_id);
+            announce(batch, pid, tid, "Host", "Thread " + std::to_string(event.thread_id));
+        }
+        
+        batch << "{\"name\":";
+        write_json_string(batch, name_of(profiler, event.name_id));
+        batch << ",\"cat\":\"" << event_category(event.type) << "\",\"ph\":\"X\",\"ts\":" << micros(event.start_ns)
+              << ",\"dur\":" << (event.end_ns - event.start_ns) / 1000.0
+              << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"bytes\":" << event.bytes_processed;
+        if (event.info_id) {
+            batch << ",\"info\":";
+            write_json_string(batch, name_of(profiler, event.info_id));
+        }
+        batch << "}},\n";
+    }
+    
+    void write_allocator_event(std::ostream& batch, int device_id, const TraceEntry& entry) {
+        const int pid = kDevicePid + device_id;
+        announce(batch, pid, kAllocatorTid, "GPU " + std::to_string(device_id), "Allocator");
+        
+        batch << "{\"name\":\"" << trace_action_name(entry.action) << "\",\"cat\":\"allocator\",\"ph\":\"i\",\"s\":\"t\""
+              << ",\"ts\":" << micros(entry.timestamp_ns) << ",\"pid\":" << pid << ",\"tid\":" << kAllocatorTid
+              << ",\"args\":{\"size\":" << entry.size << ",\"ptr\":\"" << entry.ptr << "\"";
+        if (entry.tag) {
+            batch << ",\"tag\":";
+            write_json_string(batch, entry.tag);
+        }
+        batch << "}},\n";
+        
+        if (entry.action == TraceAction::Alloc || entry.action == TraceAction::Free) {
+            int64_t& bytes = allocated_bytes[device_id];
+            bytes += entry.action == TraceAction::Alloc ? static_cast<int64_t>(entry.size)
+                                                        : -static_cast<int64_t>(entry.size);
+            batch << "{\"name\":\"allocated_bytes\",\"ph\":\"C\",\"ts\":" << micros(entry.timestamp_ns)
+                  << ",\"pid\":" << pid << ",\"args\":{\"delta_since_trace_start\":" << bytes << "}},\n";
+        }
+    }
+    
+    void drain(const PerformanceProfiler& profiler) {
+        std::vector<PerformanceEvent> events;
+        profiler.for_each_event([&](const PerformanceEvent& event) { events.push_back(event); },
+                                &ring_cursors, &dropped);
+        std::sort(events.begin(), events.end(), [](const PerformanceEvent& a, const PerformanceEvent& b) {
+            return a.start_ns < b.start_ns;
+        });
+        
+        std::ostringstream batch;
+        batch << std::fixed << std::setprecision(3);
+        for (const PerformanceEvent& event : events) {
+            write_event(batch, profiler, event);
+        }
+        
+        std::vector<TraceEntry> entries;
+        for (size_t device_id = 0; device_id < allocator_cursors.size(); ++device_id) {
+            entries.clear();
+            allocator_cursors[device_id] = MemoryManager::get_instance().read_trace(
+                static_cast<int>(device_id), allocator_cursors[device_id], entries);
+            for (const TraceEntry& entry : entries) {
+                write_allocator_event(batch, static_cast<int>(device_id), entry);
+            }
+        }
+        
+        out << batch.str();
+        out.flush();
+    }
+    
+    void run(const PerformanceProfiler& profiler) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stop) {
+            cv.wait_for(lock, interval, [this]() { return stop; });
+            lock.unlock();
+            drain(profiler);
+            lock.lock();
+        }
+    }
+};
+
 // PerformanceProfiler implementation
 PerformanceProfiler& PerformanceProfiler::get_instance() {
     static PerformanceProfiler instance;
     return instance;
 }
 
+// LatencyHistogram implementation
+size_t LatencyHistogram::bucket_index(uint64_t value_ns) {
+    constexpr uint64_t sub_buckets = uint64_t(1) << kSubBucketBits;
+    if (value_ns < sub_buckets) {
+        return static_cast<size_t>(value_ns);
+    }
+    int exponent = 63 - __builtin_clzll(value_ns);
+    if (exponent >= kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    int shift = exponent - kSubBucketBits;
+    return (static_cast<size_t>(shift + 1) << kSubBucketBits) +
+           static_cast<size_t>((value_ns >> shift) & (sub_buckets - 1));
+}
+
+uint64_t LatencyHistogram::bucket_value(size_t index) {
+    constexpr uint64_t sub_buckets = uint64_t(1) << kSubBucketBits;
+    if (index < sub_buckets) {
+        return index;
+    }
+    int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    uint64_t lower = (sub_buckets + (index & (sub_buckets - 1))) << shift;
+    return lower + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (counts.empty()) {
+        counts.assign(kBucketCount, 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    min_ns = count == 0 ? other.min_ns : std::min(min_ns, other.min_ns);
+    max_ns = std::max(max_ns, other.max_ns);
+    count += other.count;
+    sum_ns += other.sum_ns;
+    bytes += other.bytes;
+}
+
+uint64_t LatencyHistogram::percentile_ns(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Bucket totals rather than count: a snapshot taken mid-record may
+    // have one without the other
+    uint64_t total = 0;
+    for (uint64_t c : counts) {
+        total += c;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::clamp(bucket_value(i), min_ns, max_ns);
+        }
+    }
+    return max_ns;
+}
+
+// One recording thread adds, readers copy out; counters are atomics so a
+// read mid-record is merely a sample behind
+struct PerformanceProfiler::OpHistogram {
+    std::atomic<uint64_t> counts[LatencyHistogram::kBucketCount]{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum_ns{0};
+    std::atomic<uint64_t> min_ns{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> bytes{0};
+    
+    void record(uint64_t value_ns, uint64_t event_bytes) {
+        counts[LatencyHistogram::bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(value_ns, std::memory_order_relaxed);
+        bytes.fetch_add(event_bytes, std::memory_order_relaxed);
+        if (value_ns < min_ns.load(std::memory_order_relaxed)) {
+            min_ns.store(value_ns, std::memory_order_relaxed);
+        }
+        if (value_ns > max_ns.load(std::memory_order_relaxed)) {
+            max_ns.store(value_ns, std::memory_order_relaxed);
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    void reset() {
+        for (auto& c : counts) {
+            c.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        sum_ns.store(0, std::memory_order_relaxed);
+        min_ns.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        max_ns.store(0, std::memory_order_relaxed);
+        bytes.store(0, std::memory_order_relaxed);
+    }
+    
+    void read(LatencyHistogram& out) const {
+        out.count = count.load(std::memory_order_relaxed);
+        if (out.count == 0) {
+            return;
+        }
+        out.counts.resize(LatencyHistogram::kBucketCount);
+        for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+            out.counts[i] = counts[i].load(std::memory_order_relaxed);
+        }
+        out.sum_ns = sum_ns.load(std::memory_order_relaxed);
+        out.min_ns = min_ns.load(std::memory_order_relaxed);
+        out.max_ns = max_ns.load(std::memory_order_relaxed);
+        out.bytes = bytes.load(std::memory_order_relaxed);
+    }
+};
+
+PerformanceProfiler::EventRing::EventRing(size_t capacity, uint32_t thread_id)
+    : slots(std::make_unique<EventSlot[]>(capacity)), mask(capacity - 1), thread_id(thread_id) {}
+
+PerformanceProfiler::EventRing::~EventRing() = default;
+
+PerformanceProfiler::PerformanceProfiler()
+    : timing_enabled_(config_.enable_timing),
+      memory_tracking_enabled_(config_.enable_memory_tracking),
+      kernel_tracking_enabled_(config_.enable_kernel_tracking),
+      device_timing_enabled_(config_.enable_device_timing),
+      ring_capacity_(ring_capacity_for(config_.max_events)),
+      device_timing_(std::make_unique<DeviceTiming>()) {
+    names_.emplace_back();
+    name_ids_.emplace(std::string(), 0);
+}
+
+PerformanceProfiler::~PerformanceProfiler() {
+    stop_metrics_server();
+    stop_trace();
+    {
+        std::lock_guard<std::mutex> lock(device_timing_->queue_mutex);
+        device_timing_->stop = true;
+    }
+    device_timing_->work_cv.notify_all();
+    device_timing_->idle_cv.notify_all();
+    if (device_timing_->collector.joinable()) {
+        device_timing_->collector.join();
+    }
+}
+
 void PerformanceProfiler::set_config(const ProfilerConfig& config) {
     std::lock_guard<std::mutex> lock(mutex_);
     config_ = config;
+    timing_enabled_.store(config.enable_timing, std::memory_order_relaxed);
+    memory_tracking_enabled_.store(config.enable_memory_tracking, std::memory_order_relaxed);
+    kernel_tracking_enabled_.store(config.enable_kernel_tracking, std::memory_order_relaxed);
+    device_timing_enabled_.store(config.enable_device_timing, std::memory_order_relaxed);
+    ring_capacity_.store(ring_capacity_for(config.max_events), std::memory_order_relaxed);  // New rings only
 }
 
 ProfilerConfig PerformanceProfiler::get_config() const {
@@ -22,147 +602,385 @@ ProfilerConfig PerformanceProfiler::get_config() const {
     return config_;
 }
 
-void PerformanceProfiler::start_event(EventType type, const std::string& name, 
-                                     size_t bytes, const std::string& info) {
-    if (!config_.enable_timing) return;
+uint32_t PerformanceProfiler::intern(const std::string& name) {
+    thread_local std::unordered_map<std::string, uint32_t> cache;
+    auto cached = cache.find(name);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
     
-    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(names_mutex_);
+        auto it = name_ids_.find(name);
+        if (it == name_ids_.end()) {
+            it = name_ids_.emplace(name, static_cast<uint32_t>(names_.size())).first;
+            names_.push_back(name);
+        }
+        id = it->second;
+    }
+    cache.emplace(name, id);
+    return id;
+}
+
+std::string PerformanceProfiler::get_name(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(names_mutex_);
+    return id < names_.size() ? names_[id] : std::string();
+}
+
+PerformanceProfiler::EventRing* PerformanceProfiler::thread_ring() {
+    // Hands the ring back when the thread exits so a later thread reuses it
+    struct Owner {
+        EventRing* ring = nullptr;
+        ~Owner() {
+            if (ring) {
+                PerformanceProfiler::get_instance().release_ring(ring);
+            }
+        }
+    };
+    thread_local Owner owner;
+    if (owner.ring) {
+        return owner.ring;
+    }
+    
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    const size_t capacity = ring_capacity_.load(std::memory_order_relaxed);
+    for (auto& ring : rings_) {
+        if (!ring->owned.load(std::memory_order_relaxed) && ring->mask + 1 == capacity) {
+            ring->owned.store(true, std::memory_order_relaxed);
+            owner.ring = ring.get();
+            return owner.ring;
+        }
+    }
+    rings_.push_back(std::make_unique<EventRing>(capacity, static_cast<uint32_t>(rings_.size())));
+    owner.ring = rings_.back().get();
+    return owner.ring;
+}
+
+void PerformanceProfiler::release_ring(EventRing* ring) {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    ring->owned.store(false, std::memory_order_relaxed);
+}
+
+void PerformanceProfiler::append(const PerformanceEvent& event) {
+    EventRing* ring = thread_ring();
+    uint64_t index = ring->head.load(std::memory_order_relaxed);
+    EventSlot& slot = ring->slots[index & ring->mask];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.sequence.store(index + 1, std::memory_order_release);
+    ring->head.store(index + 1, std::memory_order_release);
+    
+    uint64_t key = histogram_key(event.type, event.name_id);
+    auto it = ring->histograms.find(key);
+    if (it == ring->histograms.end()) {
+        std::lock_guard<std::mutex> lock(ring->histograms_mutex);
+        it = ring->histograms.emplace(key, std::make_unique<OpHistogram>()).first;
+    }
+    it->second->record(event.end_ns - event.start_ns, event.bytes_processed);
+}
+
+std::unordered_map<uint64_t, LatencyHistogram> PerformanceProfiler::merged_histograms() const {
+    std::unordered_map<uint64_t, LatencyHistogram> merged;
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    LatencyHistogram part;
+    for (const auto& ring : rings_) {
+        std::lock_guard<std::mutex> histograms_lock(ring->histograms_mutex);
+        for (const auto& pair : ring->histograms) {
+            part = LatencyHistogram();
+            pair.second->read(part);
+            if (part.count > 0) {
+                merged[pair.first].merge(part);
+            }
+        }
+    }
+    return merged;
+}
+
+template <typename F>
+void PerformanceProfiler::for_each_event(F&& f, std::vector<uint64_t>* cursors, uint64_t* dropped) const {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    if (cursors && cursors->size() < rings_.size()) {
+        cursors->resize(rings_.size(), 0);
+    }
+    for (size_t i = 0; i < rings_.size(); ++i) {
+        const EventRing* ring = rings_[i].get();
+        const uint64_t capacity = ring->mask + 1;
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t oldest = head > capacity ? head - capacity : 0;
+        uint64_t begin = std::max(oldest, ring->floor.load(std::memory_order_relaxed));
+        if (cursors) {
+            uint64_t& cursor = (*cursors)[i];
+            if (dropped && cursor < oldest) {
+                *dropped += oldest - cursor;
+            }
+            begin = std::max(begin, cursor);
+            cursor = head;
+        }
+        for (uint64_t index = begin; index < head; ++index) {
+            const EventSlot& slot = ring->slots[index & ring->mask];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+                continue;
+            }
+            PerformanceEvent event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == index + 1) {
+                f(event);
+            }
+        }
+    }
+}
+
+EventHandle PerformanceProfiler::start_event(EventType type, const std::string& name, 
+                                             size_t bytes, const std::string& info) {
+    if (!is_enabled()) return EventHandle();
+    return start_event(type, intern(name), bytes, info.empty() ? 0 : intern(info));
+}
+
+EventHandle PerformanceProfiler::start_event(EventType type, uint32_t name_id, size_t bytes, uint32_t info_id) {
+    EventHandle handle;
+    if (!is_enabled()) return handle;
+    
+    handle.type = type;
+    handle.name_id = name_id;
+    handle.info_id = info_id;
+    handle.bytes = bytes;
+    handle.active = true;
+    handle.start_ns = now_ns();
+    return handle;
+}
+
+void PerformanceProfiler::end_event(const EventHandle& handle, void* stream) {
+    if (!handle.active) return;
     
     PerformanceEvent event;
-    event.type = type;
-    event.name = name;
-    event.start_time = std::chrono::high_resolution_clock::now();
-    event.bytes_processed = bytes;
-    event.additional_info = info;
-    event.device_id = -1; // Will be set by context
+    event.end_ns = now_ns();
+    event.start_ns = handle.start_ns;
+    event.bytes_processed = handle.bytes;
+    event.stream = stream;
+    event.name_id = handle.name_id;
+    event.info_id = handle.info_id;
+    event.device_id = DeviceManager::get_instance().get_current_device();
+    event.thread_id = thread_ring()->thread_id;
+    event.type = handle.type;
+    event.device_timed = false;
+    append(event);
+}
+
+DeviceEventHandle PerformanceProfiler::start_device_event(EventType type, uint32_t name_id, int device_id,
+                                                          void* stream, size_t bytes, uint32_t info_id) {
+    DeviceEventHandle handle;
+    if (!is_device_timing_enabled()) return handle;
+    
+    // Events recorded during graph capture would become graph nodes and
+    // never complete on their own; captured work is timed per replay instead
+    hipStreamCaptureStatus capture_status = hipStreamCaptureStatusNone;
+    if (stream && hipStreamIsCapturing(static_cast<hipStream_t>(stream), &capture_status) == hipSuccess &&
+        capture_status != hipStreamCaptureStatusNone) {
+        return handle;
+    }
     
-    active_events_[name] = event;
+    if (device_id < 0) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    DeviceTiming& timing = *device_timing_;
+    std::call_once(timing.started, [this, &timing]() {
+        timing.collector = std::thread([this, &timing]() { timing.run(*this); });
+    });
+    
+    hipEvent_t start = timing.acquire(device_id);
+    if (!start) return handle;
+    if (hipEventRecord(start, static_cast<hipStream_t>(stream)) != hipSuccess) {
+        timing.release(device_id, start);
+        return handle;
+    }
+    
+    handle.start = start;
+    handle.stream = stream;
+    handle.bytes = bytes;
+    handle.name_id = name_id;
+    handle.info_id = info_id;
+    handle.device_id = device_id;
+    handle.type = type;
+    handle.active = true;
+    return handle;
 }
 
-void PerformanceProfiler::end_event(EventType type, const std::string& name) {
-    if (!config_.enable_timing) return;
+void PerformanceProfiler::end_device_event(const DeviceEventHandle& handle) {
+    if (!handle.active) return;
     
-    std::lock_guard<std::mutex> lock(mutex_);
+    DeviceTiming& timing = *device_timing_;
+    hipEvent_t start = static_cast<hipEvent_t>(handle.start);
+    hipEvent_t end = timing.acquire(handle.device_id);
+    if (!end || hipEventRecord(end, static_cast<hipStream_t>(handle.stream)) != hipSuccess) {
+        timing.release(handle.device_id, start);
+        timing.release(handle.device_id, end);
+        return;
+    }
     
-    auto it = active_events_.find(name);
-    if (it != active_events_.end()) {
-        PerformanceEvent& event = it->second;
-        event.end_time = std::chrono::high_resolution_clock::now();
-        events_.push_back(event);
-        active_events_.erase(it);
-        
-        // Limit event storage
-        if (events_.size() > config_.max_events) {
-            events_.erase(events_.begin());
+    DeviceTiming::Pending pending;
+    pending.start = start;
+    pending.end = end;
+    PerformanceEvent& event = pending.event;
+    event.start_ns = 0;
+    event.end_ns = 0;
+    event.bytes_processed = handle.bytes;
+    event.stream = handle.stream;
+    event.name_id = handle.name_id;
+    event.info_id = handle.info_id;
+    event.device_id = handle.device_id;
+    event.thread_id = thread_ring()->thread_id;
+    event.type = handle.type;
+    event.device_timed = true;
+    {
+        std::lock_guard<std::mutex> lock(timing.queue_mutex);
+        timing.queue.push_back(pending);
+        ++timing.outstanding;
+    }
+    timing.work_cv.notify_one();
+}
+
+void PerformanceProfiler::flush_device_events() {
+    DeviceTiming& timing = *device_timing_;
+    std::unique_lock<std::mutex> lock(timing.queue_mutex);
+    timing.idle_cv.wait(lock, [&timing]() { return timing.outstanding == 0 || timing.stop; });
+}
+
+namespace {
+thread_local std::vector<EventHandle> pushed_events;
+} // namespace
+
+void PerformanceProfiler::push_event(EventType type, const std::string& name) {
+    if (!is_enabled()) return;
+    pushed_events.push_back(start_event(type, intern(name)));
+}
+
+void PerformanceProfiler::pop_event(EventType type, const std::string& name) {
+    if (pushed_events.empty()) return;
+    
+    uint32_t name_id = intern(name);
+    for (size_t i = pushed_events.size(); i-- > 0;) {
+        if (pushed_events[i].name_id == name_id && pushed_events[i].type == type) {
+            end_event(pushed_events[i]);
+            pushed_events.erase(pushed_events.begin() + i);
+            return;
         }
     }
 }
 
 void PerformanceProfiler::record_memory_allocation(size_t size, void* ptr, int device_id) {
-    if (!config_.enable_memory_tracking) return;
+    if (!memory_tracking_enabled_.load(std::memory_order_relaxed)) return;
     
     std::lock_guard<std::mutex> lock(mutex_);
     memory_allocations_[ptr] = size;
 }
 
 void PerformanceProfiler::record_memory_deallocation(void* ptr) {
-    if (!config_.enable_memory_tracking) return;
+    if (!memory_tracking_enabled_.load(std::memory_order_relaxed)) return;
     
     std::lock_guard<std::mutex> lock(mutex_);
     memory_allocations_.erase(ptr);
 }
 
 void PerformanceProfiler::record_memory_copy(size_t size, void* src, void* dst, int device_id) {
-    if (!config_.enable_memory_tracking) return;
+    if (!memory_tracking_enabled_.load(std::memory_order_relaxed)) return;
     
-    std::string name = "memcpy";
-    start_event(EventType::MEMORY_COPY, name, size);
-    // Note: We assume the copy is synchronous for profiling
-    end_event(EventType::MEMORY_COPY, name);
+    static const uint32_t name_id = intern("memcpy_host");
+    // Zero-length host marker; the copy itself is timed on the device
+    end_event(start_event(EventType::MEMORY_COPY, name_id, size));
 }
 
 void PerformanceProfiler::record_kernel_launch(const std::string& kernel_name, 
                                               size_t grid_size[3], size_t block_size[3],
                                               size_t shared_memory, int device_id) {
-    if (!config_.enable_kernel_tracking) return;
+    if (!kernel_tracking_enabled_.load(std::memory_order_relaxed) || !is_enabled()) return;
     
-    std::stringstream ss;
-    ss << kernel_name << " [" << grid_size[0] << "," << grid_size[1] << "," << grid_size[2] << "]";
-    start_event(EventType::KERNEL_LAUNCH, ss.str(), 0, 
-                "Grid: " + std::to_string(grid_size[0]) + "x" + std::to_string(grid_size[1]) + "x" + std::to_string(grid_size[2]) +
-                " Block: " + std::to_string(block_size[0]) + "x" + std::to_string(block_size[1]) + "x" + std::to_string(block_size[2]));
-    // Note: We assume kernel completion is synchronous for profiling
-    end_event(EventType::KERNEL_LAUNCH, ss.str());
+    // Launch geometry goes in the info string so stats aggregate per kernel
+    std::string info = "Grid: " + std::to_string(grid_size[0]) + "x" + std::to_string(grid_size[1]) + "x" + std::to_string(grid_size[2]) +
+                       " Block: " + std::to_string(block_size[0]) + "x" + std::to_string(block_size[1]) + "x" + std::to_string(block_size[2]);
+    // Zero-length host marker; the launch itself is timed on the device
+    end_event(start_event(EventType::KERNEL_LAUNCH, intern(kernel_name), 0, intern(info)));
 }
 
 PerformanceStats PerformanceProfiler::get_stats(EventType type, const std::string& name) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    PerformanceStats stats = {0, 0, std::numeric_limits<double>::max(), 0, 0, 0, 0};
-    std::vector<double> durations;
-    
-    for (const auto& event : events_) {
-        if (event.type == type && (name.empty() || event.name == name)) {
-            double duration = event.duration_ms();
-            durations.push_back(duration);
-            stats.total_time_ms += duration;
-            stats.total_bytes_processed += event.bytes_processed;
-            stats.min_time_ms = std::min(stats.min_time_ms, duration);
-            stats.max_time_ms = std::max(stats.max_time_ms, duration);
+    uint32_t name_id = 0;
+    if (!name.empty()) {
+        std::lock_guard<std::mutex> lock(names_mutex_);
+        auto it = name_ids_.find(name);
+        if (it == name_ids_.end()) {
+            return empty_stats();
         }
+        name_id = it->second;
     }
     
-    stats.call_count = durations.size();
-    if (stats.call_count > 0) {
-        stats.average_time_ms = stats.total_time_ms / stats.call_count;
-        if (stats.total_time_ms > 0) {
-            stats.throughput_gbps = (stats.total_bytes_processed * 8.0) / (stats.total_time_ms * 1e6); // Gbps
+    LatencyHistogram latency;
+    for (const auto& pair : merged_histograms()) {
+        if ((pair.first >> 32) == static_cast<uint64_t>(type) &&
+            (name.empty() || static_cast<uint32_t>(pair.first) == name_id)) {
+            latency.merge(pair.second);
         }
     }
-    
-    return stats;
+    return stats_from(latency);
 }
 
 std::unordered_map<std::string, PerformanceStats> PerformanceProfiler::get_all_stats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::unordered_map<std::string, PerformanceStats> result;
+    // Merge by id, resolve names once at the end
+    std::unordered_map<uint32_t, LatencyHistogram> by_id;
+    for (const auto& pair : merged_histograms()) {
+        by_id[static_cast<uint32_t>(pair.first)].merge(pair.second);
+    }
     
-    // Group events by name
-    std::unordered_map<std::string, std::vector<const PerformanceEvent*>> events_by_name;
-    for (const auto& event : events_) {
-        events_by_name[event.name].push_back(&event);
+    std::unordered_map<std::string, PerformanceStats> result;
+    for (const auto& pair : by_id) {
+        result[get_name(pair.first)] = stats_from(pair.second);
+    }
+    return result;
+}
+
+MetricsSnapshot PerformanceProfiler::collect_metrics() const {
+    MetricsSnapshot snapshot;
+    snapshot.timestamp_ns = now_ns();
+    for (auto& pair : merged_histograms()) {
+        OpMetrics op;
+        op.type = static_cast<EventType>(pair.first >> 32);
+        op.name = get_name(static_cast<uint32_t>(pair.first));
+        op.latency = std::move(pair.second);
+        snapshot.ops.push_back(std::move(op));
     }
+    std::sort(snapshot.ops.begin(), snapshot.ops.end(), [](const OpMetrics& a, const OpMetrics& b) {
+        return a.type != b.type ? a.type < b.type : a.name < b.name;
+    });
     
-    // Calculate stats for each event name
-    for (const auto& pair : events_by_name) {
-        PerformanceStats stats = {0, 0, std::numeric_limits<double>::max(), 0, 0, 0, 0};
-        std::vector<double> durations;
-        
-        for (const auto& event : pair.second) {
-            double duration = event->duration_ms();
-            durations.push_back(duration);
-            stats.total_time_ms += duration;
-            stats.total_bytes_processed += event->bytes_processed;
-            stats.min_time_ms = std::min(stats.min_time_ms, duration);
-            stats.max_time_ms = std::max(stats.max_time_ms, duration);
+    MemoryManager& memory = MemoryManager::get_instance();
+    int devices = DeviceManager::get_instance().device_count();
+    for (int device_id = 0; device_id < devices; ++device_id) {
+        DeviceMemoryMetrics device;
+        device.device_id = device_id;
+        if (memory.find_stats(device_id, device.stats)) {
+            snapshot.memory.push_back(device);
         }
-        
-        stats.call_count = durations.size();
-        if (stats.call_count > 0) {
-            stats.average_time_ms = stats.total_time_ms / stats.call_count;
-            if (stats.total_time_ms > 0) {
-                stats.throughput_gbps = (stats.total_bytes_processed * 8.0) / (stats.total_time_ms * 1e6);
-            }
-        }
-        
-        result[pair.first] = stats;
     }
-    
-    return result;
+    return snapshot;
+}
+
+std::vector<PerformanceEvent> PerformanceProfiler::get_events() const {
+    std::vector<PerformanceEvent> events;
+    for_each_event([&](const PerformanceEvent& event) { events.push_back(event); });
+    std::sort(events.begin(), events.end(), [](const PerformanceEvent& a, const PerformanceEvent& b) {
+        return a.start_ns < b.start_ns;
+    });
+    return events;
+}
+
+size_t PerformanceProfiler::get_event_count() const {
+    size_t count = 0;
+    for_each_event([&](const PerformanceEvent&) { ++count; });
+    return count;
 }
 
 void PerformanceProfiler::generate_report(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    flush_device_events();
     
     std::ostream* output = &std::cout;
     std::ofstream file;
@@ -174,12 +992,16 @@ void PerformanceProfiler::generate_report(const std::string& filename) {
         }
     }
     
+    // Group by event name
+    auto all_stats = get_all_stats();
+    size_t event_count = 0;
+    for (const auto& pair : all_stats) {
+        event_count += pair.second.call_count;
+    }
+    
     *output << "RDNA Performance Report\n";
     *output << "=======================\n\n";
-    *output << "Total events recorded: " << events_.size() << "\n\n";
-    
-    // Group by event type and name
-    auto all_stats = get_all_stats();
+    *output << "Total events recorded: " << event_count << "\n\n";
     
     for (const auto& pair : all_stats) {
         const auto& stats = pair.second;
@@ -189,13 +1011,17 @@ void PerformanceProfiler::generate_report(const std::string& filename) {
         *output << "  Average time: " << stats.average_time_ms << " ms\n";
         *output << "  Min time: " << stats.min_time_ms << " ms\n";
         *output << "  Max time: " << stats.max_time_ms << " ms\n";
+        *output << "  p50/p90/p99/p999: " << stats.p50_ms << " / " << stats.p90_ms << " / "
+                << stats.p99_ms << " / " << stats.p999_ms << " ms\n";
         if (stats.total_bytes_processed > 0) {
             *output << "  Throughput: " << stats.throughput_gbps << " Gbps\n";
+            *output << "  Bandwidth: " << stats.bandwidth_gbs << " GB/s\n";
         }
         *output << "\n";
     }
     
     // Memory allocation summary
+    std::lock_guard<std::mutex> lock(mutex_);
     if (config_.enable_memory_tracking) {
         *output << "Memory Allocations:\n";
         size_t total_allocated = 0;
@@ -211,221 +1037,757 @@ void PerformanceProfiler::generate_report(const std::string& filename) {
     }
 }
 
+bool PerformanceProfiler::start_trace(const std::string& path, int flush_interval_ms) {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    if (trace_writer_) {
+        return false;
+    }
+    
+    auto writer = std::make_unique<TraceWriter>();
+    writer->path = path.empty() ? get_config().output_file : path;
+    if (writer->path.empty()) {
+        return false;
+    }
+    writer->out.open(writer->path, std::ios::trunc);
+    if (!writer->out) {
+        std::cerr << "Warning: Cannot open trace file " << writer->path << std::endl;
+        return false;
+    }
+    writer->interval = std::chrono::milliseconds(std::max(flush_interval_ms, 1));
+    writer->origin_ns = now_ns();
+    
+    // Start from what is recorded now; earlier records stay out of the file
+    std::vector<uint64_t> heads;
+    for_each_event([](const PerformanceEvent&) {}, &heads);
+    for (auto& head : heads) {
+        writer->ring_cursors.push_back(head);
+    }
+    int devices = DeviceManager::get_instance().device_count();
+    writer->allocator_cursors.resize(devices);
+    writer->allocated_bytes.assign(devices, 0);
+    std::vector<TraceEntry> skipped;
+    for (int device_id = 0; device_id < devices; ++device_id) {
+        writer->allocator_cursors[device_id] = MemoryManager::get_instance().read_trace(
+            device_id, std::numeric_limits<uint64_t>::max(), skipped);
+    }
+    
+    writer->out << "[\n";
+    TraceWriter* raw = writer.get();
+    writer->thread = std::thread([this, raw]() { raw->run(*this); });
+    trace_writer_ = std::move(writer);
+    return true;
+}
+
+void PerformanceProfiler::stop_trace() {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    if (!trace_writer_) {
+        return;
+    }
+    flush_device_events();
+    
+    TraceWriter& writer = *trace_writer_;
+    {
+        std::lock_guard<std::mutex> writer_lock(writer.mutex);
+        writer.stop = true;
+    }
+    writer.cv.notify_all();
+    writer.thread.join();
+    writer.drain(*this);
+    
+    // Closing entry needs no trailing comma
+    writer.out << "{\"name\":\"trace_stats\",\"ph\":\"M\",\"pid\":" << kHostPid
+               << ",\"args\":{\"dropped_events\":" << writer.dropped << "}}\n]\n";
+    writer.out.close();
+    trace_writer_.reset();
+}
+
+bool PerformanceProfiler::is_tracing() const {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    return trace_writer_ != nullptr;
+}
+
+namespace {
+
+void write_label_value(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            default: out << c;
+        }
+    }
+    out << '"';
+}
+
+void write_op_labels(std::ostream& out, const OpMetrics& op, const char* quantile = nullptr) {
+    out << "{type=\"" << event_category(op.type) << "\",op=";
+    write_label_value(out, op.name);
+    if (quantile) {
+        out << ",quantile=\"" << quantile << "\"";
+    }
+    out << "}";
+}
+
+void write_memory_metric(std::ostream& out, const MetricsSnapshot& snapshot, const char* name,
+                         const char* type, const char* help, uint64_t MemoryStats::*field) {
+    out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    for (const auto& device : snapshot.memory) {
+        out << name << "{device=\"" << device.device_id << "\"} " << device.stats.*field << "\n";
+    }
+}
+
+} // namespace
+
+std::string PerformanceProfiler::format_prometheus(const MetricsSnapshot& snapshot) {
+    static const std::pair<const char*, double> quantiles[] = {
+        {"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}
+    };
+    
+    std::ostringstream out;
+    out << std::setprecision(9);
+    out << "# HELP rdna_op_latency_seconds Operation latency since the profiler was last cleared\n"
+           "# TYPE rdna_op_latency_seconds summary\n";
+    for (const auto& op : snapshot.ops) {
+        for (const auto& quantile : quantiles) {
+            out << "rdna_op_latency_seconds";
+            write_op_labels(out, op, quantile.first);
+            out << " " << op.latency.percentile_ns(quantile.second) / 1e9 << "\n";
+        }
+        out << "rdna_op_latency_seconds_sum";
+        write_op_labels(out, op);
+        out << " " << op.latency.sum_ns / 1e9 << "\n";
+        out << "rdna_op_latency_seconds_count";
+        write_op_labels(out, op);
+        out << " " << op.latency.count << "\n";
+    }
+    out << "# HELP rdna_op_bytes_total Bytes processed by the operation\n"
+           "# TYPE rdna_op_bytes_total counter\n";
+    for (const auto& op : snapshot.ops) {
+        out << "rdna_op_bytes_total";
+        write_op_labels(out, op);
+        out << " " << op.latency.bytes << "\n";
+    }
+    
+    write_memory_metric(out, snapshot, "rdna_memory_allocated_bytes", "gauge",
+                        "Bytes in live allocations", &MemoryStats::allocated_bytes);
+    write_memory_metric(out, snapshot, "rdna_memory_cached_bytes", "gauge",
+                        "Bytes held by the caching allocator but not allocated", &MemoryStats::cached_bytes);
+    write_memory_metric(out, snapshot, "rdna_memory_max_allocated_bytes", "gauge",
+                        "Peak allocated bytes", &MemoryStats::max_allocated_bytes);
+    write_memory_metric(out, snapshot, "rdna_memory_workspace_bytes", "gauge",
+                        "Bytes held by per-stream workspace arenas", &MemoryStats::workspace_bytes);
+    write_memory_metric(out, snapshot, "rdna_memory_allocations_total", "counter",
+                        "Allocations served", &MemoryStats::total_allocations);
+    write_memory_metric(out, snapshot, "rdna_memory_frees_total", "counter",
+                        "Frees served", &MemoryStats::total_frees);
+    write_memory_metric(out, snapshot, "rdna_memory_device_malloc_calls_total", "counter",
+                        "hipMalloc calls issued by the allocator", &MemoryStats::device_malloc_calls);
+    write_memory_metric(out, snapshot, "rdna_memory_device_free_calls_total", "counter",
+                        "hipFree calls issued by the allocator", &MemoryStats::device_free_calls);
+    return out.str();
+}
+
+/**
+ * Minimal HTTP responder for scrapers: one connection at a time, the
+ * request is read and ignored apart from its method, and the connection
+ * closes after the response. The poll timeout bounds how long stopping
+ * takes.
+ */
+struct PerformanceProfiler::MetricsServer {
+    int fd = -1;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+    
+    ~MetricsServer() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    
+    static void send_all(int client, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+    
+    void serve(const PerformanceProfiler& profiler) {
+        while (!stop.load(std::memory_order_relaxed)) {
+            pollfd listener{fd, POLLIN, 0};
+            if (::poll(&listener, 1, 200) <= 0) {
+                continue;
+            }
+            int client = ::accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            
+            timeval timeout{1, 0};
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            char request[1024];
+            ssize_t n = ::recv(client, request, sizeof(request), 0);
+            std::string response;
+            if (n >= 4 && std::string(request, 4) == "GET ") {
+                std::string body = format_prometheus(profiler.collect_metrics());
+                response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(body.size()) +
+                           "\r\nConnection: close\r\n\r\n" + body;
+            } else {
+                response = "HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            }
+            send_all(client, response);
+            ::close(client);
+        }
+    }
+};
+
+bool PerformanceProfiler::start_metrics_server(int port, const std::string& address) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    if (metrics_server_) {
+        return false;
+    }
+    
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (port <= 0 || port > 65535 || ::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Warning: Invalid metrics address " << address << ":" << port << std::endl;
+        return false;
+    }
+    
+    auto server = std::make_unique<MetricsServer>();
+    server->fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server->fd < 0) {
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(server->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (::bind(server->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(server->fd, 8) != 0) {
+        std::cerr << "Warning: Cannot listen for metrics on " << address << ":" << port << std::endl;
+        return false;
+    }
+    
+    MetricsServer* raw = server.get();
+    server->thread = std::thread([this, raw]() { raw->serve(*this); });
+    metrics_server_ = std::move(server);
+    return true;
+}
+
+void PerformanceProfiler::stop_metrics_server() {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    if (!metrics_server_) {
+        return;
+    }
+    metrics_server_->stop.store(true, std::memory_order_relaxed);
+    metrics_server_->thread.join();
+    metrics_server_.reset();
+}
+
 void PerformanceProfiler::print_summary() {
     generate_report(""); // Print to console
 }
 
 void PerformanceProfiler::clear_events() {
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto& ring : rings_) {
+            ring->floor.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+            std::lock_guard<std::mutex> histograms_lock(ring->histograms_mutex);
+            for (auto& pair : ring->histograms) {
+                pair.second->reset();
+            }
+        }
+    }
     std::lock_guard<std::mutex> lock(mutex_);
-    events_.clear();
-    active_events_.clear();
     memory_allocations_.clear();
 }
 
+// Shapes rdna-tune covers out of the box: the projections of the models we
+// serve, with tokens = batch * sequence folded into m. Linear layers keep
+// weights as [out, in], so B is transposed.
+namespace {
+
+struct GemmShape {
+    const char* model;
+    size_t m, n, k;
+};
+
+const GemmShape kModelZooGemms[] = {
+    {"bert-base", 4096, 2304, 768},
+    {"bert-base", 4096, 768, 768},
+    {"bert-base", 4096, 3072, 768},
+    {"bert-base", 4096, 768, 3072},
+    {"gpt2-medium", 4096, 3072, 1024},
+    {"gpt2-medium", 4096, 1024, 1024},
+    {"gpt2-medium", 4096, 4096, 1024},
+    {"gpt2-medium", 4096, 1024, 4096},
+    {"llama-7b", 2048, 12288, 4096},
+    {"llama-7b", 2048, 4096, 4096},
+    {"llama-7b", 2048, 11008, 4096},
+    {"llama-7b", 2048, 4096, 11008},
+    {"llama-7b-decode", 1, 12288, 4096},
+    {"llama-7b-decode", 1, 4096, 4096},
+    {"llama-7b-decode", 1, 11008, 4096},
+    {"llama-7b-decode", 1, 4096, 11008},
+    {"resnet50-fc", 256, 1000, 2048},
+};
+
+// NCHW input, square filter, stride and padding
+struct ConvShape {
+    const char* model;
+    size_t batch, channels, height, width, filters, kernel;
+    int stride, padding;
+};
+
+const ConvShape kModelZooConvs[] = {
+    {"resnet50", 32, 3, 224, 224, 64, 7, 2, 3},
+    {"resnet50", 32, 64, 56, 56, 64, 3, 1, 1},
+    {"resnet50", 32, 64, 56, 56, 256, 1, 1, 0},
+    {"resnet50", 32, 128, 28, 28, 128, 3, 1, 1},
+    {"resnet50", 32, 256, 14, 14, 256, 3, 1, 1},
+    {"resnet50", 32, 512, 7, 7, 512, 3, 1, 1},
+};
+
+std::string default_tuning_file_path() {
+    if (const char* path = std::getenv("RDNA_TUNING_FILE")) {
+        return path;
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/rdna/tuning.txt";
+    }
+    return "";
+}
+
+// Owns a scratch operand for the tuning suite
+struct TuningBuffer {
+    void* data = nullptr;
+    
+    TuningBuffer(size_t size, int device_id) {
+        data = MemoryManager::get_instance().allocate(size, device_id);
+        if (data) {
+            MemoryManager::get_instance().memset(data, 0, size);
+        }
+    }
+    ~TuningBuffer() {
+        if (data) {
+            MemoryManager::get_instance().deallocate(data);
+        }
+    }
+    TuningBuffer(const TuningBuffer&) = delete;
+    TuningBuffer& operator=(const TuningBuffer&) = delete;
+};
+
+} // namespace
+
+TuningResult::TuningResult() : time_ms(0.0) {}
+
 // PerformanceOptimizer implementation
 PerformanceOptimizer& PerformanceOptimizer::get_instance() {
     static PerformanceOptimizer instance;
     return instance;
 }
 
-void PerformanceOptimizer::optimize_kernel_config(const std::string& kernel_name,
-                                                size_t* grid_size, size_t* block_size,
-                                                size_t* shared_memory, int device_id) {
-    // Simple optimization rules for RDNA architecture
-    if (kernel_name.find("matmul") != std::string::npos) {
-        // Optimize for matrix multiplication
-        block_size[0] = 16;
-        block_size[1] = 16;
-        block_size[2] = 1;
-        
-        // Adjust grid size based on problem size
-        grid_size[0] = (grid_size[0] + block_size[0] - 1) / block_size[0];
-        grid_size[1] = (grid_size[1] + block_size[1] - 1) / block_size[1];
-        grid_size[2] = 1;
-        
-    } else if (kernel_name.find("conv") != std::string::npos) {
-        // Optimize for convolution
-        block_size[0] = 8;
-        block_size[1] = 8;
-        block_size[2] = 4;
-        
-        grid_size[0] = (grid_size[0] + block_size[0] - 1) / block_size[0];
-        grid_size[1] = (grid_size[1] + block_size[1] - 1) / block_size[1];
-        grid_size[2] = (grid_size[2] + block_size[2] - 1) / block_size[2];
+PerformanceOptimizer::PerformanceOptimizer()
+    : tuning_file_path_(default_tuning_file_path()), warmup_iterations_(2),
+      timed_iterations_(10), tuned_count_(0) {
+    if (!tuning_file_path_.empty()) {
+        load_locked(tuning_file_path_);
     }
-    
-    // Cache the optimal configuration
-    std::string key = kernel_name + "_" + std::to_string(device_id);
-    optimal_configs_[key][device_id] = block_size[0] * block_size[1] * block_size[2];
 }
 
-void PerformanceOptimizer::suggest_memory_layout(const std::vector<size_t>& shape,
-                                                std::vector<size_t>* optimal_strides) {
-    // Suggest optimal memory layout for RDNA
-    optimal_strides->resize(shape.size());
-    size_t stride = 1;
-    for (int i = shape.size() - 1; i >= 0; --i) {
-        (*optimal_strides)[i] = stride;
-        stride *= shape[i];
+std::vector<size_t> PerformanceOptimizer::bucket_shape(const std::vector<size_t>& shape) {
+    std::vector<size_t> bucket(shape);
+    for (size_t& extent : bucket) {
+        if (extent <= 16) {
+            continue;  // Small extents change the best kernel too much to share
+        }
+        int bits = 0;
+        for (size_t v = extent; v; v >>= 1) {
+            ++bits;
+        }
+        const size_t granule = size_t(1) << (bits - 3);
+        extent = (extent + granule - 1) / granule * granule;
     }
+    return bucket;
 }
 
-std::string PerformanceOptimizer::select_best_algorithm(const std::string& operation_type,
-                                                      const std::vector<std::string>& available_algorithms,
-                                                      int device_id) {
-    std::string key = operation_type + "_" + std::to_string(device_id);
-    
-    // Return cached algorithm if available
-    auto it = algorithm_cache_.find(key);
-    if (it != algorithm_cache_.end()) {
-        auto device_it = it->second.find(device_id);
-        if (device_it != it->second.end()) {
-            return device_it->second;
+std::string PerformanceOptimizer::make_tuning_key(const std::string& op, const std::vector<size_t>& shape,
+                                                   int data_type, const std::string& arch) {
+    std::ostringstream key;
+    key << op << '|';
+    std::vector<size_t> bucket = bucket_shape(shape);
+    for (size_t i = 0; i < bucket.size(); ++i) {
+        key << (i ? "x" : "") << bucket[i];
+    }
+    key << "|dt" << data_type << '|' << arch;
+    return key.str();
+}
+
+std::string PerformanceOptimizer::get_arch(int device_id) {
+    if (device_id < 0) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = device_arch_.find(device_id);
+        if (it != device_arch_.end()) {
+            return it->second;
         }
     }
+    std::string arch = DeviceManager::get_instance().get_device_properties(device_id).arch;
+    std::lock_guard<std::mutex> lock(mutex_);
+    device_arch_[device_id] = arch;
+    return arch;
+}
+
+bool PerformanceOptimizer::tune(const std::string& key, const std::vector<TuningCandidate>& candidates,
+                                int device_id, void* stream, TuningResult* result) {
+    int warmup, iterations;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        warmup = warmup_iterations_;
+        iterations = timed_iterations_;
+    }
     
-    // Simple algorithm selection
-    std::string best_algorithm = "DEFAULT";
-    if (!available_algorithms.empty()) {
-        best_algorithm = available_algorithms[0];
+    int previous_device = 0;
+    hipGetDevice(&previous_device);
+    if (device_id >= 0 && hipSetDevice(device_id) != hipSuccess) {
+        return false;
+    }
+    hipStream_t hip_stream = static_cast<hipStream_t>(stream);
+    hipEvent_t start = nullptr, stop = nullptr;
+    if (hipEventCreate(&start) != hipSuccess || hipEventCreate(&stop) != hipSuccess) {
+        if (start) hipEventDestroy(start);
+        hipSetDevice(previous_device);
+        return false;
+    }
+    
+    // Candidates run without the lock held: they may consult the cache
+    const TuningCandidate* best = nullptr;
+    double best_time = 0.0;
+    for (const TuningCandidate& candidate : candidates) {
+        bool ok = true;
+        for (int i = 0; i < std::max(warmup, 1) && ok; ++i) {
+            ok = candidate.launch(stream);
+        }
+        if (!ok || hipStreamSynchronize(hip_stream) != hipSuccess) {
+            continue;
+        }
         
-        // Prefer algorithms with "fast" or "optimized" in the name
-        for (const auto& alg : available_algorithms) {
-            if (alg.find("fast") != std::string::npos || 
-                alg.find("optimized") != std::string::npos) {
-                best_algorithm = alg;
-                break;
-            }
+        hipEventRecord(start, hip_stream);
+        for (int i = 0; i < iterations && ok; ++i) {
+            ok = candidate.launch(stream);
+        }
+        hipEventRecord(stop, hip_stream);
+        float elapsed_ms = 0.0f;
+        if (!ok || hipEventSynchronize(stop) != hipSuccess ||
+            hipEventElapsedTime(&elapsed_ms, start, stop) != hipSuccess) {
+            continue;
         }
+        
+        double time = elapsed_ms / std::max(iterations, 1);
+        if (!best || time < best_time) {
+            best = &candidate;
+            best_time = time;
+        }
+    }
+    
+    hipEventDestroy(start);
+    hipEventDestroy(stop);
+    hipSetDevice(previous_device);
+    if (!best) {
+        return false;
     }
     
-    // Cache the selection
-    algorithm_cache_[key][device_id] = best_algorithm;
-    return best_algorithm;
+    TuningResult winner;
+    winner.algorithm = best->name;
+    winner.config = best->config;
+    winner.time_ms = best_time;
+    record(key, winner);
+    if (result) {
+        *result = winner;
+    }
+    return true;
 }
 
-void PerformanceOptimizer::optimize_cache_behavior(size_t working_set_size, int device_id) {
-    // Simple cache optimization suggestions
-    if (working_set_size > 1024 * 1024 * 1024) { // > 1GB
-        // Suggest using unified memory for large working sets
-        std::cout << "Consider using unified memory for working set > 1GB" << std::endl;
+bool PerformanceOptimizer::lookup(const std::string& key, TuningResult& result) const {
+    if (tuned_count_ == 0) {
+        return false;
     }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = algorithm_cache_.find(key);
+    if (it == algorithm_cache_.end()) {
+        return false;
+    }
+    result.algorithm = it->second;
+    result.config = optimal_configs_.at(key);
+    result.time_ms = tuned_times_.at(key);
+    return true;
 }
 
-void PerformanceOptimizer::tune_parameters(const std::string& operation_type, int device_id) {
-    // Parameter tuning based on operation type and device
-    std::cout << "Tuning parameters for " << operation_type << " on device " << device_id << std::endl;
-    
-    if (operation_type == "matmul") {
-        std::cout << "Suggested tuning: Use tile size 16x16 for better cache utilization" << std::endl;
-    } else if (operation_type == "convolution") {
-        std::cout << "Suggested tuning: Use winograd algorithm for 3x3 convolutions" << std::endl;
-    }
+void PerformanceOptimizer::record(const std::string& key, const TuningResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    algorithm_cache_[key] = result.algorithm;
+    optimal_configs_[key] = result.config;
+    tuned_times_[key] = result.time_ms;
+    tuned_count_ = algorithm_cache_.size();
 }
 
-// BenchmarkRunner implementation
-BenchmarkRunner& BenchmarkRunner::get_instance() {
-    static BenchmarkRunner instance;
-    return instance;
+size_t PerformanceOptimizer::get_tuned_count() const {
+    return tuned_count_;
 }
 
-void BenchmarkRunner::run_benchmarks(int device_id) {
-    std::cout << "Running RDNA benchmarks on device " << device_id << std::endl;
-    
-    // Run individual benchmarks
-    double mem_bw = benchmark_memory_bandwidth(device_id, 1024 * 1024 * 1024); // 1GB
-    double matmul_time = benchmark_matrix_multiply(1024, 1024, 1024, device_id);
-    double conv_time = benchmark_convolution(32, 224, 224, 64, 64, 3, device_id);
-    
-    std::cout << "Benchmark results:" << std::endl;
-    std::cout << "Memory bandwidth: " << mem_bw << " GB/s" << std::endl;
-    std::cout << "1024x1024 matmul: " << matmul_time << " ms" << std::endl;
-    std::cout << "32x224x224 conv: " << conv_time << " ms" << std::endl;
+void PerformanceOptimizer::clear_tuning() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    algorithm_cache_.clear();
+    optimal_configs_.clear();
+    tuned_times_.clear();
+    tuned_count_ = 0;
 }
 
-double BenchmarkRunner::benchmark_memory_bandwidth(int device_id, size_t size) {
-    // Simple memory bandwidth benchmark
-    PerformanceProfiler& profiler = PerformanceProfiler::get_instance();
-    profiler.start_event(EventType::MEMORY_COPY, "memory_bandwidth", size);
-    
-    // Simulate memory operations
-    std::vector<char> buffer(size);
-    std::fill(buffer.begin(), buffer.end(), 1);
-    
-    profiler.end_event(EventType::MEMORY_COPY, "memory_bandwidth");
-    
-    auto stats = profiler.get_stats(EventType::MEMORY_COPY, "memory_bandwidth");
-    return (size / (1024.0 * 1024.0 * 1024.0)) / (stats.total_time_ms / 1000.0); // GB/s
+void PerformanceOptimizer::set_tuning_iterations(int warmup, int iterations) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    warmup_iterations_ = std::max(warmup, 0);
+    timed_iterations_ = std::max(iterations, 1);
 }
 
-double BenchmarkRunner::benchmark_kernel_latency(const std::string& kernel_name, int device_id) {
-    PerformanceProfiler& profiler = PerformanceProfiler::get_instance();
-    profiler.start_event(EventType::KERNEL_LAUNCH, kernel_name);
-    
-    // Simulate kernel execution
-    // In real implementation, this would launch an actual kernel
-    
-    profiler.end_event(EventType::KERNEL_LAUNCH, kernel_name);
-    
-    auto stats = profiler.get_stats(EventType::KERNEL_LAUNCH, kernel_name);
-    return stats.average_time_ms;
+bool PerformanceOptimizer::load_tuning_file(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return load_locked(path.empty() ? tuning_file_path_ : path);
 }
 
-double BenchmarkRunner::benchmark_matrix_multiply(int m, int n, int k, int device_id) {
-    PerformanceProfiler& profiler = PerformanceProfiler::get_instance();
-    std::string name = "matmul_" + std::to_string(m) + "x" + std::to_string(n) + "x" + std::to_string(k);
-    profiler.start_event(EventType::KERNEL_LAUNCH, name);
-    
-    // Simulate matrix multiplication
-    // In real implementation, this would use actual matmul kernel
-    
-    profiler.end_event(EventType::KERNEL_LAUNCH, name);
+// Format: a "version N" line, then "key<TAB>algorithm<TAB>grid x y z block
+// x y z shared<TAB>time_ms" per entry; '#' starts a comment line
+bool PerformanceOptimizer::load_locked(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
     
-    auto stats = profiler.get_stats(EventType::KERNEL_LAUNCH, name);
-    return stats.average_time_ms;
+    std::string line;
+    bool versioned = false;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (!versioned) {
+            std::istringstream header(line);
+            std::string word;
+            int version = 0;
+            if (!(header >> word >> version) || word != "version" || version != kTuningFileVersion) {
+                std::cerr << "Warning: Ignoring tuning file " << path << " with unsupported version" << std::endl;
+                return false;
+            }
+            versioned = true;
+            continue;
+        }
+        
+        std::istringstream fields(line);
+        std::string key, algorithm, launch;
+        double time_ms = 0.0;
+        if (!std::getline(fields, key, '\t') || !std::getline(fields, algorithm, '\t') ||
+            !std::getline(fields, launch, '\t') || !(fields >> time_ms)) {
+            continue;
+        }
+        KernelConfig config;
+        std::istringstream dims(launch);
+        if (!(dims >> config.grid_size[0] >> config.grid_size[1] >> config.grid_size[2] >>
+              config.block_size[0] >> config.block_size[1] >> config.block_size[2] >> config.shared_memory_size)) {
+            continue;
+        }
+        
+        auto existing = tuned_times_.find(key);
+        if (existing != tuned_times_.end() && existing->second <= time_ms) {
+            continue;
+        }
+        algorithm_cache_[key] = algorithm;
+        optimal_configs_[key] = config;
+        tuned_times_[key] = time_ms;
+    }
+    tuned_count_ = algorithm_cache_.size();
+    return versioned;
 }
 
-double BenchmarkRunner::benchmark_convolution(int batch, int height, int width, int channels,
-                                            int filters, int kernel_size, int device_id) {
-    PerformanceProfiler& profiler = PerformanceProfiler::get_instance();
-    std::string name = "conv2d_b" + std::to_string(batch) + "_c" + std::to_string(channels) + 
-                       "_f" + std::to_string(filters);
-    profiler.start_event(EventType::KERNEL_LAUNCH, name);
-    
-    // Simulate convolution
-    // In real implementation, this would use actual conv kernel
+bool PerformanceOptimizer::save_tuning_file(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::filesystem::path target(path.empty() ? tuning_file_path_ : path);
+    if (target.empty()) {
+        return false;
+    }
+    if (target.has_parent_path()) {
+        std::error_code error;
+        std::filesystem::create_directories(target.parent_path(), error);
+    }
+    std::ofstream out(target, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
     
-    profiler.end_event(EventType::KERNEL_LAUNCH, name);
+    // Sorted so files shipped in images diff cleanly
+    std::vector<std::string> keys;
+    for (const auto& entry : algorithm_cache_) {
+        keys.push_back(entry.first);
+    }
+    std::sort(keys.begin(), keys.end());
     
-    auto stats = profiler.get_stats(EventType::KERNEL_LAUNCH, name);
-    return stats.average_time_ms;
+    out << "# rdna-stack autotuning results\n";
+    out << "version " << kTuningFileVersion << "\n";
+    for (const std::string& key : keys) {
+        const KernelConfig& config = optimal_configs_.at(key);
+        out << key << '\t' << algorithm_cache_.at(key) << '\t'
+            << config.grid_size[0] << ' ' << config.grid_size[1] << ' ' << config.grid_size[2] << ' '
+            << config.block_size[0] << ' ' << config.block_size[1] << ' ' << config.block_size[2] << ' '
+            << config.shared_memory_size << '\t' << tuned_times_.at(key) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+void PerformanceOptimizer::set_tuning_file_path(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tuning_file_path_ = path;
+    if (!path.empty()) {
+        load_locked(path);
+    }
 }
 
-void BenchmarkRunner::compare_with_baseline(const std::string& operation, double rdna_time,
-                                           double baseline_time, const std::string& baseline_name) {
-    double speedup = baseline_time / rdna_time;
-    std::cout << operation << " performance:" << std::endl;
-    std::cout << "  RDNA: " << rdna_time << " ms" << std::endl;
-    std::cout << "  " << baseline_name << ": " << baseline_time << " ms" << std::endl;
-    std::cout << "  Speedup: " << std::fixed << std::setprecision(2) << speedup << "x" << std::endl;
+std::string PerformanceOptimizer::get_tuning_file_path() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tuning_file_path_;
+}
+
+void PerformanceOptimizer::optimize_kernel_config(const std::string& kernel_name,
+                                                size_t* grid_size, size_t* block_size,
+                                                size_t* shared_memory, int device_id) {
+    // Tuned under the problem extents passed in grid_size
+    TuningResult tuned;
+    std::string key = make_tuning_key(kernel_name, {grid_size[0], grid_size[1], grid_size[2]}, 0, get_arch(device_id));
+    if (lookup(key, tuned)) {
+        for (int i = 0; i < 3; ++i) {
+            block_size[i] = tuned.config.block_size[i];
+        }
+        if (shared_memory) {
+            *shared_memory = tuned.config.shared_memory_size;
+        }
+    }
     
-    if (speedup > 1.0) {
-        std::cout << "  RDNA is " << (speedup - 1.0) * 100 << "% faster" << std::endl;
-    } else {
-        std::cout << "  RDNA is " << (1.0 - speedup) * 100 << "% slower" << std::endl;
+    for (int i = 0; i < 3; ++i) {
+        block_size[i] = std::max<size_t>(block_size[i], 1);
+        grid_size[i] = (grid_size[i] + block_size[i] - 1) / block_size[i];
     }
 }
 
-void BenchmarkRunner::generate_benchmark_report(const std::string& filename) {
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        file << "RDNA Benchmark Report\n";
-        file << "=====================\n\n";
-        file << "Generated on: " << __DATE__ << " " << __TIME__ << "\n\n";
-        
-        // This would include actual benchmark results
-        file << "Benchmark suite completed.\n";
-        file.close();
+void PerformanceOptimizer::suggest_memory_layout(const std::vector<size_t>& shape,
+                                                std::vector<size_t>* optimal_strides) {
+    // Suggest optimal memory layout for RDNA
+    optimal_strides->resize(shape.size());
+    size_t stride = 1;
+    for (int i = shape.size() - 1; i >= 0; --i) {
+        (*optimal_strides)[i] = stride;
+        stride *= shape[i];
+    }
+}
+
+std::string PerformanceOptimizer::select_best_algorithm(const std::string& operation_type,
+                                                      const std::vector<std::string>& available_algorithms,
+                                                      int device_id) {
+    TuningResult tuned;
+    if (lookup(make_tuning_key(operation_type, {}, 0, get_arch(device_id)), tuned) &&
+        std::find(available_algorithms.begin(), available_algorithms.end(), tuned.algorithm) !=
+            available_algorithms.end()) {
+        return tuned.algorithm;
+    }
+    return available_algorithms.empty() ? "DEFAULT" : available_algorithms[0];
+}
+
+void PerformanceOptimizer::optimize_cache_behavior(size_t working_set_size, int device_id) {
+    // Simple cache optimization suggestions
+    if (working_set_size > 1024 * 1024 * 1024) { // > 1GB
+        // Suggest using unified memory for large working sets
+        std::cout << "Consider using unified memory for working set > 1GB" << std::endl;
+    }
+}
+
+void PerformanceOptimizer::tune_parameters(const std::string& operation_type, int device_id,
+                                           const TuningProgress& progress) {
+    if (device_id < 0) {
+        device_id = DeviceManager::get_instance().get_current_device();
+    }
+    KernelManager& manager = KernelManager::get_instance();
+    if (!manager.initialize_kernels(device_id)) {
+        std::cerr << "Warning: Kernels failed to initialize on device " << device_id << ", nothing tuned" << std::endl;
+        return;
+    }
+    const bool all = operation_type == "all";
+    auto report = [&](const std::string& problem, bool tuned) {
+        if (progress) {
+            progress(problem, tuned);
+        }
+    };
+    
+    if (all || operation_type == "matmul") {
+        auto matmul = manager.get_matmul_kernel(device_id);
+        MatmulConfig config;
+        config.transpose_b = true;
+        for (const GemmShape& shape : kModelZooGemms) {
+            for (int data_type : {1, 2}) {
+                TensorDesc a({shape.m, shape.k}, data_type);
+                TensorDesc b({shape.n, shape.k}, data_type);
+                TensorDesc c({shape.m, shape.n}, data_type);
+                std::string problem = std::string(shape.model) + " matmul " + std::to_string(shape.m) + "x" +
+                                      std::to_string(shape.n) + "x" + std::to_string(shape.k) +
+                                      (data_type == 1 ? " fp16" : " bf16");
+                TuningBuffer a_buf(a.get_size(), device_id), b_buf(b.get_size(), device_id), c_buf(c.get_size(), device_id);
+                if (!a_buf.data || !b_buf.data || !c_buf.data) {
+                    std::cerr << "Warning: Out of memory tuning " << problem << std::endl;
+                    report(problem, false);
+                    continue;
+                }
+                bool tuned = matmul->tune(a, a_buf.data, b, b_buf.data, c, c_buf.data, config);
+                hipDeviceSynchronize();
+                report(problem, tuned);
+            }
+        }
+    }
+    
+    // MIOpen's find results land in the convolution find-db
+    if (all || operation_type == "convolution") {
+        auto conv = manager.get_conv_kernel(device_id);
+        for (const ConvShape& shape : kModelZooConvs) {
+            ConvConfig config;
+            config.padding = {shape.padding, shape.padding};
+            config.stride = {shape.stride, shape.stride};
+            config.benchmark = true;
+            size_t out_h = (shape.height + 2 * shape.padding - shape.kernel) / shape.stride + 1;
+            size_t out_w = (shape.width + 2 * shape.padding - shape.kernel) / shape.stride + 1;
+            for (int data_type : {1, 2}) {
+                TensorDesc input({shape.batch, shape.channels, shape.height, shape.width}, data_type);
+                TensorDesc filter({shape.filters, shape.channels, shape.kernel, shape.kernel}, data_type);
+                TensorDesc output({shape.batch, shape.filters, out_h, out_w}, data_type);
+                std::string problem = std::string(shape.model) + " conv " + std::to_string(shape.channels) + "->" +
+                                      std::to_string(shape.filters) + " k" + std::to_string(shape.kernel) + " " +
+                                      std::to_string(shape.height) + "x" + std::to_string(shape.width) +
+                                      (data_type == 1 ? " fp16" : " bf16");
+                TuningBuffer in_buf(input.get_size(), device_id), filter_buf(filter.get_size(), device_id),
+                             out_buf(output.get_size(), device_id);
+                if (!in_buf.data || !filter_buf.data || !out_buf.data) {
+                    std::cerr << "Warning: Out of memory tuning " << problem << std::endl;
+                    report(problem, false);
+                    continue;
+                }
+                bool tuned = conv->conv2d_forward(input, in_buf.data, filter, filter_buf.data,
+                                                  output, out_buf.data, config);
+                hipDeviceSynchronize();
+                report(problem, tuned);
+            }
+        }
+        ConvAlgorithmCache::get_instance().save(ConvAlgorithmCache::get_instance().get_database_path());
     }
 }
 
@@ -0,0 +1,42 @@
+#ifndef RDNA_REDUCTION_H
+#define RDNA_REDUCTION_H
+
+#include "rdna/kernels.h"
+#include <vector>
+
+namespace rdna {
+
+enum class ReduceOp {
+    Sum,
+    Mean
+};
+
+/**
+ * @brief Reduce input over dims into output on stream
+ *
+ * dims may be negative and in any order; an empty list reduces every
+ * dimension. output is dense with the kept dimensions in input order, with
+ * or without the reduced ones as extent 1, and shares input's data type.
+ * input may be strided. Adjacent reduced axes that are contiguous collapse
+ * into one, then the kernel is chosen by shape:
+ *   - a block per output for long reductions along the fastest axis,
+ *   - a thread per output for short or strided reductions,
+ *   - either one split over gridDim.y when there are too few outputs to
+ *     fill the device, combined in a second pass.
+ * fp16/bf16 accumulate in fp32. Without deterministic the split count
+ * follows compute_units and splits combine with atomics; with it the split
+ * count depends only on the shape and partials combine in a fixed order,
+ * so results are bitwise reproducible run to run. Split partials live in
+ * the stream's workspace arena on device_id. Throws std::invalid_argument
+ * on mismatched descriptors, returns false if a launch fails.
+ */
+bool launch_reduction(ReduceOp op,
+                      const TensorDesc& input, const void* input_data,
+                      const TensorDesc& output, void* output_data,
+                      const std::vector<int>& dims, bool deterministic,
+                      int wavefront_size, int compute_units, int device_id,
+                      void* stream);
+
+} // namespace rdna
+
+#endif // RDNA_REDUCTION_H
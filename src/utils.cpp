@@ -154,6 +154,9 @@ struct LibraryConfig {
     bool enable_profiling = false;
     size_t memory_cache_limit = 1024 * 1024 * 1024; // 1GB
     bool use_unified_memory = false;
+    bool expandable_segments = false; // Grow the large pool by mapping pages into reserved address space
+    size_t workspace_limit = 256 * 1024 * 1024; // Per-stream cap on rocBLAS/MIOpen scratch
+    bool deterministic = false; // Fixed-order reductions, bitwise reproducible run to run
 };
 
 class ConfigManager {
@@ -182,6 +185,9 @@ public:
         if (config_.memory_cache_limit > 0) {
             MemoryManager::get_instance().get_current_allocator()->set_cache_size_limit(config_.memory_cache_limit);
         }
+        MemoryManager::get_instance().set_expandable_segments(config_.expandable_segments);
+        MemoryManager::get_instance().set_workspace_limit(config_.workspace_limit);
+        KernelManager::get_instance().set_deterministic(config_.deterministic);
     }
     
     void set_debug_logging(bool enabled) {
@@ -270,6 +276,14 @@ std::string get_memory_info(int device_id) {
     ss << "  Max Allocated: " << (stats.max_allocated_bytes / (1024 * 1024)) << " MB" << std::endl;
     ss << "  Total Allocations: " << stats.total_allocations << std::endl;
     ss << "  Total Frees: " << stats.total_frees << std::endl;
+    ss << "  Small Pool: " << stats.small_pool_segments << " segments, "
+       << stats.small_pool_blocks << " blocks" << std::endl;
+    ss << "  Large Pool: " << stats.large_pool_segments << " segments, "
+       << stats.large_pool_blocks << " blocks" << std::endl;
+    ss << "  hipMalloc/hipFree Calls: " << stats.device_malloc_calls << "/"
+       << stats.device_free_calls << std::endl;
+    ss << "  Workspace: " << (stats.workspace_bytes / (1024 * 1024)) << " MB (peak "
+       << (stats.workspace_high_water_mark / (1024 * 1024)) << " MB)" << std::endl;
     
     uint64_t total_mem = manager.get_total_memory(device_id);
     uint64_t free_mem = manager.get_free_memory(device_id);
@@ -1,3 +1,8 @@
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
@@ -7,6 +12,18 @@
 #include "rdna/device.h"
 #include "rdna/memory.h"
 #include "rdna/kernels.h"
+#include "rdna/profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace tensorflow {
 namespace rdna {
@@ -14,38 +31,300 @@ namespace rdna {
 using CPUDevice = Eigen::ThreadPoolDevice;
 using GPUDevice = Eigen::GpuDevice;
 
+// Device memory from the rdna caching allocator. Blocks are ordered on the
+// compute stream, which is where TF frees tensors once their last reader
+// has been queued; stats mirror what BFCAllocator reports.
+class RDNAAllocator : public Allocator {
+public:
+    RDNAAllocator(int device_id, void* compute_stream)
+        : device_id_(device_id), compute_stream_(compute_stream),
+          name_(strings::StrCat("rdna_", device_id)) {}
+    
+    string Name() override {
+        return name_;
+    }
+    
+    void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+        rdna::AllocationOptions options = {};
+        options.alignment = alignment;
+        options.stream = compute_stream_;
+        void* ptr = rdna::MemoryManager::get_instance().allocate(num_bytes, device_id_, options);
+        if (ptr) {
+            int64_t size = static_cast<int64_t>(num_bytes);
+            int64_t largest = largest_alloc_size_.load(std::memory_order_relaxed);
+            while (size > largest && !largest_alloc_size_.compare_exchange_weak(largest, size)) {
+            }
+        }
+        return ptr;
+    }
+    
+    void DeallocateRaw(void* ptr) override {
+        rdna::MemoryManager::get_instance().deallocate(ptr);
+    }
+    
+    absl::optional<AllocatorStats> GetStats() override {
+        rdna::MemoryManager& memory = rdna::MemoryManager::get_instance();
+        rdna::MemoryStats memory_stats = memory.get_stats(device_id_);
+        
+        AllocatorStats stats;
+        stats.num_allocs = memory_stats.total_allocations;
+        stats.bytes_in_use = memory_stats.allocated_bytes;
+        stats.peak_bytes_in_use = memory_stats.max_allocated_bytes;
+        stats.largest_alloc_size = largest_alloc_size_.load(std::memory_order_relaxed);
+        stats.bytes_limit = memory.get_total_memory(device_id_);
+        stats.bytes_reserved = memory_stats.allocated_bytes + memory_stats.cached_bytes;
+        
+        // The allocator keeps no reserved high-water mark; this one only
+        // sees the samples taken here
+        int64_t peak = peak_bytes_reserved_.load(std::memory_order_relaxed);
+        while (stats.bytes_reserved > peak &&
+               !peak_bytes_reserved_.compare_exchange_weak(peak, stats.bytes_reserved)) {
+        }
+        stats.peak_bytes_reserved = std::max(peak, stats.bytes_reserved);
+        return stats;
+    }
+    
+    AllocatorMemoryType GetMemoryType() const override {
+        return AllocatorMemoryType::kDevice;
+    }
+    
+private:
+    int device_id_;
+    void* compute_stream_;
+    string name_;
+    std::atomic<int64_t> largest_alloc_size_{0};
+    std::atomic<int64_t> peak_bytes_reserved_{0};
+};
+
+// Page-locked host memory for tensors TF stages transfers through, so
+// copies to and from the device are real asynchronous DMA
+class RDNAHostAllocator : public Allocator {
+public:
+    string Name() override {
+        return "rdna_host";
+    }
+    
+    void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+        // Pinned buffers are page aligned, which covers any TF alignment
+        return rdna::MemoryManager::get_instance().get_pinned_allocator().allocate(num_bytes);
+    }
+    
+    void DeallocateRaw(void* ptr) override {
+        rdna::MemoryManager::get_instance().get_pinned_allocator().deallocate(ptr);
+    }
+    
+    AllocatorMemoryType GetMemoryType() const override {
+        return AllocatorMemoryType::kHostPinned;
+    }
+};
+
+// Runs callbacks once their events complete, off the thread that queued
+// the work; the counterpart of TF's EventMgr for our streams
+class RDNAEventPoller {
+public:
+    RDNAEventPoller() : stop_(false), thread_([this]() { run(); }) {}
+    
+    ~RDNAEventPoller() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+    
+    void then(std::shared_ptr<rdna::Event> event, std::function<void()> callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.emplace_back(std::move(event), std::move(callback));
+        }
+        cv_.notify_all();
+    }
+    
+private:
+    static constexpr auto kPollInterval = std::chrono::microseconds(20);
+    
+    void run() {
+        std::vector<std::function<void()>> ready;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;  // Stopping with nothing left to deliver
+            }
+            auto done = std::partition(pending_.begin(), pending_.end(),
+                                       [](const Pending& p) { return !p.first->query(); });
+            for (auto it = done; it != pending_.end(); ++it) {
+                ready.push_back(std::move(it->second));
+            }
+            pending_.erase(done, pending_.end());
+            
+            // Callbacks may queue more work, so they run unlocked
+            lock.unlock();
+            for (auto& callback : ready) {
+                callback();
+            }
+            ready.clear();
+            std::this_thread::sleep_for(kPollInterval);
+            lock.lock();
+        }
+    }
+    
+    using Pending = std::pair<std::shared_ptr<rdna::Event>, std::function<void()>>;
+    
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Pending> pending_;
+    bool stop_;
+    std::thread thread_;  // Last, so it starts after the state it uses
+};
+
+// Streams an RDNADevice runs on. Ops queue kernels on the compute stream
+// and return; host transfers get streams of their own so the executor can
+// overlap them with compute, ordered against it with events.
+class RDNADeviceContext : public DeviceContext {
+public:
+    explicit RDNADeviceContext(int device_id)
+        : context_(rdna::DeviceManager::get_instance().get_context(device_id)) {
+        compute_stream_ = context_->create_stream();
+        host_to_device_stream_ = context_->create_stream();
+        device_to_host_stream_ = context_->create_stream();
+    }
+    
+    rdna::Stream& compute_stream() const {
+        return *compute_stream_;
+    }
+    
+    void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device, Tensor* device_tensor,
+                               StatusCallback done, bool sync_dst_compute) const override {
+        size_t bytes = cpu_tensor->TotalBytes();
+        if (bytes == 0) {
+            done(Status::OK());
+            return;
+        }
+        try {
+            // The destination block may still be in use by earlier compute
+            if (sync_dst_compute) {
+                order_after(*host_to_device_stream_, *compute_stream_);
+            }
+            auto copied = rdna::MemoryManager::get_instance().memcpy_async(
+                DMAHelper::base(device_tensor), DMAHelper::base(cpu_tensor), bytes, *host_to_device_stream_);
+            if (!copied) {
+                done(errors::Internal("RDNA host-to-device copy failed"));
+                return;
+            }
+            copied->wait(*compute_stream_);
+            
+            // The source must stay untouched until the DMA has read it
+            poller_.then(std::move(copied), [done]() { done(Status::OK()); });
+        } catch (const std::exception& e) {
+            done(errors::Internal("RDNA host-to-device copy failed: ", e.what()));
+        }
+    }
+    
+    void CopyDeviceTensorToCPU(const Tensor* device_tensor, StringPiece tensor_name, Device* device,
+                               Tensor* cpu_tensor, StatusCallback done) override {
+        size_t bytes = device_tensor->TotalBytes();
+        if (bytes == 0) {
+            done(Status::OK());
+            return;
+        }
+        try {
+            order_after(*device_to_host_stream_, *compute_stream_);
+            auto copied = rdna::MemoryManager::get_instance().memcpy_async(
+                DMAHelper::base(cpu_tensor), DMAHelper::base(device_tensor), bytes, *device_to_host_stream_);
+            if (!copied) {
+                done(errors::Internal("RDNA device-to-host copy failed"));
+                return;
+            }
+            
+            // TF may free the source on the compute stream before this
+            // copy has read it
+            rdna::MemoryManager::get_instance().record_stream(
+                DMAHelper::buffer(device_tensor)->root_buffer()->data(),
+                device_to_host_stream_->get_native_handle());
+            poller_.then(std::move(copied), [done]() { done(Status::OK()); });
+        } catch (const std::exception& e) {
+            done(errors::Internal("RDNA device-to-host copy failed: ", e.what()));
+        }
+    }
+    
+    void CopyTensorInSameDevice(const Tensor* input_tensor, Device* device, Tensor* output_tensor,
+                                StatusCallback done) const override {
+        // Ordered on the compute stream like any op, so done can run now
+        size_t bytes = input_tensor->TotalBytes();
+        if (bytes > 0 && !rdna::MemoryManager::get_instance().memcpy_async(
+                DMAHelper::base(output_tensor), DMAHelper::base(input_tensor), bytes, *compute_stream_)) {
+            done(errors::Internal("RDNA device-to-device copy failed"));
+            return;
+        }
+        done(Status::OK());
+    }
+    
+private:
+    // Queue waiter behind everything already queued on stream
+    void order_after(rdna::Stream& waiter, rdna::Stream& stream) const {
+        rdna::Event event(context_, false);
+        if (!event.initialize()) {
+            throw std::runtime_error("Failed to create event");
+        }
+        event.record(stream);
+        event.wait(waiter);
+    }
+    
+    std::shared_ptr<rdna::DeviceContext> context_;
+    std::shared_ptr<rdna::Stream> compute_stream_;
+    std::shared_ptr<rdna::Stream> host_to_device_stream_;
+    std::shared_ptr<rdna::Stream> device_to_host_stream_;
+    mutable RDNAEventPoller poller_;
+};
+
 // RDNA device registration
-class RDNADevice : public DeviceBase {
+class RDNADevice : public Device {
 public:
     RDNADevice(Env* env, const DeviceAttributes& device_attributes)
-        : DeviceBase(env), device_attributes_(device_attributes) {
+        : Device(env, device_attributes), device_id_(device_attributes.device_id()) {
         // Initialize RDNA device
-        device_id_ = device_attributes.device_id();
-        rdna::DeviceManager::get_instance().create_context(device_id_);
+        rdna::DeviceManager::get_instance().get_context(device_id_);
         rdna::KernelManager::get_instance().initialize_kernels(device_id_);
+        device_context_ = new RDNADeviceContext(device_id_);
+        allocator_ = std::make_unique<RDNAAllocator>(
+            device_id_, device_context_->compute_stream().get_native_handle());
     }
     
     ~RDNADevice() override {
-        // Cleanup RDNA resources
+        device_context_->Unref();
     }
     
     Allocator* GetAllocator(AllocatorAttributes attr) override {
-        // Return RDNA memory allocator
-        static rdna::MemoryAllocator* allocator = nullptr;
-        if (!allocator) {
-            auto context = rdna::DeviceManager::get_instance().create_context(device_id_);
-            allocator = new rdna::MemoryAllocator(context);
+        if (attr.on_host()) {
+            return &host_allocator_;
         }
-        return reinterpret_cast<Allocator*>(allocator);
+        return allocator_.get();
+    }
+    
+    // Every op on this device shares one context, so the executor sees a
+    // single compute stream to order transfers against
+    Status TryGetDeviceContext(DeviceContext** out_context) override {
+        device_context_->Ref();
+        *out_context = device_context_;
+        return Status::OK();
     }
     
-    const DeviceAttributes& attributes() const override {
-        return device_attributes_;
+    Status Sync() override {
+        try {
+            device_context_->compute_stream().synchronize();
+        } catch (const std::exception& e) {
+            return errors::Internal(e.what());
+        }
+        return Status::OK();
     }
     
 private:
-    DeviceAttributes device_attributes_;
     int device_id_;
+    RDNADeviceContext* device_context_;  // Reference counted
+    std::unique_ptr<RDNAAllocator> allocator_;
+    RDNAHostAllocator host_allocator_;
 };
 
 // RDNA device factory
@@ -88,11 +367,18 @@ public:
     explicit RDNAOpKernel(OpKernelConstruction* context) : OpKernel(context) {
         // Get device context
         device_id_ = context->device()->attributes().device_id();
-        context_ = rdna::DeviceManager::get_instance().create_context(device_id_);
+        context_ = rdna::DeviceManager::get_instance().get_context(device_id_);
         kernel_manager_ = &rdna::KernelManager::get_instance();
     }
     
 protected:
+    // Stream the op's kernels are queued to. Compute only enqueues; the
+    // executor orders consumers and copies through the same device context.
+    void* compute_stream(OpKernelContext* context) const {
+        auto* device_context = static_cast<RDNADeviceContext*>(context->op_device_context());
+        return device_context ? device_context->compute_stream().get_native_handle() : nullptr;
+    }
+    
     int device_id_;
     std::shared_ptr<rdna::DeviceContext> context_;
     rdna::KernelManager* kernel_manager_;
@@ -107,6 +393,7 @@ public:
     }
     
     void Compute(OpKernelContext* context) override {
+        rdna::ScopedEvent op_event(rdna::EventType::FRAMEWORK_OP, "MatMul");
         const Tensor& a = context->input(0);
         const Tensor& b = context->input(1);
         
@@ -132,7 +419,7 @@ public:
             a_desc, a.tensor_data().data(),
             b_desc, b.tensor_data().data(),
             c_desc, output->tensor_data().data(),
-            config, device_id_);
+            config, device_id_, compute_stream(context));
         
         OP_REQUIRES(context, success, errors::Internal("RDNA matmul operation failed"));
     }
@@ -154,6 +441,7 @@ public:
     }
     
     void Compute(OpKernelContext* context) override {
+        rdna::ScopedEvent op_event(rdna::EventType::FRAMEWORK_OP, "Conv2D");
         const Tensor& input = context->input(0);
         const Tensor& filter = context->input(1);
         
@@ -200,7 +488,7 @@ public:
             input_desc, input.tensor_data().data(),
             filter_desc, filter.tensor_data().data(),
             output_desc, output->tensor_data().data(),
-            config, device_id_);
+            config, device_id_, compute_stream(context));
         
         OP_REQUIRES(context, success, errors::Internal("RDNA conv2d operation failed"));
     }
@@ -219,6 +507,7 @@ public:
     explicit RDNAAddOp(OpKernelConstruction* context) : RDNAOpKernel(context) {}
     
     void Compute(OpKernelContext* context) override {
+        rdna::ScopedEvent op_event(rdna::EventType::FRAMEWORK_OP, "Add");
         const Tensor& a = context->input(0);
         const Tensor& b = context->input(1);
         
@@ -245,7 +534,8 @@ public:
         bool success = custom_kernels->add(
             a_desc, a.tensor_data().data(),
             b_desc, b.tensor_data().data(),
-            c_desc, output->tensor_data().data());
+            c_desc, output->tensor_data().data(),
+            compute_stream(context));
         
         OP_REQUIRES(context, success, errors::Internal("RDNA add operation failed"));
     }
@@ -4,6 +4,10 @@ Basic tests for RDNA Stack core functionality
 These tests can run without ROCm installation (simulation mode)
 """
 
+import array
+import json
+import math
+import struct
 import unittest
 import sys
 import os
@@ -20,47 +24,47 @@ except ImportError:
 
 @unittest.skipIf('rdna' not in sys.modules, "RDNA module not available")
 class TestRDNABasic(unittest.TestCase):
-    
+
     def test_import(self):
         """Test that the module can be imported"""
         self.assertTrue('rdna' in sys.modules)
-    
+
     def test_is_available(self):
         """Test device availability check"""
         # This should work even in simulation mode
         available = rdna.is_available()
         self.assertIsInstance(available, bool)
-    
+
     def test_device_count(self):
         """Test device count function"""
         count = rdna.device_count()
         self.assertIsInstance(count, int)
         self.assertGreaterEqual(count, 0)
-    
+
     def test_memory_functions(self):
         """Test memory management functions"""
         # These should work in simulation mode
         allocated = rdna.memory_allocated()
         self.assertIsInstance(allocated, int)
-        
+
         cached = rdna.memory_cached()
         self.assertIsInstance(cached, int)
-        
+
         # Test empty cache (should not raise)
         rdna.empty_cache()
-    
+
     def test_version_info(self):
         """Test version information functions"""
         version = rdna.get_library_version()
         self.assertIsInstance(version, str)
         self.assertTrue(len(version) > 0)
-        
+
         roc_version = rdna.get_roc_version()
         self.assertIsInstance(roc_version, str)
-        
+
         hip_version = rdna.get_hip_version()
         self.assertIsInstance(hip_version, str)
-    
+
     def test_diagnostics(self):
         """Test diagnostic functions (should not raise)"""
         # These functions should run without errors in simulation mode
@@ -69,9 +73,360 @@ class TestRDNABasic(unittest.TestCase):
         rdna.run_diagnostics()
 
 
+@unittest.skipIf('rdna' not in sys.modules or not rdna.is_available(), "No RDNA device available")
+class TestRDNADevice(unittest.TestCase):
+    """Behavior checks that need a device"""
+
+    def setUp(self):
+        self.device_id = rdna.current_device()
+
+    def _tensor(self, values, shape=None):
+        tensor = rdna.DeviceTensor.empty(shape or [len(values)])
+        tensor.copy_from(array.array('f', values))
+        return tensor
+
+    def _read(self, tensor):
+        values = array.array('f', [0.0] * (tensor.nbytes // 4))
+        tensor.copy_to(values)
+        return list(values)
+
+    def test_dlpack_round_trip(self):
+        """DLPack import shares the exporter's memory"""
+        source = self._tensor([1.0, 2.0, 3.0, 4.0, 5.0, 6.0])
+        imported = rdna.from_dlpack(source)
+        self.assertEqual(imported.data_ptr, source.data_ptr)
+        self.assertEqual(imported.shape, source.shape)
+        self.assertEqual(source.__dlpack_device__(), (10, source.device_id))
+
+        imported.copy_from(array.array('f', [6.0, 5.0, 4.0, 3.0, 2.0, 1.0]))
+        self.assertEqual(self._read(source), [6.0, 5.0, 4.0, 3.0, 2.0, 1.0])
+
+    def test_async_copy_and_set(self):
+        """Async copies and memsets complete behind their returned event"""
+        stream = rdna.DeviceManager.get_instance().get_context(self.device_id).create_stream()
+        source = self._tensor([1.0, 2.0, 3.0, 4.0])
+        target = self._tensor([0.0, 0.0, 0.0, 0.0])
+
+        event = rdna.memcpy_async(target.data, source.data, source.nbytes, stream)
+        self.assertIsNotNone(event)
+        event.synchronize()
+        self.assertTrue(event.query())
+        self.assertEqual(self._read(target), [1.0, 2.0, 3.0, 4.0])
+
+        rdna.memset_async(target.data, 0, target.nbytes, stream).synchronize()
+        self.assertEqual(self._read(target), [0.0, 0.0, 0.0, 0.0])
+
+    def test_memory_snapshot_tracks_allocations(self):
+        """Snapshots list live blocks with their tag and trace their allocation"""
+        manager = rdna.MemoryManager.get_instance()
+
+        def allocated_blocks():
+            snapshot = manager.snapshot(self.device_id)
+            return [block for segment in snapshot.segments for block in segment.blocks
+                    if block.state == 'allocated']
+
+        before = len(allocated_blocks())
+        tensor = rdna.DeviceTensor.empty([1024])
+        blocks = allocated_blocks()
+        self.assertEqual(len(blocks), before + 1)
+        owned = [block for block in blocks if block.address == tensor.data_ptr]
+        self.assertEqual(len(owned), 1)
+        self.assertEqual(owned[0].tag, 'dlpack')
+
+        trace = manager.snapshot(self.device_id).trace
+        allocs = [entry for entry in trace if entry.action == rdna.TraceAction.ALLOC]
+        self.assertEqual(allocs[-1].address, tensor.data_ptr)
+
+        del tensor
+        self.assertEqual(len(allocated_blocks()), before)
+        self.assertIn('segments', json.loads(rdna.memory_snapshot(self.device_id)))
+
+    def test_fused_elementwise_chain(self):
+        """A fused chain computes relu(a + b) and compiles once per signature"""
+        kernels = rdna.KernelManager.get_instance().get_custom_kernels(self.device_id)
+        if not kernels.is_initialized():
+            self.assertTrue(kernels.initialize())
+        a = self._tensor([-3.0, -1.0, 1.0, 2.0])
+        b = self._tensor([1.0, 2.0, -4.0, 0.5])
+        out = self._tensor([0.0, 0.0, 0.0, 0.0])
+        ops = [rdna.FusedOp(rdna.FusedOpType.Add, 0, 1), rdna.FusedOp(rdna.FusedOpType.Relu, 2)]
+
+        self.assertTrue(kernels.fused_elementwise([a.desc, b.desc], [a.data, b.data], ops,
+                                                  out.desc, out.data, None))
+        compiled = kernels.get_fused_kernel_count()
+        self.assertTrue(kernels.fused_elementwise([a.desc, b.desc], [a.data, b.data], ops,
+                                                  out.desc, out.data, None))
+        self.assertEqual(kernels.get_fused_kernel_count(), compiled)
+        self.assertEqual(self._read(out), [0.0, 1.0, 0.0, 2.5])
+
+    def test_attention_single_key(self):
+        """With one key, every query attends fully to its value row"""
+        attention = rdna.KernelManager.get_instance().get_attention_kernel(self.device_id)
+        if not attention.is_initialized():
+            self.assertTrue(attention.initialize())
+        head_dim = 8
+        value = [0.5 * i for i in range(head_dim)]
+
+        def half_tensor(shape, values):
+            tensor = rdna.DeviceTensor.empty(shape, 1)
+            tensor.copy_from(struct.pack('<%de' % len(values), *values))
+            return tensor
+
+        q = half_tensor([1, 1, 2, head_dim], [0.25] * (2 * head_dim))
+        k = half_tensor([1, 1, 1, head_dim], [1.0] * head_dim)
+        v = half_tensor([1, 1, 1, head_dim], value)
+        out = half_tensor([1, 1, 2, head_dim], [0.0] * (2 * head_dim))
+
+        self.assertTrue(attention.forward(q.desc, q.data, k.desc, k.data, v.desc, v.data, out.desc, out.data))
+        result = bytearray(out.nbytes)
+        out.copy_to(result)
+        for got, expected in zip(struct.unpack('<%de' % (2 * head_dim), bytes(result)), value * 2):
+            self.assertAlmostEqual(got, expected, places=3)
+
+    def test_matmul_tune_matches_untuned(self):
+        """Tuning picks a solution without changing the product"""
+        matmul = rdna.KernelManager.get_instance().get_matmul_kernel(self.device_id)
+        if not matmul.is_initialized():
+            self.assertTrue(matmul.initialize())
+        identity = self._tensor([1.0 if i == j else 0.0 for i in range(4) for j in range(4)], [4, 4])
+        b = self._tensor([float(i) for i in range(16)], [4, 4])
+        tuned = self._tensor([0.0] * 16, [4, 4])
+        untuned = self._tensor([0.0] * 16, [4, 4])
+        config = rdna.MatmulConfig()
+
+        self.assertTrue(matmul.tune(identity.desc, identity.data, b.desc, b.data,
+                                    tuned.desc, tuned.data, config, None))
+        self.assertTrue(matmul.matmul(identity.desc, identity.data, b.desc, b.data,
+                                      untuned.desc, untuned.data, config, None))
+        self.assertEqual(self._read(tuned), [float(i) for i in range(16)])
+        self.assertEqual(self._read(untuned), self._read(tuned))
+
+        # Beta reads C back in, so any candidate run against the real output
+        # would show up as extra copies of C
+        config.beta = 1.0
+        accumulated = self._tensor([1.0] * 16, [4, 4])
+        self.assertTrue(matmul.tune(identity.desc, identity.data, b.desc, b.data,
+                                    accumulated.desc, accumulated.data, config, None))
+        self.assertEqual(self._read(accumulated), [float(i) + 1.0 for i in range(16)])
+
+    def test_graph_capture_and_replay(self):
+        """Captured work runs only on replay, once per replay"""
+        kernels = rdna.KernelManager.get_instance().get_custom_kernels(self.device_id)
+        if not kernels.is_initialized():
+            self.assertTrue(kernels.initialize())
+        stream = rdna.DeviceManager.get_instance().get_context(self.device_id).create_stream()
+        tensor = self._tensor([1.0, 2.0, 3.0])
+
+        with rdna.graph(stream) as captured:
+            self.assertTrue(stream.is_capturing())
+            self.assertTrue(kernels.add(tensor.desc, tensor.data, tensor.desc, tensor.data,
+                                        tensor.desc, tensor.data, stream.get_native_handle()))
+        self.assertFalse(stream.is_capturing())
+        self.assertNotEqual(captured.graph.get_pool_id(), 0)
+        self.assertEqual(self._read(tensor), [1.0, 2.0, 3.0])
+
+        self.assertTrue(captured.replay())
+        self.assertTrue(captured.replay())
+        stream.synchronize()
+        self.assertEqual(self._read(tensor), [4.0, 8.0, 12.0])
+
+    def test_stream_pool_round_robin(self):
+        """Pool streams rotate per priority and rdna.stream makes one current"""
+        context = rdna.DeviceManager.get_instance().get_context(self.device_id)
+        streams = [context.get_stream_from_pool(rdna.StreamPriority.HIGH) for _ in range(5)]
+        self.assertEqual(len({id(stream) for stream in streams[:4]}), 4)
+        self.assertIs(streams[4], streams[0])
+        for stream in streams:
+            self.assertEqual(stream.get_priority(), rdna.StreamPriority.HIGH)
+
+        manager = rdna.DeviceManager.get_instance()
+        previous = manager.get_current_stream(self.device_id)
+        with rdna.stream(streams[1]):
+            self.assertIs(manager.get_current_stream(self.device_id), streams[1])
+        self.assertIs(manager.get_current_stream(self.device_id), previous)
+
+    def test_single_device_collectives(self):
+        """Collectives over one device leave all-reduce input as is and copy reduce-scatter input"""
+        manager = rdna.DeviceManager.get_instance()
+        self.assertFalse(manager.can_access_peer(self.device_id, self.device_id))
+
+        config = rdna.CollectiveConfig()
+        config.average = True
+        communicator = rdna.Communicator([self.device_id], config)
+        self.assertTrue(communicator.initialize())
+        self.assertEqual(communicator.size(), 1)
+
+        values = [1.0, -2.0, 3.5, 4.0]
+        buffer = self._tensor(values)
+        self.assertTrue(communicator.all_reduce([buffer.data_ptr], len(values)))
+        received = self._tensor([0.0] * len(values))
+        self.assertTrue(communicator.reduce_scatter([buffer.data_ptr], [received.data_ptr], len(values)))
+        communicator.wait()
+        communicator.synchronize()
+        self.assertEqual(self._read(buffer), values)
+        self.assertEqual(self._read(received), values)
+
+    def test_freed_block_is_reused(self):
+        """A freed block comes back from the cache without another device allocation"""
+        manager = rdna.MemoryManager.get_instance()
+        tensor = rdna.DeviceTensor.empty([1 << 16])
+        address = tensor.data_ptr
+        malloc_calls = manager.get_stats(self.device_id).device_malloc_calls
+
+        del tensor
+        reused = rdna.DeviceTensor.empty([1 << 16])
+        self.assertEqual(reused.data_ptr, address)
+        self.assertEqual(manager.get_stats(self.device_id).device_malloc_calls, malloc_calls)
+
+    def test_record_stream_defers_reuse(self):
+        """A block used on another stream stays pending until that stream's work completes"""
+        manager = rdna.MemoryManager.get_instance()
+        side = rdna.DeviceManager.get_instance().get_context(self.device_id).create_stream()
+
+        def state_at(address):
+            snapshot = manager.snapshot(self.device_id)
+            return [block.state for segment in snapshot.segments for block in segment.blocks
+                    if block.address == address]
+
+        tensor = rdna.DeviceTensor.empty([3 << 14])
+        address = tensor.data_ptr
+        manager.record_stream(tensor.data, side.get_native_handle())
+        del tensor
+        self.assertEqual(state_at(address), ['pending_free'])
+
+        # The next pooled allocation retires events that have completed
+        side.synchronize()
+        other = rdna.DeviceTensor.empty([1 << 20])
+        self.assertNotIn('pending_free', state_at(address))
+
+    def test_elementwise_broadcasting(self):
+        """Inputs broadcast NumPy-style against the output shape"""
+        kernels = rdna.KernelManager.get_instance().get_custom_kernels(self.device_id)
+        if not kernels.is_initialized():
+            self.assertTrue(kernels.initialize())
+        matrix = self._tensor([1.0, 2.0, 3.0, 4.0, 5.0, 6.0], [2, 3])
+        row = self._tensor([10.0, 20.0, 30.0], [3])
+        column = self._tensor([2.0, -1.0], [2, 1])
+        out = self._tensor([0.0] * 6, [2, 3])
+
+        self.assertTrue(kernels.add(matrix.desc, matrix.data, row.desc, row.data, out.desc, out.data, None))
+        self.assertEqual(self._read(out), [11.0, 22.0, 33.0, 14.0, 25.0, 36.0])
+
+        self.assertTrue(kernels.multiply(matrix.desc, matrix.data, column.desc, column.data,
+                                         out.desc, out.data, None))
+        self.assertEqual(self._read(out), [2.0, 4.0, 6.0, -4.0, -5.0, -6.0])
+
+    def test_norms_match_reference(self):
+        """LayerNorm and RMSNorm forward and backward match a direct computation"""
+        kernels = rdna.KernelManager.get_instance().get_custom_kernels(self.device_id)
+        if not kernels.is_initialized():
+            self.assertTrue(kernels.initialize())
+        rows, cols, eps = 2, 4, 1e-5
+        x = [1.0, 2.0, 3.0, 4.0, -1.0, 0.5, 2.0, -3.0]
+        w = [1.0, 0.5, 2.0, -1.0]
+        b = [0.0, 1.0, -1.0, 0.5]
+        dy = [0.5, -1.0, 2.0, 1.0, 1.0, 0.25, -0.5, 2.0]
+
+        def reference(rms):
+            y, dx, dw, db = [], [], [0.0] * cols, [0.0] * cols
+            for r in range(rows):
+                xs, gs = x[r * cols:(r + 1) * cols], dy[r * cols:(r + 1) * cols]
+                mean = 0.0 if rms else sum(xs) / cols
+                rstd = 1.0 / math.sqrt(sum((v - mean) ** 2 for v in xs) / cols + eps)
+                xhat = [(v - mean) * rstd for v in xs]
+                g = [gs[i] * w[i] for i in range(cols)]
+                g_mean = 0.0 if rms else sum(g) / cols
+                gx_mean = sum(g[i] * xhat[i] for i in range(cols)) / cols
+                y += [xhat[i] * w[i] + (0.0 if rms else b[i]) for i in range(cols)]
+                dx += [rstd * (g[i] - g_mean - xhat[i] * gx_mean) for i in range(cols)]
+                for i in range(cols):
+                    dw[i] += gs[i] * xhat[i]
+                    db[i] += gs[i]
+            return y, dx, dw, db
+
+        def check(tensor, expected):
+            for got, want in zip(self._read(tensor), expected):
+                self.assertAlmostEqual(got, want, places=4)
+
+        x_t, dy_t = self._tensor(x, [rows, cols]), self._tensor(dy, [rows, cols])
+        w_t, b_t = self._tensor(w), self._tensor(b)
+        y_t, dx_t = self._tensor([0.0] * 8, [rows, cols]), self._tensor([0.0] * 8, [rows, cols])
+        dw_t, db_t = self._tensor([0.0] * cols), self._tensor([0.0] * cols)
+        mean_t, rstd_t = self._tensor([0.0] * rows), self._tensor([0.0] * rows)
+
+        y, dx, dw, db = reference(rms=False)
+        self.assertTrue(kernels.layer_norm(x_t.desc, x_t.data, w_t.data, b_t.data, y_t.desc, y_t.data,
+                                           eps, mean_t.data, rstd_t.data))
+        check(y_t, y)
+        self.assertTrue(kernels.layer_norm_backward(dy_t.desc, dy_t.data, x_t.desc, x_t.data,
+                                                    mean_t.data, rstd_t.data, w_t.data,
+                                                    dx_t.data, dw_t.data, db_t.data))
+        check(dx_t, dx)
+        check(dw_t, dw)
+        check(db_t, db)
+
+        y, dx, dw, _ = reference(rms=True)
+        self.assertTrue(kernels.rms_norm(x_t.desc, x_t.data, w_t.data, y_t.desc, y_t.data, eps, rstd_t.data))
+        check(y_t, y)
+        self.assertTrue(kernels.rms_norm_backward(dy_t.desc, dy_t.data, x_t.desc, x_t.data,
+                                                  rstd_t.data, w_t.data, dx_t.data, dw_t.data))
+        check(dx_t, dx)
+        check(dw_t, dw)
+
+    def test_deterministic_reductions_repeat_exactly(self):
+        """Deterministic mode gives bit-identical sums from run to run"""
+        manager = rdna.KernelManager.get_instance()
+        kernels = manager.get_custom_kernels(self.device_id)
+        if not kernels.is_initialized():
+            self.assertTrue(kernels.initialize())
+        rows, cols = 4096, 64
+        values = [((i * 2654435761) % 2001 - 1000) * 10.0 ** (i % 7 - 3) for i in range(rows * cols)]
+        data = self._tensor(values, [rows, cols])
+
+        def reduce(dims, shape):
+            out = self._tensor([0.0] * (shape[0] if shape else 1), shape or [1])
+            self.assertTrue(kernels.sum(data.desc, data.data, out.desc, out.data, dims, None))
+            result = bytearray(out.nbytes)
+            out.copy_to(result)
+            return bytes(result)
+
+        was_deterministic = manager.is_deterministic()
+        manager.set_deterministic(True)
+        try:
+            total = reduce([], None)
+            columns = reduce([0], [cols])
+            for _ in range(3):
+                self.assertEqual(reduce([], None), total)
+                self.assertEqual(reduce([0], [cols]), columns)
+        finally:
+            manager.set_deterministic(was_deterministic)
+        self.assertAlmostEqual(struct.unpack('<f', total)[0], math.fsum(values),
+                               delta=1e-5 * math.fsum(abs(v) for v in values))
+
+    def test_allocator_stats_track_allocations(self):
+        """The counters the TensorFlow allocator reports follow allocations and frees"""
+        manager = rdna.MemoryManager.get_instance()
+        size = 1 << 22
+        before = manager.get_stats(self.device_id)
+        tensor = rdna.DeviceTensor.empty([size // 4])
+
+        # bytes_in_use, num_allocs and peak_bytes_in_use in AllocatorStats
+        during = manager.get_stats(self.device_id)
+        self.assertGreaterEqual(during.allocated_bytes - before.allocated_bytes, size)
+        self.assertEqual(during.total_allocations, before.total_allocations + 1)
+        self.assertGreaterEqual(during.max_allocated_bytes, during.allocated_bytes)
+
+        # bytes_reserved keeps the freed block, which stays cached
+        del tensor
+        after = manager.get_stats(self.device_id)
+        self.assertEqual(after.allocated_bytes, before.allocated_bytes)
+        self.assertEqual(after.total_frees, before.total_frees + 1)
+        self.assertGreaterEqual(after.allocated_bytes + after.cached_bytes, during.allocated_bytes)
+
+
 class TestRDNAAPISimulation(unittest.TestCase):
     """Tests that demonstrate the API structure without requiring ROCm"""
-    
+
     def test_api_structure(self):
         """Verify that expected API functions exist"""
         api_functions = [
@@ -81,22 +436,87 @@ class TestRDNAAPISimulation(unittest.TestCase):
             'get_library_version', 'diagnostics', 'set_debug_logging',
             'set_profiling', 'set_memory_cache_limit'
         ]
-        
+
         for func_name in api_functions:
             self.assertTrue(hasattr(rdna, func_name), 
                           f"Missing API function: {func_name}")
-    
+
     def test_device_context_managers(self):
         """Test device context manager API structure"""
         # PyTorch-style device context
         self.assertTrue(hasattr(rdna, 'device'))
-        
+
         # TensorFlow-style device context  
         self.assertTrue(hasattr(rdna, 'tf_device'))
-        
+
         # Configuration API
         self.assertTrue(hasattr(rdna, 'config'))
 
+    def test_async_memory_api(self):
+        """Test non-blocking copy API structure"""
+        self.assertTrue(hasattr(rdna, 'memcpy_async'))
+        self.assertTrue(hasattr(rdna, 'memset_async'))
+        self.assertTrue(hasattr(rdna, 'Event'))
+
+    def test_memory_snapshot_api(self):
+        """Test allocator snapshot API structure"""
+        self.assertTrue(hasattr(rdna, 'memory_snapshot'))
+        self.assertTrue(hasattr(rdna, 'MemorySnapshot'))
+        self.assertTrue(hasattr(rdna, 'TraceAction'))
+
+    def test_fused_kernel_api(self):
+        """Test fused elementwise and matmul epilogue API structure"""
+        self.assertTrue(hasattr(rdna, 'FusedOp'))
+        self.assertTrue(hasattr(rdna, 'FusedOpType'))
+        self.assertTrue(hasattr(rdna, 'MatmulEpilogue'))
+        self.assertTrue(hasattr(rdna.CustomKernels, 'fused_elementwise'))
+        self.assertTrue(hasattr(rdna.MatmulKernel, 'fused_matmul'))
+
+    def test_matmul_tuning_api(self):
+        """Test matmul autotuning API structure"""
+        self.assertTrue(hasattr(rdna.MatmulKernel, 'tune'))
+
+    def test_attention_api(self):
+        """Test fused attention API structure"""
+        self.assertTrue(hasattr(rdna, 'AttentionKernel'))
+        self.assertTrue(hasattr(rdna, 'AttentionConfig'))
+        self.assertTrue(hasattr(rdna.AttentionKernel, 'forward'))
+        self.assertTrue(hasattr(rdna.AttentionKernel, 'backward'))
+        self.assertTrue(hasattr(rdna.KernelManager, 'get_attention_kernel'))
+
+    def test_graph_capture_api(self):
+        """Test graph capture and replay API structure"""
+        self.assertTrue(hasattr(rdna, 'Graph'))
+        self.assertTrue(hasattr(rdna, 'graph'))
+        self.assertTrue(hasattr(rdna.Stream, 'begin_capture'))
+        self.assertTrue(hasattr(rdna.Stream, 'end_capture'))
+        self.assertTrue(hasattr(rdna.Graph, 'replay'))
+
+    def test_stream_pool_api(self):
+        """Test stream pool and current stream API structure"""
+        self.assertTrue(hasattr(rdna, 'stream'))
+        self.assertTrue(hasattr(rdna, 'StreamPriority'))
+        self.assertTrue(hasattr(rdna.DeviceContext, 'get_stream_from_pool'))
+        self.assertTrue(hasattr(rdna.DeviceManager, 'set_current_stream'))
+
+    def test_dlpack_api(self):
+        """Test DLPack interop API structure"""
+        self.assertTrue(hasattr(rdna, 'DeviceTensor'))
+        self.assertTrue(hasattr(rdna, 'from_dlpack'))
+        self.assertTrue(hasattr(rdna, 'to_dlpack'))
+        self.assertTrue(hasattr(rdna.DeviceTensor, '__dlpack__'))
+        self.assertTrue(hasattr(rdna.DeviceTensor, '__dlpack_device__'))
+
+    def test_collectives_api(self):
+        """Test peer access and collectives API structure"""
+        self.assertTrue(hasattr(rdna.DeviceManager, 'can_access_peer'))
+        self.assertTrue(hasattr(rdna.DeviceManager, 'enable_peer_access'))
+        self.assertTrue(hasattr(rdna.MemoryManager, 'peer_memcpy_async'))
+        self.assertTrue(hasattr(rdna, 'Communicator'))
+        self.assertTrue(hasattr(rdna.Communicator, 'all_reduce'))
+        self.assertTrue(hasattr(rdna.Communicator, 'reduce_scatter'))
+        self.assertTrue(hasattr(rdna, 'GradientBuckets'))
+
 
 if __name__ == '__main__':
     # Check if we can import rdna, otherwise skip tests
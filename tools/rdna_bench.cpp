@@ -0,0 +1,110 @@
+// rdna-bench: device benchmark suite
+//
+// Runs the BenchmarkRunner suite on one device, prints each result with its
+// 95% confidence interval, and optionally saves the results as JSON and
+// checks them against a baseline saved by an earlier run.
+//
+//   rdna-bench [--device N] [--suite bandwidth,latency,gemm,conv,allocator,roofline]
+//              [--warmup N] [--repetitions N] [--quick] [--output FILE]
+//              [--baseline FILE] [--tolerance FRACTION]
+//
+// Exit status is 0 on success, 1 on usage or I/O errors and 2 when any
+// result regressed against the baseline, so CI can gate on it.
+
+#include "rdna/device.h"
+#include "rdna/profiler.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void print_usage() {
+    std::cout << "Usage: rdna-bench [--device N] [--suite bandwidth,latency,gemm,conv,allocator,roofline]\n"
+              << "                  [--warmup N] [--repetitions N] [--quick] [--output FILE]\n"
+              << "                  [--baseline FILE] [--tolerance FRACTION]\n";
+}
+
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int device_id = 0;
+    double tolerance = 0.05;
+    std::vector<std::string> categories;
+    std::string output_path;
+    std::string baseline_path;
+    rdna::BenchmarkOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        }
+        if (arg == "--quick") {
+            options.quick = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--device") {
+            device_id = std::atoi(value.c_str());
+        } else if (arg == "--suite") {
+            categories = split_list(value);
+        } else if (arg == "--warmup") {
+            options.warmup = std::atoi(value.c_str());
+        } else if (arg == "--repetitions") {
+            options.repetitions = std::atoi(value.c_str());
+        } else if (arg == "--output") {
+            output_path = value;
+        } else if (arg == "--baseline") {
+            baseline_path = value;
+        } else if (arg == "--tolerance") {
+            tolerance = std::atof(value.c_str());
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (device_id < 0 || device_id >= rdna::DeviceManager::get_instance().device_count()) {
+        std::cerr << "Error: No device " << device_id << std::endl;
+        return 1;
+    }
+
+    rdna::BenchmarkRunner& runner = rdna::BenchmarkRunner::get_instance();
+    runner.set_options(options);
+    runner.run_benchmarks(device_id, categories);
+
+    if (!output_path.empty() && !runner.save_results(output_path)) {
+        std::cerr << "Error: Failed to write " << output_path << std::endl;
+        return 1;
+    }
+    if (!baseline_path.empty()) {
+        int regressions = runner.compare_with_baseline(baseline_path, tolerance);
+        if (regressions < 0) {
+            return 1;
+        }
+        if (regressions > 0) {
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+// rdna-tune: offline autotuning for a device
+//
+// Times every candidate for the built-in model zoo shapes (or a shapes file)
+// and writes the winners to the tuning file loaded at startup by the
+// PerformanceOptimizer.
+//
+//   rdna-tune [--device N] [--op matmul|convolution|all] [--shapes FILE]
+//             [--output PATH] [--iterations N]
+//
+// Shapes files hold one problem per line, '#' starts a comment:
+//   matmul M N K fp16|bf16|fp32 [batch] [NN|NT|TN|TT]
+
+#include "rdna/kernels.h"
+#include "rdna/memory.h"
+#include "rdna/profiler.h"
+#include <hip/hip_runtime.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+void print_usage() {
+    std::cout << "Usage: rdna-tune [--device N] [--op matmul|convolution|all] [--shapes FILE]\n"
+              << "                 [--output PATH] [--iterations N]\n";
+}
+
+int parse_data_type(const std::string& name) {
+    if (name == "fp32") return 0;
+    if (name == "fp16") return 1;
+    if (name == "bf16") return 2;
+    return -1;
+}
+
+struct DeviceBuffer {
+    void* data = nullptr;
+
+    DeviceBuffer(size_t size, int device_id) {
+        data = rdna::MemoryManager::get_instance().allocate(size, device_id);
+        if (data) {
+            rdna::MemoryManager::get_instance().memset(data, 0, size);
+        }
+    }
+    ~DeviceBuffer() {
+        if (data) {
+            rdna::MemoryManager::get_instance().deallocate(data);
+        }
+    }
+    DeviceBuffer(const DeviceBuffer&) = delete;
+    DeviceBuffer& operator=(const DeviceBuffer&) = delete;
+};
+
+bool tune_matmul(const std::string& line, int device_id) {
+    std::istringstream fields(line);
+    std::string op, dtype, layout = "NN";
+    size_t m = 0, n = 0, k = 0, batch = 0;
+    if (!(fields >> op >> m >> n >> k >> dtype) || op != "matmul") {
+        return false;
+    }
+    std::string token;
+    while (fields >> token) {
+        if (token[0] == 'N' || token[0] == 'T') {
+            layout = token;
+        } else {
+            batch = std::strtoull(token.c_str(), nullptr, 10);
+        }
+    }
+    int data_type = parse_data_type(dtype);
+    if (data_type < 0 || layout.size() != 2 || m == 0 || n == 0 || k == 0) {
+        return false;
+    }
+
+    rdna::MatmulConfig config;
+    config.transpose_a = layout[0] == 'T';
+    config.transpose_b = layout[1] == 'T';
+    std::vector<size_t> a_shape = config.transpose_a ? std::vector<size_t>{k, m} : std::vector<size_t>{m, k};
+    std::vector<size_t> b_shape = config.transpose_b ? std::vector<size_t>{n, k} : std::vector<size_t>{k, n};
+    std::vector<size_t> c_shape = {m, n};
+    if (batch > 0) {
+        a_shape.insert(a_shape.begin(), batch);
+        b_shape.insert(b_shape.begin(), batch);
+        c_shape.insert(c_shape.begin(), batch);
+    }
+    rdna::TensorDesc a(a_shape, data_type), b(b_shape, data_type), c(c_shape, data_type);
+
+    DeviceBuffer a_buf(a.get_size(), device_id), b_buf(b.get_size(), device_id), c_buf(c.get_size(), device_id);
+    if (!a_buf.data || !b_buf.data || !c_buf.data) {
+        std::cerr << "Warning: Out of memory tuning: " << line << std::endl;
+        return false;
+    }
+    auto matmul = rdna::KernelManager::get_instance().get_matmul_kernel(device_id);
+    bool tuned = matmul && matmul->tune(a, a_buf.data, b, b_buf.data, c, c_buf.data, config);
+    hipDeviceSynchronize();
+    return tuned;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int device_id = 0;
+    int iterations = 0;
+    std::string op = "all";
+    std::string shapes_path;
+    std::string output_path;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--device") {
+            device_id = std::atoi(value.c_str());
+        } else if (arg == "--op") {
+            op = value;
+        } else if (arg == "--shapes") {
+            shapes_path = value;
+        } else if (arg == "--output") {
+            output_path = value;
+        } else if (arg == "--iterations") {
+            iterations = std::atoi(value.c_str());
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    rdna::PerformanceOptimizer& optimizer = rdna::PerformanceOptimizer::get_instance();
+    if (iterations > 0) {
+        optimizer.set_tuning_iterations(2, iterations);
+    }
+    if (!output_path.empty()) {
+        // Startup loaded the default tuning file; keep those entries out of
+        // the output, which is extended rather than replaced
+        optimizer.clear_tuning();
+        optimizer.load_tuning_file(output_path);
+    }
+
+    if (shapes_path.empty()) {
+        optimizer.tune_parameters(op, device_id, [](const std::string& problem, bool tuned) {
+            std::cout << (tuned ? "Tuned " : "Failed ") << problem << std::endl;
+        });
+    } else {
+        std::ifstream shapes(shapes_path);
+        if (!shapes) {
+            std::cerr << "Error: Cannot open shapes file " << shapes_path << std::endl;
+            return 1;
+        }
+        if (!rdna::KernelManager::get_instance().initialize_kernels(device_id)) {
+            std::cerr << "Error: Failed to initialize kernels on device " << device_id << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(shapes, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            std::cout << (tune_matmul(line, device_id) ? "Tuned " : "Failed ") << line << std::endl;
+        }
+    }
+
+    if (!optimizer.save_tuning_file(output_path)) {
+        std::cerr << "Error: Failed to write tuning file "
+                  << (output_path.empty() ? optimizer.get_tuning_file_path() : output_path) << std::endl;
+        return 1;
+    }
+    std::cout << optimizer.get_tuned_count() << " tuned entries written to "
+              << (output_path.empty() ? optimizer.get_tuning_file_path() : output_path) << std::endl;
+    return 0;
+}